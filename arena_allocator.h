@@ -0,0 +1,230 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <new>
+
+/// arena
+/*!
+Monotonic memory arena: allocate() bumps a pointer inside the current chunk and there is
+no per-block deallocation. reset() invalidates every block at once and keeps the newest
+(largest) chunk for reuse, release() returns all chunks to operator delete.
+
+Chunks grow geometrically, starting at chunk_bytes. The last block can be extended in place
+while the current chunk has room, which lets compact_vector grow its heap buffer without copying.
+The arena is not thread-safe.
+*/
+class arena
+{
+public:
+	explicit arena(size_t chunk_bytes = 4096) :
+		next_chunk_bytes(chunk_bytes)
+	{}
+
+	arena(const arena&) = delete;
+	arena& operator= (const arena&) = delete;
+
+	~arena()
+	{
+		release();
+	}
+
+	void* allocate(size_t bytes, size_t alignment)
+	{
+		char* p = align(cursor, alignment);
+		if (p == nullptr || bytes > static_cast<size_t>(limit - p))
+		{
+			add_chunk(bytes + alignment);
+			p = align(cursor, alignment);
+		}
+
+		cursor = p + bytes;
+		last = p;
+		return p;
+	}
+
+	/// extends the last block from old_bytes to new_bytes without moving it, if the chunk has room
+	bool extend(void* p, size_t old_bytes, size_t new_bytes) noexcept
+	{
+		if (p == nullptr || p != last || new_bytes > static_cast<size_t>(limit - last))
+			return false;
+
+		(void)old_bytes;
+		cursor = last + new_bytes;
+		return true;
+	}
+
+	/// invalidates all blocks; the newest chunk is kept, the others are freed
+	void reset() noexcept
+	{
+		if (head == nullptr)
+			return;
+
+		free_chunks(head->next);
+		head->next = nullptr;
+		cursor = head->data();
+		last = nullptr;
+		used_before_head = 0;
+	}
+
+	/// invalidates all blocks and frees every chunk
+	void release() noexcept
+	{
+		free_chunks(head);
+		head = nullptr;
+		cursor = nullptr;
+		limit = nullptr;
+		last = nullptr;
+		used_before_head = 0;
+	}
+
+	/// bytes handed out since the last reset, including alignment padding
+	size_t used_bytes() const noexcept
+	{
+		return head == nullptr ? 0 : used_before_head + (cursor - head->data());
+	}
+
+	/// bytes held in chunks
+	size_t reserved_bytes() const noexcept
+	{
+		size_t bytes = 0;
+		for (chunk* c = head; c != nullptr; c = c->next)
+			bytes += c->size;
+		return bytes;
+	}
+
+private:
+	struct alignas(std::max_align_t) chunk
+	{
+		chunk* next;
+		size_t size;
+
+		char* data() noexcept
+		{
+			return reinterpret_cast<char*>(this + 1);
+		}
+	};
+
+	chunk* head = nullptr;
+	char* cursor = nullptr;
+	char* limit = nullptr;
+	char* last = nullptr;
+	size_t next_chunk_bytes;
+	size_t used_before_head = 0;
+
+	static char* align(char* p, size_t alignment) noexcept
+	{
+		if (p == nullptr)
+			return nullptr;
+		uintptr_t address = reinterpret_cast<uintptr_t>(p);
+		return p + ((alignment - address % alignment) % alignment);
+	}
+
+	void add_chunk(size_t required)
+	{
+		if (required > std::numeric_limits<size_t>::max() / 2 - sizeof(chunk))
+			throw std::bad_alloc();
+
+		size_t size = next_chunk_bytes > required ? next_chunk_bytes : required;
+		chunk* c = static_cast<chunk*>(::operator new(sizeof(chunk) + size));
+		c->next = head;
+		c->size = size;
+
+		if (head != nullptr)
+			used_before_head += cursor - head->data();
+		head = c;
+		cursor = c->data();
+		limit = cursor + size;
+		next_chunk_bytes = size * 2;
+	}
+
+	static void free_chunks(chunk* c) noexcept
+	{
+		while (c != nullptr)
+		{
+			chunk* next = c->next;
+			::operator delete(c);
+			c = next;
+		}
+	}
+};
+
+/// arena_allocator
+/*!
+Allocator that takes memory from an arena. deallocate() does nothing and is_monotonic is set,
+so compact_vector does not call it on destruction: the memory of request-scoped vectors is
+reclaimed by arena::reset(). Vectors of types with non-trivial destructors still have to be
+destroyed before the reset; vectors of trivially destructible types may simply be abandoned.
+
+reallocate() extends the most recent block in place, so a vector that grows at the top of the
+arena keeps its buffer. Copies of a container share its arena (propagate_on_container_* are false,
+as for std::pmr::polymorphic_allocator).
+*/
+template <class T>
+struct arena_allocator
+{
+	using value_type = T;
+
+	static constexpr bool is_monotonic = true;
+
+	template <class U>
+	struct rebind
+	{
+		using other = arena_allocator<U>;
+	};
+
+	explicit arena_allocator(arena& a) noexcept :
+		source(&a)
+	{}
+
+	template <class U>
+	arena_allocator(const arena_allocator<U>& x) noexcept :
+		source(x.source)
+	{}
+
+	T* allocate(size_t n)
+	{
+		if (n > std::numeric_limits<size_t>::max() / sizeof(T))
+			throw std::bad_alloc();
+
+		return static_cast<T*>(source->allocate(n * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T*, size_t) noexcept
+	{
+	}
+
+	/// reallocate
+	/*!
+	Extends the block in place if it is the last one in the arena, otherwise copies it
+	to a new block. The old block is not reclaimed until the arena is reset.
+	*/
+	T* reallocate(T* p, size_t old_n, size_t new_n)
+	{
+		if (new_n > std::numeric_limits<size_t>::max() / sizeof(T))
+			throw std::bad_alloc();
+
+		if (source->extend(p, old_n * sizeof(T), new_n * sizeof(T)))
+			return p;
+
+		T* result = allocate(new_n);
+		std::memcpy(static_cast<void*>(result), p, (old_n < new_n ? old_n : new_n) * sizeof(T));
+		return result;
+	}
+
+	arena* source;
+};
+
+template <class T, class U>
+bool operator== (const arena_allocator<T>& a, const arena_allocator<U>& b) noexcept
+{
+	return a.source == b.source;
+}
+
+template <class T, class U>
+bool operator!= (const arena_allocator<T>& a, const arena_allocator<U>& b) noexcept
+{
+	return a.source != b.source;
+}
@@ -0,0 +1,320 @@
+// Бенчмарки compact_vector в сравнении с std::vector и inline_small_vector.
+//
+// Каждый сценарий выполняется над контейнером из count элементов; одна
+// операция (op) - один полный прогон сценария. Размеры перебираются вокруг
+// границы compact_capacity. Измерения делает TestsRunner::Measure, результат
+// печатается в stdout по одному JSON-объекту на строку:
+//   {"bench":"push_back","container":"compact_vector","type":"uint8_t","count":16,
+//    "allocs_per_op":...,"bytes_per_op":...,"iterations":...,"ns_per_op":...,
+//    "min_ns_per_op":...,"counters":{"cycles":...,...}}
+// После перебора запускаются бенчмарки, зарегистрированные через
+// COMPACT_VECTOR_BENCHMARK.
+//
+// Использование: compact_vector_bench [filter]
+// filter - подстрока, которая должна встречаться в "bench/container/type".
+
+#include "../compact_vector.h"
+#include "../tests/tests_runner.h"
+#include "inline_small_vector.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+// Счетчики аллокаций: глобальные operator new/delete ниже ведут учет
+// всех выделений памяти в процессе, включая память std::string.
+size_t allocation_count = 0;
+size_t allocation_bytes = 0;
+
+}
+
+void* operator new(size_t size)
+{
+	allocation_count++;
+	allocation_bytes += size;
+	if (void* p = std::malloc(size == 0 ? 1 : size))
+		return p;
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+	return ::operator new(size);
+}
+
+// память замененного operator new получена из malloc, поэтому free здесь парный вызов;
+// GCC встраивает delete рядом с new и не видит, что они заменены вместе
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+namespace
+{
+
+const char* bench_filter = nullptr;
+
+// сценариев в переборе много, поэтому каждый прогон короче, чем по умолчанию
+const double min_time_ns = 2e6;
+
+template <class T> const char* type_name();
+template <> const char* type_name<uint8_t>() { return "uint8_t"; }
+template <> const char* type_name<uint32_t>() { return "uint32_t"; }
+template <> const char* type_name<uint64_t>() { return "uint64_t"; }
+template <> const char* type_name<std::string>() { return "std::string"; }
+
+template <class T>
+T make_value(size_t i)
+{
+	return static_cast<T>(i * 2654435761u);
+}
+
+template <>
+std::string make_value<std::string>(size_t i)
+{
+	return "value_" + std::to_string(i % 1000);
+}
+
+template <class T>
+size_t weight(const T& value)
+{
+	return static_cast<size_t>(value);
+}
+
+size_t weight(const std::string& value)
+{
+	return value.size();
+}
+
+template <class T> using compact = compact_vector<T>;
+template <class T> using compact_tail = compact_vector<T, -1, std::allocator<T>, compact_vector_growth::doubling, compact_vector_layout::tail_size>;
+template <class T> using compact_pointer = compact_vector<T, -1, std::allocator<T>, compact_vector_growth::doubling, compact_vector_layout::data_pointer>;
+template <class T> using inline_small = inline_small_vector<T, compact_vector<T>::compact_capacity>;
+
+template <template <class> class Container> const char* container_name();
+template <> const char* container_name<std::vector>() { return "std::vector"; }
+template <> const char* container_name<compact>() { return "compact_vector"; }
+template <> const char* container_name<compact_tail>() { return "compact_vector_tail_size"; }
+template <> const char* container_name<compact_pointer>() { return "compact_vector_data_pointer"; }
+template <> const char* container_name<inline_small>() { return "inline_small_vector"; }
+
+template <class Container>
+Container make_container(size_t count)
+{
+	Container c;
+	for (size_t i = 0; i < count; i++)
+		c.push_back(make_value<typename Container::value_type>(i));
+	return c;
+}
+
+bool matches(const std::string& id)
+{
+	return bench_filter == nullptr || id.find(bench_filter) != std::string::npos;
+}
+
+// Измеряет body через TestsRunner::Measure; аллокации берутся из последнего прогона.
+template <class Body>
+void run(const char* bench, const char* container, const char* type, size_t count, Body body)
+{
+	std::string id = std::string(bench) + "/" + container + "/" + type;
+	if (!matches(id))
+		return;
+
+	size_t allocs = 0;
+	size_t bytes = 0;
+	size_t iterations = 1;
+	Measurement m = TestsRunner::Measure(id, [&](size_t n)
+	{
+		size_t allocs_before = allocation_count;
+		size_t bytes_before = allocation_bytes;
+		body(n);
+		allocs = allocation_count - allocs_before;
+		bytes = allocation_bytes - bytes_before;
+		iterations = n;
+	}, min_time_ns);
+
+	std::printf(
+		"{\"bench\":\"%s\",\"container\":\"%s\",\"type\":\"%s\",\"count\":%zu,"
+		"\"allocs_per_op\":%.3f,\"bytes_per_op\":%.1f,%s}\n",
+		bench, container, type, count,
+		double(allocs) / iterations, double(bytes) / iterations,
+		TestsRunner::MeasurementFields(m).c_str());
+}
+
+template <template <class> class Container, class T>
+void bench_container(size_t count)
+{
+	using C = Container<T>;
+	const char* cname = container_name<Container>();
+	const char* tname = type_name<T>();
+	const T value = make_value<T>(count);
+
+	run("construct_destroy", cname, tname, count, [&](size_t iterations)
+	{
+		for (size_t it = 0; it < iterations; it++)
+		{
+			C c(count, value);
+			TestsRunner::DoNotOptimize(c);
+		}
+	});
+
+	run("push_back", cname, tname, count, [&](size_t iterations)
+	{
+		for (size_t it = 0; it < iterations; it++)
+		{
+			C c;
+			for (size_t i = 0; i < count; i++)
+				c.push_back(value);
+			TestsRunner::DoNotOptimize(c);
+		}
+	});
+
+	run("emplace_back", cname, tname, count, [&](size_t iterations)
+	{
+		for (size_t it = 0; it < iterations; it++)
+		{
+			C c;
+			for (size_t i = 0; i < count; i++)
+				c.emplace_back(value);
+			TestsRunner::DoNotOptimize(c);
+		}
+	});
+
+	const C source = make_container<C>(count);
+
+	run("copy", cname, tname, count, [&](size_t iterations)
+	{
+		for (size_t it = 0; it < iterations; it++)
+		{
+			C c(source);
+			TestsRunner::DoNotOptimize(c);
+		}
+	});
+
+	run("move", cname, tname, count, [&](size_t iterations)
+	{
+		C a(source);
+		for (size_t it = 0; it < iterations; it++)
+		{
+			C b(std::move(a));
+			TestsRunner::DoNotOptimize(b);
+			a = std::move(b);
+		}
+		TestsRunner::DoNotOptimize(a);
+	});
+
+	run("swap", cname, tname, count, [&](size_t iterations)
+	{
+		C a(source);
+		C b = make_container<C>(count / 2);
+		for (size_t it = 0; it < iterations; it++)
+		{
+			a.swap(b);
+			TestsRunner::DoNotOptimize(a);
+		}
+	});
+
+	run("insert_erase", cname, tname, count, [&](size_t iterations)
+	{
+		C c(source);
+		for (size_t it = 0; it < iterations; it++)
+		{
+			c.insert(c.begin() + c.size() / 2, value);
+			c.erase(c.begin() + c.size() / 2);
+			TestsRunner::DoNotOptimize(c);
+		}
+	});
+
+	run("iterate", cname, tname, count, [&](size_t iterations)
+	{
+		for (size_t it = 0; it < iterations; it++)
+		{
+			size_t sum = 0;
+			for (const T& e : source)
+				sum += weight(e);
+			TestsRunner::DoNotOptimize(sum);
+		}
+	});
+
+	std::vector<size_t> indices(count);
+	std::mt19937 random(42);
+	for (auto& index : indices)
+		index = count == 0 ? 0 : random() % count;
+
+	run("random_access", cname, tname, count, [&](size_t iterations)
+	{
+		for (size_t it = 0; it < iterations; it++)
+		{
+			size_t sum = 0;
+			for (size_t index : indices)
+				sum += weight(source[index]);
+			TestsRunner::DoNotOptimize(sum);
+		}
+	});
+}
+
+template <class T>
+void bench_type()
+{
+	const size_t capacity = compact_vector<T>::compact_capacity;
+	std::vector<size_t> counts = { 0, 1, capacity - 1, capacity, capacity + 1, 2 * capacity, 4 * capacity, 64 };
+	std::sort(counts.begin(), counts.end());
+	counts.erase(std::unique(counts.begin(), counts.end()), counts.end());
+
+	for (size_t count : counts)
+	{
+		bench_container<std::vector, T>(count);
+		bench_container<compact, T>(count);
+		bench_container<compact_tail, T>(count);
+		bench_container<compact_pointer, T>(count);
+		bench_container<inline_small, T>(count);
+	}
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	if (argc > 1)
+		bench_filter = argv[1];
+
+	bench_type<uint8_t>();
+	bench_type<uint32_t>();
+	bench_type<uint64_t>();
+	bench_type<std::string>();
+
+	TestsRunner::RunAllBenchmarks(bench_filter);
+	return 0;
+}
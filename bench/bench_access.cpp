@@ -0,0 +1,166 @@
+// Бенчмарки индексного доступа: цена проверки is_compact() в begin()/operator[]
+// в плотном цикле по сравнению с std::vector и раскладкой data_pointer, в которой
+// этой проверки нет. Одна итерация - один проход по всем элементам контейнера.
+// random_row_sum читает элементы случайных строк таблицы, где встроенные и
+// вынесенные в кучу строки перемешаны: каждое обращение идет к другому вектору,
+// и проверку is_compact() нельзя вынести из цикла.
+
+#include "../compact_vector.h"
+#include "../tests/tests_runner.h"
+
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+template <class Container>
+Container make_sequence(size_t count)
+{
+	Container c;
+	for (size_t i = 0; i < count; i++)
+		c.push_back(static_cast<typename Container::value_type>(i));
+	return c;
+}
+
+template <class Container>
+void indexed_sum(const Container& c, size_t iterations)
+{
+	for (size_t it = 0; it < iterations; it++)
+	{
+		uint64_t sum = 0;
+		for (size_t i = 0; i < c.size(); i++)
+			sum += c[i];
+		TestsRunner::DoNotOptimize(sum);
+	}
+}
+
+// таблица из rows строк: половина по 8 элементов (во встроенном буфере при compact_max_size 16),
+// половина по 40 (в куче), в случайном порядке
+template <class Container>
+std::vector<Container> make_mixed_table(size_t rows)
+{
+	std::mt19937 random(12345);
+	std::vector<Container> table;
+	table.reserve(rows);
+	for (size_t r = 0; r < rows; r++)
+		table.push_back(make_sequence<Container>(random() % 2 == 0 ? 8 : 40));
+	return table;
+}
+
+// пары (строка, столбец) для random_row_sum
+std::vector<std::pair<uint32_t, uint32_t>> make_lookups(size_t rows, size_t count)
+{
+	std::mt19937 random(54321);
+	std::vector<std::pair<uint32_t, uint32_t>> lookups(count);
+	for (auto& l : lookups)
+		l = std::make_pair(static_cast<uint32_t>(random() % rows), static_cast<uint32_t>(random() % 8));
+	return lookups;
+}
+
+template <class Container>
+void random_row_sum(size_t iterations)
+{
+	const size_t rows = 4096;
+	std::vector<Container> table = make_mixed_table<Container>(rows);
+	std::vector<std::pair<uint32_t, uint32_t>> lookups = make_lookups(rows, 4096);
+	for (size_t it = 0; it < iterations; it++)
+	{
+		uint64_t sum = 0;
+		for (const auto& l : lookups)
+			sum += table[l.first][l.second];
+		TestsRunner::DoNotOptimize(sum);
+	}
+}
+
+template <class Container>
+void iterator_sum(const Container& c, size_t iterations)
+{
+	for (size_t it = 0; it < iterations; it++)
+	{
+		uint64_t sum = 0;
+		for (auto e : c)
+			sum += e;
+		TestsRunner::DoNotOptimize(sum);
+	}
+}
+
+}
+
+COMPACT_VECTOR_BENCHMARK(indexed_sum_std_vector_16)
+{
+	indexed_sum(make_sequence<std::vector<uint32_t>>(16), iterations);
+}
+
+COMPACT_VECTOR_BENCHMARK(indexed_sum_compact_vector_inline_16)
+{
+	indexed_sum(make_sequence<compact_vector<uint32_t, 16>>(16), iterations);
+}
+
+COMPACT_VECTOR_BENCHMARK(indexed_sum_std_vector_1024)
+{
+	indexed_sum(make_sequence<std::vector<uint32_t>>(1024), iterations);
+}
+
+COMPACT_VECTOR_BENCHMARK(indexed_sum_compact_vector_heap_1024)
+{
+	indexed_sum(make_sequence<compact_vector<uint32_t, 16>>(1024), iterations);
+}
+
+COMPACT_VECTOR_BENCHMARK(iterator_sum_compact_vector_inline_16)
+{
+	iterator_sum(make_sequence<compact_vector<uint32_t, 16>>(16), iterations);
+}
+
+COMPACT_VECTOR_BENCHMARK(iterator_sum_compact_vector_heap_1024)
+{
+	iterator_sum(make_sequence<compact_vector<uint32_t, 16>>(1024), iterations);
+}
+
+template <class T>
+using pointer_vector = compact_vector<T, 16, std::allocator<T>, compact_vector_growth::doubling, compact_vector_layout::data_pointer>;
+
+COMPACT_VECTOR_BENCHMARK(indexed_sum_data_pointer_inline_16)
+{
+	indexed_sum(make_sequence<pointer_vector<uint32_t>>(16), iterations);
+}
+
+COMPACT_VECTOR_BENCHMARK(indexed_sum_data_pointer_heap_1024)
+{
+	indexed_sum(make_sequence<pointer_vector<uint32_t>>(1024), iterations);
+}
+
+template <class T>
+using tail_vector = compact_vector<T, 16, std::allocator<T>, compact_vector_growth::doubling, compact_vector_layout::tail_size>;
+
+COMPACT_VECTOR_BENCHMARK(indexed_sum_tail_size_inline_16)
+{
+	indexed_sum(make_sequence<tail_vector<uint32_t>>(16), iterations);
+}
+
+COMPACT_VECTOR_BENCHMARK(indexed_sum_tail_size_heap_1024)
+{
+	indexed_sum(make_sequence<tail_vector<uint32_t>>(1024), iterations);
+}
+
+COMPACT_VECTOR_BENCHMARK(random_row_sum_std_vector)
+{
+	random_row_sum<std::vector<uint32_t>>(iterations);
+}
+
+COMPACT_VECTOR_BENCHMARK(random_row_sum_compact_vector)
+{
+	random_row_sum<compact_vector<uint32_t, 16>>(iterations);
+}
+
+COMPACT_VECTOR_BENCHMARK(random_row_sum_tail_size)
+{
+	random_row_sum<tail_vector<uint32_t>>(iterations);
+}
+
+COMPACT_VECTOR_BENCHMARK(random_row_sum_data_pointer)
+{
+	random_row_sum<pointer_vector<uint32_t>>(iterations);
+}
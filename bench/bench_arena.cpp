@@ -0,0 +1,53 @@
+// Бенчмарки временных векторов в обработчике запроса: std::allocator против arena_allocator
+// с одним сбросом арены на запрос. Одна итерация - запрос, который строит 256 векторов
+// по 1..24 элемента (большая часть выходит из компактного режима) и затем их разрушает.
+
+#include "../compact_vector.h"
+#include "../arena_allocator.h"
+#include "../tests/tests_runner.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+
+const size_t vectors_per_request = 256;
+
+template <class Vector, class Allocator>
+void handle_request(std::vector<Vector>& vectors, const Allocator& allocator)
+{
+	for (size_t v = 0; v < vectors_per_request; v++)
+	{
+		vectors.emplace_back(allocator);
+		size_t count = 1 + v % 24;
+		for (size_t i = 0; i < count; i++)
+			vectors.back().push_back(static_cast<uint32_t>(i));
+	}
+	TestsRunner::DoNotOptimize(vectors);
+	vectors.clear();
+}
+
+}
+
+COMPACT_VECTOR_BENCHMARK(request_256_vectors_std_allocator)
+{
+	using vector_type = compact_vector<uint32_t, 4>;
+	std::vector<vector_type> vectors;
+	vectors.reserve(vectors_per_request);
+	for (size_t it = 0; it < iterations; it++)
+		handle_request(vectors, std::allocator<uint32_t>());
+}
+
+COMPACT_VECTOR_BENCHMARK(request_256_vectors_arena_allocator)
+{
+	using vector_type = compact_vector<uint32_t, 4, arena_allocator<uint32_t>>;
+	std::vector<vector_type> vectors;
+	vectors.reserve(vectors_per_request);
+	arena a(64 * 1024);
+	for (size_t it = 0; it < iterations; it++)
+	{
+		handle_request(vectors, arena_allocator<uint32_t>(a));
+		a.reset();
+	}
+}
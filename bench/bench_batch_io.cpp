@@ -0,0 +1,199 @@
+// Бенчмарки контрольной точки таблицы compact_vector<uint32_t> в файл (кэш страниц): копирование
+// в промежуточный буфер и один write против writev/readv из data() строк через compact_vector_batch_io.
+// Таблицы: 64K коротких строк по 0..39 элементов и 1K длинных по 1..8K элементов.
+// Файл в текущем каталоге удаляется при выходе.
+
+#include "../compact_vector_io.h"
+#include "../tests/tests_runner.h"
+
+#ifdef COMPACT_VECTOR_HAS_IOVEC
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+
+using table_row = compact_vector<uint32_t>;
+
+const size_t row_count = 1 << 16;
+
+std::vector<table_row> make_table(size_t rows, size_t max_length)
+{
+	std::vector<table_row> t(rows);
+	for (size_t i = 0; i < rows; i++)
+		for (size_t j = 0; j < (i * 7919) % max_length; j++)
+			t[i].push_back(static_cast<uint32_t>(i + j));
+	return t;
+}
+
+const std::vector<table_row>& table()
+{
+	static std::vector<table_row> result = make_table(row_count, 40);
+	return result;
+}
+
+const std::vector<table_row>& large_table()
+{
+	static std::vector<table_row> result = make_table(1024, 8192);
+	return result;
+}
+
+struct checkpoint_file
+{
+	const char* path = "compact_vector_bench_batch_io.bin";
+	int fd;
+
+	checkpoint_file() :
+		fd(::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644))
+	{}
+
+	~checkpoint_file()
+	{
+		::close(fd);
+		std::remove(path);
+	}
+};
+
+int checkpoint_fd()
+{
+	static checkpoint_file file;
+	return file.fd;
+}
+
+// прежний способ: счетчики и элементы копируются в один буфер, который пишется одним вызовом
+void stage(std::vector<unsigned char>& buffer, const std::vector<table_row>& rows)
+{
+	buffer.resize(compact_vector_batch_io::batch_bytes(rows.begin(), rows.end()));
+	unsigned char* p = buffer.data();
+	for (const table_row& row : rows)
+	{
+		uint64_t n = row.size();
+		std::memcpy(p, &n, sizeof(n));
+		p += sizeof(n);
+	}
+	for (const table_row& row : rows)
+	{
+		std::memcpy(p, row.data(), row.size() * sizeof(uint32_t));
+		p += row.size() * sizeof(uint32_t);
+	}
+}
+
+void unstage(const std::vector<unsigned char>& buffer, std::vector<table_row>& rows)
+{
+	const unsigned char* counts = buffer.data();
+	const unsigned char* p = counts + rows.size() * sizeof(uint64_t);
+	for (table_row& row : rows)
+	{
+		uint64_t n;
+		std::memcpy(&n, counts, sizeof(n));
+		counts += sizeof(n);
+		row.assign_bytes(p, static_cast<size_t>(n));
+		p += n * sizeof(uint32_t);
+	}
+}
+
+}
+
+COMPACT_VECTOR_BENCHMARK(checkpoint_64k_rows_staging_write)
+{
+	int fd = checkpoint_fd();
+	std::vector<unsigned char> buffer;
+	for (size_t it = 0; it < iterations; it++)
+	{
+		stage(buffer, table());
+		TestsRunner::DoNotOptimize(::pwrite(fd, buffer.data(), buffer.size(), 0));
+	}
+}
+
+COMPACT_VECTOR_BENCHMARK(checkpoint_64k_rows_writev)
+{
+	int fd = checkpoint_fd();
+	compact_vector_batch_io io;
+	for (size_t it = 0; it < iterations; it++)
+		TestsRunner::DoNotOptimize(io.pwrite(fd, 0, table().begin(), table().end()));
+}
+
+COMPACT_VECTOR_BENCHMARK(checkpoint_1k_large_rows_staging_write)
+{
+	int fd = checkpoint_fd();
+	std::vector<unsigned char> buffer;
+	for (size_t it = 0; it < iterations; it++)
+	{
+		stage(buffer, large_table());
+		TestsRunner::DoNotOptimize(::pwrite(fd, buffer.data(), buffer.size(), 0));
+	}
+}
+
+COMPACT_VECTOR_BENCHMARK(checkpoint_1k_large_rows_writev)
+{
+	int fd = checkpoint_fd();
+	compact_vector_batch_io io;
+	for (size_t it = 0; it < iterations; it++)
+		TestsRunner::DoNotOptimize(io.pwrite(fd, 0, large_table().begin(), large_table().end()));
+}
+
+COMPACT_VECTOR_BENCHMARK(restore_64k_rows_staging_read)
+{
+	int fd = checkpoint_fd();
+	compact_vector_batch_io().pwrite(fd, 0, table().begin(), table().end());
+
+	std::vector<unsigned char> buffer(compact_vector_batch_io::batch_bytes(table().begin(), table().end()));
+	std::vector<table_row> rows(row_count);
+	for (size_t it = 0; it < iterations; it++)
+	{
+		TestsRunner::DoNotOptimize(::pread(fd, buffer.data(), buffer.size(), 0));
+		unstage(buffer, rows);
+		TestsRunner::DoNotOptimize(rows);
+	}
+}
+
+COMPACT_VECTOR_BENCHMARK(restore_64k_rows_readv)
+{
+	int fd = checkpoint_fd();
+	compact_vector_batch_io io;
+	io.pwrite(fd, 0, table().begin(), table().end());
+
+	std::vector<table_row> rows(row_count);
+	for (size_t it = 0; it < iterations; it++)
+	{
+		TestsRunner::DoNotOptimize(io.pread(fd, 0, rows.begin(), rows.end()));
+		TestsRunner::DoNotOptimize(rows);
+	}
+}
+
+COMPACT_VECTOR_BENCHMARK(restore_1k_large_rows_staging_read)
+{
+	int fd = checkpoint_fd();
+	compact_vector_batch_io().pwrite(fd, 0, large_table().begin(), large_table().end());
+
+	std::vector<unsigned char> buffer(compact_vector_batch_io::batch_bytes(large_table().begin(), large_table().end()));
+	std::vector<table_row> rows(large_table().size());
+	for (size_t it = 0; it < iterations; it++)
+	{
+		TestsRunner::DoNotOptimize(::pread(fd, buffer.data(), buffer.size(), 0));
+		unstage(buffer, rows);
+		TestsRunner::DoNotOptimize(rows);
+	}
+}
+
+COMPACT_VECTOR_BENCHMARK(restore_1k_large_rows_readv)
+{
+	int fd = checkpoint_fd();
+	compact_vector_batch_io io;
+	io.pwrite(fd, 0, large_table().begin(), large_table().end());
+
+	std::vector<table_row> rows(large_table().size());
+	for (size_t it = 0; it < iterations; it++)
+	{
+		TestsRunner::DoNotOptimize(io.pread(fd, 0, rows.begin(), rows.end()));
+		TestsRunner::DoNotOptimize(rows);
+	}
+}
+
+#endif // COMPACT_VECTOR_HAS_IOVEC
@@ -0,0 +1,101 @@
+// Бенчмарки наборов флагов: compact_vector<bool> (байт на флаг) и std::vector<bool> против compact_bitvector.
+// flags_120 - 10000 сущностей по 120 флагов (помещаются во встроенные 128 бит), одна итерация
+// считает сущности, у которых есть общий флаг с запросом. and_count_4096 - одна итерация
+// пересекает два набора по 4096 бит и считает установленные биты.
+
+#include "../compact_vector.h"
+#include "../compact_bitvector.h"
+#include "../tests/tests_runner.h"
+
+#include <random>
+#include <vector>
+
+namespace
+{
+
+const size_t entity_count = 10000;
+const size_t flag_count = 120;
+
+template <class Flags>
+std::vector<Flags> make_entities(size_t flags)
+{
+	std::vector<Flags> entities(entity_count);
+	std::mt19937 random(21);
+	for (auto& e : entities)
+		for (size_t i = 0; i < flags; i++)
+			e.push_back(random() % 64 == 0);
+	return entities;
+}
+
+}
+
+COMPACT_VECTOR_BENCHMARK(flags_120_intersect_compact_vector_bool)
+{
+	static const auto entities = make_entities<compact_vector<bool>>(flag_count);
+	static const auto query = make_entities<compact_vector<bool>>(flag_count)[7];
+	for (size_t it = 0; it < iterations; it++)
+	{
+		size_t matches = 0;
+		for (const auto& e : entities)
+		{
+			bool common = false;
+			for (size_t i = 0; i < flag_count; i++)
+				common |= e[i] & query[i];
+			matches += common;
+		}
+		TestsRunner::DoNotOptimize(matches);
+	}
+}
+
+COMPACT_VECTOR_BENCHMARK(flags_120_intersect_compact_bitvector)
+{
+	static const auto entities = make_entities<compact_bitvector>(flag_count);
+	static const auto query = make_entities<compact_bitvector>(flag_count)[7];
+	for (size_t it = 0; it < iterations; it++)
+	{
+		size_t matches = 0;
+		for (const auto& e : entities)
+			matches += e.intersects(query);
+		TestsRunner::DoNotOptimize(matches);
+	}
+}
+
+COMPACT_VECTOR_BENCHMARK(and_count_4096_std_vector_bool)
+{
+	std::vector<bool> a, b;
+	std::mt19937 random(5);
+	for (size_t i = 0; i < 4096; i++)
+	{
+		a.push_back(random() % 2);
+		b.push_back(random() % 2);
+	}
+	for (size_t it = 0; it < iterations; it++)
+	{
+		std::vector<bool> c = a;
+		size_t count = 0;
+		for (size_t i = 0; i < c.size(); i++)
+		{
+			c[i] = c[i] && b[i];
+			count += c[i];
+		}
+		TestsRunner::DoNotOptimize(count);
+	}
+}
+
+COMPACT_VECTOR_BENCHMARK(and_count_4096_compact_bitvector)
+{
+	compact_bitvector a, b;
+	std::mt19937 random(5);
+	for (size_t i = 0; i < 4096; i++)
+	{
+		a.push_back(random() % 2);
+		b.push_back(random() % 2);
+	}
+	for (size_t it = 0; it < iterations; it++)
+	{
+		compact_bitvector c = a;
+		c &= b;
+		size_t count = c.count();
+		TestsRunner::DoNotOptimize(count);
+	}
+}
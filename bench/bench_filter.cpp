@@ -0,0 +1,63 @@
+// Бенчмарки фильтрации списков идентификаторов: erase-remove через begin()/end()
+// против remove_value (векторные ядра) и erase_if. Одна итерация - восстановление
+// исходных 1024 элементов и удаление примерно половины из них.
+
+#include "../compact_vector.h"
+#include "../tests/tests_runner.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+
+namespace
+{
+
+using id_vector = compact_vector<uint32_t, 16>;
+
+const id_vector& source()
+{
+	static const id_vector ids = []
+	{
+		id_vector v;
+		std::mt19937 random(3);
+		for (size_t i = 0; i < 1024; i++)
+			v.push_back(random() % 2);
+		return v;
+	}();
+	return ids;
+}
+
+}
+
+COMPACT_VECTOR_BENCHMARK(filter_erase_remove_idiom_1024)
+{
+	id_vector ids;
+	for (size_t it = 0; it < iterations; it++)
+	{
+		ids = source();
+		ids.erase(std::remove(ids.begin(), ids.end(), 1u), ids.end());
+		TestsRunner::DoNotOptimize(ids);
+	}
+}
+
+COMPACT_VECTOR_BENCHMARK(filter_remove_value_1024)
+{
+	id_vector ids;
+	for (size_t it = 0; it < iterations; it++)
+	{
+		ids = source();
+		ids.remove_value(1);
+		TestsRunner::DoNotOptimize(ids);
+	}
+}
+
+COMPACT_VECTOR_BENCHMARK(filter_erase_if_1024)
+{
+	id_vector ids;
+	for (size_t it = 0; it < iterations; it++)
+	{
+		ids = source();
+		ids.erase_if([](uint32_t x) { return x == 1; });
+		TestsRunner::DoNotOptimize(ids);
+	}
+}
@@ -0,0 +1,113 @@
+// Бенчмарки поиска в маленьких словарях: std::map, std::unordered_map и compact_flat_map на 1..64 ключах.
+// Одна итерация ищет 256 случайных ключей, половина из которых есть в словаре.
+// build - одна итерация строит словарь из 64 ключей в случайном порядке.
+
+#include "../compact_flat_map.h"
+#include "../tests/tests_runner.h"
+
+#include <cstdint>
+#include <map>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+
+const size_t probe_count = 256;
+
+std::vector<uint32_t> make_keys(size_t n)
+{
+	std::vector<uint32_t> keys;
+	std::mt19937 random(static_cast<unsigned>(n));
+	for (size_t i = 0; i < n; i++)
+		keys.push_back(static_cast<uint32_t>(random() % 1000000) * 2);
+	return keys;
+}
+
+std::vector<uint32_t> make_probes(const std::vector<uint32_t>& keys)
+{
+	std::vector<uint32_t> probes;
+	std::mt19937 random(7);
+	for (size_t i = 0; i < probe_count; i++)
+	{
+		uint32_t key = keys[random() % keys.size()];
+		probes.push_back(i % 2 ? key : key + 1);
+	}
+	return probes;
+}
+
+template <class Map>
+void lookup(size_t n, size_t iterations)
+{
+	std::vector<uint32_t> keys = make_keys(n);
+	std::vector<uint32_t> probes = make_probes(keys);
+	Map map;
+	for (uint32_t key : keys)
+		map[key] = key;
+
+	for (size_t it = 0; it < iterations; it++)
+	{
+		uint32_t sum = 0;
+		for (uint32_t key : probes)
+		{
+			auto found = map.find(key);
+			if (found != map.end())
+				sum += found->second;
+		}
+		TestsRunner::DoNotOptimize(sum);
+	}
+}
+
+template <class Map>
+void build(size_t iterations)
+{
+	std::vector<uint32_t> keys = make_keys(64);
+	for (size_t it = 0; it < iterations; it++)
+	{
+		Map map;
+		for (uint32_t key : keys)
+			map[key] = key;
+		TestsRunner::DoNotOptimize(map);
+	}
+}
+
+using std_map = std::map<uint32_t, uint32_t>;
+using std_unordered_map = std::unordered_map<uint32_t, uint32_t>;
+using flat_map = compact_flat_map<uint32_t, uint32_t, 16>;
+
+}
+
+#define COMPACT_FLAT_MAP_LOOKUP_BENCHMARK(map, n) \
+	COMPACT_VECTOR_BENCHMARK(lookup_##map##_##n) \
+	{ \
+		lookup<map>(n, iterations); \
+	}
+
+COMPACT_FLAT_MAP_LOOKUP_BENCHMARK(std_map, 1)
+COMPACT_FLAT_MAP_LOOKUP_BENCHMARK(std_unordered_map, 1)
+COMPACT_FLAT_MAP_LOOKUP_BENCHMARK(flat_map, 1)
+COMPACT_FLAT_MAP_LOOKUP_BENCHMARK(std_map, 8)
+COMPACT_FLAT_MAP_LOOKUP_BENCHMARK(std_unordered_map, 8)
+COMPACT_FLAT_MAP_LOOKUP_BENCHMARK(flat_map, 8)
+COMPACT_FLAT_MAP_LOOKUP_BENCHMARK(std_map, 16)
+COMPACT_FLAT_MAP_LOOKUP_BENCHMARK(std_unordered_map, 16)
+COMPACT_FLAT_MAP_LOOKUP_BENCHMARK(flat_map, 16)
+COMPACT_FLAT_MAP_LOOKUP_BENCHMARK(std_map, 64)
+COMPACT_FLAT_MAP_LOOKUP_BENCHMARK(std_unordered_map, 64)
+COMPACT_FLAT_MAP_LOOKUP_BENCHMARK(flat_map, 64)
+
+COMPACT_VECTOR_BENCHMARK(build_std_map_64)
+{
+	build<std_map>(iterations);
+}
+
+COMPACT_VECTOR_BENCHMARK(build_std_unordered_map_64)
+{
+	build<std_unordered_map>(iterations);
+}
+
+COMPACT_VECTOR_BENCHMARK(build_flat_map_64)
+{
+	build<flat_map>(iterations);
+}
@@ -0,0 +1,110 @@
+// Бенчмарки вектора в отображаемом файле: загрузка 1M uint32 чтением и десериализацией
+// против повторного открытия отображения без разбора, и стоимость обхода через offset_ptr.
+// Файлы лежат в текущем каталоге и после прогона удаляются; кэш страниц теплый.
+
+#include "../compact_vector.h"
+#include "../mmap_allocator.h"
+#include "../tests/tests_runner.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <numeric>
+
+#ifdef COMPACT_VECTOR_HAS_MMAP
+
+namespace
+{
+
+const size_t element_count = 1 << 20;
+
+using mapped_vector = compact_vector<uint32_t, -1, mmap_allocator<uint32_t>>;
+
+const char* mapped_path = "compact_vector_bench_mmap.bin";
+
+const char* plain_path = "compact_vector_bench_plain.bin";
+
+// файлы пишутся один раз при первом обращении и удаляются при выходе; минимум по прогонам их создание не включает
+struct bench_files
+{
+	bench_files()
+	{
+		mapped_file file = mapped_file::create(mapped_path, element_count * sizeof(uint32_t) + 4096);
+		mapped_vector& v = file.construct_root<mapped_vector>(file.allocator<uint32_t>());
+		v.reserve(element_count);
+		for (size_t i = 0; i < element_count; i++)
+			v.push_back(static_cast<uint32_t>(i));
+
+		std::FILE* f = std::fopen(plain_path, "wb");
+		std::fwrite(v.data(), sizeof(uint32_t), v.size(), f);
+		std::fclose(f);
+	}
+
+	~bench_files()
+	{
+		std::remove(mapped_path);
+		std::remove(plain_path);
+	}
+};
+
+void prepare_files()
+{
+	static bench_files files;
+}
+
+}
+
+COMPACT_VECTOR_BENCHMARK(mmap_load_1m_read_file)
+{
+	prepare_files();
+	for (size_t it = 0; it < iterations; it++)
+	{
+		std::FILE* f = std::fopen(plain_path, "rb");
+		compact_vector<uint32_t> v(element_count);
+		size_t read = std::fread(v.data(), sizeof(uint32_t), element_count, f);
+		std::fclose(f);
+		TestsRunner::DoNotOptimize(read);
+		TestsRunner::DoNotOptimize(std::accumulate(v.begin(), v.end(), uint64_t(0)));
+	}
+}
+
+COMPACT_VECTOR_BENCHMARK(mmap_load_1m_reopen_mapping)
+{
+	prepare_files();
+	for (size_t it = 0; it < iterations; it++)
+	{
+		const mapped_file file = mapped_file::open(mapped_path, mapped_file::read_only);
+		const mapped_vector* v = file.root<mapped_vector>();
+		TestsRunner::DoNotOptimize(std::accumulate(v->begin(), v->end(), uint64_t(0)));
+	}
+}
+
+COMPACT_VECTOR_BENCHMARK(mmap_index_1m_std_allocator)
+{
+	compact_vector<uint32_t> v;
+	for (size_t i = 0; i < element_count; i++)
+		v.push_back(static_cast<uint32_t>(i));
+
+	for (size_t it = 0; it < iterations; it++)
+	{
+		uint64_t sum = 0;
+		for (size_t i = 0; i < v.size(); i++)
+			sum += v[i];
+		TestsRunner::DoNotOptimize(sum);
+	}
+}
+
+COMPACT_VECTOR_BENCHMARK(mmap_index_1m_offset_ptr)
+{
+	prepare_files();
+	static const mapped_file file = mapped_file::open(mapped_path, mapped_file::read_only);
+	const mapped_vector& v = *file.root<mapped_vector>();
+	for (size_t it = 0; it < iterations; it++)
+	{
+		uint64_t sum = 0;
+		for (size_t i = 0; i < v.size(); i++)
+			sum += v[i];
+		TestsRunner::DoNotOptimize(sum);
+	}
+}
+
+#endif // COMPACT_VECTOR_HAS_MMAP
@@ -0,0 +1,66 @@
+// Бенчмарки перемещения векторов, как при перестройке хеш-таблицы или росте std::vector:
+// одна итерация переносит 100000 векторов (половина во встроенном буфере, половина в куче) в новый массив и обратно.
+
+#include "../compact_vector.h"
+#include "../tests/tests_runner.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+const size_t vector_count = 100000;
+
+template <class V, class Make>
+std::vector<V> make_vectors(Make make)
+{
+	std::vector<V> vectors(vector_count);
+	for (size_t i = 0; i < vector_count; i++)
+		for (size_t k = 0, n = i % 2 ? V::compact_capacity + 3 : V::compact_capacity - 1; k < n; k++)
+			vectors[i].push_back(make(i + k));
+	return vectors;
+}
+
+template <class V>
+void move_around(std::vector<V>& vectors, size_t iterations)
+{
+	std::vector<V> other;
+	other.reserve(vectors.size());
+	for (size_t it = 0; it < iterations; it++)
+	{
+		other.clear();
+		for (auto& v : vectors)
+			other.push_back(std::move(v));
+		for (size_t i = 0; i < other.size(); i++)
+			vectors[i] = std::move(other[i]);
+		TestsRunner::DoNotOptimize(vectors);
+	}
+}
+
+}
+
+COMPACT_VECTOR_BENCHMARK(move_vectors_uint32)
+{
+	static auto vectors = make_vectors<compact_vector<uint32_t, 4>>([](size_t i) { return static_cast<uint32_t>(i); });
+	move_around(vectors, iterations);
+}
+
+COMPACT_VECTOR_BENCHMARK(move_vectors_string)
+{
+	static auto vectors = make_vectors<compact_vector<std::string, 2>>([](size_t i) { return std::to_string(i); });
+	move_around(vectors, iterations);
+}
+
+COMPACT_VECTOR_BENCHMARK(move_vectors_swap_uint32)
+{
+	static auto vectors = make_vectors<compact_vector<uint32_t, 4>>([](size_t i) { return static_cast<uint32_t>(i); });
+	for (size_t it = 0; it < iterations; it++)
+	{
+		for (size_t i = 1; i < vectors.size(); i++)
+			vectors[i - 1].swap(vectors[i]);
+		TestsRunner::DoNotOptimize(vectors);
+	}
+}
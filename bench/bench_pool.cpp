@@ -0,0 +1,100 @@
+// Бенчмарки списков смежности: std::vector<compact_vector<uint32_t>> против compact_vector_pool.
+// Граф из 100000 вершин со степенями 0..15, ребра добавляются в случайном порядке вершин.
+// scan - одна итерация суммирует все ребра графа, build - одна итерация строит граф заново.
+
+#include "../compact_vector.h"
+#include "../compact_vector_pool.h"
+#include "../tests/tests_runner.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+const size_t vertex_count = 100000;
+
+const std::vector<std::pair<uint32_t, uint32_t>>& edges()
+{
+	static const std::vector<std::pair<uint32_t, uint32_t>> list = []
+	{
+		std::vector<std::pair<uint32_t, uint32_t>> e;
+		std::mt19937 random(11);
+		for (uint32_t v = 0; v < vertex_count; v++)
+			for (uint32_t d = random() % 16; d > 0; d--)
+				e.push_back(std::make_pair(v, static_cast<uint32_t>(random() % vertex_count)));
+		std::shuffle(e.begin(), e.end(), random);
+		return e;
+	}();
+	return list;
+}
+
+std::vector<compact_vector<uint32_t>> build_vectors()
+{
+	std::vector<compact_vector<uint32_t>> graph(vertex_count);
+	for (const auto& e : edges())
+		graph[e.first].push_back(e.second);
+	return graph;
+}
+
+compact_vector_pool<uint32_t> build_pool()
+{
+	compact_vector_pool<uint32_t> graph(vertex_count);
+	for (const auto& e : edges())
+		graph.push_back(e.first, e.second);
+	return graph;
+}
+
+}
+
+COMPACT_VECTOR_BENCHMARK(adjacency_build_vectors)
+{
+	for (size_t it = 0; it < iterations; it++)
+	{
+		auto graph = build_vectors();
+		TestsRunner::DoNotOptimize(graph);
+	}
+}
+
+COMPACT_VECTOR_BENCHMARK(adjacency_build_pool)
+{
+	for (size_t it = 0; it < iterations; it++)
+	{
+		auto graph = build_pool();
+		TestsRunner::DoNotOptimize(graph);
+	}
+}
+
+COMPACT_VECTOR_BENCHMARK(adjacency_scan_vectors)
+{
+	static const auto graph = build_vectors();
+	for (size_t it = 0; it < iterations; it++)
+	{
+		uint64_t sum = 0;
+		for (const auto& row : graph)
+			for (uint32_t v : row)
+				sum += v;
+		TestsRunner::DoNotOptimize(sum);
+	}
+}
+
+COMPACT_VECTOR_BENCHMARK(adjacency_scan_pool)
+{
+	static const auto view = []
+	{
+		auto graph = build_pool();
+		graph.shrink_to_fit();
+		return graph;
+	}();
+	for (size_t it = 0; it < iterations; it++)
+	{
+		uint64_t sum = 0;
+		for (size_t r = 0; r < view.size(); r++)
+			for (uint32_t v : view[r])
+				sum += v;
+		TestsRunner::DoNotOptimize(sum);
+	}
+}
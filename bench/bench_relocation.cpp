@@ -0,0 +1,37 @@
+// Бенчмарки роста буфера в куче: поэлементный перенос против побайтового
+// переноса (is_trivially_relocatable) и realloc_allocator. Одна итерация -
+// заполнение вектора из 4096 std::unique_ptr.
+
+#include "../compact_vector.h"
+#include "../realloc_allocator.h"
+#include "../tests/tests_runner.h"
+
+#include <memory>
+#include <string>
+
+namespace
+{
+
+template <class Container>
+void fill(size_t iterations)
+{
+	for (size_t it = 0; it < iterations; it++)
+	{
+		Container c;
+		for (int i = 0; i < 4096; i++)
+			c.emplace_back(nullptr);
+		TestsRunner::DoNotOptimize(c);
+	}
+}
+
+}
+
+COMPACT_VECTOR_BENCHMARK(grow_unique_ptr_std_allocator)
+{
+	fill<compact_vector<std::unique_ptr<int>, 2>>(iterations);
+}
+
+COMPACT_VECTOR_BENCHMARK(grow_unique_ptr_realloc_allocator)
+{
+	fill<compact_vector<std::unique_ptr<int>, 2, realloc_allocator<std::unique_ptr<int>>>>(iterations);
+}
@@ -0,0 +1,95 @@
+// Бенчмарки поиска: std::find через begin()/end() против compact_vector::find
+// (векторные ядра, развернутый цикл во встроенном буфере) и min() против std::min_element.
+// Искомое значение отсутствует, поэтому одна итерация - полный проход по контейнеру.
+
+#include "../compact_vector.h"
+#include "../tests/tests_runner.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace
+{
+
+template <class Vector>
+Vector make_ids(size_t count)
+{
+	Vector v;
+	for (size_t i = 0; i < count; i++)
+		v.push_back(static_cast<typename Vector::value_type>(i * 7 + 1));
+	return v;
+}
+
+template <class Vector>
+void std_find(const Vector& v, size_t iterations)
+{
+	for (size_t it = 0; it < iterations; it++)
+	{
+		auto value = static_cast<typename Vector::value_type>(it * 7);
+		auto i = std::find(v.begin(), v.end(), value);
+		TestsRunner::DoNotOptimize(i);
+	}
+}
+
+template <class Vector>
+void member_find(const Vector& v, size_t iterations)
+{
+	for (size_t it = 0; it < iterations; it++)
+	{
+		auto value = static_cast<typename Vector::value_type>(it * 7);
+		auto i = v.find(value);
+		TestsRunner::DoNotOptimize(i);
+	}
+}
+
+}
+
+COMPACT_VECTOR_BENCHMARK(search_std_find_u32_inline_16)
+{
+	std_find(make_ids<compact_vector<uint32_t, 16>>(16), iterations);
+}
+
+COMPACT_VECTOR_BENCHMARK(search_find_u32_inline_16)
+{
+	member_find(make_ids<compact_vector<uint32_t, 16>>(16), iterations);
+}
+
+COMPACT_VECTOR_BENCHMARK(search_std_find_u32_heap_1024)
+{
+	std_find(make_ids<compact_vector<uint32_t, 16>>(1024), iterations);
+}
+
+COMPACT_VECTOR_BENCHMARK(search_find_u32_heap_1024)
+{
+	member_find(make_ids<compact_vector<uint32_t, 16>>(1024), iterations);
+}
+
+COMPACT_VECTOR_BENCHMARK(search_std_find_u64_heap_1024)
+{
+	std_find(make_ids<compact_vector<uint64_t, 8>>(1024), iterations);
+}
+
+COMPACT_VECTOR_BENCHMARK(search_find_u64_heap_1024)
+{
+	member_find(make_ids<compact_vector<uint64_t, 8>>(1024), iterations);
+}
+
+COMPACT_VECTOR_BENCHMARK(search_std_min_element_u32_heap_1024)
+{
+	auto v = make_ids<compact_vector<uint32_t, 16>>(1024);
+	for (size_t it = 0; it < iterations; it++)
+	{
+		auto i = std::min_element(v.begin(), v.end());
+		TestsRunner::DoNotOptimize(i);
+	}
+}
+
+COMPACT_VECTOR_BENCHMARK(search_min_u32_heap_1024)
+{
+	auto v = make_ids<compact_vector<uint32_t, 16>>(1024);
+	for (size_t it = 0; it < iterations; it++)
+	{
+		const uint32_t* i = &v.min();
+		TestsRunner::DoNotOptimize(i);
+	}
+}
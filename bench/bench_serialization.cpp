@@ -0,0 +1,132 @@
+// Бенчмарки сериализации 64K записей compact_vector<uint32_t> по 1..8 элементов (большая часть
+// помещается во встроенный буфер): поэлементное копирование против compact_vector_writer
+// с пакетной записью, compact_vector_reader с одним memcpy на запись и чтения через представления.
+
+#include "../compact_vector_serialization.h"
+#include "../tests/tests_runner.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+
+using record = compact_vector<uint32_t>;
+
+const size_t record_count = 1 << 16;
+
+const std::vector<record>& records()
+{
+	static std::vector<record> result = []
+	{
+		std::vector<record> r(record_count);
+		for (size_t i = 0; i < record_count; i++)
+			for (size_t j = 0; j <= i % 8; j++)
+				r[i].push_back(static_cast<uint32_t>(i + j));
+		return r;
+	}();
+	return result;
+}
+
+// прежний способ: длина и каждый элемент дописываются по отдельности
+void write_elementwise(std::vector<unsigned char>& out, const record& r)
+{
+	uint32_t n = static_cast<uint32_t>(r.size());
+	out.insert(out.end(), reinterpret_cast<const unsigned char*>(&n), reinterpret_cast<const unsigned char*>(&n + 1));
+	for (uint32_t value : r)
+		out.insert(out.end(), reinterpret_cast<const unsigned char*>(&value), reinterpret_cast<const unsigned char*>(&value + 1));
+}
+
+const unsigned char* read_elementwise(const unsigned char* p, record& r)
+{
+	uint32_t n;
+	std::memcpy(&n, p, sizeof(n));
+	p += sizeof(n);
+	r.clear();
+	for (uint32_t i = 0; i < n; i++, p += sizeof(uint32_t))
+	{
+		uint32_t value;
+		std::memcpy(&value, p, sizeof(value));
+		r.push_back(value);
+	}
+	return p;
+}
+
+std::vector<unsigned char> encoded_records()
+{
+	std::vector<unsigned char> buffer;
+	compact_vector_writer<std::vector<unsigned char>> writer(buffer);
+	writer.write(records().begin(), records().end());
+	return buffer;
+}
+
+}
+
+COMPACT_VECTOR_BENCHMARK(serialize_64k_records_elementwise)
+{
+	const std::vector<record>& input = records();
+	std::vector<unsigned char> buffer;
+	for (size_t it = 0; it < iterations; it++)
+	{
+		buffer.clear();
+		for (const record& r : input)
+			write_elementwise(buffer, r);
+		TestsRunner::DoNotOptimize(buffer);
+	}
+}
+
+COMPACT_VECTOR_BENCHMARK(serialize_64k_records_writer_batch)
+{
+	const std::vector<record>& input = records();
+	std::vector<unsigned char> buffer;
+	for (size_t it = 0; it < iterations; it++)
+	{
+		buffer.clear();
+		compact_vector_writer<std::vector<unsigned char>> writer(buffer);
+		writer.write(input.begin(), input.end());
+		TestsRunner::DoNotOptimize(buffer);
+	}
+}
+
+COMPACT_VECTOR_BENCHMARK(deserialize_64k_records_elementwise)
+{
+	std::vector<unsigned char> buffer;
+	for (const record& r : records())
+		write_elementwise(buffer, r);
+
+	std::vector<record> output(record_count);
+	for (size_t it = 0; it < iterations; it++)
+	{
+		const unsigned char* p = buffer.data();
+		for (record& r : output)
+			p = read_elementwise(p, r);
+		TestsRunner::DoNotOptimize(output);
+	}
+}
+
+COMPACT_VECTOR_BENCHMARK(deserialize_64k_records_reader)
+{
+	std::vector<unsigned char> buffer = encoded_records();
+	std::vector<record> output(record_count);
+	for (size_t it = 0; it < iterations; it++)
+	{
+		compact_vector_reader reader(buffer.data(), buffer.size());
+		for (record& r : output)
+			reader.read(r);
+		TestsRunner::DoNotOptimize(output);
+	}
+}
+
+COMPACT_VECTOR_BENCHMARK(deserialize_64k_records_views_sum)
+{
+	std::vector<unsigned char> buffer = encoded_records();
+	for (size_t it = 0; it < iterations; it++)
+	{
+		compact_vector_reader reader(buffer.data(), buffer.size());
+		uint64_t sum = 0;
+		while (!reader.at_end())
+			for (uint32_t value : reader.read_view<uint32_t>())
+				sum += value;
+		TestsRunner::DoNotOptimize(sum);
+	}
+}
@@ -0,0 +1,58 @@
+// Бенчмарки снимков: копия compact_vector<uint32_t> из 10K элементов против shared_compact_vector,
+// у которого копия разделяет блок кучи, и цена первой записи в разделенную копию.
+
+#include "../shared_compact_vector.h"
+#include "../tests/tests_runner.h"
+
+#include <cstdint>
+
+namespace
+{
+
+const size_t element_count = 10000;
+
+template <class Vector>
+const Vector& source()
+{
+	static Vector result = []
+	{
+		Vector v;
+		for (size_t i = 0; i < element_count; i++)
+			v.push_back(static_cast<uint32_t>(i));
+		return v;
+	}();
+	return result;
+}
+
+}
+
+COMPACT_VECTOR_BENCHMARK(snapshot_10k_compact_vector_copy)
+{
+	const compact_vector<uint32_t>& v = source<compact_vector<uint32_t>>();
+	for (size_t it = 0; it < iterations; it++)
+	{
+		compact_vector<uint32_t> copy(v);
+		TestsRunner::DoNotOptimize(copy);
+	}
+}
+
+COMPACT_VECTOR_BENCHMARK(snapshot_10k_shared_copy)
+{
+	const shared_compact_vector<uint32_t>& v = source<shared_compact_vector<uint32_t>>();
+	for (size_t it = 0; it < iterations; it++)
+	{
+		shared_compact_vector<uint32_t> copy(v);
+		TestsRunner::DoNotOptimize(copy);
+	}
+}
+
+COMPACT_VECTOR_BENCHMARK(snapshot_10k_shared_copy_then_write)
+{
+	const shared_compact_vector<uint32_t>& v = source<shared_compact_vector<uint32_t>>();
+	for (size_t it = 0; it < iterations; it++)
+	{
+		shared_compact_vector<uint32_t> copy(v);
+		copy[0] = 1;
+		TestsRunner::DoNotOptimize(copy);
+	}
+}
@@ -0,0 +1,64 @@
+// Бенчмарки маленьких списков (id, weight, flags): compact_vector структур против compact_soa_vector.
+// 100000 списков по 0..7 строк, одна итерация суммирует только веса всех списков.
+
+#include "../compact_vector.h"
+#include "../compact_soa_vector.h"
+#include "../tests/tests_runner.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+const size_t list_count = 100000;
+
+struct entry
+{
+	uint32_t id;
+	float weight;
+	uint8_t flags;
+};
+
+using entry_list = compact_vector<entry, 4>;
+using entry_columns = basic_compact_soa_vector<4, std::allocator<unsigned char>, uint32_t, float, uint8_t>;
+
+template <class List, class Append>
+std::vector<List> build(Append append)
+{
+	std::vector<List> lists(list_count);
+	std::mt19937 random(3);
+	for (auto& list : lists)
+		for (uint32_t n = random() % 8; n > 0; n--)
+			append(list, static_cast<uint32_t>(random()), static_cast<float>(random() % 100), static_cast<uint8_t>(random()));
+	return lists;
+}
+
+}
+
+COMPACT_VECTOR_BENCHMARK(soa_scan_weights_struct)
+{
+	static const auto lists = build<entry_list>([](entry_list& l, uint32_t id, float w, uint8_t f) { l.push_back(entry{ id, w, f }); });
+	for (size_t it = 0; it < iterations; it++)
+	{
+		float sum = 0;
+		for (const auto& list : lists)
+			for (const auto& e : list)
+				sum += e.weight;
+		TestsRunner::DoNotOptimize(sum);
+	}
+}
+
+COMPACT_VECTOR_BENCHMARK(soa_scan_weights_columns)
+{
+	static const auto lists = build<entry_columns>([](entry_columns& l, uint32_t id, float w, uint8_t f) { l.push_back(id, w, f); });
+	for (size_t it = 0; it < iterations; it++)
+	{
+		float sum = 0;
+		for (const auto& list : lists)
+			for (float w : list.column<1>())
+				sum += w;
+		TestsRunner::DoNotOptimize(sum);
+	}
+}
@@ -0,0 +1,110 @@
+// Бенчмарки сортировки: compact_vector::sort против std::sort.
+// small - одна итерация сортирует 10000 списков uint32_t длиной 2..16 (копия исходных данных входит в замер у обоих),
+// large - одна итерация сортирует 100000 случайных uint64_t.
+
+#include "../compact_vector.h"
+#include "../tests/tests_runner.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+const size_t list_count = 10000;
+const size_t large_size = 100000;
+
+const std::vector<uint32_t>& small_values()
+{
+	static const std::vector<uint32_t> values = []
+	{
+		std::vector<uint32_t> v;
+		std::mt19937 random(21);
+		for (size_t i = 0; i < list_count * 16; i++)
+			v.push_back(random());
+		return v;
+	}();
+	return values;
+}
+
+const std::vector<uint32_t>& small_sizes()
+{
+	static const std::vector<uint32_t> sizes = []
+	{
+		std::vector<uint32_t> s;
+		std::mt19937 random(22);
+		for (size_t i = 0; i < list_count; i++)
+			s.push_back(2 + random() % 15);
+		return s;
+	}();
+	return sizes;
+}
+
+const std::vector<uint64_t>& large_values()
+{
+	static const std::vector<uint64_t> values = []
+	{
+		std::vector<uint64_t> v;
+		std::mt19937_64 random(23);
+		for (size_t i = 0; i < large_size; i++)
+			v.push_back(random());
+		return v;
+	}();
+	return values;
+}
+
+template <class Sort>
+void sort_small_lists(size_t iterations, Sort sort)
+{
+	const auto& values = small_values();
+	const auto& sizes = small_sizes();
+	compact_vector<uint32_t, 16> list;
+	for (size_t it = 0; it < iterations; it++)
+	{
+		uint32_t sum = 0;
+		for (size_t i = 0; i < list_count; i++)
+		{
+			const uint32_t* first = values.data() + i * 16;
+			list.assign(first, first + sizes[i]);
+			sort(list);
+			sum += list[0];
+		}
+		TestsRunner::DoNotOptimize(sum);
+	}
+}
+
+}
+
+COMPACT_VECTOR_BENCHMARK(sort_small_std_sort)
+{
+	sort_small_lists(iterations, [](compact_vector<uint32_t, 16>& v) { std::sort(v.begin(), v.end()); });
+}
+
+COMPACT_VECTOR_BENCHMARK(sort_small_compact_vector)
+{
+	sort_small_lists(iterations, [](compact_vector<uint32_t, 16>& v) { v.sort(); });
+}
+
+COMPACT_VECTOR_BENCHMARK(sort_large_std_sort)
+{
+	std::vector<uint64_t> v;
+	for (size_t it = 0; it < iterations; it++)
+	{
+		v = large_values();
+		std::sort(v.begin(), v.end());
+		TestsRunner::DoNotOptimize(v);
+	}
+}
+
+COMPACT_VECTOR_BENCHMARK(sort_large_compact_vector)
+{
+	compact_vector<uint64_t> v;
+	for (size_t it = 0; it < iterations; it++)
+	{
+		v.assign(large_values().begin(), large_values().end());
+		v.sort();
+		TestsRunner::DoNotOptimize(v);
+	}
+}
@@ -0,0 +1,111 @@
+// Бенчмарки строковых ключей: std::string против compact_string.
+// Ключи - 100000 строк длиной 8..31 символ, большая часть помещается в 23 символа compact_string,
+// но не в 15 символов std::string из libstdc++. build - одна итерация строит вектор ключей,
+// sort - сортирует его копию, lookup - ищет каждый ключ в unordered_set.
+
+#include "../compact_string.h"
+#include "../tests/tests_runner.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace
+{
+
+const std::vector<std::string>& source_keys()
+{
+	static const std::vector<std::string> keys = []
+	{
+		std::vector<std::string> k;
+		std::mt19937 random(17);
+		for (size_t i = 0; i < 100000; i++)
+		{
+			std::string key = "user:";
+			size_t length = 8 + random() % 24;
+			while (key.size() < length)
+				key.push_back(static_cast<char>('a' + random() % 26));
+			k.push_back(key);
+		}
+		return k;
+	}();
+	return keys;
+}
+
+template <class String>
+std::vector<String> build_keys()
+{
+	std::vector<String> keys;
+	keys.reserve(source_keys().size());
+	for (const auto& k : source_keys())
+		keys.emplace_back(k);
+	return keys;
+}
+
+template <class String>
+void bench_sort(size_t iterations)
+{
+	static const std::vector<String> keys = build_keys<String>();
+	for (size_t it = 0; it < iterations; it++)
+	{
+		std::vector<String> copy = keys;
+		std::sort(copy.begin(), copy.end());
+		TestsRunner::DoNotOptimize(copy);
+	}
+}
+
+template <class String>
+void bench_lookup(size_t iterations)
+{
+	static const std::vector<String> keys = build_keys<String>();
+	static const std::unordered_set<String> set(keys.begin(), keys.end());
+	for (size_t it = 0; it < iterations; it++)
+	{
+		size_t found = 0;
+		for (const auto& k : keys)
+			found += set.count(k);
+		TestsRunner::DoNotOptimize(found);
+	}
+}
+
+}
+
+COMPACT_VECTOR_BENCHMARK(string_keys_build_std_string)
+{
+	for (size_t it = 0; it < iterations; it++)
+	{
+		auto keys = build_keys<std::string>();
+		TestsRunner::DoNotOptimize(keys);
+	}
+}
+
+COMPACT_VECTOR_BENCHMARK(string_keys_build_compact_string)
+{
+	for (size_t it = 0; it < iterations; it++)
+	{
+		auto keys = build_keys<compact_string>();
+		TestsRunner::DoNotOptimize(keys);
+	}
+}
+
+COMPACT_VECTOR_BENCHMARK(string_keys_sort_std_string)
+{
+	bench_sort<std::string>(iterations);
+}
+
+COMPACT_VECTOR_BENCHMARK(string_keys_sort_compact_string)
+{
+	bench_sort<compact_string>(iterations);
+}
+
+COMPACT_VECTOR_BENCHMARK(string_keys_lookup_std_string)
+{
+	bench_lookup<std::string>(iterations);
+}
+
+COMPACT_VECTOR_BENCHMARK(string_keys_lookup_compact_string)
+{
+	bench_lookup<compact_string>(iterations);
+}
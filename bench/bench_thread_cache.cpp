@@ -0,0 +1,80 @@
+// Бенчмарки thread_cache_allocator против std::allocator на многопоточной нагрузке:
+// каждый поток создает и разрушает векторы, которые выходят из компактного режима,
+// а каждый четвертый вектор передается соседнему потоку и разрушается там.
+// Одна итерация - один вектор в каждом из четырех потоков.
+
+#include "../compact_vector.h"
+#include "../thread_cache_allocator.h"
+#include "../tests/tests_runner.h"
+
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+const size_t thread_count = 4;
+
+template <class Vector>
+struct mailbox
+{
+	std::mutex mutex;
+	std::vector<Vector> vectors;
+};
+
+template <class Vector>
+void churn(size_t iterations)
+{
+	std::vector<mailbox<Vector>> mailboxes(thread_count);
+	std::vector<std::thread> threads;
+
+	for (size_t t = 0; t < thread_count; t++)
+	{
+		threads.emplace_back([t, iterations, &mailboxes]
+		{
+			mailbox<Vector>& next = mailboxes[(t + 1) % thread_count];
+			mailbox<Vector>& own = mailboxes[t];
+			for (size_t it = 0; it < iterations; it++)
+			{
+				Vector v;
+				size_t count = 5 + it % 24;
+				for (size_t i = 0; i < count; i++)
+					v.push_back(static_cast<uint32_t>(i));
+				TestsRunner::DoNotOptimize(v);
+
+				if (it % 4 == 0)
+				{
+					std::lock_guard<std::mutex> lock(next.mutex);
+					next.vectors.push_back(std::move(v));
+				}
+
+				if (it % 64 == 0)
+				{
+					// чужие векторы разрушаются вне блокировки
+					std::vector<Vector> received;
+					{
+						std::lock_guard<std::mutex> lock(own.mutex);
+						received.swap(own.vectors);
+					}
+				}
+			}
+		});
+	}
+
+	for (auto& thread : threads)
+		thread.join();
+}
+
+}
+
+COMPACT_VECTOR_BENCHMARK(churn_4_threads_std_allocator)
+{
+	churn<compact_vector<uint32_t, 4>>(iterations);
+}
+
+COMPACT_VECTOR_BENCHMARK(churn_4_threads_thread_cache_allocator)
+{
+	churn<compact_vector<uint32_t, 4, thread_cache_allocator<uint32_t>>>(iterations);
+}
@@ -0,0 +1,186 @@
+// Эталонный small vector для сравнения в бенчмарках.
+// Раскладка как у llvm::SmallVector: указатель на данные, size, capacity
+// и отдельный встроенный буфер на N элементов. Реализован только тот
+// минимум интерфейса std::vector, который используют бенчмарки.
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+template <class T, size_t N>
+class inline_small_vector
+{
+public:
+	using value_type = T;
+	using iterator = T*;
+	using const_iterator = const T*;
+
+	inline_small_vector() noexcept
+	{}
+
+	inline_small_vector(size_t n, const T& val)
+	{
+		reserve(n);
+		for (size_t i = 0; i < n; i++)
+			::new(ptr + i) T(val);
+		count = n;
+	}
+
+	inline_small_vector(const inline_small_vector& x)
+	{
+		reserve(x.count);
+		for (size_t i = 0; i < x.count; i++)
+			::new(ptr + i) T(x.ptr[i]);
+		count = x.count;
+	}
+
+	inline_small_vector(inline_small_vector&& x) noexcept
+	{
+		steal(x);
+	}
+
+	~inline_small_vector()
+	{
+		destroy_all();
+	}
+
+	inline_small_vector& operator= (const inline_small_vector& x)
+	{
+		if (this != &x)
+		{
+			inline_small_vector tmp(x);
+			swap(tmp);
+		}
+		return *this;
+	}
+
+	inline_small_vector& operator= (inline_small_vector&& x) noexcept
+	{
+		if (this != &x)
+		{
+			destroy_all();
+			steal(x);
+		}
+		return *this;
+	}
+
+	T* begin() noexcept { return ptr; }
+	const T* begin() const noexcept { return ptr; }
+	T* end() noexcept { return ptr + count; }
+	const T* end() const noexcept { return ptr + count; }
+
+	size_t size() const noexcept { return count; }
+	size_t capacity() const noexcept { return cap; }
+
+	T& operator[] (size_t n) { return ptr[n]; }
+	const T& operator[] (size_t n) const { return ptr[n]; }
+
+	void reserve(size_t n)
+	{
+		if (n <= cap)
+			return;
+
+		T* p = static_cast<T*>(::operator new(n * sizeof(T)));
+		for (size_t i = 0; i < count; i++)
+		{
+			::new(p + i) T(std::move(ptr[i]));
+			ptr[i].~T();
+		}
+		if (!is_inline())
+			::operator delete(ptr);
+		ptr = p;
+		cap = n;
+	}
+
+	void push_back(const T& val)
+	{
+		emplace_back(val);
+	}
+
+	void push_back(T&& val)
+	{
+		emplace_back(std::move(val));
+	}
+
+	template <class... Args>
+	void emplace_back(Args&&... args)
+	{
+		if (count == cap)
+			reserve(2 * cap);
+		::new(ptr + count) T(std::forward<Args>(args)...);
+		count++;
+	}
+
+	T* insert(const T* position, const T& val)
+	{
+		size_t offset = position - ptr;
+		T tmp(val);
+		emplace_back(std::move(tmp));
+		for (size_t i = count - 1; i > offset; i--)
+			std::swap(ptr[i], ptr[i - 1]);
+		return ptr + offset;
+	}
+
+	T* erase(const T* position)
+	{
+		size_t offset = position - ptr;
+		for (size_t i = offset; i + 1 < count; i++)
+			ptr[i] = std::move(ptr[i + 1]);
+		ptr[--count].~T();
+		return ptr + offset;
+	}
+
+	void swap(inline_small_vector& x)
+	{
+		inline_small_vector tmp(std::move(x));
+		x = std::move(*this);
+		*this = std::move(tmp);
+	}
+
+private:
+	bool is_inline() const noexcept
+	{
+		return ptr == reinterpret_cast<const T*>(&buffer);
+	}
+
+	void destroy_all() noexcept
+	{
+		for (size_t i = 0; i < count; i++)
+			ptr[i].~T();
+		if (!is_inline())
+			::operator delete(ptr);
+		ptr = reinterpret_cast<T*>(&buffer);
+		count = 0;
+		cap = N;
+	}
+
+	void steal(inline_small_vector& x) noexcept
+	{
+		if (x.is_inline())
+		{
+			for (size_t i = 0; i < x.count; i++)
+			{
+				::new(ptr + i) T(std::move(x.ptr[i]));
+				x.ptr[i].~T();
+			}
+			count = x.count;
+		}
+		else
+		{
+			ptr = x.ptr;
+			count = x.count;
+			cap = x.cap;
+			x.ptr = reinterpret_cast<T*>(&x.buffer);
+			x.cap = N;
+		}
+		x.count = 0;
+	}
+
+	T* ptr = reinterpret_cast<T*>(&buffer);
+	size_t count = 0;
+	size_t cap = N;
+	typename std::aligned_storage<sizeof(T) * N, alignof(T)>::type buffer;
+};
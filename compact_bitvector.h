@@ -0,0 +1,568 @@
+#pragma once
+
+#include "compact_vector.h"
+#include "compact_vector_simd.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+/// compact_bitvector
+/*!
+Bit-packed companion of compact_vector<bool>: bits are stored in 64-bit words. On 64-bit targets
+the object takes 24 bytes like compact_vector: two inline words (128 bits) overlap the heap pointer
+and capacity, and the size word keeps the bit count with the heap flag in its top bit.
+Longer vectors spill to a heap buffer of words that grows by doubling.
+
+Bits past size() are always zero, so count(), any(), comparison and the bitwise operators work on
+whole words. In heap mode they use the compact_vector_simd word kernels; in compact mode they are
+two scalar word operations. operator[] is read-only, bits are changed with set(), reset() and flip().
+*/
+template <class allocator_type = std::allocator<uint64_t>>
+class basic_compact_bitvector : private allocator_type
+{
+	static_assert(std::is_same<typename allocator_type::value_type, uint64_t>::value, "compact_bitvector allocates uint64_t words");
+
+	using allocator_traits = std::allocator_traits<allocator_type>;
+
+public:
+	static constexpr size_t bits_per_word = 64;
+
+	static constexpr size_t compact_words = (sizeof(uint64_t*) + sizeof(size_t)) / sizeof(uint64_t);
+
+	/// bits kept inline, without a heap allocation
+	static constexpr size_t compact_capacity = compact_words * bits_per_word;
+
+	static constexpr size_t npos = static_cast<size_t>(-1);
+
+	explicit basic_compact_bitvector(const allocator_type& alloc = allocator_type()) :
+		allocator_type(alloc)
+	{
+		set_compact(0);
+	}
+
+	/// n bits equal to value
+	explicit basic_compact_bitvector(size_t n, bool value = false, const allocator_type& alloc = allocator_type()) :
+		allocator_type(alloc)
+	{
+		set_compact(0);
+		resize(n, value);
+	}
+
+	basic_compact_bitvector(const basic_compact_bitvector& x) :
+		allocator_type(allocator_traits::select_on_container_copy_construction(x.get_allocator()))
+	{
+		set_compact(0);
+		copy_from(x);
+	}
+
+	basic_compact_bitvector(basic_compact_bitvector&& x) noexcept :
+		allocator_type(x.get_allocator())
+	{
+		steal(x);
+	}
+
+	~basic_compact_bitvector()
+	{
+		release();
+	}
+
+	basic_compact_bitvector& operator= (const basic_compact_bitvector& x)
+	{
+		if (this != &x)
+		{
+			if (allocator_traits::propagate_on_container_copy_assignment::value && get_allocator() != x.get_allocator())
+			{
+				release();
+				set_compact(0);
+				allocator() = x.allocator();
+			}
+			copy_from(x);
+		}
+		return *this;
+	}
+
+	basic_compact_bitvector& operator= (basic_compact_bitvector&& x)
+	{
+		if (this != &x)
+		{
+			if (allocator_traits::propagate_on_container_move_assignment::value || get_allocator() == x.get_allocator())
+			{
+				release();
+				move_allocator(x, std::integral_constant<bool, allocator_traits::propagate_on_container_move_assignment::value>());
+				steal(x);
+			}
+			else
+			{
+				copy_from(x);
+			}
+		}
+		return *this;
+	}
+
+	allocator_type get_allocator() const noexcept
+	{
+		return allocator();
+	}
+
+	size_t size() const noexcept
+	{
+		return size_word & ~heap_flag;
+	}
+
+	bool empty() const noexcept
+	{
+		return size() == 0;
+	}
+
+	size_t capacity() const noexcept
+	{
+		return is_compact() ? compact_capacity : storage.heap.capacity * bits_per_word;
+	}
+
+	/// words holding size() bits
+	size_t word_count() const noexcept
+	{
+		return words_for(size());
+	}
+
+	/// the words, bit i is bit i % 64 of word i / 64
+	const uint64_t* data() const noexcept
+	{
+		return words();
+	}
+
+	bool operator[] (size_t i) const noexcept
+	{
+		return (words()[i / bits_per_word] >> (i % bits_per_word)) & 1;
+	}
+
+	bool test(size_t i) const
+	{
+		if (i >= size())
+			throw std::out_of_range(u8"compact_bitvector out of range");
+		return (*this)[i];
+	}
+
+	void set(size_t i, bool value = true) noexcept
+	{
+		uint64_t bit = uint64_t(1) << (i % bits_per_word);
+		uint64_t& w = words()[i / bits_per_word];
+		w = value ? (w | bit) : (w & ~bit);
+	}
+
+	void reset(size_t i) noexcept
+	{
+		words()[i / bits_per_word] &= ~(uint64_t(1) << (i % bits_per_word));
+	}
+
+	void flip(size_t i) noexcept
+	{
+		words()[i / bits_per_word] ^= uint64_t(1) << (i % bits_per_word);
+	}
+
+	/// sets all bits
+	void set() noexcept
+	{
+		size_t n = word_count();
+		if (n != 0)
+			std::memset(words(), 0xff, n * sizeof(uint64_t));
+		clear_tail();
+	}
+
+	/// clears all bits
+	void reset() noexcept
+	{
+		size_t n = word_count();
+		if (n != 0)
+			std::memset(words(), 0, n * sizeof(uint64_t));
+	}
+
+	/// flips all bits
+	void flip() noexcept
+	{
+		uint64_t* w = words();
+		for (size_t i = 0, n = word_count(); i < n; i++)
+			w[i] = ~w[i];
+		clear_tail();
+	}
+
+	void push_back(bool value)
+	{
+		size_t s = size();
+		if (s == capacity())
+			grow_words(compact_vector_growth::doubling::next_capacity(capacity(), s + 1, 1) / bits_per_word);
+
+		words()[s / bits_per_word] |= uint64_t(value) << (s % bits_per_word);
+		set_size(s + 1);
+	}
+
+	void pop_back() noexcept
+	{
+		size_t s = size() - 1;
+		reset(s);
+		set_size(s);
+	}
+
+	void resize(size_t n, bool value = false)
+	{
+		size_t s = size();
+		if (n < s)
+		{
+			set_size(n);
+			clear_tail();
+			size_t used = words_for(n);
+			size_t old_used = words_for(s);
+			if (old_used > used)
+				std::memset(words() + used, 0, (old_used - used) * sizeof(uint64_t));
+			return;
+		}
+
+		if (n > capacity())
+			grow_words(words_for(n));
+
+		set_size(n);
+		if (value)
+			set_range(s, n);
+	}
+
+	void reserve(size_t n)
+	{
+		if (n > capacity())
+			grow_words(words_for(n));
+	}
+
+	void clear() noexcept
+	{
+		reset();
+		set_size(0);
+	}
+
+	void shrink_to_fit()
+	{
+		if (is_compact())
+			return;
+
+		size_t s = size();
+		size_t used = words_for(s);
+		if (s <= compact_capacity)
+		{
+			uint64_t* heap = storage.heap.begin;
+			size_t heap_capacity = storage.heap.capacity;
+			uint64_t inline_words[compact_words] = {};
+			std::memcpy(inline_words, heap, used * sizeof(uint64_t));
+			allocator().deallocate(heap, heap_capacity);
+			std::memcpy(storage.compact, inline_words, sizeof(inline_words));
+			size_word = s;
+		}
+		else if (used < storage.heap.capacity)
+		{
+			relocate(used);
+		}
+	}
+
+	/// number of set bits
+	size_t count() const noexcept
+	{
+		if (is_compact())
+			return compact_count();
+		return compact_vector_simd::popcount_words(storage.heap.begin, word_count());
+	}
+
+	bool any() const noexcept
+	{
+		if (is_compact())
+			return compact_any();
+		size_t n = word_count();
+		return compact_vector_simd::find_nonzero_word(storage.heap.begin, n) != n;
+	}
+
+	bool none() const noexcept
+	{
+		return !any();
+	}
+
+	bool all() const noexcept
+	{
+		return count() == size();
+	}
+
+	/// index of the first set bit at or after from, or npos
+	size_t find_first(size_t from = 0) const noexcept
+	{
+		size_t s = size();
+		if (from >= s)
+			return npos;
+
+		const uint64_t* w = words();
+		size_t i = from / bits_per_word;
+		uint64_t first = w[i] & (~uint64_t(0) << (from % bits_per_word));
+		if (first != 0)
+			return i * bits_per_word + compact_vector_simd::lowest_bit(first);
+
+		size_t n = word_count();
+		size_t j = i + 1 + compact_vector_simd::find_nonzero_word(w + i + 1, n - i - 1);
+		return j == n ? npos : j * bits_per_word + compact_vector_simd::lowest_bit(w[j]);
+	}
+
+	/// the vectors have a common set bit
+	bool intersects(const basic_compact_bitvector& x) const noexcept
+	{
+		const uint64_t* a = words();
+		const uint64_t* b = x.words();
+		size_t n = std::min(word_count(), x.word_count());
+		for (size_t i = 0; i < n; i++)
+			if ((a[i] & b[i]) != 0)
+				return true;
+		return false;
+	}
+
+	/// bitwise operators keep size(); bits of x past it are ignored, missing bits of x are zero
+	basic_compact_bitvector& operator&= (const basic_compact_bitvector& x) noexcept
+	{
+		size_t n = word_count();
+		size_t m = std::min(n, x.word_count());
+		combine<compact_vector_simd::detail::and_words_op>(x, m);
+		if (n > m)
+			std::memset(words() + m, 0, (n - m) * sizeof(uint64_t));
+		return *this;
+	}
+
+	basic_compact_bitvector& operator|= (const basic_compact_bitvector& x) noexcept
+	{
+		combine<compact_vector_simd::detail::or_words_op>(x, std::min(word_count(), x.word_count()));
+		clear_tail();
+		return *this;
+	}
+
+	basic_compact_bitvector& operator^= (const basic_compact_bitvector& x) noexcept
+	{
+		combine<compact_vector_simd::detail::xor_words_op>(x, std::min(word_count(), x.word_count()));
+		clear_tail();
+		return *this;
+	}
+
+	/// clears the bits set in x
+	basic_compact_bitvector& and_not(const basic_compact_bitvector& x) noexcept
+	{
+		combine<compact_vector_simd::detail::and_not_words_op>(x, std::min(word_count(), x.word_count()));
+		return *this;
+	}
+
+	void swap(basic_compact_bitvector& x) noexcept
+	{
+		std::swap(storage, x.storage);
+		std::swap(size_word, x.size_word);
+		swap_allocators(x, std::integral_constant<bool, allocator_traits::propagate_on_container_swap::value>());
+	}
+
+	friend bool operator== (const basic_compact_bitvector& a, const basic_compact_bitvector& b) noexcept
+	{
+		return a.size() == b.size() && std::memcmp(a.words(), b.words(), a.word_count() * sizeof(uint64_t)) == 0;
+	}
+
+	friend bool operator!= (const basic_compact_bitvector& a, const basic_compact_bitvector& b) noexcept
+	{
+		return !(a == b);
+	}
+
+private:
+	static constexpr size_t heap_flag = ~(~size_t(0) >> 1);
+
+	union words_storage
+	{
+		uint64_t compact[compact_words];
+		struct
+		{
+			uint64_t* begin;
+			size_t capacity;
+		} heap;
+	};
+
+	words_storage storage;
+	size_t size_word;
+
+	static size_t words_for(size_t bits) noexcept
+	{
+		return (bits + bits_per_word - 1) / bits_per_word;
+	}
+
+	allocator_type& allocator() noexcept
+	{
+		return *this;
+	}
+
+	const allocator_type& allocator() const noexcept
+	{
+		return *this;
+	}
+
+	bool is_compact() const noexcept
+	{
+		return (size_word & heap_flag) == 0;
+	}
+
+	uint64_t* words() noexcept
+	{
+		return is_compact() ? storage.compact : storage.heap.begin;
+	}
+
+	const uint64_t* words() const noexcept
+	{
+		return is_compact() ? storage.compact : storage.heap.begin;
+	}
+
+	void set_compact(size_t n) noexcept
+	{
+		for (size_t i = 0; i < compact_words; i++)
+			storage.compact[i] = 0;
+		size_word = n;
+	}
+
+	void set_size(size_t n) noexcept
+	{
+		size_word = n | (size_word & heap_flag);
+	}
+
+	size_t compact_count() const noexcept
+	{
+		size_t count = 0;
+		for (size_t i = 0; i < compact_words; i++)
+			count += compact_vector_simd::bit_count(storage.compact[i]);
+		return count;
+	}
+
+	bool compact_any() const noexcept
+	{
+		uint64_t any = 0;
+		for (size_t i = 0; i < compact_words; i++)
+			any |= storage.compact[i];
+		return any != 0;
+	}
+
+	// обнуляет биты последнего слова за пределами size()
+	void clear_tail() noexcept
+	{
+		size_t s = size();
+		if (s % bits_per_word != 0)
+			words()[s / bits_per_word] &= (uint64_t(1) << (s % bits_per_word)) - 1;
+	}
+
+	// устанавливает биты [first, last) внутри емкости
+	void set_range(size_t first, size_t last) noexcept
+	{
+		uint64_t* w = words();
+		for (; first < last && first % bits_per_word != 0; first++)
+			w[first / bits_per_word] |= uint64_t(1) << (first % bits_per_word);
+		size_t full = (last - first) / bits_per_word;
+		if (full != 0)
+			std::memset(w + first / bits_per_word, 0xff, full * sizeof(uint64_t));
+		for (first += full * bits_per_word; first < last; first++)
+			w[first / bits_per_word] |= uint64_t(1) << (first % bits_per_word);
+	}
+
+	// во встроенном режиме два слова обрабатываются без диспетчеризации
+	template <class Op>
+	void combine(const basic_compact_bitvector& x, size_t n) noexcept
+	{
+		uint64_t* a = words();
+		const uint64_t* b = x.words();
+		if (is_compact())
+			compact_vector_simd::detail::combine_words_scalar<Op>(a, b, n);
+		else
+			compact_vector_simd::detail::combine_words_dispatch<Op>(a, b, n);
+	}
+
+	// новый буфер из capacity_words слов, неиспользуемые слова обнулены
+	void grow_words(size_t capacity_words)
+	{
+		relocate(capacity_words);
+	}
+
+	void relocate(size_t capacity_words)
+	{
+		size_t used = word_count();
+		uint64_t* heap = allocator().allocate(capacity_words);
+		std::memcpy(heap, words(), used * sizeof(uint64_t));
+		std::memset(heap + used, 0, (capacity_words - used) * sizeof(uint64_t));
+
+		size_t s = size();
+		release();
+		storage.heap.begin = heap;
+		storage.heap.capacity = capacity_words;
+		size_word = s | heap_flag;
+	}
+
+	void release() noexcept
+	{
+		if (!is_compact())
+			allocator().deallocate(storage.heap.begin, storage.heap.capacity);
+	}
+
+	void copy_from(const basic_compact_bitvector& x)
+	{
+		size_t n = x.size();
+		reset();
+		if (n > capacity())
+		{
+			set_size(0);
+			grow_words(words_for(n));
+		}
+		size_t used = words_for(n);
+		if (used != 0)
+			std::memcpy(words(), x.words(), used * sizeof(uint64_t));
+		set_size(n);
+	}
+
+	void steal(basic_compact_bitvector& x) noexcept
+	{
+		storage = x.storage;
+		size_word = x.size_word;
+		x.set_compact(0);
+	}
+
+	void move_allocator(basic_compact_bitvector& x, std::integral_constant<bool, true>)
+	{
+		allocator() = std::move(x.allocator());
+	}
+
+	void move_allocator(basic_compact_bitvector&, std::integral_constant<bool, false>)
+	{
+	}
+
+	void swap_allocators(basic_compact_bitvector& x, std::integral_constant<bool, true>)
+	{
+		using std::swap;
+		swap(allocator(), x.allocator());
+	}
+
+	void swap_allocators(basic_compact_bitvector&, std::integral_constant<bool, false>)
+	{
+	}
+};
+
+using compact_bitvector = basic_compact_bitvector<>;
+
+template <class A>
+basic_compact_bitvector<A> operator& (basic_compact_bitvector<A> a, const basic_compact_bitvector<A>& b)
+{
+	a &= b;
+	return a;
+}
+
+template <class A>
+basic_compact_bitvector<A> operator| (basic_compact_bitvector<A> a, const basic_compact_bitvector<A>& b)
+{
+	a |= b;
+	return a;
+}
+
+template <class A>
+basic_compact_bitvector<A> operator^ (basic_compact_bitvector<A> a, const basic_compact_bitvector<A>& b)
+{
+	a ^= b;
+	return a;
+}
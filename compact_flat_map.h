@@ -0,0 +1,763 @@
+#pragma once
+
+#include "compact_vector.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/// sorted flat containers
+/*!
+compact_flat_set keeps sorted unique keys in one compact_vector, compact_flat_map keeps sorted keys
+and their values in two parallel compact_vectors (structure of arrays), so a lookup scans only
+the dense key array. With compact_max_size chosen to cover the typical size, small sets and maps
+do not allocate at all.
+
+For arithmetic keys ordered by std::less the lower bound is found with a branchless linear count
+up to linear_search_limit keys and with a branchless binary search beyond it: the independent
+lookups then overlap in the pipeline instead of waiting on mispredicted branches. A vectorized count
+loses to the binary search already at 8 keys because of the dispatch call, so it is not used.
+Other keys use std::lower_bound.
+
+Insertion and erasure shift the tail of the arrays (memmove for trivially relocatable types), which is
+cheap at the sizes these containers are meant for. insert_sorted_range merges a sorted range in one pass.
+*/
+namespace compact_flat_detail
+{
+	/// keys up to which the lower bound is found by a linear count
+	static constexpr size_t linear_search_limit = 4;
+
+	template <class K, class Compare>
+	struct is_fast_search : std::integral_constant<bool, std::is_arithmetic<K>::value &&
+		(std::is_same<Compare, std::less<K>>::value || std::is_same<Compare, std::less<void>>::value)>
+	{};
+
+	// число ключей меньше key; для отсортированных ключей это и есть нижняя граница
+	template <class K>
+	size_t count_less(const K* keys, size_t n, K key) noexcept
+	{
+		size_t count = 0;
+		for (size_t i = 0; i < n; i++)
+			count += keys[i] < key;
+		return count;
+	}
+
+	// двоичный поиск без переходов: на каждом шаге база сдвигается условной пересылкой
+	template <class K>
+	size_t branchless_lower_bound(const K* keys, size_t n, K key) noexcept
+	{
+		if (n == 0)
+			return 0;
+
+		const K* base = keys;
+		while (n > 1)
+		{
+			size_t half = n / 2;
+			base = base[half] < key ? base + half : base;
+			n -= half;
+		}
+		return (base - keys) + (*base < key);
+	}
+
+	template <class K, class Compare>
+	size_t lower_bound(const K* keys, size_t n, const K& key, const Compare&, std::integral_constant<bool, true>) noexcept
+	{
+		return n <= linear_search_limit ? count_less(keys, n, key) : branchless_lower_bound(keys, n, key);
+	}
+
+	template <class K, class Compare>
+	size_t lower_bound(const K* keys, size_t n, const K& key, const Compare& compare, std::integral_constant<bool, false>)
+	{
+		return std::lower_bound(keys, keys + n, key, compare) - keys;
+	}
+
+	/// index of the first key not less than key
+	template <class K, class Compare>
+	size_t lower_bound(const K* keys, size_t n, const K& key, const Compare& compare)
+	{
+		return lower_bound(keys, n, key, compare, std::integral_constant<bool, is_fast_search<K, Compare>::value>());
+	}
+}
+
+/// compact_flat_set
+/*!
+Sorted set of unique keys stored in compact_vector<K, compact_max_size>.
+Iterators are const pointers into the key array and are invalidated by insertion and erasure.
+*/
+template <class K, int compact_max_size = -1, class Compare = std::less<K>, class allocator_type = std::allocator<K>>
+class compact_flat_set
+{
+public:
+	using key_type = K;
+	using value_type = K;
+	using key_compare = Compare;
+	using vector_type = compact_vector<K, compact_max_size, allocator_type>;
+	using iterator = const K*;
+	using const_iterator = const K*;
+
+	explicit compact_flat_set(const Compare& compare = Compare(), const allocator_type& alloc = allocator_type()) :
+		keys(alloc),
+		compare(compare)
+	{}
+
+	compact_flat_set(std::initializer_list<K> il, const Compare& compare = Compare(), const allocator_type& alloc = allocator_type()) :
+		keys(alloc),
+		compare(compare)
+	{
+		insert(il.begin(), il.end());
+	}
+
+	const_iterator begin() const noexcept
+	{
+		return keys.begin();
+	}
+
+	const_iterator end() const noexcept
+	{
+		return keys.end();
+	}
+
+	size_t size() const noexcept
+	{
+		return keys.size();
+	}
+
+	bool empty() const noexcept
+	{
+		return keys.empty();
+	}
+
+	void clear() noexcept
+	{
+		keys.clear();
+	}
+
+	void reserve(size_t n)
+	{
+		keys.reserve(n);
+	}
+
+	void shrink_to_fit()
+	{
+		keys.shrink_to_fit();
+	}
+
+	/// the sorted keys
+	const vector_type& data() const noexcept
+	{
+		return keys;
+	}
+
+	const_iterator lower_bound(const K& key) const
+	{
+		return begin() + lower_index(key);
+	}
+
+	const_iterator upper_bound(const K& key) const
+	{
+		return std::upper_bound(begin(), end(), key, compare);
+	}
+
+	const_iterator find(const K& key) const
+	{
+		size_t i = lower_index(key);
+		return i != size() && !compare(key, keys[i]) ? begin() + i : end();
+	}
+
+	bool contains(const K& key) const
+	{
+		return find(key) != end();
+	}
+
+	size_t count(const K& key) const
+	{
+		return contains(key) ? 1 : 0;
+	}
+
+	std::pair<const_iterator, bool> insert(const K& key)
+	{
+		size_t i = lower_index(key);
+		if (i != size() && !compare(key, keys[i]))
+			return std::make_pair(begin() + i, false);
+		keys.insert(keys.begin() + i, key);
+		return std::make_pair(begin() + i, true);
+	}
+
+	std::pair<const_iterator, bool> insert(K&& key)
+	{
+		size_t i = lower_index(key);
+		if (i != size() && !compare(key, keys[i]))
+			return std::make_pair(begin() + i, false);
+		keys.insert(keys.begin() + i, std::move(key));
+		return std::make_pair(begin() + i, true);
+	}
+
+	template <class... Args>
+	std::pair<const_iterator, bool> emplace(Args&&... args)
+	{
+		return insert(K(std::forward<Args>(args)...));
+	}
+
+	/// inserts keys of an unsorted range one by one
+	template <class InputIterator>
+	void insert(InputIterator first, InputIterator last)
+	{
+		for (; first != last; ++first)
+			insert(*first);
+	}
+
+	/// merges a range sorted by key_compare (duplicates allowed) in a single pass
+	template <class InputIterator>
+	void insert_sorted_range(InputIterator first, InputIterator last)
+	{
+		vector_type merged(keys.get_allocator());
+		merged.reserve(keys.size() + range_size(first, last, typename std::iterator_traits<InputIterator>::iterator_category()));
+
+		auto i = keys.begin();
+		while (i != keys.end() || first != last)
+		{
+			bool take_range = i == keys.end() || (first != last && compare(*first, *i));
+			const K& key = take_range ? *first : *i;
+			if (merged.empty() || compare(merged.back(), key))
+				merged.push_back(key);
+			if (take_range)
+				++first;
+			else
+				++i;
+		}
+		keys.swap(merged);
+	}
+
+	size_t erase(const K& key)
+	{
+		const_iterator i = find(key);
+		if (i == end())
+			return 0;
+		erase(i);
+		return 1;
+	}
+
+	const_iterator erase(const_iterator position)
+	{
+		return keys.erase(position);
+	}
+
+	const_iterator erase(const_iterator first, const_iterator last)
+	{
+		return keys.erase(first, last);
+	}
+
+	void swap(compact_flat_set& x)
+	{
+		keys.swap(x.keys);
+		std::swap(compare, x.compare);
+	}
+
+	key_compare key_comp() const
+	{
+		return compare;
+	}
+
+	friend bool operator== (const compact_flat_set& a, const compact_flat_set& b)
+	{
+		return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+	}
+
+	friend bool operator!= (const compact_flat_set& a, const compact_flat_set& b)
+	{
+		return !(a == b);
+	}
+
+private:
+	vector_type keys;
+	Compare compare;
+
+	size_t lower_index(const K& key) const
+	{
+		return compact_flat_detail::lower_bound(keys.data(), keys.size(), key, compare);
+	}
+
+	template <class InputIterator>
+	static size_t range_size(InputIterator first, InputIterator last, std::forward_iterator_tag)
+	{
+		return static_cast<size_t>(std::distance(first, last));
+	}
+
+	template <class InputIterator>
+	static size_t range_size(InputIterator, InputIterator, std::input_iterator_tag)
+	{
+		return 0;
+	}
+};
+
+/// compact_flat_map
+/*!
+Sorted map with keys and values in two parallel compact_vectors of compact_max_size elements each.
+Iterators dereference to std::pair<const K&, V&> and are invalidated by insertion and erasure;
+keys() and values() give direct access to the arrays.
+*/
+template <class K, class V, int compact_max_size = -1, class Compare = std::less<K>,
+	class key_allocator = std::allocator<K>, class value_allocator = std::allocator<V>>
+class compact_flat_map
+{
+public:
+	using key_type = K;
+	using mapped_type = V;
+	using value_type = std::pair<K, V>;
+	using key_compare = Compare;
+	using key_vector_type = compact_vector<K, compact_max_size, key_allocator>;
+	using value_vector_type = compact_vector<V, compact_max_size, value_allocator>;
+
+	template <bool is_const>
+	class basic_iterator
+	{
+	public:
+		using mapped_pointer = typename std::conditional<is_const, const V*, V*>::type;
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = std::pair<K, V>;
+		using difference_type = std::ptrdiff_t;
+		using reference = std::pair<const K&, typename std::conditional<is_const, const V&, V&>::type>;
+
+		struct pointer
+		{
+			reference value;
+
+			const reference* operator-> () const noexcept
+			{
+				return &value;
+			}
+		};
+
+		basic_iterator() noexcept :
+			key(nullptr),
+			mapped(nullptr)
+		{}
+
+		basic_iterator(const K* key, mapped_pointer mapped) noexcept :
+			key(key),
+			mapped(mapped)
+		{}
+
+		// iterator -> const_iterator
+		template <bool other_const, class = typename std::enable_if<is_const && !other_const>::type>
+		basic_iterator(const basic_iterator<other_const>& x) noexcept :
+			key(x.key),
+			mapped(x.mapped)
+		{}
+
+		reference operator* () const noexcept
+		{
+			return reference(*key, *mapped);
+		}
+
+		pointer operator-> () const noexcept
+		{
+			return pointer{**this};
+		}
+
+		reference operator[] (difference_type n) const noexcept
+		{
+			return reference(key[n], mapped[n]);
+		}
+
+		basic_iterator& operator++ () noexcept
+		{
+			++key;
+			++mapped;
+			return *this;
+		}
+
+		basic_iterator operator++ (int) noexcept
+		{
+			basic_iterator tmp = *this;
+			++*this;
+			return tmp;
+		}
+
+		basic_iterator& operator-- () noexcept
+		{
+			--key;
+			--mapped;
+			return *this;
+		}
+
+		basic_iterator operator-- (int) noexcept
+		{
+			basic_iterator tmp = *this;
+			--*this;
+			return tmp;
+		}
+
+		basic_iterator& operator+= (difference_type n) noexcept
+		{
+			key += n;
+			mapped += n;
+			return *this;
+		}
+
+		basic_iterator& operator-= (difference_type n) noexcept
+		{
+			key -= n;
+			mapped -= n;
+			return *this;
+		}
+
+		basic_iterator operator+ (difference_type n) const noexcept
+		{
+			return basic_iterator(key + n, mapped + n);
+		}
+
+		basic_iterator operator- (difference_type n) const noexcept
+		{
+			return basic_iterator(key - n, mapped - n);
+		}
+
+		difference_type operator- (const basic_iterator& x) const noexcept
+		{
+			return key - x.key;
+		}
+
+		bool operator== (const basic_iterator& x) const noexcept
+		{
+			return key == x.key;
+		}
+
+		bool operator!= (const basic_iterator& x) const noexcept
+		{
+			return key != x.key;
+		}
+
+		bool operator< (const basic_iterator& x) const noexcept
+		{
+			return key < x.key;
+		}
+
+	private:
+		template <bool>
+		friend class basic_iterator;
+
+		friend class compact_flat_map;
+
+		const K* key;
+		mapped_pointer mapped;
+	};
+
+	using iterator = basic_iterator<false>;
+	using const_iterator = basic_iterator<true>;
+
+	explicit compact_flat_map(const Compare& compare = Compare()) :
+		compare(compare)
+	{}
+
+	compact_flat_map(std::initializer_list<value_type> il, const Compare& compare = Compare()) :
+		compare(compare)
+	{
+		for (const auto& kv : il)
+			insert(kv.first, kv.second);
+	}
+
+	iterator begin() noexcept
+	{
+		return iterator(key_vector.data(), value_vector.data());
+	}
+
+	iterator end() noexcept
+	{
+		return begin() + size();
+	}
+
+	const_iterator begin() const noexcept
+	{
+		return const_iterator(key_vector.data(), value_vector.data());
+	}
+
+	const_iterator end() const noexcept
+	{
+		return begin() + size();
+	}
+
+	size_t size() const noexcept
+	{
+		return key_vector.size();
+	}
+
+	bool empty() const noexcept
+	{
+		return key_vector.empty();
+	}
+
+	void clear() noexcept
+	{
+		key_vector.clear();
+		value_vector.clear();
+	}
+
+	void reserve(size_t n)
+	{
+		key_vector.reserve(n);
+		value_vector.reserve(n);
+	}
+
+	void shrink_to_fit()
+	{
+		key_vector.shrink_to_fit();
+		value_vector.shrink_to_fit();
+	}
+
+	/// the sorted keys
+	const key_vector_type& keys() const noexcept
+	{
+		return key_vector;
+	}
+
+	/// the values, in the order of keys()
+	const value_vector_type& values() const noexcept
+	{
+		return value_vector;
+	}
+
+	iterator lower_bound(const K& key)
+	{
+		return begin() + lower_index(key);
+	}
+
+	const_iterator lower_bound(const K& key) const
+	{
+		return begin() + lower_index(key);
+	}
+
+	iterator find(const K& key)
+	{
+		size_t i = find_index(key);
+		return begin() + i;
+	}
+
+	const_iterator find(const K& key) const
+	{
+		size_t i = find_index(key);
+		return begin() + i;
+	}
+
+	bool contains(const K& key) const
+	{
+		return find_index(key) != size();
+	}
+
+	size_t count(const K& key) const
+	{
+		return contains(key) ? 1 : 0;
+	}
+
+	V& at(const K& key)
+	{
+		size_t i = find_index(key);
+		if (i == size())
+			throw std::out_of_range(u8"compact_flat_map: ключ не найден");
+		return value_vector[i];
+	}
+
+	const V& at(const K& key) const
+	{
+		size_t i = find_index(key);
+		if (i == size())
+			throw std::out_of_range(u8"compact_flat_map: ключ не найден");
+		return value_vector[i];
+	}
+
+	V& operator[] (const K& key)
+	{
+		return try_emplace(key).first->second;
+	}
+
+	/// inserts the value if the key is absent
+	template <class... Args>
+	std::pair<iterator, bool> try_emplace(const K& key, Args&&... args)
+	{
+		size_t i = lower_index(key);
+		if (i != size() && !compare(key, key_vector[i]))
+			return std::make_pair(begin() + i, false);
+		insert_at(i, key, std::forward<Args>(args)...);
+		return std::make_pair(begin() + i, true);
+	}
+
+	std::pair<iterator, bool> insert(const K& key, const V& value)
+	{
+		return try_emplace(key, value);
+	}
+
+	std::pair<iterator, bool> insert(const value_type& kv)
+	{
+		return try_emplace(kv.first, kv.second);
+	}
+
+	template <class M>
+	std::pair<iterator, bool> insert_or_assign(const K& key, M&& value)
+	{
+		size_t i = lower_index(key);
+		if (i != size() && !compare(key, key_vector[i]))
+		{
+			value_vector[i] = std::forward<M>(value);
+			return std::make_pair(begin() + i, false);
+		}
+		insert_at(i, key, std::forward<M>(value));
+		return std::make_pair(begin() + i, true);
+	}
+
+	/// merges a range of pairs sorted by key (the first of equal keys wins) in a single pass
+	/*!
+	The merged result is built aside and swapped in at the end, so an exception leaves the map unchanged.
+	Existing elements are moved only when nothing in the merge can throw after the first move.
+	*/
+	template <class InputIterator>
+	void insert_sorted_range(InputIterator first, InputIterator last)
+	{
+		using reference = typename std::iterator_traits<InputIterator>::reference;
+		using move_existing = std::integral_constant<bool,
+			std::is_nothrow_move_constructible<K>::value && std::is_nothrow_move_constructible<V>::value &&
+			std::is_nothrow_constructible<K, decltype(std::get<0>(std::declval<reference>()))>::value &&
+			std::is_nothrow_constructible<V, decltype(std::get<1>(std::declval<reference>()))>::value &&
+			std::is_base_of<std::forward_iterator_tag, typename std::iterator_traits<InputIterator>::iterator_category>::value>;
+
+		key_vector_type merged_keys(key_vector.get_allocator());
+		value_vector_type merged_values(value_vector.get_allocator());
+		size_t n = range_size(first, last, typename std::iterator_traits<InputIterator>::iterator_category());
+		merged_keys.reserve(size() + n);
+		merged_values.reserve(size() + n);
+
+		size_t i = 0;
+		while (i != size() || first != last)
+		{
+			bool take_range = i == size() || (first != last && compare(std::get<0>(*first), key_vector[i]));
+			if (take_range)
+			{
+				const auto& kv = *first;
+				if (merged_keys.empty() || compare(merged_keys.back(), std::get<0>(kv)))
+				{
+					merged_keys.push_back(std::get<0>(kv));
+					merged_values.push_back(std::get<1>(kv));
+				}
+				++first;
+			}
+			else
+			{
+				if (merged_keys.empty() || compare(merged_keys.back(), key_vector[i]))
+				{
+					merged_keys.push_back(take(key_vector[i], move_existing()));
+					merged_values.push_back(take(value_vector[i], move_existing()));
+				}
+				++i;
+			}
+		}
+		key_vector.swap(merged_keys);
+		value_vector.swap(merged_values);
+	}
+
+	size_t erase(const K& key)
+	{
+		size_t i = find_index(key);
+		if (i == size())
+			return 0;
+		erase_at(i);
+		return 1;
+	}
+
+	iterator erase(const_iterator position)
+	{
+		size_t i = position.key - key_vector.data();
+		erase_at(i);
+		return begin() + i;
+	}
+
+	void swap(compact_flat_map& x)
+	{
+		key_vector.swap(x.key_vector);
+		value_vector.swap(x.value_vector);
+		std::swap(compare, x.compare);
+	}
+
+	key_compare key_comp() const
+	{
+		return compare;
+	}
+
+	friend bool operator== (const compact_flat_map& a, const compact_flat_map& b)
+	{
+		return a.size() == b.size() &&
+			std::equal(a.key_vector.begin(), a.key_vector.end(), b.key_vector.begin()) &&
+			std::equal(a.value_vector.begin(), a.value_vector.end(), b.value_vector.begin());
+	}
+
+	friend bool operator!= (const compact_flat_map& a, const compact_flat_map& b)
+	{
+		return !(a == b);
+	}
+
+private:
+	key_vector_type key_vector;
+	value_vector_type value_vector;
+	Compare compare;
+
+	size_t lower_index(const K& key) const
+	{
+		return compact_flat_detail::lower_bound(key_vector.data(), key_vector.size(), key, compare);
+	}
+
+	// индекс ключа или size(), если его нет
+	size_t find_index(const K& key) const
+	{
+		size_t i = lower_index(key);
+		return i != size() && !compare(key, key_vector[i]) ? i : size();
+	}
+
+	// значение вставляется первым: если его конструктор бросит, массив ключей не изменится
+	template <class... Args>
+	void insert_at(size_t i, const K& key, Args&&... args)
+	{
+		value_vector.emplace(value_vector.begin() + i, std::forward<Args>(args)...);
+		try
+		{
+			key_vector.insert(key_vector.begin() + i, key);
+		}
+		catch (...)
+		{
+			value_vector.erase(value_vector.begin() + i);
+			throw;
+		}
+	}
+
+	void erase_at(size_t i)
+	{
+		key_vector.erase(key_vector.begin() + i);
+		value_vector.erase(value_vector.begin() + i);
+	}
+
+	template <class InputIterator>
+	static size_t range_size(InputIterator first, InputIterator last, std::forward_iterator_tag)
+	{
+		return static_cast<size_t>(std::distance(first, last));
+	}
+
+	template <class InputIterator>
+	static size_t range_size(InputIterator, InputIterator, std::input_iterator_tag)
+	{
+		return 0;
+	}
+
+	template <class T>
+	static T&& take(T& x, std::integral_constant<bool, true>) noexcept
+	{
+		return std::move(x);
+	}
+
+	template <class T>
+	static const T& take(T& x, std::integral_constant<bool, false>) noexcept
+	{
+		return x;
+	}
+};
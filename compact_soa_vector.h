@@ -0,0 +1,762 @@
+#pragma once
+
+#include "compact_vector.h"
+
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/// contiguous view of one column of compact_soa_vector
+template <class T>
+class compact_soa_span
+{
+public:
+	compact_soa_span(T* first, size_t size) noexcept :
+		first(first),
+		count(size)
+	{}
+
+	T* begin() const noexcept
+	{
+		return first;
+	}
+
+	T* end() const noexcept
+	{
+		return first + count;
+	}
+
+	T* data() const noexcept
+	{
+		return first;
+	}
+
+	size_t size() const noexcept
+	{
+		return count;
+	}
+
+	bool empty() const noexcept
+	{
+		return count == 0;
+	}
+
+	T& operator[] (size_t n) const
+	{
+		return first[n];
+	}
+
+private:
+	T* first;
+	size_t count;
+};
+
+namespace compact_soa_detail
+{
+	/// placement of the columns in a block of capacity rows
+	template <class... Ts>
+	struct columns
+	{
+		static constexpr size_t align_up(size_t offset, size_t alignment) noexcept
+		{
+			return (offset + alignment - 1) / alignment * alignment;
+		}
+
+		// смещение столбца k в блоке на capacity строк; при k == sizeof...(Ts) - размер блока
+		static constexpr size_t offset(size_t k, size_t capacity) noexcept
+		{
+			const size_t sizes[] = { sizeof(Ts)... };
+			const size_t alignments[] = { alignof(Ts)... };
+			size_t offset = 0;
+			for (size_t i = 0; i < k; i++)
+				offset = align_up(offset, alignments[i]) + sizes[i] * capacity;
+			return k < sizeof...(Ts) ? align_up(offset, alignments[k]) : offset;
+		}
+
+		/// alignment of the block: the largest of the columns and of a pointer
+		static constexpr size_t alignment() noexcept
+		{
+			const size_t alignments[] = { alignof(Ts)... };
+			size_t a = alignof(unsigned char*);
+			for (size_t i = 0; i < sizeof...(Ts); i++)
+				a = alignments[i] > a ? alignments[i] : a;
+			return a;
+		}
+
+		/// the number of rows that fit into bytes, at least one
+		static constexpr size_t default_capacity(size_t bytes) noexcept
+		{
+			size_t c = 1;
+			while (offset(sizeof...(Ts), c + 1) <= bytes)
+				c++;
+			return c;
+		}
+	};
+}
+
+/// compact_soa_vector
+/*!
+Vector of rows (Ts...) stored as a structure of arrays: every field is a column of its own, so a scan
+over one field reads only that field's bytes. The columns of up to compact_capacity rows live in an inline
+buffer that overlaps {block, capacity}, as in compact_vector_layout::standard, and the size word with the
+compact flag is the same size_allocator_pair. Past compact_capacity all columns move to a single heap block:
+column k starts at the aligned end of column k - 1, so one allocation serves the whole row set.
+
+With compact_max_size <= 0 the inline buffer holds as many rows as fit into 16 bytes (at least one).
+The fields must be trivially copyable: columns are moved with memcpy and memmove.
+column<I>() gives a contiguous span of field I, begin()/end() iterate over rows as std::tuple<Ts&...>.
+*/
+template <int compact_max_size, class allocator_type, class... Ts>
+class basic_compact_soa_vector
+{
+	static_assert(sizeof...(Ts) > 0, "compact_soa_vector requires at least one column");
+
+	template <class... Us>
+	struct all_trivially_copyable : std::true_type
+	{};
+
+	template <class U, class... Us>
+	struct all_trivially_copyable<U, Us...> : std::integral_constant<bool, std::is_trivially_copyable<U>::value && all_trivially_copyable<Us...>::value>
+	{};
+
+	static_assert(all_trivially_copyable<Ts...>::value, "compact_soa_vector requires trivially copyable columns");
+
+	using columns = compact_soa_detail::columns<Ts...>;
+
+	static constexpr size_t full_size = sizeof(unsigned char*) + sizeof(size_t);
+
+	static constexpr size_t storage_alignment = columns::alignment();
+
+	// блок кучи выделяется словами максимального выравнивания
+	struct alignas(storage_alignment) block_word
+	{
+		unsigned char bytes[storage_alignment];
+	};
+
+	using block_allocator = typename std::allocator_traits<allocator_type>::template rebind_alloc<block_word>;
+	using block_traits = std::allocator_traits<block_allocator>;
+	using size_allocator_pair = typename compact_vector_layout::standard<block_word, 1, block_allocator, size_t>::size_allocator_pair;
+
+public:
+	using value_type = std::tuple<Ts...>;
+	using reference = std::tuple<Ts&...>;
+	using const_reference = std::tuple<const Ts&...>;
+
+	static constexpr size_t column_count = sizeof...(Ts);
+
+	static constexpr size_t compact_capacity = compact_max_size <= 0 ? columns::default_capacity(full_size) : compact_max_size;
+
+	static constexpr size_t row_bytes = columns::offset(sizeof...(Ts), 1);
+
+	// в строках: блок на max_size строк не переполняет size_t
+	static constexpr size_t max_size = (std::numeric_limits<size_t>::max() >> 1) / row_bytes;
+
+	template <size_t I>
+	using column_type = typename std::tuple_element<I, value_type>::type;
+
+	/// zipped iterator over rows, dereferences to std::tuple<Ts&...>
+	template <bool is_const>
+	class basic_iterator
+	{
+	public:
+		using owner_pointer = typename std::conditional<is_const, const basic_compact_soa_vector*, basic_compact_soa_vector*>::type;
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = std::tuple<Ts...>;
+		using difference_type = std::ptrdiff_t;
+		using reference = typename std::conditional<is_const, std::tuple<const Ts&...>, std::tuple<Ts&...>>::type;
+		using pointer = void;
+
+		basic_iterator() noexcept :
+			owner(nullptr),
+			index(0)
+		{}
+
+		basic_iterator(owner_pointer owner, size_t index) noexcept :
+			owner(owner),
+			index(index)
+		{}
+
+		// iterator -> const_iterator
+		template <bool other_const, class = typename std::enable_if<is_const && !other_const>::type>
+		basic_iterator(const basic_iterator<other_const>& x) noexcept :
+			owner(x.owner),
+			index(x.index)
+		{}
+
+		reference operator* () const noexcept
+		{
+			return (*owner)[index];
+		}
+
+		reference operator[] (difference_type n) const noexcept
+		{
+			return (*owner)[index + n];
+		}
+
+		basic_iterator& operator++ () noexcept
+		{
+			++index;
+			return *this;
+		}
+
+		basic_iterator operator++ (int) noexcept
+		{
+			basic_iterator tmp = *this;
+			++index;
+			return tmp;
+		}
+
+		basic_iterator& operator-- () noexcept
+		{
+			--index;
+			return *this;
+		}
+
+		basic_iterator operator-- (int) noexcept
+		{
+			basic_iterator tmp = *this;
+			--index;
+			return tmp;
+		}
+
+		basic_iterator& operator+= (difference_type n) noexcept
+		{
+			index += n;
+			return *this;
+		}
+
+		basic_iterator& operator-= (difference_type n) noexcept
+		{
+			index -= n;
+			return *this;
+		}
+
+		basic_iterator operator+ (difference_type n) const noexcept
+		{
+			return basic_iterator(owner, index + n);
+		}
+
+		basic_iterator operator- (difference_type n) const noexcept
+		{
+			return basic_iterator(owner, index - n);
+		}
+
+		difference_type operator- (const basic_iterator& x) const noexcept
+		{
+			return static_cast<difference_type>(index) - static_cast<difference_type>(x.index);
+		}
+
+		bool operator== (const basic_iterator& x) const noexcept
+		{
+			return index == x.index;
+		}
+
+		bool operator!= (const basic_iterator& x) const noexcept
+		{
+			return index != x.index;
+		}
+
+		bool operator< (const basic_iterator& x) const noexcept
+		{
+			return index < x.index;
+		}
+
+		/// row number
+		size_t position() const noexcept
+		{
+			return index;
+		}
+
+	private:
+		template <bool>
+		friend class basic_iterator;
+
+		owner_pointer owner;
+		size_t index;
+	};
+
+	using iterator = basic_iterator<false>;
+	using const_iterator = basic_iterator<true>;
+
+	/// constructor: default
+	explicit basic_compact_soa_vector(const allocator_type& alloc = allocator_type()) :
+		size_allocator(block_allocator(alloc))
+	{}
+
+	/// constructor: fill
+	/*!
+	Constructs a container with n value-initialized rows.
+	*/
+	explicit basic_compact_soa_vector(size_t n, const allocator_type& alloc = allocator_type()) :
+		size_allocator(block_allocator(alloc))
+	{
+		resize(n);
+	}
+
+	/// constructor: copy
+	basic_compact_soa_vector(const basic_compact_soa_vector& x) :
+		size_allocator(block_traits::select_on_container_copy_construction(x.get_block_allocator()))
+	{
+		copy_rows(x);
+	}
+
+	/// constructor: move
+	/*!
+	Takes the heap block of x or copies its inline buffer; x is left empty and compact.
+	*/
+	basic_compact_soa_vector(basic_compact_soa_vector&& x) noexcept :
+		size_allocator(block_allocator(std::move(x.get_block_allocator())))
+	{
+		take_storage(x);
+	}
+
+	~basic_compact_soa_vector()
+	{
+		release();
+	}
+
+	basic_compact_soa_vector& operator= (const basic_compact_soa_vector& x)
+	{
+		if (this == &x)
+			return *this;
+		if (block_traits::propagate_on_container_copy_assignment::value && get_block_allocator() != x.get_block_allocator())
+		{
+			release();
+			get_block_allocator() = x.get_block_allocator();
+		}
+		set_size(0);
+		copy_rows(x);
+		return *this;
+	}
+
+	basic_compact_soa_vector& operator= (basic_compact_soa_vector&& x) noexcept(block_traits::propagate_on_container_move_assignment::value)
+	{
+		if (this == &x)
+			return *this;
+		if (block_traits::propagate_on_container_move_assignment::value || get_block_allocator() == x.get_block_allocator())
+		{
+			release();
+			if (block_traits::propagate_on_container_move_assignment::value)
+				get_block_allocator() = std::move(x.get_block_allocator());
+			take_storage(x);
+		}
+		else
+		{
+			set_size(0);
+			copy_rows(x);
+			x.set_size(0);
+		}
+		return *this;
+	}
+
+	allocator_type get_allocator() const noexcept
+	{
+		return allocator_type(get_block_allocator());
+	}
+
+	iterator begin() noexcept
+	{
+		return iterator(this, 0);
+	}
+
+	iterator end() noexcept
+	{
+		return iterator(this, size());
+	}
+
+	const_iterator begin() const noexcept
+	{
+		return const_iterator(this, 0);
+	}
+
+	const_iterator end() const noexcept
+	{
+		return const_iterator(this, size());
+	}
+
+	size_t size() const noexcept
+	{
+		return size_allocator.get_size();
+	}
+
+	bool empty() const noexcept
+	{
+		return size() == 0;
+	}
+
+	size_t capacity() const noexcept
+	{
+		return is_compact() ? compact_capacity : heap_capacity();
+	}
+
+	/// the rows are in the inline buffer
+	bool is_compact() const noexcept
+	{
+		return size_allocator.is_compact();
+	}
+
+	/// span of column I
+	template <size_t I>
+	compact_soa_span<column_type<I>> column() noexcept
+	{
+		return compact_soa_span<column_type<I>>(column_data<I>(), size());
+	}
+
+	template <size_t I>
+	compact_soa_span<const column_type<I>> column() const noexcept
+	{
+		return compact_soa_span<const column_type<I>>(column_data<I>(), size());
+	}
+
+	template <size_t I>
+	column_type<I>* column_data() noexcept
+	{
+		return reinterpret_cast<column_type<I>*>(base() + columns::offset(I, capacity()));
+	}
+
+	template <size_t I>
+	const column_type<I>* column_data() const noexcept
+	{
+		return reinterpret_cast<const column_type<I>*>(base() + columns::offset(I, capacity()));
+	}
+
+	reference operator[] (size_t n) noexcept
+	{
+		return row(n, std::index_sequence_for<Ts...>());
+	}
+
+	const_reference operator[] (size_t n) const noexcept
+	{
+		return row(n, std::index_sequence_for<Ts...>());
+	}
+
+	reference at(size_t n)
+	{
+		if (n >= size())
+			throw std::out_of_range(u8"compact_soa_vector out of range");
+		return (*this)[n];
+	}
+
+	const_reference at(size_t n) const
+	{
+		if (n >= size())
+			throw std::out_of_range(u8"compact_soa_vector out of range");
+		return (*this)[n];
+	}
+
+	reference front() noexcept
+	{
+		return (*this)[0];
+	}
+
+	reference back() noexcept
+	{
+		return (*this)[size() - 1];
+	}
+
+	/// appends a row; the values are taken by copy, so they may refer into this vector
+	void push_back(Ts... values)
+	{
+		size_t n = size();
+		if (n == capacity())
+			grow(n + 1);
+		store(n, std::index_sequence_for<Ts...>(), values...);
+		set_size(n + 1);
+	}
+
+	void push_back(const value_type& row)
+	{
+		push_back_tuple(row, std::index_sequence_for<Ts...>());
+	}
+
+	void pop_back() noexcept
+	{
+		set_size(size() - 1);
+	}
+
+	/// inserts a row before position
+	iterator insert(const_iterator position, Ts... values)
+	{
+		size_t index = position.position();
+		size_t n = size();
+		if (n == capacity())
+			grow(n + 1);
+		move_rows(index + 1, index, n - index, std::index_sequence_for<Ts...>());
+		store(index, std::index_sequence_for<Ts...>(), values...);
+		set_size(n + 1);
+		return begin() + index;
+	}
+
+	iterator erase(const_iterator position) noexcept
+	{
+		return erase(position, position + 1);
+	}
+
+	/// removes rows [first, last) from every column
+	iterator erase(const_iterator first, const_iterator last) noexcept
+	{
+		size_t from = first.position();
+		size_t to = last.position();
+		size_t n = size();
+		move_rows(from, to, n - to, std::index_sequence_for<Ts...>());
+		set_size(n - (to - from));
+		return begin() + from;
+	}
+
+	void clear() noexcept
+	{
+		set_size(0);
+	}
+
+	/// resizes to n rows, new rows are value-initialized
+	void resize(size_t n)
+	{
+		size_t old_size = size();
+		if (n > capacity())
+			reallocate(n);
+		if (n > old_size)
+			value_initialize(old_size, n - old_size, std::index_sequence_for<Ts...>());
+		set_size(n);
+	}
+
+	void reserve(size_t n)
+	{
+		if (n > capacity())
+			reallocate(n);
+	}
+
+	/// returns to the inline buffer if the rows fit, otherwise shrinks the heap block to size()
+	void shrink_to_fit()
+	{
+		if (is_compact() || size() == capacity())
+			return;
+		if (size() <= compact_capacity)
+			shrink_to_inline();
+		else
+			reallocate(size());
+	}
+
+	void swap(basic_compact_soa_vector& x) noexcept
+	{
+		swap_allocators(x, typename block_traits::propagate_on_container_swap());
+
+		// столбцы тривиально копируемы, поэтому вектора меняются побайтно вместе со словом размера
+		unsigned char tmp[region_size];
+		std::memcpy(tmp, region, region_size);
+		std::memcpy(region, x.region, region_size);
+		std::memcpy(x.region, tmp, region_size);
+
+		size_t s = size();
+		bool compact = is_compact();
+		size_allocator.set_size(x.size(), x.is_compact());
+		x.size_allocator.set_size(s, compact);
+	}
+
+	friend bool operator== (const basic_compact_soa_vector& a, const basic_compact_soa_vector& b)
+	{
+		return a.size() == b.size() && a.equal_columns(b, std::index_sequence_for<Ts...>());
+	}
+
+	friend bool operator!= (const basic_compact_soa_vector& a, const basic_compact_soa_vector& b)
+	{
+		return !(a == b);
+	}
+
+private:
+	static constexpr size_t required_size = columns::offset(sizeof...(Ts), compact_capacity);
+
+	static constexpr size_t region_size = columns::align_up(required_size > full_size ? required_size : full_size, storage_alignment);
+
+	alignas(storage_alignment) unsigned char region[region_size];
+
+	size_allocator_pair size_allocator;
+
+	block_allocator& get_block_allocator() noexcept
+	{
+		return size_allocator;
+	}
+
+	const block_allocator& get_block_allocator() const noexcept
+	{
+		return size_allocator;
+	}
+
+	void set_size(size_t n) noexcept
+	{
+		size_allocator.set_size(n, is_compact());
+	}
+
+	block_word* heap_block() const noexcept
+	{
+		block_word* block;
+		std::memcpy(&block, region, sizeof(block_word*));
+		return block;
+	}
+
+	size_t heap_capacity() const noexcept
+	{
+		size_t c;
+		std::memcpy(&c, region + sizeof(block_word*), sizeof(size_t));
+		return c;
+	}
+
+	void set_heap(block_word* block, size_t capacity, size_t n) noexcept
+	{
+		std::memcpy(region, &block, sizeof(block_word*));
+		std::memcpy(region + sizeof(block_word*), &capacity, sizeof(size_t));
+		size_allocator.set_size(n, false);
+	}
+
+	unsigned char* base() noexcept
+	{
+		return is_compact() ? region : reinterpret_cast<unsigned char*>(heap_block());
+	}
+
+	const unsigned char* base() const noexcept
+	{
+		return is_compact() ? region : reinterpret_cast<const unsigned char*>(heap_block());
+	}
+
+	static size_t block_words(size_t capacity) noexcept
+	{
+		return (columns::offset(sizeof...(Ts), capacity) + sizeof(block_word) - 1) / sizeof(block_word);
+	}
+
+	template <size_t... I>
+	reference row(size_t n, std::index_sequence<I...>) noexcept
+	{
+		return reference(column_data<I>()[n]...);
+	}
+
+	template <size_t... I>
+	const_reference row(size_t n, std::index_sequence<I...>) const noexcept
+	{
+		return const_reference(column_data<I>()[n]...);
+	}
+
+	template <size_t... I>
+	void store(size_t n, std::index_sequence<I...>, const Ts&... values) noexcept
+	{
+		int expand[] = { (column_data<I>()[n] = values, 0)... };
+		(void)expand;
+	}
+
+	template <size_t... I>
+	void push_back_tuple(const value_type& row, std::index_sequence<I...>)
+	{
+		push_back(std::get<I>(row)...);
+	}
+
+	// сдвиг count строк с позиции from на позицию to во всех столбцах
+	template <size_t... I>
+	void move_rows(size_t to, size_t from, size_t count, std::index_sequence<I...>) noexcept
+	{
+		int expand[] = { (std::memmove(column_data<I>() + to, column_data<I>() + from, count * sizeof(column_type<I>)), 0)... };
+		(void)expand;
+	}
+
+	template <size_t... I>
+	void value_initialize(size_t from, size_t count, std::index_sequence<I...>) noexcept
+	{
+		int expand[] = { (value_initialize_column(column_data<I>() + from, count), 0)... };
+		(void)expand;
+	}
+
+	template <class T>
+	static void value_initialize_column(T* first, size_t count) noexcept
+	{
+		for (size_t i = 0; i < count; i++)
+			::new (static_cast<void*>(first + i)) T();
+	}
+
+	template <size_t... I>
+	static void copy_columns(unsigned char* to, size_t to_capacity, const unsigned char* from, size_t from_capacity, size_t count, std::index_sequence<I...>) noexcept
+	{
+		int expand[] = { (count == 0 ? nullptr : std::memcpy(to + columns::offset(I, to_capacity), from + columns::offset(I, from_capacity), count * sizeof(column_type<I>)), 0)... };
+		(void)expand;
+	}
+
+	template <size_t... I>
+	bool equal_columns(const basic_compact_soa_vector& x, std::index_sequence<I...>) const
+	{
+		bool equal = true;
+		int expand[] = { (equal = equal && std::equal(column_data<I>(), column_data<I>() + size(), x.template column_data<I>()), 0)... };
+		(void)expand;
+		return equal;
+	}
+
+	void grow(size_t required)
+	{
+		size_t c = compact_vector_growth::doubling::next_capacity(capacity(), required, row_bytes);
+		reallocate(c > max_size && required <= max_size ? required : c);
+	}
+
+	// все столбцы переписываются в блок кучи на new_capacity строк, new_capacity > compact_capacity
+	void reallocate(size_t new_capacity)
+	{
+		if (new_capacity > max_size)
+			throw std::length_error(u8"попытка выделить памяти больше чем max_size()");
+
+		size_t n = size();
+		size_t old_capacity = capacity();
+		block_word* block = block_traits::allocate(get_block_allocator(), block_words(new_capacity));
+		copy_columns(reinterpret_cast<unsigned char*>(block), new_capacity, base(), old_capacity, n, std::index_sequence_for<Ts...>());
+		release();
+		set_heap(block, new_capacity, n);
+	}
+
+	// возврат строк из кучи во встроенный буфер, только для shrink_to_fit
+	void shrink_to_inline() noexcept
+	{
+		size_t n = size();
+		block_word* block = heap_block();
+		size_t old_capacity = heap_capacity();
+		copy_columns(region, compact_capacity, reinterpret_cast<unsigned char*>(block), old_capacity, n, std::index_sequence_for<Ts...>());
+		block_traits::deallocate(get_block_allocator(), block, block_words(old_capacity));
+		size_allocator.set_size(n, true);
+	}
+
+	void release() noexcept
+	{
+		if (!is_compact())
+		{
+			block_traits::deallocate(get_block_allocator(), heap_block(), block_words(heap_capacity()));
+			size_allocator.set_size(size(), true);
+		}
+	}
+
+	void copy_rows(const basic_compact_soa_vector& x)
+	{
+		size_t n = x.size();
+		if (n > capacity())
+			reallocate(n);
+		copy_columns(base(), capacity(), x.base(), x.capacity(), n, std::index_sequence_for<Ts...>());
+		set_size(n);
+	}
+
+	// x остается пустым встроенным вектором
+	void take_storage(basic_compact_soa_vector& x) noexcept
+	{
+		std::memcpy(region, x.region, region_size);
+		size_allocator.set_size(x.size(), x.is_compact());
+		x.size_allocator.set_size(0, true);
+	}
+
+	void swap_allocators(basic_compact_soa_vector& x, std::true_type) noexcept
+	{
+		using std::swap;
+		swap(get_block_allocator(), x.get_block_allocator());
+	}
+
+	void swap_allocators(basic_compact_soa_vector&, std::false_type) noexcept
+	{}
+};
+
+template <class... Ts>
+using compact_soa_vector = basic_compact_soa_vector<-1, std::allocator<unsigned char>, Ts...>;
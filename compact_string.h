@@ -0,0 +1,567 @@
+#pragma once
+
+#include "compact_vector.h"
+
+#include <cstring>
+#include <functional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+/// compact_string
+/*!
+Null-terminated string on top of compact_vector<char> with the tail_size layout.
+On 64-bit targets the object takes 24 bytes and keeps up to 23 chars inline: the last byte
+counts the free inline chars, so for a 23-char string it is zero and serves as the terminator.
+On the heap the buffer always has room for the terminator after size() chars.
+
+Conversion to std::string_view is a pointer and a size, find() uses memchr, ordering compares
+the first 8 bytes as one word before memcmp and std::hash is the std::string_view hash.
+Requires C++17.
+*/
+template <class allocator_type = std::allocator<char>>
+class basic_compact_string
+{
+	using chars_type = compact_vector<char, -1, allocator_type, compact_vector_growth::doubling, compact_vector_layout::tail_size>;
+
+public:
+	using value_type = char;
+	using size_type = size_t;
+	using iterator = char*;
+	using const_iterator = const char*;
+
+	static constexpr size_t npos = std::string_view::npos;
+
+	/// chars kept inline, without a heap allocation
+	static constexpr size_t compact_capacity = chars_type::compact_capacity;
+
+	explicit basic_compact_string(const allocator_type& alloc = allocator_type()) :
+		chars(alloc)
+	{
+		terminate();
+	}
+
+	basic_compact_string(const char* s, const allocator_type& alloc = allocator_type()) :
+		basic_compact_string(std::string_view(s), alloc)
+	{}
+
+	basic_compact_string(const char* s, size_t n, const allocator_type& alloc = allocator_type()) :
+		basic_compact_string(std::string_view(s, n), alloc)
+	{}
+
+	basic_compact_string(size_t n, char c, const allocator_type& alloc = allocator_type()) :
+		chars(alloc)
+	{
+		resize(n, c);
+	}
+
+	explicit basic_compact_string(std::string_view s, const allocator_type& alloc = allocator_type()) :
+		chars(alloc)
+	{
+		reserve(s.size());
+		append(s);
+	}
+
+	basic_compact_string(const std::string& s, const allocator_type& alloc = allocator_type()) :
+		basic_compact_string(std::string_view(s), alloc)
+	{}
+
+	// копирование compact_vector резервирует ровно size() элементов, а нужно место под терминатор
+	basic_compact_string(const basic_compact_string& x) :
+		chars(std::allocator_traits<allocator_type>::select_on_container_copy_construction(x.chars.get_allocator()))
+	{
+		reserve(x.size());
+		append(x.view());
+	}
+
+	basic_compact_string(basic_compact_string&& x) noexcept :
+		chars(std::move(x.chars))
+	{
+		x.terminate();
+	}
+
+	basic_compact_string& operator= (const basic_compact_string& x)
+	{
+		if (this != &x)
+			assign(x.view());
+		return *this;
+	}
+
+	basic_compact_string& operator= (basic_compact_string&& x)
+	{
+		if (this != &x)
+		{
+			// при неравных аллокаторах элементы переносятся в буфер ровно на size() элементов
+			chars = std::move(x.chars);
+			grow_for(size());
+			terminate();
+			x.terminate();
+		}
+		return *this;
+	}
+
+	basic_compact_string& operator= (std::string_view s)
+	{
+		return assign(s);
+	}
+
+	basic_compact_string& operator= (const char* s)
+	{
+		return assign(std::string_view(s));
+	}
+
+	basic_compact_string& assign(std::string_view s)
+	{
+		// s может указывать внутрь этой строки
+		if (s.data() >= chars.data() && s.data() < chars.data() + chars.size())
+		{
+			basic_compact_string copy(s, chars.get_allocator());
+			return *this = std::move(copy);
+		}
+
+		chars.clear();
+		return append(s);
+	}
+
+	const char* c_str() const noexcept
+	{
+		return chars.data();
+	}
+
+	const char* data() const noexcept
+	{
+		return chars.data();
+	}
+
+	char* data() noexcept
+	{
+		return chars.data();
+	}
+
+	std::string_view view() const noexcept
+	{
+		return std::string_view(chars.data(), chars.size());
+	}
+
+	operator std::string_view() const noexcept
+	{
+		return view();
+	}
+
+	std::string str() const
+	{
+		return std::string(chars.data(), chars.size());
+	}
+
+	size_t size() const noexcept
+	{
+		return chars.size();
+	}
+
+	size_t length() const noexcept
+	{
+		return chars.size();
+	}
+
+	bool empty() const noexcept
+	{
+		return chars.empty();
+	}
+
+	/// chars that fit without reallocation
+	size_t capacity() const noexcept
+	{
+		return chars.capacity() == compact_capacity ? compact_capacity : chars.capacity() - 1;
+	}
+
+	allocator_type get_allocator() const noexcept
+	{
+		return chars.get_allocator();
+	}
+
+	iterator begin() noexcept
+	{
+		return chars.begin();
+	}
+
+	iterator end() noexcept
+	{
+		return chars.end();
+	}
+
+	const_iterator begin() const noexcept
+	{
+		return chars.begin();
+	}
+
+	const_iterator end() const noexcept
+	{
+		return chars.end();
+	}
+
+	char& operator[] (size_t n)
+	{
+		return chars[n];
+	}
+
+	const char& operator[] (size_t n) const
+	{
+		return chars[n];
+	}
+
+	char& at(size_t n)
+	{
+		if (n >= size())
+			throw std::out_of_range(u8"compact_string out of range");
+		return chars[n];
+	}
+
+	const char& at(size_t n) const
+	{
+		if (n >= size())
+			throw std::out_of_range(u8"compact_string out of range");
+		return chars[n];
+	}
+
+	char& front()
+	{
+		return chars.front();
+	}
+
+	const char& front() const
+	{
+		return chars.front();
+	}
+
+	char& back()
+	{
+		return chars.back();
+	}
+
+	const char& back() const
+	{
+		return chars.back();
+	}
+
+	void reserve(size_t n)
+	{
+		if (!fits(n))
+			chars.reserve(n + 1);
+	}
+
+	void shrink_to_fit()
+	{
+		if (size() <= compact_capacity)
+		{
+			chars.shrink_to_fit();
+			terminate();
+		}
+		else if (chars.capacity() > size() + 1)
+		{
+			basic_compact_string copy(chars.get_allocator());
+			copy.reserve(size());
+			copy.append(view());
+			chars.swap(copy.chars);
+		}
+	}
+
+	void clear() noexcept
+	{
+		chars.clear();
+		terminate();
+	}
+
+	void push_back(char c)
+	{
+		grow_for(size() + 1);
+		chars.push_back(c);
+		terminate();
+	}
+
+	void pop_back()
+	{
+		chars.pop_back();
+		terminate();
+	}
+
+	void resize(size_t n, char c = '\0')
+	{
+		grow_for(n);
+		chars.resize(n, c);
+		terminate();
+	}
+
+	basic_compact_string& append(std::string_view s)
+	{
+		if (s.empty())
+		{
+			terminate();
+			return *this;
+		}
+
+		if (s.data() >= chars.data() && s.data() < chars.data() + chars.size())
+		{
+			// s указывает внутрь строки и может переехать при росте
+			size_t offset = s.data() - chars.data();
+			grow_for(size() + s.size());
+			s = std::string_view(chars.data() + offset, s.size());
+		}
+		else
+		{
+			grow_for(size() + s.size());
+		}
+
+		chars.insert(chars.end(), s.data(), s.data() + s.size());
+		terminate();
+		return *this;
+	}
+
+	basic_compact_string& append(const char* s, size_t n)
+	{
+		return append(std::string_view(s, n));
+	}
+
+	basic_compact_string& append(size_t n, char c)
+	{
+		grow_for(size() + n);
+		chars.insert(chars.end(), n, c);
+		terminate();
+		return *this;
+	}
+
+	basic_compact_string& operator+= (std::string_view s)
+	{
+		return append(s);
+	}
+
+	basic_compact_string& operator+= (const char* s)
+	{
+		return append(std::string_view(s));
+	}
+
+	basic_compact_string& operator+= (char c)
+	{
+		push_back(c);
+		return *this;
+	}
+
+	/// erases count chars starting at pos (up to the end by default)
+	basic_compact_string& erase(size_t pos = 0, size_t count = npos)
+	{
+		if (pos > size())
+			throw std::out_of_range(u8"compact_string out of range");
+
+		size_t n = std::min(count, size() - pos);
+		chars.erase(chars.begin() + pos, chars.begin() + pos + n);
+		terminate();
+		return *this;
+	}
+
+	basic_compact_string substr(size_t pos = 0, size_t count = npos) const
+	{
+		if (pos > size())
+			throw std::out_of_range(u8"compact_string out of range");
+		return basic_compact_string(view().substr(pos, count), chars.get_allocator());
+	}
+
+	size_t find(char c, size_t pos = 0) const noexcept
+	{
+		if (pos >= size())
+			return npos;
+		const void* p = std::memchr(chars.data() + pos, c, size() - pos);
+		return p == nullptr ? npos : static_cast<const char*>(p) - chars.data();
+	}
+
+	size_t find(std::string_view s, size_t pos = 0) const noexcept
+	{
+		return view().find(s, pos);
+	}
+
+	size_t rfind(char c, size_t pos = npos) const noexcept
+	{
+		return view().rfind(c, pos);
+	}
+
+	size_t rfind(std::string_view s, size_t pos = npos) const noexcept
+	{
+		return view().rfind(s, pos);
+	}
+
+	bool contains(char c) const noexcept
+	{
+		return find(c) != npos;
+	}
+
+	bool contains(std::string_view s) const noexcept
+	{
+		return find(s) != npos;
+	}
+
+	bool starts_with(std::string_view s) const noexcept
+	{
+		return size() >= s.size() && std::memcmp(chars.data(), s.data(), s.size()) == 0;
+	}
+
+	bool ends_with(std::string_view s) const noexcept
+	{
+		return size() >= s.size() && std::memcmp(chars.data() + size() - s.size(), s.data(), s.size()) == 0;
+	}
+
+	/// lexicographic comparison; the first 8 bytes are compared as one big-endian word
+	int compare(std::string_view s) const noexcept
+	{
+		return compare(view(), s);
+	}
+
+	static int compare(std::string_view a, std::string_view b) noexcept
+	{
+		size_t n = a.size() < b.size() ? a.size() : b.size();
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+		// ключи обычно различаются в первых байтах, и сравнение слов обходится без вызова memcmp
+		if (n >= sizeof(uint64_t))
+		{
+			uint64_t x, y;
+			std::memcpy(&x, a.data(), sizeof(x));
+			std::memcpy(&y, b.data(), sizeof(y));
+			if (x != y)
+				return __builtin_bswap64(x) < __builtin_bswap64(y) ? -1 : 1;
+		}
+#endif
+		int r = std::memcmp(a.data(), b.data(), n);
+		if (r != 0)
+			return r;
+		return a.size() < b.size() ? -1 : (a.size() > b.size() ? 1 : 0);
+	}
+
+	void swap(basic_compact_string& x)
+	{
+		chars.swap(x.chars);
+	}
+
+	friend void swap(basic_compact_string& a, basic_compact_string& b)
+	{
+		a.swap(b);
+	}
+
+private:
+	chars_type chars;
+
+	// n символов и терминатор помещаются без роста; заполненный встроенный буфер завершается
+	// нулевым счетчиком свободного места в последнем байте
+	bool fits(size_t n) const noexcept
+	{
+		return n < chars.capacity() || n == compact_capacity;
+	}
+
+	// рост с удвоением, как у compact_vector, но с местом под терминатор
+	void grow_for(size_t n)
+	{
+		if (fits(n))
+			return;
+		chars.reserve(compact_vector_growth::doubling::next_capacity(chars.capacity(), n + 1, sizeof(char)));
+	}
+
+	void terminate() noexcept
+	{
+		size_t n = chars.size();
+		if (n < chars.capacity())
+			chars.data()[n] = '\0';
+	}
+};
+
+using compact_string = basic_compact_string<>;
+
+template <class A>
+bool operator== (const basic_compact_string<A>& a, const basic_compact_string<A>& b) noexcept
+{
+	return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size()) == 0;
+}
+
+template <class A>
+bool operator== (const basic_compact_string<A>& a, std::string_view b) noexcept
+{
+	return a.view() == b;
+}
+
+template <class A>
+bool operator== (std::string_view a, const basic_compact_string<A>& b) noexcept
+{
+	return a == b.view();
+}
+
+template <class A>
+bool operator!= (const basic_compact_string<A>& a, const basic_compact_string<A>& b) noexcept
+{
+	return !(a == b);
+}
+
+template <class A>
+bool operator!= (const basic_compact_string<A>& a, std::string_view b) noexcept
+{
+	return !(a == b);
+}
+
+template <class A>
+bool operator!= (std::string_view a, const basic_compact_string<A>& b) noexcept
+{
+	return !(a == b);
+}
+
+template <class A>
+bool operator< (const basic_compact_string<A>& a, const basic_compact_string<A>& b) noexcept
+{
+	return basic_compact_string<A>::compare(a.view(), b.view()) < 0;
+}
+
+template <class A>
+bool operator<= (const basic_compact_string<A>& a, const basic_compact_string<A>& b) noexcept
+{
+	return basic_compact_string<A>::compare(a.view(), b.view()) <= 0;
+}
+
+template <class A>
+bool operator> (const basic_compact_string<A>& a, const basic_compact_string<A>& b) noexcept
+{
+	return basic_compact_string<A>::compare(a.view(), b.view()) > 0;
+}
+
+template <class A>
+bool operator>= (const basic_compact_string<A>& a, const basic_compact_string<A>& b) noexcept
+{
+	return basic_compact_string<A>::compare(a.view(), b.view()) >= 0;
+}
+
+template <class A>
+basic_compact_string<A> operator+ (const basic_compact_string<A>& a, std::string_view b)
+{
+	basic_compact_string<A> result(a);
+	result.append(b);
+	return result;
+}
+
+template <class A>
+std::ostream& operator<< (std::ostream& out, const basic_compact_string<A>& s)
+{
+	return out << s.view();
+}
+
+namespace std
+{
+	template <class A>
+	struct hash<basic_compact_string<A>>
+	{
+		size_t operator() (const basic_compact_string<A>& s) const noexcept
+		{
+			return hash<string_view>()(s.view());
+		}
+	};
+
+#ifdef __GLIBCXX__
+	// libstdc++ хранит хеш в узлах unordered-контейнеров только для "медленных" хешей, как у std::string;
+	// без этого поиск пересчитывает хеш каждого узла цепочки
+	template <class A>
+	struct __is_fast_hash<hash<basic_compact_string<A>>> : false_type
+	{};
+#endif
+}
@@ -1,133 +1,780 @@
 ﻿#pragma once
 
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
 #include <memory>
+#include <new>
 #include <utility>
 #include <limits>
 #include <type_traits>
 #include <algorithm>
-
-template <
-	class T,
-	int compact_max_size = -1,
-	class allocator_type = std::allocator<T>>
-class compact_vector
+#include <iterator>
+#include <functional>
+
+#include "compact_vector_simd.h"
+#include "compact_vector_sort.h"
+
+#ifdef COMPACT_VECTOR_TELEMETRY
+#include "compact_vector_telemetry.h"
+#endif // COMPACT_VECTOR_TELEMETRY
+
+/// growth policies
+/*!
+A growth policy decides the new capacity when an insertion does not fit into the current one.
+It is a class with a static function
+	size_t next_capacity(size_t capacity, size_t required, size_t element_size)
+that returns a value not less than required. Explicit reserve() calls are not affected.
+The result saturates at max_capacity(element_size) instead of overflowing; a required size
+above it is returned as is, for the container to reject.
+*/
+namespace compact_vector_growth
 {
-public:
-	struct full_storage
+	/// the largest capacity whose size in bytes fits into size_t
+	inline size_t max_capacity(size_t element_size) noexcept
 	{
-		T* begin = nullptr;
-		size_t capacity = 0;
+		return std::numeric_limits<size_t>::max() / (element_size == 0 ? 1 : element_size);
+	}
 
-		T* get(size_t i) noexcept
+	/// capacity is doubled until the required size fits
+	struct doubling
+	{
+		static size_t next_capacity(size_t capacity, size_t required, size_t element_size) noexcept
 		{
-			return begin + i;
+			size_t limit = max_capacity(element_size);
+			if (required >= limit)
+				return required;
+
+			size_t c = capacity == 0 ? 1 : capacity;
+			while (required > c) c = c > limit / 2 ? limit : 2 * c;
+			return c;
 		}
+	};
 
-		const T* get(size_t i) const noexcept
+	/// capacity is multiplied by 1.5 until the required size fits
+	struct one_and_half
+	{
+		static size_t next_capacity(size_t capacity, size_t required, size_t element_size) noexcept
 		{
-			return begin + i;
+			size_t limit = max_capacity(element_size);
+			if (required >= limit)
+				return required;
+
+			size_t c = capacity == 0 ? 1 : capacity;
+			while (required > c) c = c > limit - (c + 1) / 2 ? limit : c + (c + 1) / 2;
+			return c;
 		}
 	};
 
-	static constexpr size_t compact_default_capacity = sizeof(full_storage) / sizeof(T);
+	/// capacity grows by a fixed number of elements, which bounds the cost of a single reallocation
+	template <size_t step>
+	struct fixed_step
+	{
+		static_assert(step > 0, "fixed_step growth requires a positive step");
+
+		static size_t next_capacity(size_t capacity, size_t required, size_t element_size) noexcept
+		{
+			size_t limit = max_capacity(element_size);
+			if (required >= limit)
+				return required;
+			if (required <= capacity)
+				return capacity;
+
+			// число шагов считается сразу, без цикла по одному шагу
+			size_t steps = (required - capacity - 1) / step + 1;
+			return steps > (limit - capacity) / step ? limit : capacity + steps * step;
+		}
+	};
+
+	/// allocation size in bytes rounded up to a malloc size class
+	/*!
+	Classes follow the jemalloc scheme (tcmalloc is close to it): 8, 16, 32, 48, 64,
+	then four classes per power of two: 80, 96, 112, 128, 160, 192, 224, 256, 320...
+	Sizes above half of the address space are returned unchanged.
+	*/
+	inline size_t malloc_size_class(size_t bytes) noexcept
+	{
+		if (bytes <= 8)
+			return 8;
+		if (bytes <= 16)
+			return 16;
+		if (bytes <= 32)
+			return 32;
+		if (bytes <= 64)
+			return (bytes + 15) & ~size_t(15);
+		if (bytes > (std::numeric_limits<size_t>::max() >> 1))
+			return bytes;
+
+		size_t group = 64;
+		while ((group << 1) < bytes) group <<= 1;
+		size_t delta = group >> 2;
+		return (bytes + delta - 1) & ~(delta - 1);
+	}
+
+	/// capacity of base_policy rounded up so that the allocation fills its whole malloc size class
+	template <class base_policy = doubling>
+	struct size_class
+	{
+		static size_t next_capacity(size_t capacity, size_t required, size_t element_size) noexcept
+		{
+			size_t c = base_policy::next_capacity(capacity, required, element_size);
+			if (element_size == 0 || c >= max_capacity(element_size))
+				return c;
+
+			size_t bytes = malloc_size_class(c * element_size);
+			return bytes / element_size > c ? bytes / element_size : c;
+		}
+	};
+}
+
+/// type traits
+namespace compact_vector_traits
+{
+	/// customization point: T can be moved to another address by copying its bytes
+	/*!
+	The source object is not destroyed afterwards, so relocation of n elements is a single memcpy.
+	Defaults to std::is_trivially_copyable. Specialize it for types that own external resources
+	through pointers only, such as std::unique_ptr. Types that point into themselves
+	(e.g. libstdc++ std::string with the small string buffer) must not be marked.
+	*/
+	template <class T>
+	struct is_trivially_relocatable : std::is_trivially_copyable<T>
+	{};
+
+	template <class T, class D>
+	struct is_trivially_relocatable<std::unique_ptr<T, D>> : is_trivially_relocatable<D>
+	{};
+
+	/// the allocator has T* reallocate(T* p, size_t old_n, size_t new_n)
+	template <class A, class = void>
+	struct has_reallocate : std::false_type
+	{};
+
+	template <class A>
+	struct has_reallocate<A, decltype(void(std::declval<A&>().reallocate(
+		std::declval<typename A::value_type*>(), size_t(), size_t())))> : std::true_type
+	{};
 
-	static constexpr size_t compact_default_capacity_nonzero = compact_default_capacity == 0 ? 1 : compact_default_capacity;
+	/// deallocate() of the allocator is a no-op and memory is released in bulk (e.g. by an arena reset)
+	/*!
+	Defaults to the allocator's static constexpr bool is_monotonic member, false if there is none.
+	compact_vector then skips deallocate() when it is destroyed.
+	*/
+	template <class A, class = void>
+	struct is_monotonic : std::false_type
+	{};
+
+	template <class A>
+	struct is_monotonic<A, typename std::enable_if<A::is_monotonic>::type> : std::true_type
+	{};
+
+	/// raw address held by an allocator pointer, like C++20 std::to_address
+	template <class T>
+	T* to_address(T* p) noexcept
+	{
+		return p;
+	}
 
-	static constexpr size_t compact_capacity = compact_max_size <= 0 ? compact_default_capacity_nonzero : compact_max_size;
+	template <class P>
+	auto to_address(const P& p) noexcept -> decltype(to_address(p.operator->()))
+	{
+		return to_address(p.operator->());
+	}
 
-	static constexpr size_t vector_max_size = std::numeric_limits<size_t>::max() >> 1;
+	template <class P, class T>
+	P from_address(T* p, std::true_type) noexcept
+	{
+		return p;
+	}
 
-	struct compact_storage
+	template <class P, class T>
+	P from_address(T* p, std::false_type) noexcept
 	{
-		T buffer[compact_capacity];
+		return p == nullptr ? P(nullptr) : std::pointer_traits<P>::pointer_to(*p);
+	}
+
+	/// allocator pointer (std::allocator_traits<A>::pointer) for a raw address
+	/*!
+	Fancy pointers are built with std::pointer_traits<P>::pointer_to, raw pointers are passed through.
+	*/
+	template <class P, class T>
+	P from_address(T* p) noexcept
+	{
+		return from_address<P>(p, std::is_pointer<P>());
+	}
+}
+
+/// storage layouts
+/*!
+A layout owns the bytes of compact_vector: the inline buffer, the heap pointer, capacity, size,
+the compact/heap flag and the allocator. compact_vector works with it only through
+is_compact(), get_size(), set_size(), set_compact(), set_heap(), compact_data(), heap_data(),
+heap_capacity(), data(), capacity() and get_allocator().
+
+The heap pointer is stored as std::allocator_traits<allocator_type>::pointer, so an allocator with
+a fancy pointer (e.g. the self-relative offset_ptr of mmap_allocator.h) keeps the container
+position-independent. Such a pointer must be trivially destructible; the layouts construct it in place
+and never copy it bytewise. The interface above still takes and returns raw T*.
+*/
+namespace compact_vector_layout
+{
+	/// inline buffer overlapping {begin, capacity}, followed by a size word whose top bit marks compact mode
+	/*!
+	The shared region is sizeof(T*) + sizeof(size_type) bytes (or more for a larger compact_max_size)
+	with no padding between the pointer, the capacity and the size word. With size_type = size_t
+	the object takes 24 bytes on 64-bit targets, with size_type = uint32_t it takes 16 bytes
+	and keeps 12 bytes inline.
+	*/
+	template <class T, int compact_max_size, class allocator_type, class size_type>
+	class standard
+	{
+	public:
+		static_assert(std::is_unsigned<size_type>::value, "size_type must be an unsigned integer type");
+
+		using pointer = typename std::allocator_traits<allocator_type>::pointer;
+
+		static_assert(std::is_trivially_destructible<pointer>::value, "allocator pointer must be trivially destructible");
+
+		static constexpr size_t full_size = sizeof(pointer) + sizeof(size_type);
+
+		static constexpr size_t compact_default_capacity = full_size / sizeof(T);
+
+		static constexpr size_t compact_default_capacity_nonzero = compact_default_capacity == 0 ? 1 : compact_default_capacity;
+
+		static constexpr size_t compact_capacity = compact_max_size <= 0 ? compact_default_capacity_nonzero : compact_max_size;
+
+		static constexpr size_t max_size = std::numeric_limits<size_type>::max() >> 1;
+
+		static constexpr size_t storage_alignment = alignof(pointer) > alignof(T) ? alignof(pointer) : alignof(T);
+
+		static constexpr size_t required_size = compact_capacity * sizeof(T) > full_size ? compact_capacity * sizeof(T) : full_size;
+
+		// размер общей области выровнен только до size_type, чтобы слово размера шло сразу за ней
+		static constexpr size_t region_size = (required_size + alignof(size_type) - 1) / alignof(size_type) * alignof(size_type);
+
+		// Empty Base Optimization
+		struct size_allocator_pair : public allocator_type
+		{
+			// bitset 1000...000
+			static const size_type zero_compact = size_type(size_type(1) << (8 * sizeof(size_type) - 1));
+
+			size_allocator_pair(const allocator_type& base) :
+				allocator_type(base)
+			{}
+
+			size_allocator_pair() :
+				allocator_type(allocator_type())
+			{}
+
+			size_t get_size() const noexcept
+			{
+				return size & max_size;
+			}
+
+			bool is_compact() const noexcept
+			{
+				return size & zero_compact;
+			}
+
+			void set_size(size_t new_size, bool is_compact)
+			{
+#ifdef COMPACT_VECTOR_DEBUG
+				if (new_size > max_size)
+					throw std::exception(u8"попытка создать вектор больше max_size");
+#endif
+				if (is_compact)
+					size = zero_compact | static_cast<size_type>(new_size);
+				else
+					size = static_cast<size_type>(new_size);
+			}
+
+		private:
+			size_type size = zero_compact;
+		};
+
+		standard(const allocator_type& alloc) :
+			size_allocaltor(alloc)
+		{}
+
+		standard(const standard&) = delete;
+		standard& operator= (const standard&) = delete;
+
+		allocator_type* get_allocator() noexcept
+		{
+			return &size_allocaltor;
+		}
+
+		const allocator_type* get_allocator() const noexcept
+		{
+			return &size_allocaltor;
+		}
+
+		bool is_compact() const noexcept
+		{
+			return size_allocaltor.is_compact();
+		}
+
+		size_t get_size() const noexcept
+		{
+			return size_allocaltor.get_size();
+		}
+
+		void set_size(size_t new_size)
+		{
+			size_allocaltor.set_size(new_size, is_compact());
+		}
+
+		void set_compact(size_t new_size)
+		{
+			size_allocaltor.set_size(new_size, true);
+		}
+
+		void set_heap(T* begin, size_t capacity, size_t new_size)
+		{
+			size_type c = static_cast<size_type>(capacity);
+			// указатель создается на месте: fancy pointer может зависеть от собственного адреса
+			new (region) pointer(compact_vector_traits::from_address<pointer>(begin));
+			std::memcpy(region + sizeof(pointer), &c, sizeof(size_type));
+			size_allocaltor.set_size(new_size, false);
+		}
+
+		T* compact_data() noexcept
+		{
+			return reinterpret_cast<T*>(region);
+		}
+
+		const T* compact_data() const noexcept
+		{
+			return reinterpret_cast<const T*>(region);
+		}
 
-		T* get(size_t i) noexcept
+		T* heap_data() const noexcept
 		{
-			return &buffer[i];
+			return compact_vector_traits::to_address(*reinterpret_cast<const pointer*>(region));
 		}
 
-		const T* get(size_t i) const noexcept
+		size_t heap_capacity() const noexcept
 		{
-			return &buffer[i];
+			size_type c;
+			std::memcpy(&c, region + sizeof(pointer), sizeof(size_type));
+			return c;
 		}
+
+		T* data() noexcept
+		{
+			if (is_compact())
+				return compact_data();
+			else
+				return heap_data();
+		}
+
+		const T* data() const noexcept
+		{
+			if (is_compact())
+				return compact_data();
+			else
+				return heap_data();
+		}
+
+		size_t capacity() const noexcept
+		{
+			if (is_compact())
+				return compact_capacity;
+			return heap_capacity();
+		}
+
+	private:
+		alignas(storage_alignment) unsigned char region[region_size];
+
+		size_allocator_pair size_allocaltor;
 	};
 
-	// Empty Base Optimization
-	struct size_allocator_pair : public allocator_type
+	/// heap-mode storage of tail_size: the heap flag lives in the bits of capacity that overlap the last byte
+	template <class pointer, class size_type>
+	struct tail_size_full_storage
 	{
-		// bitset 1000...000
-		static const size_t zero_compact = size_t(1) << (8 * sizeof(size_t) - 1);
+		pointer begin;
+		size_type size;
+		size_type capacity;
+	};
 
-		size_allocator_pair(const allocator_type& base) :
-			allocator_type(base)
-		{}
+	/// tail_size only works when capacity ends exactly at the last byte of the object
+	/*!
+	Narrow size types leave trailing padding after capacity (for example {void*, uint16_t, uint16_t}),
+	and heap mode would then never write the tail byte.
+	*/
+	template <class pointer, class size_type>
+	struct tail_size_fits
+	{
+		using full_storage = tail_size_full_storage<pointer, size_type>;
 
-		size_allocator_pair(allocator_type&& base) :
-			allocator_type(base)
-		{}
+		static constexpr bool value = offsetof(full_storage, capacity) + sizeof(size_type) == sizeof(full_storage);
+	};
 
-		size_allocator_pair() :
-			allocator_type(allocator_type())
-		{}
+	/// size and mode are kept in the last byte of the storage while compact, as in fbstring or libc++ SSO
+	/*!
+	In heap mode the storage holds {begin, size, capacity}; the capacity word carries the heap flag
+	in the bits that overlap the last byte. In compact mode the last byte holds compact_capacity - size,
+	so a full inline buffer is followed by a zero byte. With the default capacity compact_vector<uint8_t>
+	keeps 23 elements inline and compact_vector<uint32_t> keeps 5, in 24 bytes; with size_type = uint32_t
+	the object takes 16 bytes and keeps 15 uint8_t inline.
+	*/
+	template <class T, int compact_max_size, class allocator_type, class size_type>
+	class tail_size : private allocator_type
+	{
+	public:
+		static_assert(std::is_unsigned<size_type>::value, "size_type must be an unsigned integer type");
+
+		using pointer = typename std::allocator_traits<allocator_type>::pointer;
 
-		allocator_type* get_allocator()
+		static_assert(std::is_trivially_destructible<pointer>::value, "allocator pointer must be trivially destructible");
+
+		using full_storage = tail_size_full_storage<pointer, size_type>;
+
+		static_assert(tail_size_fits<pointer, size_type>::value, "tail_size layout needs capacity to end at the last byte; use a wider size_type");
+
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+		static constexpr bool little_endian = false;
+#else
+		static constexpr bool little_endian = true;
+#endif
+
+		// в little endian последний байт - старший байт capacity, в big endian - младший
+		static constexpr size_type heap_flag = little_endian ? size_type(size_type(1) << (8 * sizeof(size_type) - 1)) : size_type(1);
+
+		static constexpr unsigned char tail_flag = little_endian ? 0x80 : 0x01;
+
+		static constexpr unsigned tail_shift = little_endian ? 0 : 1;
+
+		static constexpr size_t compact_default_capacity = (sizeof(full_storage) - 1) / sizeof(T);
+
+		static constexpr size_t compact_default_capacity_nonzero = compact_default_capacity == 0 ? 1 : compact_default_capacity;
+
+		static constexpr size_t compact_capacity = compact_max_size <= 0 ? compact_default_capacity_nonzero : compact_max_size;
+
+		static_assert(compact_capacity < 128, "tail_size layout keeps the compact size in 7 bits");
+
+		static constexpr size_t max_size = std::numeric_limits<size_type>::max() >> 1;
+
+		static constexpr size_t storage_alignment = alignof(full_storage) > alignof(T) ? alignof(full_storage) : alignof(T);
+
+		static constexpr size_t required_size = compact_capacity * sizeof(T) + 1 > sizeof(full_storage) ? compact_capacity * sizeof(T) + 1 : sizeof(full_storage);
+
+		static constexpr size_t storage_size = (required_size + storage_alignment - 1) / storage_alignment * storage_alignment;
+
+		// full_storage лежит в конце, чтобы capacity перекрывала последний байт
+		static constexpr size_t full_offset = storage_size - sizeof(full_storage);
+
+		tail_size(const allocator_type& alloc) :
+			allocator_type(alloc)
 		{
-			return this;
+			set_compact(0);
 		}
 
-		const allocator_type* get_allocator() const
+		tail_size(const tail_size&) = delete;
+		tail_size& operator= (const tail_size&) = delete;
+
+		allocator_type* get_allocator() noexcept
 		{
 			return this;
 		}
 
-		size_t get_size() const noexcept
+		const allocator_type* get_allocator() const noexcept
 		{
-			return size & vector_max_size;
+			return this;
 		}
 
 		bool is_compact() const noexcept
 		{
-			return size & zero_compact;
+			return (tail() & tail_flag) == 0;
 		}
 
-		void set_size(size_t new_size, bool is_compact)
+		size_t get_size() const noexcept
 		{
-#ifdef COMPACT_VECTOR_DEBUG
-			if (new_size > vector_max_size)
-				throw std::exception(u8"попытка создать вектор больше max_size");
-#endif
-			if (is_compact)
-				size = zero_compact | new_size;
+			if (is_compact())
+				return compact_capacity - (tail() >> tail_shift);
+			return full()->size;
+		}
+
+		void set_size(size_t new_size)
+		{
+			if (is_compact())
+				set_compact(new_size);
 			else
-				size = new_size;
+				full()->size = static_cast<size_type>(new_size);
+		}
+
+		void set_compact(size_t new_size)
+		{
+			bytes[storage_size - 1] = static_cast<unsigned char>((compact_capacity - new_size) << tail_shift);
+		}
+
+		void set_heap(T* begin, size_t capacity, size_t new_size)
+		{
+			size_type c = static_cast<size_type>(capacity);
+			full_storage* f = full();
+			new (&f->begin) pointer(compact_vector_traits::from_address<pointer>(begin));
+			f->size = static_cast<size_type>(new_size);
+			f->capacity = little_endian ? size_type(c | heap_flag) : size_type((c << 1) | heap_flag);
+		}
+
+		T* compact_data() noexcept
+		{
+			return reinterpret_cast<T*>(bytes);
+		}
+
+		const T* compact_data() const noexcept
+		{
+			return reinterpret_cast<const T*>(bytes);
+		}
+
+		T* heap_data() const noexcept
+		{
+			return compact_vector_traits::to_address(full()->begin);
+		}
+
+		size_t heap_capacity() const noexcept
+		{
+			size_type c = full()->capacity;
+			return little_endian ? size_type(c & ~heap_flag) : size_type(c >> 1);
+		}
+
+		T* data() noexcept
+		{
+			if (is_compact())
+				return compact_data();
+			return heap_data();
+		}
+
+		const T* data() const noexcept
+		{
+			return const_cast<tail_size*>(this)->data();
+		}
+
+		size_t capacity() const noexcept
+		{
+			if (is_compact())
+				return compact_capacity;
+			return heap_capacity();
 		}
 
 	private:
-		size_t size = zero_compact;
+		alignas(storage_alignment) unsigned char bytes[storage_size];
+
+		unsigned char tail() const noexcept
+		{
+			return bytes[storage_size - 1];
+		}
+
+		full_storage* full() noexcept
+		{
+			return reinterpret_cast<full_storage*>(bytes + full_offset);
+		}
+
+		const full_storage* full() const noexcept
+		{
+			return reinterpret_cast<const full_storage*>(bytes + full_offset);
+		}
 	};
 
-	union
+	/// a data pointer that always points at the elements, so begin(), end(), data() and operator[] do not branch
+	/*!
+	In compact mode the pointer refers to the inline buffer owned by the object itself. It is set by
+	set_compact(), which every move, swap and shrink goes through, so the object must never be copied
+	bytewise. In heap mode the inline region holds the capacity. The price is one extra pointer:
+	with the default capacity the object takes 32 bytes and keeps 16 bytes inline.
+	In a loop over one vector the compiler loads the begin pointer once for the other layouts too;
+	the layout pays off when every access goes to another vector, such as random lookups in a table
+	of rows that are partly inline and partly on the heap (random_row_sum in bench/bench_access.cpp).
+	*/
+	template <class T, int compact_max_size, class allocator_type, class size_type>
+	class data_pointer
 	{
-		compact_storage compact;
-		full_storage full;
+	public:
+		static_assert(std::is_unsigned<size_type>::value, "size_type must be an unsigned integer type");
+
+		using pointer = typename std::allocator_traits<allocator_type>::pointer;
+
+		static constexpr size_t compact_default_capacity = (sizeof(pointer) + sizeof(size_type)) / sizeof(T);
+
+		static constexpr size_t compact_default_capacity_nonzero = compact_default_capacity == 0 ? 1 : compact_default_capacity;
+
+		static constexpr size_t compact_capacity = compact_max_size <= 0 ? compact_default_capacity_nonzero : compact_max_size;
+
+		static constexpr size_t max_size = std::numeric_limits<size_type>::max() >> 1;
+
+		static constexpr size_t storage_alignment = alignof(size_type) > alignof(T) ? alignof(size_type) : alignof(T);
+
+		static constexpr size_t region_size = compact_capacity * sizeof(T) > sizeof(size_type) ? compact_capacity * sizeof(T) : sizeof(size_type);
+
+		// bitset 1000...000
+		static constexpr size_type zero_compact = size_type(size_type(1) << (8 * sizeof(size_type) - 1));
+
+		// Empty Base Optimization
+		struct begin_allocator_pair : public allocator_type
+		{
+			begin_allocator_pair(const allocator_type& base) :
+				allocator_type(base)
+			{}
+
+			pointer begin = nullptr;
+		};
+
+		data_pointer(const allocator_type& alloc) :
+			begin_allocator(alloc)
+		{
+			set_compact(0);
+		}
+
+		data_pointer(const data_pointer&) = delete;
+		data_pointer& operator= (const data_pointer&) = delete;
+
+		allocator_type* get_allocator() noexcept
+		{
+			return &begin_allocator;
+		}
+
+		const allocator_type* get_allocator() const noexcept
+		{
+			return &begin_allocator;
+		}
+
+		bool is_compact() const noexcept
+		{
+			return size & zero_compact;
+		}
+
+		size_t get_size() const noexcept
+		{
+			return size & max_size;
+		}
+
+		void set_size(size_t new_size)
+		{
+			size = size_type((size & zero_compact) | new_size);
+		}
+
+		void set_compact(size_t new_size)
+		{
+			begin_allocator.begin = compact_vector_traits::from_address<pointer>(compact_data());
+			size = size_type(zero_compact | new_size);
+		}
+
+		void set_heap(T* begin, size_t capacity, size_t new_size)
+		{
+			size_type c = static_cast<size_type>(capacity);
+			std::memcpy(region, &c, sizeof(size_type));
+			begin_allocator.begin = compact_vector_traits::from_address<pointer>(begin);
+			size = static_cast<size_type>(new_size);
+		}
+
+		T* compact_data() noexcept
+		{
+			return reinterpret_cast<T*>(region);
+		}
+
+		const T* compact_data() const noexcept
+		{
+			return reinterpret_cast<const T*>(region);
+		}
+
+		T* heap_data() const noexcept
+		{
+			return compact_vector_traits::to_address(begin_allocator.begin);
+		}
+
+		size_t heap_capacity() const noexcept
+		{
+			size_type c;
+			std::memcpy(&c, region, sizeof(size_type));
+			return c;
+		}
+
+		T* data() noexcept
+		{
+			return compact_vector_traits::to_address(begin_allocator.begin);
+		}
+
+		const T* data() const noexcept
+		{
+			return compact_vector_traits::to_address(begin_allocator.begin);
+		}
+
+		size_t capacity() const noexcept
+		{
+			if (is_compact())
+				return compact_capacity;
+			return heap_capacity();
+		}
+
+	private:
+		begin_allocator_pair begin_allocator;
+
+		size_type size;
+
+		alignas(storage_alignment) unsigned char region[region_size];
 	};
+}
+
+template <
+	class T,
+	int compact_max_size = -1,
+	class allocator_type = std::allocator<T>,
+	class growth_policy = compact_vector_growth::doubling,
+	template <class, int, class, class> class layout = compact_vector_layout::standard,
+	class size_type = size_t>
+class compact_vector
+{
+public:
+	using storage_type = layout<T, compact_max_size, allocator_type, size_type>;
+
+	static constexpr size_t compact_capacity = storage_type::compact_capacity;
+
+	static constexpr size_t vector_max_size = storage_type::max_size;
+
+	static constexpr bool trivially_relocatable = compact_vector_traits::is_trivially_relocatable<T>::value;
 
-	size_allocator_pair size_allocaltor;
+	/// find, count and index_of use the compact_vector_simd kernels
+	static constexpr bool search_kernels = compact_vector_simd::is_search_supported<T>::value;
+
+	// буфер в куче можно расширять через allocator.reallocate, если элементы переносятся побайтово
+	static constexpr bool use_reallocate = trivially_relocatable && compact_vector_traits::has_reallocate<allocator_type>::value;
+
+	// память монотонного аллокатора освобождается сбросом арены, деструктор ее не возвращает
+	static constexpr bool monotonic_allocator = compact_vector_traits::is_monotonic<allocator_type>::value;
+
+private:
+	using allocator_traits = std::allocator_traits<allocator_type>;
+
+	static constexpr bool propagate_on_copy = allocator_traits::propagate_on_container_copy_assignment::value;
+	static constexpr bool propagate_on_move = allocator_traits::propagate_on_container_move_assignment::value;
+	static constexpr bool propagate_on_swap = allocator_traits::propagate_on_container_swap::value;
+
+private:
+	storage_type storage;
+
+#ifdef COMPACT_VECTOR_TELEMETRY
+	// вектор оставлен пустым перемещением и с тех пор не заполнялся
+	bool moved_from_shell = false;
+#endif // COMPACT_VECTOR_TELEMETRY
 
 public:
+	using value_type = T;
 	using iterator = T*;
 	using const_iterator = const T*;
 	using reverse_iterator = T*; // todo
 	using const_reverse_iterator = const T*; // todo
-	using this_type = compact_vector<T, compact_max_size, allocator_type>;
+	using this_type = compact_vector<T, compact_max_size, allocator_type, growth_policy, layout, size_type>;
+	using growth_policy_type = growth_policy;
+	using size_word_type = size_type;
 
 	/// constructor: default
 	/*!
 	Constructs an empty container, with no elements.
 	*/
 	explicit compact_vector(const allocator_type& alloc = allocator_type()) :
-		size_allocaltor(alloc)
+		storage(alloc)
 	{}
 
 	/// constructor: fill
@@ -135,7 +782,7 @@ public:
 	Constructs a container with n elements.
 	*/
 	explicit compact_vector(size_t n) :
-		size_allocaltor()
+		storage(allocator_type())
 	{
 		resize(n);
 	}
@@ -145,7 +792,7 @@ public:
 	Constructs a container with n elements. Each element is a copy of val.
 	*/
 	compact_vector(size_t n, const T& val, const allocator_type& alloc = allocator_type()) :
-		size_allocaltor(alloc)
+		storage(alloc)
 	{
 		resize(n, val);
 	}
@@ -155,9 +802,9 @@ public:
 	Constructs a container with as many elements as the range [first,last), 
 	with each element emplace-constructed from its corresponding element in that range, in the same order.
 	*/
-	template <class InputIterator>
+	template <class InputIterator, class = typename std::enable_if<!std::is_integral<InputIterator>::value>::type>
 	compact_vector(InputIterator first, InputIterator last, const allocator_type& alloc = allocator_type()) :
-		size_allocaltor(alloc)
+		storage(alloc)
 	{
 		assign(first, last);
 	}
@@ -165,12 +812,14 @@ public:
 	/// constructor: copy
 	/*!
 	Constructs a container with a copy of each of the elements in x, in the same order.
+	The allocator is obtained with select_on_container_copy_construction.
 	*/
 	compact_vector(const this_type& x) :
-		size_allocaltor(x.get_allocator())
+		storage(allocator_traits::select_on_container_copy_construction(x.get_allocator()))
 	{
 		reserve(x.size());
 		copy_data(x.begin(), x.end(), begin());
+		set_new_size(x.size());
 	}
 
 	/// constructor: copy
@@ -178,23 +827,24 @@ public:
 	Constructs a container with a copy of each of the elements in x, in the same order.
 	*/
 	compact_vector(const this_type& x, const allocator_type& alloc) :
-		size_allocaltor(alloc)
+		storage(alloc)
 	{
 		reserve(x.size());
 		copy_data(x.begin(), x.end(), begin());
+		set_new_size(x.size());
 	}
 
 	/// constructor: move
 	/*!
 	Constructs a container that acquires the elements of x.
-	If alloc is specified and is different from x's allocator, the elements are moved. 
-	Otherwise, no elements are constructed (their ownership is directly transferred).
-	x is left in an unspecified but valid state.
+	A heap buffer is taken over as is (pointer, capacity and size). Elements in the inline buffer
+	are moved; for trivially relocatable T the whole inline buffer is copied with one memcpy
+	of a size known at compile time. x is left empty in compact mode and owns no memory.
 	*/
-	compact_vector(this_type&& x) :
-		size_allocaltor(x.get_allocator())
+	compact_vector(this_type&& x) noexcept(trivially_relocatable || std::is_nothrow_move_constructible<T>::value) :
+		storage(x.get_allocator())
 	{
-		swap(x);
+		take_data(x);
 	}
 
 	/// constructor: move
@@ -205,9 +855,12 @@ public:
 	x is left in an unspecified but valid state.
 	*/
 	compact_vector(this_type&& x, const allocator_type& alloc) :
-		size_allocaltor(alloc)
+		storage(alloc)
 	{
-		swap(x);
+		if (get_allocator() == x.get_allocator())
+			take_data(x);
+		else
+			move_elements(x);
 	}
 
 	/// constructor: initializer list
@@ -215,7 +868,7 @@ public:
 	Constructs a container with a copy of each of the elements in il, in the same order.
 	*/
 	compact_vector(std::initializer_list<T> il, const allocator_type& alloc = allocator_type()) :
-		size_allocaltor(alloc)
+		storage(alloc)
 	{
 		assign(il);
 	}
@@ -223,11 +876,12 @@ public:
 	/// destructor
 	~compact_vector()
 	{
+		note_destruct();
 		destruct();
 	}
 
 	/// assign: range
-	template <class InputIterator>
+	template <class InputIterator, class = typename std::enable_if<!std::is_integral<InputIterator>::value>::type>
 	void assign(InputIterator first, InputIterator last)
 	{
 		clear();
@@ -248,6 +902,22 @@ public:
 		insert(begin(), il);
 	}
 
+	/// assign: n elements copied bytewise from p, which need not be aligned for T
+	/*!
+	For trivially copyable T only. A vector in compact mode keeps n elements that fit
+	the inline buffer there, so deserializing a small record is a single memcpy.
+	*/
+	void assign_bytes(const void* p, size_t n)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "assign_bytes requires a trivially copyable T");
+
+		clear();
+		reserve(n);
+		if (n != 0)
+			std::memcpy(static_cast<void*>(data()), p, n * sizeof(T));
+		set_new_size(n);
+	}
+
 	T& at(size_t n)
 	{
 		if (n >= size())
@@ -276,48 +946,34 @@ public:
 
 	iterator begin() noexcept
 	{
-		if (is_compact())
-			return compact.get(0);
-		else
-			return full.get(0);
+		return storage.data();
 	}
 
 	const_iterator begin() const noexcept
 	{
-		if (is_compact())
-			return compact.get(0);
-		else
-			return full.get(0);
+		return storage.data();
 	}
 
 	size_t capacity() const noexcept
 	{
-		if (is_compact())
-			return compact_capacity;
-		return full.capacity;
+		return storage.capacity();
 	}
 
 	const_iterator cbegin() const noexcept
 	{
-		if (is_compact())
-			return compact.get(0);
-		else
-			return full.get(0);
+		return storage.data();
 	}
 
 	const_iterator cend() const noexcept
 	{
-		if (is_compact())
-			return compact.get(size() - 1);
-		else
-			return full.get(size() - 1);
+		return storage.data() + size();
 	}
 
 	void clear() noexcept
 	{
 		call_destructors(begin(), end());
 
-		size_allocaltor.set_size(0, is_compact());
+		storage.set_size(0);
 	}
 
 	const_reverse_iterator crbegin() const noexcept; // todo
@@ -334,20 +990,36 @@ public:
 		return begin();
 	}
 
+	/// emplace
+	/*!
+	Inserts a new element constructed from args at position.
+	Elements after position are shifted with memmove when T is trivially relocatable,
+	otherwise with move construction and move assignment.
+	*/
 	template <class... Args>
-	iterator emplace(const_iterator position, Args&&... args); // todo
+	iterator emplace(const_iterator position, Args&&... args)
+	{
+		// emplace_back сам создает значение до реаллокации
+		if (position == end())
+		{
+			size_t offset = size();
+			emplace_back(std::forward<Args>(args)...);
+			return begin() + offset;
+		}
+
+		// args могут ссылаться на элементы самого вектора, поэтому значение создается до сдвига хвоста
+		T tmp(std::forward<Args>(args)...);
+		return insert_n(position, 1, move_source(tmp));
+	}
 
 	template <class... Args>
 	void emplace_back(Args&&... args)
 	{
-		static const size_t args_size = sizeof...(Args); 
-
-		size_t c = capacity();
-		size_t required_size = size() + args_size;
-		while (required_size > c) c = 2 * c;
-		reserve(c);
-
-		::new(end()) value_type(std::forward<Args>(args)...);
+		size_t required_size = size() + 1;
+		if (required_size > capacity())
+			grow_emplace_back(std::integral_constant<bool, use_reallocate>(), std::forward<Args>(args)...);
+		else
+			::new(end()) value_type(std::forward<Args>(args)...);
 		set_new_size(required_size);
 	}
 
@@ -358,50 +1030,175 @@ public:
 
 	iterator end() noexcept
 	{
-		if (is_compact())
-			return compact.get(size());
-		else
-			return full.get(size());
+		return storage.data() + size();
 	}
 
 	const_iterator end() const noexcept
 	{
-		if (is_compact())
-			return compact.get(size() - 1);
-		else
-			return full.get(size() - 1);
+		return storage.data() + size();
 	}
 
 	iterator erase(const_iterator position)
 	{
-		iterator p = const_cast<iterator>(position);
-		iterator e = end();
-
-		if (p <= e)
-			copy_data(p + 1, e, p);
-		e--;
-		e->~T();
-		set_new_size(size() - 1);
-		return p;
+		return erase(position, position + 1);
 	}
 
+	/// erase: range
+	/*!
+	Removes the elements in [first,last). The tail is shifted with memmove when T is
+	trivially relocatable, otherwise it is move-assigned and the vacated elements are destroyed.
+	*/
 	iterator erase(const_iterator first, const_iterator last)
 	{
 		iterator f = const_cast<iterator>(first);
 		iterator l = const_cast<iterator>(last);
-		iterator e = end();
 
 		if (f > l)
 			return nullptr;
 
-		if (l <= e)
-			copy_data(l, e, f);
-		call_destructors(f + (e - l), e);
-
-		set_new_size(size() - (e - l));
+		if (f != l)
+		{
+			size_t n = l - f;
+			erase_n(f, l, std::integral_constant<bool, trivially_relocatable>());
+			set_new_size(size() - n);
+		}
 		return f;
 	}
 
+	/// erase_if
+	/*!
+	Removes all elements for which pred returns true, keeping the order of the rest.
+	The elements are compacted in place with a single write cursor and only the discarded
+	tail is destroyed. Returns the number of removed elements.
+	*/
+	template <class Predicate>
+	size_t erase_if(Predicate pred)
+	{
+		iterator w = compact_if(pred, std::integral_constant<bool, std::is_arithmetic<T>::value>());
+		return erase_tail(w);
+	}
+
+	/// remove_value
+	/*!
+	Removes all elements equal to value, keeping the order of the rest.
+	For 4 and 8 byte integral types the compaction runs on AVX2 or SSE4.2 kernels
+	selected at runtime (see compact_vector_simd). Returns the number of removed elements.
+	*/
+	size_t remove_value(const T& value)
+	{
+		// value может лежать в самом векторе и быть перезаписан при уплотнении
+		if (&value >= begin() && &value < end())
+		{
+			T tmp(value);
+			return remove_value(tmp, std::integral_constant<bool, compact_vector_simd::is_supported<T>::value>());
+		}
+		return remove_value(value, std::integral_constant<bool, compact_vector_simd::is_supported<T>::value>());
+	}
+
+	/// find
+	/*!
+	Returns an iterator to the first element equal to value, or end().
+	For integral and floating point types the search runs on SIMD compare + movemask kernels;
+	while the elements are in the inline buffer the whole buffer of compact_capacity elements
+	is compared with a fixed, fully unrolled sequence of loads.
+	*/
+	iterator find(const T& value)
+	{
+		return begin() + index_of(value);
+	}
+
+	const_iterator find(const T& value) const
+	{
+		return begin() + index_of(value);
+	}
+
+	/// contains
+	bool contains(const T& value) const
+	{
+		return index_of(value) != size();
+	}
+
+	/// count
+	/*!
+	Returns the number of elements equal to value.
+	*/
+	size_t count(const T& value) const
+	{
+		return count_equal(value, std::integral_constant<bool, search_kernels>());
+	}
+
+	/// index_of
+	/*!
+	Returns the index of the first element equal to value, or size() if there is none.
+	*/
+	size_t index_of(const T& value) const
+	{
+		return find_index(value, std::integral_constant<bool, search_kernels>());
+	}
+
+	/// min
+	/*!
+	Returns the first smallest element. The container must not be empty.
+	4 and 8 byte integral types are reduced with SIMD min instructions.
+	*/
+	const T& min() const
+	{
+		return (*this)[extremum_index<false>(std::integral_constant<bool, compact_vector_simd::is_supported<T>::value>())];
+	}
+
+	/// max
+	/*!
+	Returns the first largest element. The container must not be empty.
+	*/
+	const T& max() const
+	{
+		return (*this)[extremum_index<true>(std::integral_constant<bool, compact_vector_simd::is_supported<T>::value>())];
+	}
+
+	/// sort
+	/*!
+	Sorts the elements with comp (operator< by default). Arithmetic and pointer elements
+	up to compact_vector_sort::network_max_size are sorted by a branchless sorting network,
+	small ranges by insertion sort and larger ones by pattern-defeating quicksort
+	(see compact_vector_sort). The sort is not stable.
+	*/
+	void sort()
+	{
+		compact_vector_sort::sort(data(), data() + size(), std::less<T>());
+	}
+
+	template <class Compare>
+	void sort(Compare comp)
+	{
+		compact_vector_sort::sort(data(), data() + size(), comp);
+	}
+
+	/// unique
+	/*!
+	Removes consecutive equal elements, keeping the first of each group.
+	Returns the number of removed elements.
+	*/
+	size_t unique()
+	{
+		return erase_tail(std::unique(begin(), end()));
+	}
+
+	template <class BinaryPredicate>
+	size_t unique(BinaryPredicate pred)
+	{
+		return erase_tail(std::unique(begin(), end(), pred));
+	}
+
+	/// dedupe
+	/*!
+	Sorts the elements and removes duplicates. Returns the number of removed elements.
+	*/
+	size_t dedupe()
+	{
+		sort();
+		return unique();
+	}
+
 	T& front()
 	{
 		return *begin();
@@ -414,7 +1211,7 @@ public:
 
 	allocator_type get_allocator() const noexcept
 	{
-		return *size_allocaltor.get_allocator();
+		return *storage.get_allocator();
 	}
 
 	/// insert: single element
@@ -424,71 +1221,42 @@ public:
 	}
 
 	/// insert: fill
+	/*!
+	Inserts n copies of val before position. No element is constructed more than once:
+	the tail is relocated once and the copies are constructed directly in the gap.
+	*/
 	iterator insert(const_iterator position, size_t n, const T& val)
 	{
-		size_t p = end() - position;
-		resize(size() + n, val);
-
-		iterator i = end() - n - 1;
-		iterator j = end() - 1;
-		for (; p > 0; p--, i--, j--)
-			std::iter_swap(i, j);
-		return i;
+		// val может лежать в самом векторе и сдвинуться вместе с хвостом
+		if (&val >= begin() && &val < end())
+		{
+			T tmp(val);
+			return insert_n(position, n, fill_source(tmp));
+		}
+		return insert_n(position, n, fill_source(val));
 	}
 
 	/// insert: range
-	template <class InputIterator>
+	/*!
+	Forward iterators are measured with std::distance and their elements are constructed
+	directly in place. Single-pass input iterators are appended to the end and rotated into position.
+	*/
+	template <class InputIterator, class = typename std::enable_if<!std::is_integral<InputIterator>::value>::type>
 	iterator insert(const_iterator position, InputIterator first, InputIterator last)
 	{
-		size_t n = 0;
-		for (InputIterator i = first; i != last; i++, n++);
-
-		if (n == 0)
-			return end();
-
-		size_t p = end() - position;
-		resize(size() + n, *first);
-
-		iterator i = end() - n - 1;
-		iterator j = end() - 1;
-		for (size_t counter = p; counter > 0; counter--, i--, j--)
-			std::iter_swap(i, j);
-
-		i = begin() + p;
-		for (InputIterator j = first; j != last; j++, i++)
-			*i = *j;
-
-		return begin() + p;
+		return insert_range(position, first, last, typename std::iterator_traits<InputIterator>::iterator_category());
 	}
 
 	/// insert: move
 	iterator insert(const_iterator position, T&& val)
 	{
-		return emplace(position, std::move(value));
+		return emplace(position, std::move(val));
 	}
 
 	/// initializer list
 	iterator insert(const_iterator position, std::initializer_list<T> il)
 	{
-		if (il.size() == 0)
-			return end();
-
-		size_t p = end() - position;
-		resize(size() + il.size(), *il.begin());
-
-		iterator i = end() - il.size() - 1;
-		iterator j = end() - 1;
-		for (size_t counter = p; counter > 0; counter--, i--, j--)
-			std::iter_swap(i, j);
-
-		i = begin() + p;
-		for (auto& e : il)
-		{
-			*i = e;
-			i++;
-		}
-
-		return begin() + p;
+		return insert(position, il.begin(), il.end());
 	}
 
 	size_t max_size() const noexcept
@@ -501,9 +1269,11 @@ public:
 	{
 		if (this != &x)
 		{
+			copy_allocator(x, std::integral_constant<bool, propagate_on_copy>());
 			clear();
 			reserve(x.size());
 			copy_data(x.begin(), x.end(), begin());
+			set_new_size(x.size());
 		}
 		return *this;
 	}
@@ -512,10 +1282,7 @@ public:
 	compact_vector& operator= (compact_vector&& x)
 	{
 		if (this != &x)
-		{
-			destruct();
-			swap(x);
-		}
+			move_assign(x, std::integral_constant<bool, propagate_on_move>());
 		return *this;
 	}
 
@@ -525,23 +1292,18 @@ public:
 		clear();
 		reserve(il.size());
 		copy_data(il.begin(), il.end(), begin());
+		set_new_size(il.size());
 		return *this;
 	}
 
 	T& operator[] (size_t n)
 	{
-		if (is_compact())
-			return *compact.get(n);
-		else
-			return *full.get(n);
+		return storage.data()[n];
 	}
 
 	const T& operator[] (size_t n) const
 	{
-		if (is_compact())
-			return *compact.get(n);
-		else
-			return *full.get(n);
+		return storage.data()[n];
 	}
 
 	void pop_back()
@@ -551,22 +1313,12 @@ public:
 
 	void push_back(const T& val)
 	{
-		auto size = size() + 1;
-		if (size > capacity())
-			reserve(2 * capacity());
-
-		::new(end()) T(val);
-		set_new_size(size);
+		emplace_back(val);
 	}
 
 	void push_back(T&& val)
 	{
-		auto size = size() + 1;
-		if (size > capacity())
-			reserve(2 * capacity());
-
-		::new(end()) T(std::move(val));
-		set_new_size(size);
+		emplace_back(std::move(val));
 	}
 
 	reverse_iterator rbegin() noexcept; // todo
@@ -581,7 +1333,7 @@ public:
 			return;
 
 		if (n > max_size())
-			std::length_error(u8"попытка выделить памяти больше чем max_size()");
+			throw std::length_error(u8"попытка выделить памяти больше чем max_size()");
 
 		grow(n);
 	}
@@ -590,10 +1342,7 @@ public:
 	{
 		if (n > size())
 		{
-			size_t c = capacity();
-			while (n > c) c = 2 * c;
-			
-			reserve(c);
+			grow_to_fit(n);
 
 			add_to_end(n);
 		}
@@ -608,89 +1357,205 @@ public:
 	{
 		if (n > size())
 		{
-			size_t c = capacity();
-			while (n > c) c = 2 * c;
-
-			reserve(c);
-			
+			// val может лежать в самом векторе и переехать при росте
+			if (n > capacity() && &val >= begin() && &val < end())
+			{
+				T tmp(val);
+				grow_to_fit(n);
+				add_to_end(n, tmp);
+				return;
+			}
+			grow_to_fit(n);
 			add_to_end(n, val);
 		}
 		else
 		{
-			call_destructors(begin() + n, end());
-			set_new_size(n);
+			call_destructors(begin() + n, end());
+			set_new_size(n);
+		}
+	}
+
+	/// resize: new elements are left uninitialized, to be overwritten by the caller (e.g. by read())
+	/*!
+	For trivially copyable T only. Up to compact_capacity elements stay in the inline buffer.
+	*/
+	void resize_for_overwrite(size_t n)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "resize_for_overwrite requires a trivially copyable T");
+
+		if (n > size())
+			grow_to_fit(n);
+		set_new_size(n);
+	}
+
+	void shrink_to_fit()
+	{
+		if (is_compact())
+			return;
+
+		if (size() > compact_capacity)
+		{
+			if (size() == storage.heap_capacity())
+				return;
+
+			if (reallocate_data(size(), std::integral_constant<bool, use_reallocate>()))
+				return;
+
+			size_t new_capacity = size();
+			auto ptr_begin = allocate_heap(new_capacity);
+			move_data(begin(), end(), ptr_begin);
+
+			deallocate_heap(storage.heap_data(), storage.heap_capacity());
+
+			storage.set_heap(ptr_begin, new_capacity, new_capacity);
+		}
+		else
+		{
+			auto b = storage.heap_data();
+			auto c = storage.heap_capacity();
+			auto s = size();
+
+			move_data(b, b + s, storage.compact_data());
+			deallocate_heap(b, c);
+
+			storage.set_compact(s);
+			note_return();
+		}
+	}
+
+	size_t size() const noexcept
+	{
+		return storage.get_size();
+	}
+
+	/// swap
+	/*!
+	Allocators are exchanged only if propagate_on_container_swap is true;
+	otherwise they must compare equal, as for the standard containers.
+	*/
+	void swap(compact_vector& x)
+	{
+		swap_data(x);
+		swap_allocators(x, std::integral_constant<bool, propagate_on_swap>());
+	}
+
+#ifdef COMPACT_VECTOR_DEBUG
+public:
+#else
+private:
+#endif
+
+	bool is_compact() const noexcept
+	{
+		return storage.is_compact();
+	}
+
+	void destruct()
+	{
+		call_destructors(begin(), end());
+
+		if (!is_compact() && !monotonic_allocator)
+			deallocate_heap(storage.heap_data(), storage.heap_capacity());
+		storage.set_compact(0);
+	}
+
+	// обмен содержимым без обмена аллокаторами
+	void swap_data(this_type& x)
+	{
+		swap_moved_from(x);
+		if (is_compact())
+		{
+			if (x.is_compact())
+				swap_compact_compact(x);
+			else
+				swap_compact_full(x);
+		}
+		else
+		{
+			if (x.is_compact())
+				swap_full_compact(x);
+			else
+				swap_full_full(x);
 		}
 	}
 
-	void shrink_to_fit()
+	// при propagate_on_container_copy_assignment буфер освобождается старым аллокатором до замены
+	void copy_allocator(const this_type& x, std::integral_constant<bool, true>)
 	{
-		if (is_compact())
-			return;
+		if (get_allocator() != x.get_allocator())
+			destruct();
+		*storage.get_allocator() = *x.storage.get_allocator();
+	}
 
-		if (size() >= compact_capacity)
-		{
-			size_t new_capacity = size();
-			auto ptr_begin = get_allocator().allocate(new_capacity);
-			move_data(begin(), end(), ptr_begin);
+	void copy_allocator(const this_type&, std::integral_constant<bool, false>)
+	{
+	}
 
-			get_allocator().deallocate(full.begin, full.capacity);
+	void move_assign(this_type& x, std::integral_constant<bool, true>)
+	{
+		destruct();
+		*storage.get_allocator() = std::move(*x.storage.get_allocator());
+		take_data(x);
+	}
 
-			full.begin = ptr_begin;
-			full.capacity = new_capacity;
+	// аллокатор остается своим: буфер x можно забрать, только если аллокаторы равны
+	void move_assign(this_type& x, std::integral_constant<bool, false>)
+	{
+		if (get_allocator() == x.get_allocator())
+		{
+			destruct();
+			take_data(x);
 		}
 		else
 		{
-			auto b = full.begin;
-			auto c = full.capacity;
-
-			move_data(b, b + c, compact.get(0));
-			get_allocator().deallocate(b, c);
-
-			size_allocaltor.set_size(size(), true);
+			clear();
+			move_elements(x);
 		}
 	}
 
-	size_t size() const noexcept
-	{
-		return this->size_allocaltor.get_size();
-	}
-
-	void swap(compact_vector& x)
+	// перенос содержимого x в пустой компактный вектор; x остается пустым компактным и памяти не держит
+	void take_data(this_type& x)
 	{
-		if (is_compact())
+		size_t n = x.size();
+		if (x.is_compact())
 		{
-			if (x.is_compact())
-				swap_compact_compact(x);
-			else
-				swap_compact_full(x);
+			relocate_compact(x.storage.compact_data(), storage.compact_data(), n);
+			storage.set_compact(n);
 		}
 		else
 		{
-			if (x.is_compact())
-				swap_full_compact(x);
-			else
-				swap_full_full(x);
+			storage.set_heap(x.storage.heap_data(), x.storage.heap_capacity(), n);
 		}
+		x.storage.set_compact(0);
+		note_filled();
+		x.note_moved_from();
 	}
 
-#ifdef COMPACT_VECTOR_DEBUG
-public:
-#else
-private:
-#endif
+	// перенос n элементов между встроенными буферами
+	static void relocate_compact(T* from, T* to, size_t n)
+	{
+		relocate_compact(from, to, n, std::integral_constant<bool, trivially_relocatable>());
+	}
 
-	bool is_compact() const noexcept
+	// буфер копируется целиком: размер известен при компиляции, и memcpy превращается в несколько пересылок без цикла
+	static void relocate_compact(T* from, T* to, size_t, std::integral_constant<bool, true>)
 	{
-		return size_allocaltor.is_compact();
+		std::memcpy(static_cast<void*>(to), static_cast<const void*>(from), sizeof(T) * compact_capacity);
 	}
 
-	void destruct()
+	static void relocate_compact(T* from, T* to, size_t n, std::integral_constant<bool, false>)
 	{
-		call_destructors(begin(), end());
+		move_data(from, from + n, to);
+	}
 
-		if (!is_compact())
-			get_allocator().deallocate(full.begin, full.capacity);
-		size_allocaltor.set_size(0, true);
+	// поэлементный перенос из вектора с другим аллокатором, x остается пустым со своим буфером
+	void move_elements(this_type& x)
+	{
+		reserve(x.size());
+		move_data(x.begin(), x.end(), begin());
+		set_new_size(x.size());
+		x.set_new_size(0);
+		x.note_moved_from();
 	}
 
 	// swap для случая, когда this->is_compact() == false && x.is_compact() == false
@@ -701,9 +1566,12 @@ private:
 			throw std::exception(u8"неправильный вызов swap_full_full");
 #endif // COMPACT_VECTOR_DEBUG
 
-		std::swap(size_allocaltor, x.size_allocaltor);
-		std::swap(full.begin, x.full.begin);
-		std::swap(full.capacity, x.full.capacity);
+		auto this_begin = storage.heap_data();
+		auto this_capacity = storage.heap_capacity();
+		auto this_size = size();
+
+		storage.set_heap(x.storage.heap_data(), x.storage.heap_capacity(), x.size());
+		x.storage.set_heap(this_begin, this_capacity, this_size);
 	}
 
 	// swap для случая, когда this->is_compact() == true && x.is_compact() == false
@@ -714,14 +1582,14 @@ private:
 			throw std::exception(u8"неправильный вызов swap_compact_full");
 #endif // COMPACT_VECTOR_DEBUG
 
-		auto x_begin = x.full.begin;
-		auto x_capacity = x.full.capacity;
+		auto x_begin = x.storage.heap_data();
+		auto x_capacity = x.storage.heap_capacity();
+		auto x_size = x.size();
+		auto this_size = size();
 
-		move_data(begin(), end(), x.compact.get(0));
-		full.begin = x_begin;
-		full.capacity = x_capacity;
-
-		std::swap(size_allocaltor, x.size_allocaltor);
+		relocate_compact(storage.compact_data(), x.storage.compact_data(), this_size);
+		x.storage.set_compact(this_size);
+		storage.set_heap(x_begin, x_capacity, x_size);
 	}
 
 	// swap для случая, когда this->is_compact() == false && x.is_compact() == true
@@ -732,14 +1600,7 @@ private:
 			throw std::exception(u8"неправильный вызов swap_full_compact");
 #endif // COMPACT_VECTOR_DEBUG
 
-		auto this_begin = full.begin;
-		auto this_capacity = full.capacity;
-
-		move_data(x.begin(), x.end(), compact.get(0));
-		x.full.begin = x_begin;
-		x.full.capacity = x_capacity;
-
-		std::swap(size_allocaltor, x.size_allocaltor);
+		x.swap_compact_full(*this);
 	}
 
 	// swap для случая, когда this->is_compact() == true && x.is_compact() == true
@@ -750,50 +1611,63 @@ private:
 			throw std::exception(u8"неправильный вызов swap_compact_compact");
 #endif // COMPACT_VECTOR_DEBUG
 
-		swap_compact_compact(x, std::is_trivially_copyable<T>::type());
+		size_t s1 = size();
+		size_t s2 = x.size();
+
+		swap_compact_compact(x, s1, s2, std::integral_constant<bool, trivially_relocatable>());
+
+		storage.set_compact(s2);
+		x.storage.set_compact(s1);
 	}
 
-	void swap_compact_compact(this_type& x, std::integral_constant<bool, true>)
+	void swap_compact_compact(this_type& x, size_t, size_t, std::integral_constant<bool, true>)
 	{
-		compact_storage tmp;
-		std::memcpy(&tmp, &compact, sizeof(compact_storage));
-		std::memcpy(&compact, &x.compact, sizeof(compact_storage));
-		std::memcpy(&x.compact, &tmp, sizeof(compact_storage));
-		
-		std::swap(size_allocaltor, x.size_allocaltor);
+		// сырая память, чтобы для tmp не вызывались конструкторы и деструкторы T
+		typename std::aligned_storage<sizeof(T) * compact_capacity, alignof(T)>::type tmp;
+		std::memcpy(&tmp, static_cast<const void*>(storage.compact_data()), sizeof(T) * compact_capacity);
+		std::memcpy(static_cast<void*>(storage.compact_data()), static_cast<const void*>(x.storage.compact_data()), sizeof(T) * compact_capacity);
+		std::memcpy(static_cast<void*>(x.storage.compact_data()), &tmp, sizeof(T) * compact_capacity);
 	}
 
-	void swap_compact_compact(this_type& x, std::integral_constant<bool, false>)
+	void swap_compact_compact(this_type& x, size_t s1, size_t s2, std::integral_constant<bool, false>)
 	{
-		size_t s1 = size();
-		size_t s2 = x.size();
 		size_t s = std::max(s1, s2);
+		T* a = storage.compact_data();
+		T* b = x.storage.compact_data();
 
 		for (size_t i = 0; i < s; i++)
 		{
 			if (i < s1 && i < s2)
 			{
-				std::iter_swap(compact.get(i), x.compact.get(i));
+				std::iter_swap(a + i, b + i);
 			}
 			else if (i < s2)
 			{
-				::new(compact.get(i)) T(std::move(*x.compact.get(i)));
-				x.compact.get(i)->~T();
+				::new(a + i) T(std::move(b[i]));
+				b[i].~T();
 			}
 			else
 			{
-				::new(x.compact.get(i)) T(std::move(*compact.get(i)));
-				compact.get(i)->~T();
+				::new(b + i) T(std::move(a[i]));
+				a[i].~T();
 			}
 		}
+	}
+
+	void swap_allocators(this_type& x, std::integral_constant<bool, true>)
+	{
+		using std::swap;
+		swap(*storage.get_allocator(), *x.storage.get_allocator());
+	}
 
-		std::swap(size_allocaltor, x.size_allocaltor);
+	void swap_allocators(this_type&, std::integral_constant<bool, false>)
+	{
 	}
 
 	template<typename InputIterator>
 	static void call_destructors(InputIterator first, InputIterator last)
 	{
-		call_destructors(first, last, std::is_trivial<T>::type());
+		call_destructors(first, last, typename std::is_trivial<T>::type());
 	}
 
 	// для тривиальных типов деструктор вызывать не нужно
@@ -817,17 +1691,101 @@ private:
 			throw std::exception(u8"попытка уменьшить размер вектора");
 #endif // COMPACT_VECTOR_DEBUG
 
-		auto ptr_begin = get_allocator().allocate(new_size);
+		if (!is_compact() && reallocate_data(new_size, std::integral_constant<bool, use_reallocate>()))
+			return;
+
+		auto ptr_begin = allocate_heap(new_size);
 		move_data(begin(), end(), ptr_begin);
 
 		if (!is_compact())
-			get_allocator().deallocate(full.begin, full.capacity);
+			deallocate_heap(storage.heap_data(), storage.heap_capacity());
+		else
+			note_spill();
 
-		full.begin = ptr_begin;
-		full.capacity = new_size;
+		storage.set_heap(ptr_begin, new_size, size());
+	}
 
-		if (is_compact())
-			this->size_allocaltor.set_size(size(), false);
+	// перевыделение буфера в куче на месте через allocator.reallocate (realloc/mremap)
+	bool reallocate_data(size_t new_capacity, std::integral_constant<bool, true>)
+	{
+		auto ptr_begin = compact_vector_traits::to_address(
+			storage.get_allocator()->reallocate(storage.heap_data(), storage.heap_capacity(), new_capacity));
+		note_deallocate(storage.heap_capacity());
+		note_allocate(new_capacity);
+		storage.set_heap(ptr_begin, new_capacity, size());
+		return true;
+	}
+
+	bool reallocate_data(size_t, std::integral_constant<bool, false>)
+	{
+		return false;
+	}
+
+	// расширение по growth_policy, если n элементов не помещаются в текущую емкость
+	void grow_to_fit(size_t n)
+	{
+		if (n <= capacity())
+			return;
+
+		if (n > max_size())
+			throw std::length_error(u8"попытка выделить памяти больше чем max_size()");
+
+		reserve(next_capacity(n));
+	}
+
+	size_t next_capacity(size_t n) const noexcept
+	{
+		size_t c = growth_policy::next_capacity(capacity(), n, sizeof(T));
+		return c > vector_max_size ? n : c;
+	}
+
+	// emplace_back в заполненный вектор: args могут ссылаться на элементы самого вектора,
+	// поэтому новый элемент создается до того, как старые элементы переедут
+	template <class... Args>
+	void grow_emplace_back(std::integral_constant<bool, false>, Args&&... args)
+	{
+		size_t n = size();
+		if (n + 1 > max_size())
+			throw std::length_error(u8"попытка выделить памяти больше чем max_size()");
+
+		size_t new_capacity = next_capacity(n + 1);
+		auto ptr_begin = allocate_heap(new_capacity);
+		try
+		{
+			::new(ptr_begin + n) T(std::forward<Args>(args)...);
+		}
+		catch (...)
+		{
+			deallocate_heap(ptr_begin, new_capacity);
+			throw;
+		}
+		move_data(begin(), end(), ptr_begin);
+
+		if (!is_compact())
+			deallocate_heap(storage.heap_data(), storage.heap_capacity());
+		else
+			note_spill();
+
+		storage.set_heap(ptr_begin, new_capacity, n);
+	}
+
+	// realloc переносит буфер на месте, поэтому элемент создается во временном буфере
+	// и после роста переносится побайтно, как и остальные trivially relocatable элементы
+	template <class... Args>
+	void grow_emplace_back(std::integral_constant<bool, true>, Args&&... args)
+	{
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type tmp;
+		T* value = ::new(static_cast<void*>(&tmp)) T(std::forward<Args>(args)...);
+		try
+		{
+			grow_to_fit(size() + 1);
+		}
+		catch (...)
+		{
+			value->~T();
+			throw;
+		}
+		std::memcpy(static_cast<void*>(end()), static_cast<const void*>(value), sizeof(T));
 	}
 
 	void add_to_end(size_t n)
@@ -860,46 +1818,415 @@ private:
 
 	void set_new_size(size_t new_size)
 	{
-		this->size_allocaltor.set_size(new_size, is_compact());
+		storage.set_size(new_size);
+		if (new_size != 0)
+			note_filled();
 	}
 
 	static void move_data(iterator first, iterator last, iterator target)
 	{
-		move_data(first, last, target, std::is_trivially_copyable<T>::type());
+		move_data(first, last, target, std::integral_constant<bool, trivially_relocatable>());
 	}
 
-	// для тривиальных типов можно использовать memcpy
+	// для побайтово переносимых типов можно использовать memcpy, деструкторы не вызываются
 	static void move_data(iterator first, iterator last, iterator target, std::integral_constant<bool, true>)
 	{
-		std::memcpy(target, first, last - first);
+		std::memcpy(static_cast<void*>(target), static_cast<const void*>(first), (last - first) * sizeof(T));
 	}
 
 	// для нетривиальных типов вызывается std::move
 	static void move_data(iterator first, iterator last, iterator target, std::integral_constant<bool, false>)
 	{
-		for (; first != last; first++, target++)
-			::new(target) T(std::move(*first));
+		for (iterator i = first; i != last; i++, target++)
+			::new(target) T(std::move(*i));
 		call_destructors(first, last);
 	}
 
 	static void copy_data(const_iterator first, const_iterator last, iterator target)
 	{
-		copy_data(first, last, target, std::is_trivially_copyable<T>::type());
+		copy_data(first, last, target, typename std::is_trivially_copyable<T>::type());
 	}
 
 	// для тривиальных типов можно использовать memcpy
 	static void copy_data(const_iterator first, const_iterator last, iterator target, std::integral_constant<bool, true>)
 	{
-		std::memcpy(target, first, last - first);
+		std::memcpy(target, first, (last - first) * sizeof(T));
 	}
 
-	// для нетривиальных типов вызывается поэлементное копирование
+	// для нетривиальных типов вызывается поэлементное копирование в неинициализированную память
 	static void copy_data(const_iterator first, const_iterator last, iterator target, std::integral_constant<bool, false>)
 	{
 		for (; first != last; first++, target++)
+			::new(target) T(*first);
+	}
+
+	// источники значений для insert_n: construct создает очередное значение
+	// в сырой памяти, assign присваивает его живому (перемещенному) элементу
+	struct fill_source
+	{
+		const T& val;
+
+		explicit fill_source(const T& v) : val(v) {}
+		void construct(T* p) { ::new(p) T(val); }
+		void assign(T& x) { x = val; }
+	};
+
+	struct move_source
+	{
+		T& val;
+
+		explicit move_source(T& v) : val(v) {}
+		void construct(T* p) { ::new(p) T(std::move(val)); }
+		void assign(T& x) { x = std::move(val); }
+	};
+
+	template <class ForwardIterator>
+	struct range_source
+	{
+		ForwardIterator it;
+
+		explicit range_source(ForwardIterator i) : it(i) {}
+		void construct(T* p) { ::new(p) T(*it); ++it; }
+		void assign(T& x) { x = *it; ++it; }
+	};
+
+	template <class ForwardIterator>
+	iterator insert_range(const_iterator position, ForwardIterator first, ForwardIterator last, std::forward_iterator_tag)
+	{
+		size_t n = static_cast<size_t>(std::distance(first, last));
+		return insert_n(position, n, range_source<ForwardIterator>(first));
+	}
+
+	// длина однопроходного диапазона неизвестна: дописываем в конец и поворачиваем на место
+	template <class InputIterator>
+	iterator insert_range(const_iterator position, InputIterator first, InputIterator last, std::input_iterator_tag)
+	{
+		size_t offset = position - begin();
+		size_t old_size = size();
+		for (; first != last; ++first)
+			emplace_back(*first);
+
+		std::rotate(begin() + offset, begin() + old_size, end());
+		return begin() + offset;
+	}
+
+	// вставка n значений из source перед position; каждый элемент переносится не более одного раза
+	template <class Source>
+	iterator insert_n(const_iterator position, size_t n, Source source)
+	{
+		size_t offset = position - begin();
+		if (n == 0)
+			return begin() + offset;
+
+		size_t new_size = size() + n;
+		if (new_size > capacity())
+		{
+			insert_n_grow(offset, n, source);
+			return begin() + offset;
+		}
+
+		insert_n_shift(begin() + offset, n, source, std::integral_constant<bool, trivially_relocatable>());
+		set_new_size(new_size);
+		return begin() + offset;
+	}
+
+	// емкости не хватает: новые значения создаются сразу в новом буфере, старые
+	// элементы переносятся вокруг них, поэтому хвост не сдвигается отдельно
+	template <class Source>
+	void insert_n_grow(size_t offset, size_t n, Source& source)
+	{
+		size_t new_size = size() + n;
+		if (new_size > max_size())
+			throw std::length_error(u8"попытка выделить памяти больше чем max_size()");
+
+		size_t new_capacity = growth_policy::next_capacity(capacity(), new_size, sizeof(T));
+		if (new_capacity > vector_max_size)
+			new_capacity = new_size;
+
+		auto ptr_begin = allocate_heap(new_capacity);
+		iterator gap = ptr_begin + offset;
+		size_t constructed = 0;
+		try
+		{
+			for (; constructed < n; constructed++)
+				source.construct(gap + constructed);
+		}
+		catch (...)
+		{
+			call_destructors(gap, gap + constructed);
+			deallocate_heap(ptr_begin, new_capacity);
+			throw;
+		}
+
+		iterator b = begin();
+		move_data(b, b + offset, ptr_begin);
+		move_data(b + offset, end(), gap + n);
+
+		if (!is_compact())
+			deallocate_heap(storage.heap_data(), storage.heap_capacity());
+		else
+			note_spill();
+
+		storage.set_heap(ptr_begin, new_capacity, new_size);
+		note_filled();
+	}
+
+	// побайтово переносимые типы: хвост сдвигается одним memmove, значения создаются в сырой памяти
+	template <class Source>
+	void insert_n_shift(iterator p, size_t n, Source& source, std::integral_constant<bool, true>)
+	{
+		iterator e = end();
+		std::memmove(static_cast<void*>(p + n), static_cast<const void*>(p), (e - p) * sizeof(T));
+
+		size_t constructed = 0;
+		try
+		{
+			for (; constructed < n; constructed++)
+				source.construct(p + constructed);
+		}
+		catch (...)
+		{
+			// возвращаем хвост на место, вектор остается прежним
+			call_destructors(p, p + constructed);
+			std::memmove(static_cast<void*>(p), static_cast<const void*>(p + n), (e - p) * sizeof(T));
+			throw;
+		}
+	}
+
+	// остальные типы: хвост перемещается в сырую память за end() конструктором перемещения,
+	// середина - перемещающим присваиванием, новые значения присваиваются или создаются
+	template <class Source>
+	void insert_n_shift(iterator p, size_t n, Source& source, std::integral_constant<bool, false>)
+	{
+		iterator e = end();
+		size_t tail = e - p;
+
+		if (tail > n)
+		{
+			for (iterator from = e - n, to = e; from != e; from++, to++)
+				::new(to) T(std::move(*from));
+			std::move_backward(p, e - n, e);
+			for (iterator i = p; i != p + n; i++)
+				source.assign(*i);
+		}
+		else
+		{
+			for (iterator from = p, to = p + n; from != e; from++, to++)
+				::new(to) T(std::move(*from));
+			for (iterator i = p; i != e; i++)
+				source.assign(*i);
+			for (iterator i = e; i != p + n; i++)
+				source.construct(i);
+		}
+	}
+
+	// побайтово переносимые типы: удаленные элементы разрушаются, хвост сдвигается memmove
+	void erase_n(iterator f, iterator l, std::integral_constant<bool, true>)
+	{
+		iterator e = end();
+		call_destructors(f, l);
+		std::memmove(static_cast<void*>(f), static_cast<const void*>(l), (e - l) * sizeof(T));
+	}
+
+	void erase_n(iterator f, iterator l, std::integral_constant<bool, false>)
+	{
+		iterator e = end();
+		std::move(l, e, f);
+		call_destructors(e - (l - f), e);
+	}
+
+	// уплотнение без ветвлений для арифметических типов: запись безусловная, сдвигается только курсор
+	template <class Predicate>
+	iterator compact_if(Predicate& pred, std::integral_constant<bool, true>)
+	{
+		iterator w = begin();
+		for (iterator i = begin(), e = end(); i != e; i++)
+		{
+			T x = *i;
+			*w = x;
+			w += !pred(x);
+		}
+		return w;
+	}
+
+	template <class Predicate>
+	iterator compact_if(Predicate& pred, std::integral_constant<bool, false>)
+	{
+		iterator w = begin();
+		for (iterator i = begin(), e = end(); i != e; i++)
 		{
-			*target = *first;
+			if (pred(*i))
+				continue;
+			if (w != i)
+				*w = std::move(*i);
+			w++;
 		}
+		return w;
+	}
+
+	size_t remove_value(const T& value, std::integral_constant<bool, true>)
+	{
+		size_t n = compact_vector_simd::remove_equal(data(), size(), value);
+		return erase_tail(begin() + n);
+	}
+
+	size_t remove_value(const T& value, std::integral_constant<bool, false>)
+	{
+		auto equal = [&value](const T& x) { return x == value; };
+		return erase_tail(compact_if(equal, std::integral_constant<bool, std::is_arithmetic<T>::value>()));
+	}
+
+	// разрушение хвоста [w, end()) после уплотнения
+	size_t erase_tail(iterator w)
+	{
+		size_t removed = end() - w;
+		call_destructors(w, end());
+		set_new_size(size() - removed);
+		return removed;
+	}
+
+	size_t find_index(const T& value, std::integral_constant<bool, true>) const
+	{
+		// во встроенном буфере сравнивается весь буфер целиком, лишние дорожки отбрасываются маской
+		if (is_compact())
+			return compact_vector_simd::find_equal_fixed<compact_capacity>(storage.compact_data(), size(), value);
+		return compact_vector_simd::find_equal(data(), size(), value);
+	}
+
+	size_t find_index(const T& value, std::integral_constant<bool, false>) const
+	{
+		size_t n = size();
+		const T* d = data();
+		for (size_t i = 0; i < n; i++)
+			if (d[i] == value)
+				return i;
+		return n;
+	}
+
+	size_t count_equal(const T& value, std::integral_constant<bool, true>) const
+	{
+		if (is_compact())
+			return compact_vector_simd::count_equal_fixed<compact_capacity>(storage.compact_data(), size(), value);
+		return compact_vector_simd::count_equal(data(), size(), value);
+	}
+
+	size_t count_equal(const T& value, std::integral_constant<bool, false>) const
+	{
+		return std::count(begin(), end(), value);
+	}
+
+	template <bool maximum>
+	size_t extremum_index(std::integral_constant<bool, true>) const
+	{
+		return maximum ? compact_vector_simd::max_index(data(), size()) : compact_vector_simd::min_index(data(), size());
+	}
+
+	template <bool maximum>
+	size_t extremum_index(std::integral_constant<bool, false>) const
+	{
+		const_iterator i = maximum ? std::max_element(begin(), end()) : std::min_element(begin(), end());
+		return i - begin();
+	}
+
+	// через allocator_traits: указатель аллокатора может быть fancy pointer
+	T* allocate_heap(size_t n)
+	{
+		T* p = compact_vector_traits::to_address(allocator_traits::allocate(*storage.get_allocator(), n));
+		note_allocate(n);
+		return p;
+	}
+
+	void deallocate_heap(T* p, size_t n)
+	{
+		allocator_traits::deallocate(*storage.get_allocator(), compact_vector_traits::from_address<typename allocator_traits::pointer>(p), n);
+		note_deallocate(n);
+	}
+
+	// точки сбора телеметрии; без COMPACT_VECTOR_TELEMETRY пустые и исчезают после встраивания
+	void note_spill() noexcept
+	{
+#ifdef COMPACT_VECTOR_TELEMETRY
+		compact_vector_telemetry::on_spill<this_type>();
+#endif // COMPACT_VECTOR_TELEMETRY
+	}
+
+	void note_return() noexcept
+	{
+#ifdef COMPACT_VECTOR_TELEMETRY
+		compact_vector_telemetry::on_return<this_type>();
+#endif // COMPACT_VECTOR_TELEMETRY
+	}
+
+	void note_allocate(size_t n) noexcept
+	{
+#ifdef COMPACT_VECTOR_TELEMETRY
+		compact_vector_telemetry::on_allocate<this_type>(n * sizeof(T));
+#else
+		(void)n;
+#endif // COMPACT_VECTOR_TELEMETRY
+	}
+
+	void note_deallocate(size_t n) noexcept
+	{
+#ifdef COMPACT_VECTOR_TELEMETRY
+		compact_vector_telemetry::on_deallocate<this_type>(n * sizeof(T));
+#else
+		(void)n;
+#endif // COMPACT_VECTOR_TELEMETRY
+	}
+
+	// пустой вектор после перемещения не отражает итоговый размер и считается в телеметрии отдельно;
+	// флаг снимается при любой записи элементов и при обмене переходит вместе с содержимым
+	void note_moved_from() noexcept
+	{
+#ifdef COMPACT_VECTOR_TELEMETRY
+		moved_from_shell = true;
+#endif // COMPACT_VECTOR_TELEMETRY
+	}
+
+	void note_filled() noexcept
+	{
+#ifdef COMPACT_VECTOR_TELEMETRY
+		moved_from_shell = false;
+#endif // COMPACT_VECTOR_TELEMETRY
+	}
+
+	void swap_moved_from(this_type& x) noexcept
+	{
+#ifdef COMPACT_VECTOR_TELEMETRY
+		std::swap(moved_from_shell, x.moved_from_shell);
+#else
+		(void)x;
+#endif // COMPACT_VECTOR_TELEMETRY
+	}
+
+	void note_destruct() noexcept
+	{
+#ifdef COMPACT_VECTOR_TELEMETRY
+		compact_vector_telemetry::on_destruct<this_type>(size(), capacity(), moved_from_shell && size() == 0);
+#endif // COMPACT_VECTOR_TELEMETRY
 	}
 };
 
+/// erase_if
+/*!
+Free function form of compact_vector::erase_if.
+*/
+template <class T, int compact_max_size, class allocator_type, class growth_policy,
+	template<class, int, class, class> class layout, class size_type, class Predicate>
+size_t erase_if(compact_vector<T, compact_max_size, allocator_type, growth_policy, layout, size_type>& c, Predicate pred)
+{
+	return c.erase_if(pred);
+}
+
+/// remove_value
+/*!
+Free function form of compact_vector::remove_value.
+*/
+template <class T, int compact_max_size, class allocator_type, class growth_policy,
+	template<class, int, class, class> class layout, class size_type>
+size_t remove_value(compact_vector<T, compact_max_size, allocator_type, growth_policy, layout, size_type>& c,
+	const typename compact_vector<T, compact_max_size, allocator_type, growth_policy, layout, size_type>::value_type& value)
+{
+	return c.remove_value(value);
+}
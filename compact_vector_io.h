@@ -0,0 +1,279 @@
+#pragma once
+
+#include "compact_vector.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#define COMPACT_VECTOR_HAS_IOVEC 1
+#endif
+
+#ifdef COMPACT_VECTOR_HAS_IOVEC
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+/// compact_vector_batch_io
+/*!
+Gather-write and scatter-read of many vectors of trivially copyable elements with writev / readv
+(pwritev / preadv at an explicit offset). The iovec array points straight at data() of every vector
+longer than copy_limit bytes, inline or on the heap, so large state is not copied in user space;
+runs of short vectors share one iovec of a staging buffer.
+
+A batch is a table of element counts (one uint64_t per vector, native byte order) followed by
+the elements of every vector back to back. read() takes a range of the same length, sizes each vector
+with resize_for_overwrite() (inline when it fits) and reads the elements into its storage.
+Partial transfers and EINTR are retried; IOV_MAX limits the iovecs of one system call.
+Errors throw std::system_error, a file that ends inside a batch throws std::out_of_range.
+Every vector is sized before any element is read, so after a failed read() the vectors have the right
+sizes but unspecified elements; if the count table itself could not be read, they are left unchanged.
+
+The object keeps its iovec and count arrays between calls, so repeated checkpoints do not allocate.
+*/
+class compact_vector_batch_io
+{
+public:
+	/// vectors of up to copy_limit bytes go through a staging run
+	/*!
+	The kernel spends about as much on an iovec as on copying a few hundred bytes, so runs of short
+	vectors are coalesced into one iovec of a reused staging buffer, and only longer vectors are
+	written from and read into their own storage.
+	*/
+	static constexpr size_t copy_limit = 512;
+
+	/// writes the vectors in [first, last) at the current file position; returns the bytes written
+	template <class Iterator>
+	size_t write(int fd, Iterator first, Iterator last)
+	{
+		plan_write(first, last);
+		return transfer(fd, -1, true);
+	}
+
+	/// writes the vectors in [first, last) at offset; the file position is not changed
+	template <class Iterator>
+	size_t pwrite(int fd, off_t offset, Iterator first, Iterator last)
+	{
+		plan_write(first, last);
+		return transfer(fd, offset, true);
+	}
+
+	/// reads a batch into the vectors in [first, last) from the current file position; returns the bytes read
+	template <class Iterator>
+	size_t read(int fd, Iterator first, Iterator last)
+	{
+		size_t header = read_counts(fd, -1, first, last);
+		plan_read(first, last);
+		size_t bytes = transfer(fd, -1, false);
+		finish_read(first, last);
+		return header + bytes;
+	}
+
+	/// reads a batch into the vectors in [first, last) from offset; the file position is not changed
+	template <class Iterator>
+	size_t pread(int fd, off_t offset, Iterator first, Iterator last)
+	{
+		size_t header = read_counts(fd, offset, first, last);
+		plan_read(first, last);
+		size_t bytes = transfer(fd, offset + static_cast<off_t>(header), false);
+		finish_read(first, last);
+		return header + bytes;
+	}
+
+	/// bytes of a batch of the vectors in [first, last)
+	template <class Iterator>
+	static size_t batch_bytes(Iterator first, Iterator last)
+	{
+		size_t bytes = 0;
+		for (; first != last; ++first)
+			bytes += sizeof(uint64_t) + first->size() * sizeof(*first->data());
+		return bytes;
+	}
+
+private:
+	std::vector<iovec> iov;
+	std::vector<uint64_t> counts;
+	std::vector<unsigned char> staging;
+
+	template <class Vector>
+	static void check_element_type()
+	{
+		static_assert(std::is_trivially_copyable<typename Vector::value_type>::value, "batch I/O requires trivially copyable elements");
+	}
+
+	// пустые векторы не дают iovec: иначе writev может вернуть 0 при незаконченной передаче
+	void add(const void* p, size_t bytes)
+	{
+		if (bytes != 0)
+			iov.push_back(iovec{const_cast<void*>(p), bytes});
+	}
+
+	template <class Iterator>
+	void plan_write(Iterator first, Iterator last)
+	{
+		check_element_type<typename std::iterator_traits<Iterator>::value_type>();
+
+		counts.clear();
+		size_t staged_bytes = 0;
+		for (Iterator i = first; i != last; ++i)
+		{
+			size_t bytes = i->size() * sizeof(*i->data());
+			counts.push_back(i->size());
+			if (bytes <= copy_limit)
+				staged_bytes += bytes;
+		}
+
+		iov.clear();
+		add(counts.data(), counts.size() * sizeof(uint64_t));
+
+		// короткие векторы подряд копируются в один iovec, длинные передаются со своего места
+		staging.resize(staged_bytes);
+		unsigned char* staged = staging.data();
+		for (; first != last; ++first)
+		{
+			size_t bytes = first->size() * sizeof(*first->data());
+			if (bytes == 0 || bytes > copy_limit)
+			{
+				add(first->data(), bytes);
+				continue;
+			}
+
+			std::memcpy(staged, first->data(), bytes);
+			if (!iov.empty() && static_cast<unsigned char*>(iov.back().iov_base) + iov.back().iov_len == staged)
+				iov.back().iov_len += bytes;
+			else
+				add(staged, bytes);
+			staged += bytes;
+		}
+	}
+
+	template <class Iterator>
+	size_t read_counts(int fd, off_t offset, Iterator first, Iterator last)
+	{
+		check_element_type<typename std::iterator_traits<Iterator>::value_type>();
+
+		counts.resize(static_cast<size_t>(std::distance(first, last)));
+		iov.clear();
+		add(counts.data(), counts.size() * sizeof(uint64_t));
+		return transfer(fd, offset, false);
+	}
+
+	// все векторы сразу получают размер; длинные получают свой iovec, короткие читаются в staging
+	// и копируются в finish_read
+	template <class Iterator>
+	void plan_read(Iterator first, Iterator last)
+	{
+		using T = typename std::iterator_traits<Iterator>::value_type::value_type;
+
+		// испорченный счетчик не должен переполнить *count * sizeof(T) и размер пакета
+		const uint64_t max_count = (SIZE_MAX - counts.size() * sizeof(uint64_t)) / sizeof(T);
+
+		size_t staged_bytes = 0;
+		Iterator i = first;
+		for (const uint64_t* count = counts.data(); i != last; ++i, ++count)
+		{
+			if (*count > i->max_size())
+				throw std::out_of_range(u8"compact_vector_batch_io: element count exceeds max_size()");
+			if (*count > max_count)
+				throw std::out_of_range(u8"compact_vector_batch_io: element count overflows the batch size");
+			if (*count * sizeof(T) <= copy_limit)
+				staged_bytes += static_cast<size_t>(*count) * sizeof(T);
+		}
+
+		iov.clear();
+		staging.resize(staged_bytes);
+		unsigned char* staged = staging.data();
+		for (const uint64_t* count = counts.data(); first != last; ++first, ++count)
+		{
+			size_t bytes = static_cast<size_t>(*count) * sizeof(T);
+			first->resize_for_overwrite(static_cast<size_t>(*count));
+			if (bytes > copy_limit)
+				add(first->data(), bytes);
+			else if (bytes != 0)
+			{
+				if (!iov.empty() && static_cast<unsigned char*>(iov.back().iov_base) + iov.back().iov_len == staged)
+					iov.back().iov_len += bytes;
+				else
+					add(staged, bytes);
+				staged += bytes;
+			}
+		}
+	}
+
+	template <class Iterator>
+	void finish_read(Iterator first, Iterator last)
+	{
+		using T = typename std::iterator_traits<Iterator>::value_type::value_type;
+
+		const unsigned char* staged = staging.data();
+		for (const uint64_t* count = counts.data(); first != last; ++first, ++count)
+		{
+			size_t bytes = static_cast<size_t>(*count) * sizeof(T);
+			if (bytes <= copy_limit && bytes != 0)
+			{
+				std::memcpy(static_cast<void*>(first->data()), staged, bytes);
+				staged += bytes;
+			}
+		}
+	}
+
+	// передает все iovec, продолжая после частичных передач; offset < 0 - текущая позиция файла
+	size_t transfer(int fd, off_t offset, bool writing)
+	{
+		iovec* v = iov.data();
+		size_t left = iov.size();
+		size_t total = 0;
+		while (left != 0)
+		{
+			int n = left > IOV_MAX ? IOV_MAX : static_cast<int>(left);
+			ssize_t done;
+			if (offset < 0)
+				done = writing ? ::writev(fd, v, n) : ::readv(fd, v, n);
+			else
+			{
+				off_t at = offset + static_cast<off_t>(total);
+				done = writing ? ::pwritev(fd, v, n, at) : ::preadv(fd, v, n, at);
+			}
+
+			if (done < 0)
+			{
+				if (errno == EINTR)
+					continue;
+				throw std::system_error(errno, std::generic_category(), writing ? "writev" : "readv");
+			}
+			if (done == 0)
+				throw std::out_of_range(u8"compact_vector_batch_io: unexpected end of file");
+
+			total += static_cast<size_t>(done);
+
+			// пропускаем переданные iovec, частично переданный укорачиваем
+			size_t bytes = static_cast<size_t>(done);
+			while (left != 0 && bytes >= v->iov_len)
+			{
+				bytes -= v->iov_len;
+				++v;
+				--left;
+			}
+			if (left != 0)
+			{
+				v->iov_base = static_cast<char*>(v->iov_base) + bytes;
+				v->iov_len -= bytes;
+			}
+		}
+		return total;
+	}
+};
+
+#endif // COMPACT_VECTOR_HAS_IOVEC
@@ -0,0 +1,450 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+/// compact_vector_pool
+/*!
+Jagged array: many small vectors (rows) stored in one contiguous value buffer, CSR-style.
+Every row is a header {offset, size, capacity} of three size_type words (12 bytes with the
+default uint32_t) instead of a whole compact_vector, and rows sit next to each other in the
+order they were laid out, so a scan over all rows reads memory sequentially.
+
+A row that outgrows its capacity is extended in place if it is the last one in the buffer,
+otherwise it is moved to the end of the buffer with doubled capacity and leaves a hole.
+When holes exceed half of the buffer, the pool is compacted: rows are rewritten in row order
+with a quarter of their size as slack. compact() and shrink_to_fit() do the same on demand.
+
+Growing a row may move other rows (on compaction), so pointers and row views into the pool
+are invalidated by any operation that adds elements; views stay valid across reads and erases.
+T must be trivially copyable: rows are moved with memcpy.
+*/
+template <class T, class size_type = uint32_t, class allocator_type = std::allocator<T>>
+class compact_vector_pool
+{
+	static_assert(std::is_trivially_copyable<T>::value, "compact_vector_pool requires a trivially copyable T");
+
+	struct row_header
+	{
+		size_type offset;
+		size_type size;
+		size_type capacity;
+	};
+
+public:
+	using value_type = T;
+	using iterator = T*;
+	using const_iterator = const T*;
+
+	/// read-only view of a row
+	class const_row
+	{
+	public:
+		const_row(const T* first, size_t size) noexcept :
+			first(first),
+			count(size)
+		{}
+
+		const T* begin() const noexcept
+		{
+			return first;
+		}
+
+		const T* end() const noexcept
+		{
+			return first + count;
+		}
+
+		const T* data() const noexcept
+		{
+			return first;
+		}
+
+		size_t size() const noexcept
+		{
+			return count;
+		}
+
+		bool empty() const noexcept
+		{
+			return count == 0;
+		}
+
+		const T& operator[] (size_t n) const
+		{
+			return first[n];
+		}
+
+		const T& front() const
+		{
+			return first[0];
+		}
+
+		const T& back() const
+		{
+			return first[count - 1];
+		}
+
+	private:
+		const T* first;
+		size_t count;
+	};
+
+	/// mutable view of a row with a compact_vector-like interface
+	class row
+	{
+	public:
+		row(compact_vector_pool* pool, size_t index) noexcept :
+			pool(pool),
+			index(index)
+		{}
+
+		operator const_row() const noexcept
+		{
+			return static_cast<const compact_vector_pool*>(pool)->get_row(index);
+		}
+
+		T* begin() noexcept
+		{
+			return pool->row_data(index);
+		}
+
+		T* end() noexcept
+		{
+			return begin() + size();
+		}
+
+		T* data() noexcept
+		{
+			return begin();
+		}
+
+		size_t size() const noexcept
+		{
+			return pool->headers[index].size;
+		}
+
+		size_t capacity() const noexcept
+		{
+			return pool->headers[index].capacity;
+		}
+
+		bool empty() const noexcept
+		{
+			return size() == 0;
+		}
+
+		T& operator[] (size_t n)
+		{
+			return begin()[n];
+		}
+
+		T& front()
+		{
+			return *begin();
+		}
+
+		T& back()
+		{
+			return begin()[size() - 1];
+		}
+
+		void push_back(const T& val)
+		{
+			pool->push_back(index, val);
+		}
+
+		void pop_back()
+		{
+			pool->headers[index].size--;
+		}
+
+		T* erase(const T* position)
+		{
+			return erase(position, position + 1);
+		}
+
+		T* erase(const T* first, const T* last)
+		{
+			return pool->erase(index, first - begin(), last - first);
+		}
+
+		void clear() noexcept
+		{
+			pool->headers[index].size = 0;
+		}
+
+		void reserve(size_t n)
+		{
+			pool->reserve_row(index, n);
+		}
+
+		template <class InputIterator>
+		void assign(InputIterator first, InputIterator last)
+		{
+			clear();
+			for (; first != last; ++first)
+				push_back(*first);
+		}
+
+	private:
+		compact_vector_pool* pool;
+		size_t index;
+	};
+
+	explicit compact_vector_pool(const allocator_type& alloc = allocator_type()) :
+		values(alloc)
+	{}
+
+	/// pool of n empty rows
+	explicit compact_vector_pool(size_t n, const allocator_type& alloc = allocator_type()) :
+		values(alloc)
+	{
+		resize(n);
+	}
+
+	/// number of rows
+	size_t size() const noexcept
+	{
+		return headers.size();
+	}
+
+	bool empty() const noexcept
+	{
+		return headers.empty();
+	}
+
+	/// changes the number of rows; new rows are empty, the space of removed rows becomes a hole
+	void resize(size_t n)
+	{
+		for (size_t i = n; i < headers.size(); i++)
+			live_capacity -= headers[i].capacity;
+
+		row_header empty_row = {checked(values.size()), 0, 0};
+		headers.resize(n, empty_row);
+	}
+
+	/// appends an empty row with room for capacity elements and returns its index
+	size_t add_row(size_t capacity = 0)
+	{
+		headers.push_back(row_header{checked(values.size()), 0, 0});
+		if (capacity != 0)
+			reserve_row(headers.size() - 1, capacity);
+		return headers.size() - 1;
+	}
+
+	/// appends a row with a copy of [first,last) and returns its index
+	template <class InputIterator, class = typename std::enable_if<!std::is_integral<InputIterator>::value>::type>
+	size_t add_row(InputIterator first, InputIterator last)
+	{
+		size_t index = add_row();
+		(*this)[index].assign(first, last);
+		return index;
+	}
+
+	size_t add_row(std::initializer_list<T> il)
+	{
+		return add_row(il.begin(), il.end());
+	}
+
+	row operator[] (size_t n) noexcept
+	{
+		return row(this, n);
+	}
+
+	const_row operator[] (size_t n) const noexcept
+	{
+		return get_row(n);
+	}
+
+	row at(size_t n)
+	{
+		if (n >= headers.size())
+			throw std::out_of_range(u8"compact_vector_pool out of range");
+		return row(this, n);
+	}
+
+	const_row at(size_t n) const
+	{
+		if (n >= headers.size())
+			throw std::out_of_range(u8"compact_vector_pool out of range");
+		return get_row(n);
+	}
+
+	void push_back(size_t n, const T& val)
+	{
+		row_header& h = headers[n];
+		if (h.size == h.capacity)
+		{
+			// val может ссылаться на элемент пула, который переедет при росте
+			T copy = val;
+			grow_row(n, h.size + 1);
+			row_header& moved = headers[n];
+			values[moved.offset + moved.size++] = copy;
+			return;
+		}
+		values[h.offset + h.size++] = val;
+	}
+
+	/// removes count elements of row n starting at position, returns a pointer to the element after them
+	T* erase(size_t n, size_t position, size_t count)
+	{
+		row_header& h = headers[n];
+		T* first = values.data() + h.offset + position;
+		std::memmove(static_cast<void*>(first), first + count, (h.size - position - count) * sizeof(T));
+		h.size -= static_cast<size_type>(count);
+		return first;
+	}
+
+	void reserve_row(size_t n, size_t capacity)
+	{
+		if (capacity > headers[n].capacity)
+			grow_row(n, capacity);
+	}
+
+	/// rewrites rows contiguously in row order, keeping a quarter of each row's size as slack
+	void compact()
+	{
+		relayout(headers.size(), 0, 4);
+	}
+
+	/// rewrites rows contiguously in row order without slack
+	void shrink_to_fit()
+	{
+		relayout(headers.size(), 0, 0);
+		values.shrink_to_fit();
+	}
+
+	/// removes all rows
+	void clear() noexcept
+	{
+		headers.clear();
+		values.clear();
+		live_capacity = 0;
+	}
+
+	/// elements in the value buffer, including slack and holes
+	size_t buffer_size() const noexcept
+	{
+		return values.size();
+	}
+
+	/// elements in the value buffer that belong to no row
+	size_t garbage() const noexcept
+	{
+		return values.size() - live_capacity;
+	}
+
+	/// elements of all rows
+	size_t total_size() const noexcept
+	{
+		size_t total = 0;
+		for (const auto& h : headers)
+			total += h.size;
+		return total;
+	}
+
+	allocator_type get_allocator() const noexcept
+	{
+		return values.get_allocator();
+	}
+
+private:
+	std::vector<row_header> headers;
+	std::vector<T, allocator_type> values;
+	size_t live_capacity = 0;
+
+	static size_type checked(size_t n)
+	{
+		if (n > static_cast<size_t>(std::numeric_limits<size_type>::max()))
+			throw std::length_error(u8"размер буфера compact_vector_pool не помещается в size_type");
+		return static_cast<size_type>(n);
+	}
+
+	const_row get_row(size_t n) const noexcept
+	{
+		const row_header& h = headers[n];
+		return const_row(values.data() + h.offset, h.size);
+	}
+
+	T* row_data(size_t n) noexcept
+	{
+		return values.data() + headers[n].offset;
+	}
+
+	void grow_row(size_t n, size_t required)
+	{
+		row_header& h = headers[n];
+		size_t capacity = h.capacity < 2 ? 4 : 2 * static_cast<size_t>(h.capacity);
+		if (capacity < required)
+			capacity = required;
+
+		// последняя строка буфера растет на месте
+		if (static_cast<size_t>(h.offset) + h.capacity == values.size())
+		{
+			checked(h.offset + capacity);
+			values.resize(h.offset + capacity);
+			live_capacity += capacity - h.capacity;
+			h.capacity = static_cast<size_type>(capacity);
+			return;
+		}
+
+		// перенос в конец оставит дыру; если дыры займут больше половины буфера, выгоднее уплотнить все
+		if ((garbage() + h.capacity) * 2 > values.size() + capacity)
+		{
+			relayout(n, capacity, 4);
+			return;
+		}
+
+		size_t offset = values.size();
+		checked(offset + capacity);
+		values.resize(offset + capacity);
+		row_header& moved = headers[n];
+		std::memcpy(static_cast<void*>(values.data() + offset), values.data() + moved.offset, moved.size * sizeof(T));
+		live_capacity += capacity - moved.capacity;
+		moved.offset = static_cast<size_type>(offset);
+		moved.capacity = static_cast<size_type>(capacity);
+	}
+
+	// строки переписываются подряд в новый буфер; строка grown получает емкость grown_capacity,
+	// остальные - size + size / slack_divisor (без запаса при slack_divisor == 0)
+	void relayout(size_t grown, size_t grown_capacity, size_t slack_divisor)
+	{
+		size_t total = 0;
+		for (size_t i = 0; i < headers.size(); i++)
+			total += new_capacity(i, grown, grown_capacity, slack_divisor);
+		checked(total);
+
+		std::vector<T, allocator_type> buffer(values.get_allocator());
+		buffer.resize(total);
+
+		size_t offset = 0;
+		for (size_t i = 0; i < headers.size(); i++)
+		{
+			row_header& h = headers[i];
+			size_t capacity = new_capacity(i, grown, grown_capacity, slack_divisor);
+			std::memcpy(static_cast<void*>(buffer.data() + offset), values.data() + h.offset, h.size * sizeof(T));
+			h.offset = static_cast<size_type>(offset);
+			h.capacity = static_cast<size_type>(capacity);
+			offset += capacity;
+		}
+
+		values.swap(buffer);
+		live_capacity = total;
+	}
+
+	size_t new_capacity(size_t i, size_t grown, size_t grown_capacity, size_t slack_divisor) const noexcept
+	{
+		if (i == grown)
+			return grown_capacity;
+		size_t size = headers[i].size;
+		return slack_divisor == 0 ? size : size + size / slack_divisor;
+	}
+};
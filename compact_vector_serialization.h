@@ -0,0 +1,386 @@
+#pragma once
+
+#include "compact_vector.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+/// compact_vector_view
+/*!
+Non-owning read-only view of contiguous elements: a pointer and a size. It does not allocate,
+so it can point straight into a mapped file or a network buffer (see compact_vector_reader::read_view).
+The viewed memory must outlive the view.
+*/
+template <class T>
+class compact_vector_view
+{
+public:
+	using value_type = T;
+	using size_type = size_t;
+	using const_iterator = const T*;
+	using iterator = const T*;
+
+	compact_vector_view() noexcept
+	{}
+
+	compact_vector_view(const T* data, size_t size) noexcept :
+		first(data),
+		count(size)
+	{}
+
+	/// a view of a container with data() and size(), e.g. compact_vector or std::vector
+	template <class Container, class = decltype(std::declval<const Container&>().data() + std::declval<const Container&>().size())>
+	compact_vector_view(const Container& x) noexcept :
+		first(x.data()),
+		count(x.size())
+	{}
+
+	const T* data() const noexcept
+	{
+		return first;
+	}
+
+	size_t size() const noexcept
+	{
+		return count;
+	}
+
+	bool empty() const noexcept
+	{
+		return count == 0;
+	}
+
+	const T* begin() const noexcept
+	{
+		return first;
+	}
+
+	const T* end() const noexcept
+	{
+		return first + count;
+	}
+
+	const T& operator[] (size_t n) const noexcept
+	{
+		return first[n];
+	}
+
+	const T& at(size_t n) const
+	{
+		if (n >= count)
+			throw std::out_of_range(u8"compact_vector_view out of range");
+
+		return first[n];
+	}
+
+	const T& front() const noexcept
+	{
+		return first[0];
+	}
+
+	const T& back() const noexcept
+	{
+		return first[count - 1];
+	}
+
+private:
+	const T* first = nullptr;
+	size_t count = 0;
+};
+
+/// binary format
+/*!
+A raw record is the element count as an LEB128 varint followed by the elements' bytes in native
+byte order; it is written for trivially copyable T. The varint may be padded with redundant
+continuation bytes (0x80) so that the payload starts at an offset from the start of the output
+buffer that is a multiple of alignof(T); element types aligned to more than max_alignment (64) bytes
+are rejected at compile time. A reader does not need to know the padding, and when
+the buffer itself is aligned (heap blocks, mapped files) the payload can be viewed in place.
+
+A delta record holds integers: the count, then the first value and the differences between
+neighbours, each zigzag-encoded as a varint. Sorted sequences of close values take one or two bytes
+per element. Delta records have no padding and are always decoded into a container.
+*/
+namespace compact_vector_serialization
+{
+	// наибольшее выравнивание элементов сырых записей (строка кэша)
+	static constexpr size_t max_alignment = 64;
+
+	// самый длинный varint: 10 байт значения и до max_alignment - 1 байт выравнивания
+	static constexpr size_t max_varint_bytes = 10 + max_alignment - 1;
+
+	inline size_t varint_size(uint64_t value) noexcept
+	{
+		size_t bytes = 1;
+		while (value >= 0x80)
+		{
+			value >>= 7;
+			bytes++;
+		}
+		return bytes;
+	}
+
+	// пишет varint в bytes байт, лишние байты - продолжения с нулевыми битами
+	inline unsigned char* put_varint(unsigned char* p, uint64_t value, size_t bytes) noexcept
+	{
+		for (size_t i = 1; i < bytes; i++)
+		{
+			*p++ = static_cast<unsigned char>(value | 0x80);
+			value >>= 7;
+		}
+		*p++ = static_cast<unsigned char>(value);
+		return p;
+	}
+
+	inline uint64_t zigzag(uint64_t value) noexcept
+	{
+		return (value << 1) ^ (uint64_t(0) - (value >> 63));
+	}
+
+	inline uint64_t unzigzag(uint64_t value) noexcept
+	{
+		return (value >> 1) ^ (uint64_t(0) - (value & 1));
+	}
+
+	// число байт выравнивания, чтобы данные после varint легли по смещению, кратному alignment
+	inline size_t padding(size_t offset, uint64_t count, size_t alignment) noexcept
+	{
+		if (count == 0)
+			return 0;
+		size_t payload = offset + varint_size(count);
+		return (alignment - payload % alignment) % alignment;
+	}
+
+	template <class Container>
+	size_t raw_record_size(size_t offset, const Container& x) noexcept
+	{
+		using T = typename std::remove_cv<typename std::remove_reference<decltype(*x.data())>::type>::type;
+		return varint_size(x.size()) + padding(offset, x.size(), alignof(T)) + x.size() * sizeof(T);
+	}
+}
+
+/// compact_vector_writer
+/*!
+Appends records to a byte buffer: any container of char or unsigned char with size(), resize() and data(),
+such as std::vector<unsigned char>, std::string or compact_vector<unsigned char>. Alignment padding
+is computed from offsets in this buffer. write(first, last) writes a batch of records with a single
+resize of the buffer.
+*/
+template <class Buffer>
+class compact_vector_writer
+{
+public:
+	explicit compact_vector_writer(Buffer& buffer) noexcept :
+		out(buffer)
+	{}
+
+	/// appends a raw record of a container with data() and size() of trivially copyable elements
+	template <class Container>
+	void write(const Container& x)
+	{
+		write(&x, &x + 1);
+	}
+
+	/// appends raw records of the containers in [first, last)
+	template <class Iterator>
+	void write(Iterator first, Iterator last)
+	{
+		size_t offset = out.size();
+		size_t end = offset;
+		for (Iterator i = first; i != last; ++i)
+			end += compact_vector_serialization::raw_record_size(end, *i);
+		if (end == offset)
+			return;
+
+		out.resize(end);
+		unsigned char* p = bytes() + offset;
+		for (; first != last; ++first)
+			p = put_raw(p, *first);
+	}
+
+	/// appends a delta record of a container of integers
+	template <class Container>
+	void write_delta(const Container& x)
+	{
+		using T = typename std::remove_cv<typename std::remove_reference<decltype(*x.data())>::type>::type;
+		static_assert(std::is_integral<T>::value, "delta encoding requires integers");
+
+		using namespace compact_vector_serialization;
+
+		// сначала резервируем худший случай, затем обрезаем до записанного
+		size_t offset = out.size();
+		out.resize(offset + (x.size() + 1) * 10);
+		unsigned char* p = bytes() + offset;
+
+		p = put_varint(p, x.size(), varint_size(x.size()));
+		uint64_t previous = 0;
+		const T* values = x.data();
+		for (size_t i = 0; i < x.size(); i++)
+		{
+			uint64_t value = static_cast<uint64_t>(values[i]);
+			uint64_t delta = zigzag(value - previous);
+			p = put_varint(p, delta, varint_size(delta));
+			previous = value;
+		}
+		out.resize(p - bytes());
+	}
+
+	Buffer& buffer() noexcept
+	{
+		return out;
+	}
+
+private:
+	Buffer& out;
+
+	unsigned char* bytes() noexcept
+	{
+		return reinterpret_cast<unsigned char*>(&out[0]);
+	}
+
+	template <class Container>
+	unsigned char* put_raw(unsigned char* p, const Container& x) noexcept
+	{
+		using T = typename std::remove_cv<typename std::remove_reference<decltype(*x.data())>::type>::type;
+		static_assert(std::is_trivially_copyable<T>::value, "raw records require trivially copyable elements");
+		static_assert(alignof(T) <= compact_vector_serialization::max_alignment, "raw record padding is limited to max_alignment");
+
+		using namespace compact_vector_serialization;
+
+		size_t offset = p - bytes();
+		p = put_varint(p, x.size(), varint_size(x.size()) + padding(offset, x.size(), alignof(T)));
+		if (x.size() != 0)
+			std::memcpy(p, x.data(), x.size() * sizeof(T));
+		return p + x.size() * sizeof(T);
+	}
+};
+
+/// compact_vector_reader
+/*!
+Reads records written by compact_vector_writer from a span of bytes. read() copies a raw record
+into a compact_vector (a single memcpy, inline when it fits), read_view() returns a view
+of the payload without copying. A truncated or malformed record throws std::out_of_range and leaves
+the read position unchanged.
+*/
+class compact_vector_reader
+{
+public:
+	compact_vector_reader(const void* data, size_t bytes) noexcept :
+		first(static_cast<const unsigned char*>(data)),
+		cursor(first),
+		last(first + bytes)
+	{}
+
+	/// replaces the contents of v with the next raw record
+	template <class Vector>
+	void read(Vector& v)
+	{
+		using T = typename Vector::value_type;
+		size_t n;
+		const unsigned char* payload = next_raw(sizeof(T), n);
+		v.assign_bytes(payload, n);
+		cursor = payload + n * sizeof(T);
+	}
+
+	/// the next raw record in place; throws std::invalid_argument if the payload is not aligned for T
+	template <class T>
+	compact_vector_view<T> read_view()
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "raw records require trivially copyable elements");
+		static_assert(alignof(T) <= compact_vector_serialization::max_alignment, "raw record padding is limited to max_alignment");
+
+		size_t n;
+		const unsigned char* payload = next_raw(sizeof(T), n);
+		if (n != 0 && reinterpret_cast<uintptr_t>(payload) % alignof(T) != 0)
+			throw std::invalid_argument(u8"compact_vector_reader: payload is not aligned, use read()");
+
+		cursor = payload + n * sizeof(T);
+		return compact_vector_view<T>(n == 0 ? nullptr : reinterpret_cast<const T*>(payload), n);
+	}
+
+	/// replaces the contents of v with the next delta record
+	template <class Vector>
+	void read_delta(Vector& v)
+	{
+		using T = typename Vector::value_type;
+		static_assert(std::is_integral<T>::value, "delta encoding requires integers");
+
+		const unsigned char* p = cursor;
+		uint64_t n = next_varint(p);
+		// каждое значение занимает хотя бы байт
+		if (n > static_cast<uint64_t>(last - p))
+			throw_truncated();
+
+		v.resize(static_cast<size_t>(n));
+		T* values = v.data();
+		uint64_t value = 0;
+		for (size_t i = 0; i < n; i++)
+		{
+			value += compact_vector_serialization::unzigzag(next_varint(p));
+			values[i] = static_cast<T>(value);
+		}
+		cursor = p;
+	}
+
+	bool at_end() const noexcept
+	{
+		return cursor == last;
+	}
+
+	/// offset of the next record from the start of the span
+	size_t position() const noexcept
+	{
+		return cursor - first;
+	}
+
+	size_t remaining() const noexcept
+	{
+		return last - cursor;
+	}
+
+private:
+	const unsigned char* first;
+	const unsigned char* cursor;
+	const unsigned char* last;
+
+	[[noreturn]] static void throw_truncated()
+	{
+		throw std::out_of_range(u8"compact_vector_reader: truncated or malformed record");
+	}
+
+	// биты за пределами 64 отбрасываются, как в protobuf; длина записи все равно проверяется по границе
+	uint64_t next_varint(const unsigned char*& p) const
+	{
+		// короткие длины и разности занимают один байт
+		if (p != last && *p < 0x80)
+			return *p++;
+
+		const unsigned char* end = static_cast<size_t>(last - p) > compact_vector_serialization::max_varint_bytes ?
+			p + compact_vector_serialization::max_varint_bytes : last;
+		uint64_t value = 0;
+		for (unsigned shift = 0; p != end; shift += 7)
+		{
+			unsigned char byte = *p++;
+			if (shift < 64)
+				value |= uint64_t(byte & 0x7f) << shift;
+			if (byte < 0x80)
+				return value;
+		}
+		throw_truncated();
+	}
+
+	// разбирает заголовок сырой записи; cursor не двигается
+	const unsigned char* next_raw(size_t element_size, size_t& n) const
+	{
+		const unsigned char* p = cursor;
+		uint64_t count = next_varint(p);
+		if (count > static_cast<uint64_t>(last - p) / element_size)
+			throw_truncated();
+
+		n = static_cast<size_t>(count);
+		return p;
+	}
+};
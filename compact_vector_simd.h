@@ -0,0 +1,978 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define COMPACT_VECTOR_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+/// vectorized kernels
+/*!
+Kernels used by compact_vector for bulk operations (compaction, search, min/max) on arithmetic element types
+and by compact_bitvector for whole-word bit operations.
+On x86 with GCC or Clang the AVX2 and SSE4.2 versions are compiled with target attributes
+and selected at runtime with __builtin_cpu_supports, so the library itself does not need
+-mavx2. On other platforms only the scalar versions are compiled.
+*/
+namespace compact_vector_simd
+{
+	/// T is handled by the vectorized kernels
+	/*!
+	Integral types of 4 or 8 bytes. Floating point types are excluded: their == is not
+	a bitwise comparison (NaN, -0.0).
+	*/
+	template <class T>
+	struct is_supported : std::integral_constant<bool,
+		std::is_integral<T>::value && (sizeof(T) == 4 || sizeof(T) == 8)>
+	{};
+
+	/// T is handled by the vectorized search kernels (find_equal, count_equal)
+	/*!
+	All integral types except bool and the floating point types; floating point
+	lanes are compared with IEEE equality, as operator== does.
+	*/
+	template <class T>
+	struct is_search_supported : std::integral_constant<bool,
+		(std::is_integral<T>::value && !std::is_same<T, bool>::value && sizeof(T) <= 8) ||
+		std::is_same<T, float>::value || std::is_same<T, double>::value>
+	{};
+
+	/// index of the lowest set bit, x != 0
+	inline unsigned lowest_bit(uint64_t x) noexcept
+	{
+#if defined(_MSC_VER) && defined(_M_X64)
+		unsigned long index;
+		_BitScanForward64(&index, x);
+		return index;
+#elif defined(__GNUC__) || defined(__clang__)
+		return static_cast<unsigned>(__builtin_ctzll(x));
+#else
+		unsigned index = 0;
+		for (; (x & 1) == 0; x >>= 1)
+			index++;
+		return index;
+#endif
+	}
+
+	/// number of set bits
+	inline unsigned bit_count(uint64_t x) noexcept
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		return static_cast<unsigned>(__builtin_popcountll(x));
+#else
+		unsigned count = 0;
+		for (; x != 0; x &= x - 1)
+			count++;
+		return count;
+#endif
+	}
+
+	enum class isa
+	{
+		scalar,
+		sse42,
+		avx2
+	};
+
+	/// the best instruction set available on the running CPU, detected once
+	inline isa detected_isa()
+	{
+#if defined(COMPACT_VECTOR_SIMD_X86)
+		static const isa value = []
+		{
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx2"))
+				return isa::avx2;
+			if (__builtin_cpu_supports("sse4.2"))
+				return isa::sse42;
+			return isa::scalar;
+		}();
+		return value;
+#else
+		return isa::scalar;
+#endif
+	}
+
+	namespace detail
+	{
+		// однопроходное уплотнение без ветвлений: элемент пишется всегда, курсор сдвигается только для оставляемых
+		template <class U>
+		size_t remove_equal_scalar(U* data, size_t n, U value) noexcept
+		{
+			size_t w = 0;
+			for (size_t i = 0; i < n; i++)
+			{
+				U x = data[i];
+				data[w] = x;
+				w += x != value;
+			}
+			return w;
+		}
+
+		template <class T>
+		size_t find_equal_scalar(const T* data, size_t n, T value) noexcept
+		{
+			for (size_t i = 0; i < n; i++)
+				if (data[i] == value)
+					return i;
+			return n;
+		}
+
+		template <class T>
+		size_t count_equal_scalar(const T* data, size_t n, T value) noexcept
+		{
+			size_t count = 0;
+			for (size_t i = 0; i < n; i++)
+				count += data[i] == value;
+			return count;
+		}
+
+		template <class T, class Less>
+		size_t extremum_scalar(const T* data, size_t n, Less less) noexcept
+		{
+			size_t best = 0;
+			for (size_t i = 1; i < n; i++)
+				if (less(data[i], data[best]))
+					best = i;
+			return best;
+		}
+
+		template <class T>
+		struct less_than
+		{
+			bool operator() (T a, T b) const noexcept { return a < b; }
+		};
+
+		template <class T>
+		struct greater_than
+		{
+			bool operator() (T a, T b) const noexcept { return b < a; }
+		};
+
+#if defined(COMPACT_VECTOR_SIMD_X86)
+		// таблица перестановок: для маски оставляемых дорожек - индексы этих дорожек подряд
+		template <int lanes, int words_per_lane>
+		struct permutation_table
+		{
+			alignas(32) uint32_t words[1 << lanes][lanes * words_per_lane];
+
+			permutation_table() noexcept
+			{
+				std::memset(words, 0, sizeof(words));
+				for (int mask = 0; mask < (1 << lanes); mask++)
+				{
+					int k = 0;
+					for (int lane = 0; lane < lanes; lane++)
+						if (mask & (1 << lane))
+						{
+							for (int w = 0; w < words_per_lane; w++)
+								words[mask][k * words_per_lane + w] = lane * words_per_lane + w;
+							k++;
+						}
+				}
+			}
+		};
+
+		// то же, но индексы байтов для pshufb
+		template <int lanes, int bytes_per_lane>
+		struct shuffle_table
+		{
+			alignas(16) uint8_t bytes[1 << lanes][16];
+
+			shuffle_table() noexcept
+			{
+				std::memset(bytes, 0x80, sizeof(bytes));
+				for (int mask = 0; mask < (1 << lanes); mask++)
+				{
+					int k = 0;
+					for (int lane = 0; lane < lanes; lane++)
+						if (mask & (1 << lane))
+						{
+							for (int b = 0; b < bytes_per_lane; b++)
+								bytes[mask][k * bytes_per_lane + b] = static_cast<uint8_t>(lane * bytes_per_lane + b);
+							k++;
+						}
+				}
+			}
+		};
+
+		template <class Table>
+		const Table& table() noexcept
+		{
+			static const Table t;
+			return t;
+		}
+
+		// запись полного регистра по курсору безопасна: курсор не обгоняет чтение,
+		// а байты за курсором уже прочитаны и будут перезаписаны
+		__attribute__((target("avx2")))
+		inline size_t remove_equal_avx2(uint32_t* data, size_t n, uint32_t value) noexcept
+		{
+			const auto& perm = table<permutation_table<8, 1>>();
+			const __m256i v = _mm256_set1_epi32(static_cast<int>(value));
+			size_t w = 0;
+			size_t i = 0;
+			for (; i + 8 <= n; i += 8)
+			{
+				__m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+				int drop = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(x, v)));
+				int keep = ~drop & 0xFF;
+				__m256i p = _mm256_load_si256(reinterpret_cast<const __m256i*>(perm.words[keep]));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(data + w), _mm256_permutevar8x32_epi32(x, p));
+				w += __builtin_popcount(keep);
+			}
+			for (; i < n; i++)
+			{
+				uint32_t x = data[i];
+				data[w] = x;
+				w += x != value;
+			}
+			return w;
+		}
+
+		__attribute__((target("avx2")))
+		inline size_t remove_equal_avx2(uint64_t* data, size_t n, uint64_t value) noexcept
+		{
+			const auto& perm = table<permutation_table<4, 2>>();
+			const __m256i v = _mm256_set1_epi64x(static_cast<long long>(value));
+			size_t w = 0;
+			size_t i = 0;
+			for (; i + 4 <= n; i += 4)
+			{
+				__m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+				int drop = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(x, v)));
+				int keep = ~drop & 0xF;
+				__m256i p = _mm256_load_si256(reinterpret_cast<const __m256i*>(perm.words[keep]));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(data + w), _mm256_permutevar8x32_epi32(x, p));
+				w += __builtin_popcount(keep);
+			}
+			for (; i < n; i++)
+			{
+				uint64_t x = data[i];
+				data[w] = x;
+				w += x != value;
+			}
+			return w;
+		}
+
+		__attribute__((target("sse4.2")))
+		inline size_t remove_equal_sse42(uint32_t* data, size_t n, uint32_t value) noexcept
+		{
+			const auto& shuffle = table<shuffle_table<4, 4>>();
+			const __m128i v = _mm_set1_epi32(static_cast<int>(value));
+			size_t w = 0;
+			size_t i = 0;
+			for (; i + 4 <= n; i += 4)
+			{
+				__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+				int drop = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(x, v)));
+				int keep = ~drop & 0xF;
+				__m128i p = _mm_load_si128(reinterpret_cast<const __m128i*>(shuffle.bytes[keep]));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(data + w), _mm_shuffle_epi8(x, p));
+				w += __builtin_popcount(keep);
+			}
+			for (; i < n; i++)
+			{
+				uint32_t x = data[i];
+				data[w] = x;
+				w += x != value;
+			}
+			return w;
+		}
+
+		__attribute__((target("sse4.2")))
+		inline size_t remove_equal_sse42(uint64_t* data, size_t n, uint64_t value) noexcept
+		{
+			const auto& shuffle = table<shuffle_table<2, 8>>();
+			const __m128i v = _mm_set1_epi64x(static_cast<long long>(value));
+			size_t w = 0;
+			size_t i = 0;
+			for (; i + 2 <= n; i += 2)
+			{
+				__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+				int drop = _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(x, v)));
+				int keep = ~drop & 0x3;
+				__m128i p = _mm_load_si128(reinterpret_cast<const __m128i*>(shuffle.bytes[keep]));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(data + w), _mm_shuffle_epi8(x, p));
+				w += __builtin_popcount(keep);
+			}
+			for (; i < n; i++)
+			{
+				uint64_t x = data[i];
+				data[w] = x;
+				w += x != value;
+			}
+			return w;
+		}
+
+		// операции над дорожками: set1 и сравнение на равенство для каждой ширины элемента.
+		// Результат сравнения - маска из единичных байтов, поэтому movemask_epi8 общий для всех типов
+		template <class T, size_t size = sizeof(T), bool floating = std::is_floating_point<T>::value>
+		struct lanes;
+
+		template <class T>
+		struct lanes<T, 1, false>
+		{
+			__attribute__((target("avx2"))) static __m256i set1_256(T v) noexcept { return _mm256_set1_epi8(static_cast<char>(v)); }
+			__attribute__((target("avx2"))) static __m256i equal_256(__m256i a, __m256i b) noexcept { return _mm256_cmpeq_epi8(a, b); }
+			__attribute__((target("sse4.2"))) static __m128i set1_128(T v) noexcept { return _mm_set1_epi8(static_cast<char>(v)); }
+			__attribute__((target("sse4.2"))) static __m128i equal_128(__m128i a, __m128i b) noexcept { return _mm_cmpeq_epi8(a, b); }
+		};
+
+		template <class T>
+		struct lanes<T, 2, false>
+		{
+			__attribute__((target("avx2"))) static __m256i set1_256(T v) noexcept { return _mm256_set1_epi16(static_cast<short>(v)); }
+			__attribute__((target("avx2"))) static __m256i equal_256(__m256i a, __m256i b) noexcept { return _mm256_cmpeq_epi16(a, b); }
+			__attribute__((target("sse4.2"))) static __m128i set1_128(T v) noexcept { return _mm_set1_epi16(static_cast<short>(v)); }
+			__attribute__((target("sse4.2"))) static __m128i equal_128(__m128i a, __m128i b) noexcept { return _mm_cmpeq_epi16(a, b); }
+		};
+
+		template <class T>
+		struct lanes<T, 4, false>
+		{
+			__attribute__((target("avx2"))) static __m256i set1_256(T v) noexcept { return _mm256_set1_epi32(static_cast<int>(v)); }
+			__attribute__((target("avx2"))) static __m256i equal_256(__m256i a, __m256i b) noexcept { return _mm256_cmpeq_epi32(a, b); }
+			__attribute__((target("sse4.2"))) static __m128i set1_128(T v) noexcept { return _mm_set1_epi32(static_cast<int>(v)); }
+			__attribute__((target("sse4.2"))) static __m128i equal_128(__m128i a, __m128i b) noexcept { return _mm_cmpeq_epi32(a, b); }
+		};
+
+		template <class T>
+		struct lanes<T, 8, false>
+		{
+			__attribute__((target("avx2"))) static __m256i set1_256(T v) noexcept { return _mm256_set1_epi64x(static_cast<long long>(v)); }
+			__attribute__((target("avx2"))) static __m256i equal_256(__m256i a, __m256i b) noexcept { return _mm256_cmpeq_epi64(a, b); }
+			__attribute__((target("sse4.2"))) static __m128i set1_128(T v) noexcept { return _mm_set1_epi64x(static_cast<long long>(v)); }
+			__attribute__((target("sse4.2"))) static __m128i equal_128(__m128i a, __m128i b) noexcept { return _mm_cmpeq_epi64(a, b); }
+		};
+
+		template <>
+		struct lanes<float, 4, true>
+		{
+			__attribute__((target("avx2"))) static __m256i set1_256(float v) noexcept { return _mm256_castps_si256(_mm256_set1_ps(v)); }
+			__attribute__((target("avx2"))) static __m256i equal_256(__m256i a, __m256i b) noexcept { return _mm256_castps_si256(_mm256_cmp_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b), _CMP_EQ_OQ)); }
+			__attribute__((target("sse4.2"))) static __m128i set1_128(float v) noexcept { return _mm_castps_si128(_mm_set1_ps(v)); }
+			__attribute__((target("sse4.2"))) static __m128i equal_128(__m128i a, __m128i b) noexcept { return _mm_castps_si128(_mm_cmpeq_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b))); }
+		};
+
+		template <>
+		struct lanes<double, 8, true>
+		{
+			__attribute__((target("avx2"))) static __m256i set1_256(double v) noexcept { return _mm256_castpd_si256(_mm256_set1_pd(v)); }
+			__attribute__((target("avx2"))) static __m256i equal_256(__m256i a, __m256i b) noexcept { return _mm256_castpd_si256(_mm256_cmp_pd(_mm256_castsi256_pd(a), _mm256_castsi256_pd(b), _CMP_EQ_OQ)); }
+			__attribute__((target("sse4.2"))) static __m128i set1_128(double v) noexcept { return _mm_castpd_si128(_mm_set1_pd(v)); }
+			__attribute__((target("sse4.2"))) static __m128i equal_128(__m128i a, __m128i b) noexcept { return _mm_castpd_si128(_mm_cmpeq_pd(_mm_castsi128_pd(a), _mm_castsi128_pd(b))); }
+		};
+
+		// поиск: четыре регистра за итерацию объединяются через or, точная позиция
+		// ищется по одному регистру только после попадания
+		template <class T>
+		__attribute__((target("avx2")))
+		size_t find_equal_avx2(const T* data, size_t n, T value) noexcept
+		{
+			const size_t step = 32 / sizeof(T);
+			const __m256i v = lanes<T>::set1_256(value);
+			size_t i = 0;
+			for (; i + 4 * step <= n; i += 4 * step)
+			{
+				const __m256i* p = reinterpret_cast<const __m256i*>(data + i);
+				__m256i e0 = lanes<T>::equal_256(_mm256_loadu_si256(p), v);
+				__m256i e1 = lanes<T>::equal_256(_mm256_loadu_si256(p + 1), v);
+				__m256i e2 = lanes<T>::equal_256(_mm256_loadu_si256(p + 2), v);
+				__m256i e3 = lanes<T>::equal_256(_mm256_loadu_si256(p + 3), v);
+				__m256i any = _mm256_or_si256(_mm256_or_si256(e0, e1), _mm256_or_si256(e2, e3));
+				if (!_mm256_testz_si256(any, any))
+					break;
+			}
+			for (; i + step <= n; i += step)
+			{
+				__m256i e = lanes<T>::equal_256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)), v);
+				uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(e));
+				if (mask != 0)
+					return i + lowest_bit(mask) / sizeof(T);
+			}
+			return i + find_equal_scalar(data + i, n - i, value);
+		}
+
+		template <class T>
+		__attribute__((target("sse4.2")))
+		size_t find_equal_sse42(const T* data, size_t n, T value) noexcept
+		{
+			const size_t step = 16 / sizeof(T);
+			const __m128i v = lanes<T>::set1_128(value);
+			size_t i = 0;
+			for (; i + step <= n; i += step)
+			{
+				__m128i e = lanes<T>::equal_128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)), v);
+				uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(e));
+				if (mask != 0)
+					return i + lowest_bit(mask) / sizeof(T);
+			}
+			return i + find_equal_scalar(data + i, n - i, value);
+		}
+
+		template <class T>
+		__attribute__((target("avx2")))
+		size_t count_equal_avx2(const T* data, size_t n, T value) noexcept
+		{
+			const size_t step = 32 / sizeof(T);
+			const __m256i v = lanes<T>::set1_256(value);
+			size_t bytes = 0;
+			size_t i = 0;
+			for (; i + step <= n; i += step)
+			{
+				__m256i e = lanes<T>::equal_256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)), v);
+				bytes += __builtin_popcount(static_cast<uint32_t>(_mm256_movemask_epi8(e)));
+			}
+			return bytes / sizeof(T) + count_equal_scalar(data + i, n - i, value);
+		}
+
+		template <class T>
+		__attribute__((target("sse4.2")))
+		size_t count_equal_sse42(const T* data, size_t n, T value) noexcept
+		{
+			const size_t step = 16 / sizeof(T);
+			const __m128i v = lanes<T>::set1_128(value);
+			size_t bytes = 0;
+			size_t i = 0;
+			for (; i + step <= n; i += step)
+			{
+				__m128i e = lanes<T>::equal_128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)), v);
+				bytes += __builtin_popcount(static_cast<uint32_t>(_mm_movemask_epi8(e)));
+			}
+			return bytes / sizeof(T) + count_equal_scalar(data + i, n - i, value);
+		}
+
+		// минимум и максимум для 4- и 8-байтовых целых. Для 64-битных min/max нет до AVX-512,
+		// поэтому они собираются из cmpgt и blendv; беззнаковые сравниваются со сдвигом на знаковый бит
+		template <class T, size_t size = sizeof(T), bool is_signed = std::is_signed<T>::value>
+		struct extremum_lanes;
+
+		template <class T>
+		struct extremum_lanes<T, 4, true>
+		{
+			__attribute__((target("avx2"))) static __m256i min_256(__m256i a, __m256i b) noexcept { return _mm256_min_epi32(a, b); }
+			__attribute__((target("avx2"))) static __m256i max_256(__m256i a, __m256i b) noexcept { return _mm256_max_epi32(a, b); }
+			__attribute__((target("sse4.2"))) static __m128i min_128(__m128i a, __m128i b) noexcept { return _mm_min_epi32(a, b); }
+			__attribute__((target("sse4.2"))) static __m128i max_128(__m128i a, __m128i b) noexcept { return _mm_max_epi32(a, b); }
+		};
+
+		template <class T>
+		struct extremum_lanes<T, 4, false>
+		{
+			__attribute__((target("avx2"))) static __m256i min_256(__m256i a, __m256i b) noexcept { return _mm256_min_epu32(a, b); }
+			__attribute__((target("avx2"))) static __m256i max_256(__m256i a, __m256i b) noexcept { return _mm256_max_epu32(a, b); }
+			__attribute__((target("sse4.2"))) static __m128i min_128(__m128i a, __m128i b) noexcept { return _mm_min_epu32(a, b); }
+			__attribute__((target("sse4.2"))) static __m128i max_128(__m128i a, __m128i b) noexcept { return _mm_max_epu32(a, b); }
+		};
+
+		template <class T, bool is_signed>
+		struct extremum_lanes<T, 8, is_signed>
+		{
+			static const long long bias = is_signed ? 0 : (long long)(1ull << 63);
+
+			__attribute__((target("avx2"))) static __m256i greater_256(__m256i a, __m256i b) noexcept
+			{
+				const __m256i s = _mm256_set1_epi64x(bias);
+				return _mm256_cmpgt_epi64(_mm256_xor_si256(a, s), _mm256_xor_si256(b, s));
+			}
+			__attribute__((target("avx2"))) static __m256i min_256(__m256i a, __m256i b) noexcept { return _mm256_blendv_epi8(a, b, greater_256(a, b)); }
+			__attribute__((target("avx2"))) static __m256i max_256(__m256i a, __m256i b) noexcept { return _mm256_blendv_epi8(b, a, greater_256(a, b)); }
+
+			__attribute__((target("sse4.2"))) static __m128i greater_128(__m128i a, __m128i b) noexcept
+			{
+				const __m128i s = _mm_set1_epi64x(bias);
+				return _mm_cmpgt_epi64(_mm_xor_si128(a, s), _mm_xor_si128(b, s));
+			}
+			__attribute__((target("sse4.2"))) static __m128i min_128(__m128i a, __m128i b) noexcept { return _mm_blendv_epi8(a, b, greater_128(a, b)); }
+			__attribute__((target("sse4.2"))) static __m128i max_128(__m128i a, __m128i b) noexcept { return _mm_blendv_epi8(b, a, greater_128(a, b)); }
+		};
+
+		// значение экстремума сворачивается по дорожкам, индекс первого вхождения ищется find_equal
+		template <class T, bool maximum>
+		__attribute__((target("avx2")))
+		size_t extremum_avx2(const T* data, size_t n) noexcept
+		{
+			const size_t step = 32 / sizeof(T);
+			if (n < step)
+				return maximum ? extremum_scalar(data, n, greater_than<T>()) : extremum_scalar(data, n, less_than<T>());
+
+			__m256i acc = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+			size_t i = step;
+			for (; i + step <= n; i += step)
+			{
+				__m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+				acc = maximum ? extremum_lanes<T>::max_256(acc, x) : extremum_lanes<T>::min_256(acc, x);
+			}
+
+			alignas(32) T lane[32 / sizeof(T)];
+			_mm256_store_si256(reinterpret_cast<__m256i*>(lane), acc);
+			T best = lane[0];
+			for (size_t k = 1; k < step; k++)
+				best = (maximum ? best < lane[k] : lane[k] < best) ? lane[k] : best;
+			for (; i < n; i++)
+				best = (maximum ? best < data[i] : data[i] < best) ? data[i] : best;
+
+			return find_equal_avx2(data, n, best);
+		}
+
+		template <class T, bool maximum>
+		__attribute__((target("sse4.2")))
+		size_t extremum_sse42(const T* data, size_t n) noexcept
+		{
+			const size_t step = 16 / sizeof(T);
+			if (n < step)
+				return maximum ? extremum_scalar(data, n, greater_than<T>()) : extremum_scalar(data, n, less_than<T>());
+
+			__m128i acc = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+			size_t i = step;
+			for (; i + step <= n; i += step)
+			{
+				__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+				acc = maximum ? extremum_lanes<T>::max_128(acc, x) : extremum_lanes<T>::min_128(acc, x);
+			}
+
+			alignas(16) T lane[16 / sizeof(T)];
+			_mm_store_si128(reinterpret_cast<__m128i*>(lane), acc);
+			T best = lane[0];
+			for (size_t k = 1; k < step; k++)
+				best = (maximum ? best < lane[k] : lane[k] < best) ? lane[k] : best;
+			for (; i < n; i++)
+				best = (maximum ? best < data[i] : data[i] < best) ? data[i] : best;
+
+			return find_equal_sse42(data, n, best);
+		}
+
+		// маска совпадающих байтов для буфера известного при компиляции размера (не больше 64 байт).
+		// Буфер читается перекрывающимися загрузками, поэтому за его пределы чтение не выходит;
+		// буфер короче регистра копируется в локальный
+		template <class T, size_t bytes>
+		__attribute__((target("sse4.2")))
+		uint64_t equal_bytes_sse42(const T* data, T value) noexcept
+		{
+			static_assert(bytes <= 64, "equal_bytes supports buffers up to 64 bytes");
+			const __m128i v = lanes<T>::set1_128(value);
+			const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+			if (bytes < 16)
+			{
+				alignas(16) unsigned char local[16] = {};
+				std::memcpy(local, p, bytes);
+				__m128i e = lanes<T>::equal_128(_mm_load_si128(reinterpret_cast<const __m128i*>(local)), v);
+				return static_cast<uint32_t>(_mm_movemask_epi8(e));
+			}
+
+			uint64_t mask = 0;
+			size_t offset = 0;
+			for (; offset + 16 <= bytes; offset += 16)
+			{
+				__m128i e = lanes<T>::equal_128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + offset)), v);
+				mask |= uint64_t(static_cast<uint32_t>(_mm_movemask_epi8(e))) << offset;
+			}
+			if (offset != bytes)
+			{
+				const size_t last = bytes >= 16 ? bytes - 16 : 0;
+				__m128i e = lanes<T>::equal_128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + last)), v);
+				mask |= uint64_t(static_cast<uint32_t>(_mm_movemask_epi8(e))) << last;
+			}
+			return mask;
+		}
+
+		template <class T, size_t bytes>
+		__attribute__((target("avx2")))
+		uint64_t equal_bytes_avx2(const T* data, T value) noexcept
+		{
+			if (bytes < 32)
+				return equal_bytes_sse42<T, bytes>(data, value);
+
+			const __m256i v = lanes<T>::set1_256(value);
+			const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+			uint64_t mask = 0;
+			size_t offset = 0;
+			for (; offset + 32 <= bytes; offset += 32)
+			{
+				__m256i e = lanes<T>::equal_256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + offset)), v);
+				mask |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(e))) << offset;
+			}
+			if (offset != bytes)
+			{
+				const size_t last = bytes >= 32 ? bytes - 32 : 0;
+				__m256i e = lanes<T>::equal_256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + last)), v);
+				mask |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(e))) << last;
+			}
+			return mask;
+		}
+#endif
+
+		// побитовые операции над словами: scalar для хвоста и скалярного пути, v256/v128 для векторных
+		struct and_words_op
+		{
+			static uint64_t scalar(uint64_t a, uint64_t b) noexcept { return a & b; }
+#if defined(COMPACT_VECTOR_SIMD_X86)
+			__attribute__((target("avx2"))) static __m256i v256(__m256i a, __m256i b) noexcept { return _mm256_and_si256(a, b); }
+			__attribute__((target("sse4.2"))) static __m128i v128(__m128i a, __m128i b) noexcept { return _mm_and_si128(a, b); }
+#endif
+		};
+
+		struct or_words_op
+		{
+			static uint64_t scalar(uint64_t a, uint64_t b) noexcept { return a | b; }
+#if defined(COMPACT_VECTOR_SIMD_X86)
+			__attribute__((target("avx2"))) static __m256i v256(__m256i a, __m256i b) noexcept { return _mm256_or_si256(a, b); }
+			__attribute__((target("sse4.2"))) static __m128i v128(__m128i a, __m128i b) noexcept { return _mm_or_si128(a, b); }
+#endif
+		};
+
+		struct xor_words_op
+		{
+			static uint64_t scalar(uint64_t a, uint64_t b) noexcept { return a ^ b; }
+#if defined(COMPACT_VECTOR_SIMD_X86)
+			__attribute__((target("avx2"))) static __m256i v256(__m256i a, __m256i b) noexcept { return _mm256_xor_si256(a, b); }
+			__attribute__((target("sse4.2"))) static __m128i v128(__m128i a, __m128i b) noexcept { return _mm_xor_si128(a, b); }
+#endif
+		};
+
+		// a & ~b; andnot в SSE/AVX инвертирует первый операнд
+		struct and_not_words_op
+		{
+			static uint64_t scalar(uint64_t a, uint64_t b) noexcept { return a & ~b; }
+#if defined(COMPACT_VECTOR_SIMD_X86)
+			__attribute__((target("avx2"))) static __m256i v256(__m256i a, __m256i b) noexcept { return _mm256_andnot_si256(b, a); }
+			__attribute__((target("sse4.2"))) static __m128i v128(__m128i a, __m128i b) noexcept { return _mm_andnot_si128(b, a); }
+#endif
+		};
+
+		template <class Op>
+		void combine_words_scalar(uint64_t* a, const uint64_t* b, size_t n) noexcept
+		{
+			for (size_t i = 0; i < n; i++)
+				a[i] = Op::scalar(a[i], b[i]);
+		}
+
+		inline size_t popcount_words_scalar(const uint64_t* words, size_t n) noexcept
+		{
+			size_t count = 0;
+			for (size_t i = 0; i < n; i++)
+				count += bit_count(words[i]);
+			return count;
+		}
+
+		inline size_t find_nonzero_word_scalar(const uint64_t* words, size_t n) noexcept
+		{
+			size_t i = 0;
+			while (i < n && words[i] == 0)
+				i++;
+			return i;
+		}
+
+#if defined(COMPACT_VECTOR_SIMD_X86)
+		template <class Op>
+		__attribute__((target("avx2")))
+		void combine_words_avx2(uint64_t* a, const uint64_t* b, size_t n) noexcept
+		{
+			size_t i = 0;
+			for (; i + 4 <= n; i += 4)
+			{
+				__m256i* pa = reinterpret_cast<__m256i*>(a + i);
+				__m256i r = Op::v256(_mm256_loadu_si256(pa), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+				_mm256_storeu_si256(pa, r);
+			}
+			combine_words_scalar<Op>(a + i, b + i, n - i);
+		}
+
+		template <class Op>
+		__attribute__((target("sse4.2")))
+		void combine_words_sse42(uint64_t* a, const uint64_t* b, size_t n) noexcept
+		{
+			size_t i = 0;
+			for (; i + 2 <= n; i += 2)
+			{
+				__m128i* pa = reinterpret_cast<__m128i*>(a + i);
+				__m128i r = Op::v128(_mm_loadu_si128(pa), _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)));
+				_mm_storeu_si128(pa, r);
+			}
+			combine_words_scalar<Op>(a + i, b + i, n - i);
+		}
+
+		// подсчет битов по полубайтам через pshufb (алгоритм Мула), суммы байтов собирает psadbw
+		__attribute__((target("avx2")))
+		inline size_t popcount_words_avx2(const uint64_t* words, size_t n) noexcept
+		{
+			const __m256i table = _mm256_setr_epi8(
+				0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+				0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+			const __m256i low_mask = _mm256_set1_epi8(0x0f);
+			__m256i total = _mm256_setzero_si256();
+			size_t i = 0;
+			for (; i + 4 <= n; i += 4)
+			{
+				__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + i));
+				__m256i low = _mm256_shuffle_epi8(table, _mm256_and_si256(v, low_mask));
+				__m256i high = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask));
+				total = _mm256_add_epi64(total, _mm256_sad_epu8(_mm256_add_epi8(low, high), _mm256_setzero_si256()));
+			}
+			uint64_t lanes[4];
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), total);
+			return static_cast<size_t>(lanes[0] + lanes[1] + lanes[2] + lanes[3]) + popcount_words_scalar(words + i, n - i);
+		}
+
+		// процессоры с SSE4.2 поддерживают и popcnt
+		__attribute__((target("sse4.2,popcnt")))
+		inline size_t popcount_words_sse42(const uint64_t* words, size_t n) noexcept
+		{
+			size_t count = 0;
+			for (size_t i = 0; i < n; i++)
+				count += static_cast<size_t>(_mm_popcnt_u64(words[i]));
+			return count;
+		}
+
+		__attribute__((target("avx2")))
+		inline size_t find_nonzero_word_avx2(const uint64_t* words, size_t n) noexcept
+		{
+			size_t i = 0;
+			for (; i + 4 <= n; i += 4)
+			{
+				__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + i));
+				if (!_mm256_testz_si256(v, v))
+					break;
+			}
+			return i + find_nonzero_word_scalar(words + i, n - i);
+		}
+#endif
+
+		template <class Op>
+		void combine_words_dispatch(uint64_t* a, const uint64_t* b, size_t n) noexcept
+		{
+#if defined(COMPACT_VECTOR_SIMD_X86)
+			switch (detected_isa())
+			{
+			case isa::avx2:
+				return combine_words_avx2<Op>(a, b, n);
+			case isa::sse42:
+				return combine_words_sse42<Op>(a, b, n);
+			default:
+				break;
+			}
+#endif
+			combine_words_scalar<Op>(a, b, n);
+		}
+
+		template <class U>
+		size_t remove_equal_dispatch(U* data, size_t n, U value) noexcept
+		{
+#if defined(COMPACT_VECTOR_SIMD_X86)
+			switch (detected_isa())
+			{
+			case isa::avx2:
+				return remove_equal_avx2(data, n, value);
+			case isa::sse42:
+				return remove_equal_sse42(data, n, value);
+			default:
+				break;
+			}
+#endif
+			return remove_equal_scalar(data, n, value);
+		}
+	}
+
+	/// stream compaction: removes all elements equal to value
+	/*!
+	Keeps the order of the remaining elements, writes them to the front of data and returns their count.
+	T must satisfy is_supported<T>.
+	*/
+	template <class T>
+	size_t remove_equal(T* data, size_t n, T value) noexcept
+	{
+		static_assert(is_supported<T>::value, "compact_vector_simd::remove_equal supports 4 and 8 byte integral types");
+
+		using U = typename std::conditional<sizeof(T) == 4, uint32_t, uint64_t>::type;
+		U u;
+		std::memcpy(&u, &value, sizeof(U));
+		return detail::remove_equal_dispatch(reinterpret_cast<U*>(data), n, u);
+	}
+	/// index of the first element equal to value, or n
+	/*!
+	T must satisfy is_search_supported<T>.
+	*/
+	template <class T>
+	size_t find_equal(const T* data, size_t n, T value) noexcept
+	{
+		static_assert(is_search_supported<T>::value, "compact_vector_simd::find_equal supports integral and floating point types");
+#if defined(COMPACT_VECTOR_SIMD_X86)
+		switch (detected_isa())
+		{
+		case isa::avx2:
+			return detail::find_equal_avx2(data, n, value);
+		case isa::sse42:
+			return detail::find_equal_sse42(data, n, value);
+		default:
+			break;
+		}
+#endif
+		return detail::find_equal_scalar(data, n, value);
+	}
+
+	/// number of elements equal to value
+	/*!
+	T must satisfy is_search_supported<T>.
+	*/
+	template <class T>
+	size_t count_equal(const T* data, size_t n, T value) noexcept
+	{
+		static_assert(is_search_supported<T>::value, "compact_vector_simd::count_equal supports integral and floating point types");
+#if defined(COMPACT_VECTOR_SIMD_X86)
+		switch (detected_isa())
+		{
+		case isa::avx2:
+			return detail::count_equal_avx2(data, n, value);
+		case isa::sse42:
+			return detail::count_equal_sse42(data, n, value);
+		default:
+			break;
+		}
+#endif
+		return detail::count_equal_scalar(data, n, value);
+	}
+
+	/// index of the first smallest element, n > 0
+	/*!
+	T must satisfy is_supported<T>.
+	*/
+	template <class T>
+	size_t min_index(const T* data, size_t n) noexcept
+	{
+		static_assert(is_supported<T>::value, "compact_vector_simd::min_index supports 4 and 8 byte integral types");
+#if defined(COMPACT_VECTOR_SIMD_X86)
+		switch (detected_isa())
+		{
+		case isa::avx2:
+			return detail::extremum_avx2<T, false>(data, n);
+		case isa::sse42:
+			return detail::extremum_sse42<T, false>(data, n);
+		default:
+			break;
+		}
+#endif
+		return detail::extremum_scalar(data, n, detail::less_than<T>());
+	}
+
+	/// index of the first largest element, n > 0
+	/*!
+	T must satisfy is_supported<T>.
+	*/
+	template <class T>
+	size_t max_index(const T* data, size_t n) noexcept
+	{
+		static_assert(is_supported<T>::value, "compact_vector_simd::max_index supports 4 and 8 byte integral types");
+#if defined(COMPACT_VECTOR_SIMD_X86)
+		switch (detected_isa())
+		{
+		case isa::avx2:
+			return detail::extremum_avx2<T, true>(data, n);
+		case isa::sse42:
+			return detail::extremum_sse42<T, true>(data, n);
+		default:
+			break;
+		}
+#endif
+		return detail::extremum_scalar(data, n, detail::greater_than<T>());
+	}
+	/// find_equal over a buffer of capacity elements known at compile time, n <= capacity
+	/*!
+	Intended for the inline buffer of compact_vector: the whole buffer is compared with
+	a fixed sequence of loads and the lanes past n are masked off, so there is no loop over n.
+	Falls back to find_equal when capacity * sizeof(T) exceeds 64 bytes.
+	*/
+	template <size_t capacity, class T>
+	size_t find_equal_fixed(const T* data, size_t n, T value) noexcept
+	{
+#if defined(COMPACT_VECTOR_SIMD_X86)
+		if (capacity * sizeof(T) <= 64 && detected_isa() != isa::scalar)
+		{
+			const size_t bytes = capacity * sizeof(T) <= 64 ? capacity * sizeof(T) : 64;
+			uint64_t mask = detected_isa() == isa::avx2
+				? detail::equal_bytes_avx2<T, bytes>(data, value)
+				: detail::equal_bytes_sse42<T, bytes>(data, value);
+			size_t valid = n * sizeof(T);
+			if (valid < 64)
+				mask &= (uint64_t(1) << valid) - 1;
+			return mask == 0 ? n : lowest_bit(mask) / sizeof(T);
+		}
+#endif
+		return find_equal(data, n, value);
+	}
+
+	/// count_equal over a buffer of capacity elements known at compile time, n <= capacity
+	template <size_t capacity, class T>
+	size_t count_equal_fixed(const T* data, size_t n, T value) noexcept
+	{
+#if defined(COMPACT_VECTOR_SIMD_X86)
+		if (capacity * sizeof(T) <= 64 && detected_isa() != isa::scalar)
+		{
+			const size_t bytes = capacity * sizeof(T) <= 64 ? capacity * sizeof(T) : 64;
+			uint64_t mask = detected_isa() == isa::avx2
+				? detail::equal_bytes_avx2<T, bytes>(data, value)
+				: detail::equal_bytes_sse42<T, bytes>(data, value);
+			size_t valid = n * sizeof(T);
+			if (valid < 64)
+				mask &= (uint64_t(1) << valid) - 1;
+			return bit_count(mask) / sizeof(T);
+		}
+#endif
+		return count_equal(data, n, value);
+	}
+
+	/// a[i] &= b[i] for n words
+	inline void and_words(uint64_t* a, const uint64_t* b, size_t n) noexcept
+	{
+		detail::combine_words_dispatch<detail::and_words_op>(a, b, n);
+	}
+
+	/// a[i] |= b[i] for n words
+	inline void or_words(uint64_t* a, const uint64_t* b, size_t n) noexcept
+	{
+		detail::combine_words_dispatch<detail::or_words_op>(a, b, n);
+	}
+
+	/// a[i] ^= b[i] for n words
+	inline void xor_words(uint64_t* a, const uint64_t* b, size_t n) noexcept
+	{
+		detail::combine_words_dispatch<detail::xor_words_op>(a, b, n);
+	}
+
+	/// a[i] &= ~b[i] for n words
+	inline void and_not_words(uint64_t* a, const uint64_t* b, size_t n) noexcept
+	{
+		detail::combine_words_dispatch<detail::and_not_words_op>(a, b, n);
+	}
+
+	/// number of set bits in n words
+	inline size_t popcount_words(const uint64_t* words, size_t n) noexcept
+	{
+#if defined(COMPACT_VECTOR_SIMD_X86)
+		switch (detected_isa())
+		{
+		case isa::avx2:
+			return detail::popcount_words_avx2(words, n);
+		case isa::sse42:
+			return detail::popcount_words_sse42(words, n);
+		default:
+			break;
+		}
+#endif
+		return detail::popcount_words_scalar(words, n);
+	}
+
+	/// index of the first non-zero word, or n
+	inline size_t find_nonzero_word(const uint64_t* words, size_t n) noexcept
+	{
+#if defined(COMPACT_VECTOR_SIMD_X86)
+		if (detected_isa() == isa::avx2)
+			return detail::find_nonzero_word_avx2(words, n);
+#endif
+		return detail::find_nonzero_word_scalar(words, n);
+	}
+}
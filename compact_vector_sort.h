@@ -0,0 +1,542 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+/// sorting
+/*!
+Sort used by compact_vector::sort, dispatched on the number of elements:
+- up to network_max_size arithmetic or pointer elements are sorted by a fixed sorting network
+  (Batcher's odd-even merge sort, pruned to n inputs) on local copies, so every compare-exchange
+  becomes a min/max pair or a conditional move and there are no data-dependent branches;
+- up to insertion_sort_max_size elements, and for other types below that size, insertion sort;
+- larger ranges use pattern-defeating quicksort: median of three (ninther past 128 elements),
+  block partitioning without branches for arithmetic types, a partial insertion sort for inputs
+  that are already sorted, and heapsort after too many unbalanced partitions.
+The networks are scalar: the AVX2 kernels of compact_vector_simd are selected at runtime and cannot be
+inlined, and the call alone costs about as much as the whole network on 16 elements.
+*/
+namespace compact_vector_sort
+{
+	/// largest size sorted by a network
+	static constexpr size_t network_max_size = 16;
+
+	/// largest size sorted by insertion sort
+	static constexpr size_t insertion_sort_max_size = 32;
+
+	/// T is sorted by networks
+	template <class T>
+	struct is_network_sortable : std::integral_constant<bool, std::is_arithmetic<T>::value || std::is_pointer<T>::value>
+	{};
+
+	namespace detail
+	{
+		struct network_table
+		{
+			unsigned char first[64];
+			unsigned char second[64];
+			size_t count;
+		};
+
+		// компараторы сети Бэтчера на степень двойки, покрывающую n; компараторы с входом за n
+		// отбрасываются: недостающие входы можно считать бесконечными, такой компаратор их не двигает
+		constexpr network_table make_network(size_t n)
+		{
+			network_table t = {};
+			size_t width = 1;
+			while (width < n)
+				width *= 2;
+			for (size_t p = 1; p < width; p *= 2)
+				for (size_t k = p; k >= 1; k /= 2)
+					for (size_t j = k % p; j + k < width; j += 2 * k)
+						for (size_t i = 0; i < k && i + j + k < width; i++)
+							if ((i + j) / (2 * p) == (i + j + k) / (2 * p) && i + j + k < n)
+							{
+								t.first[t.count] = static_cast<unsigned char>(i + j);
+								t.second[t.count] = static_cast<unsigned char>(i + j + k);
+								t.count++;
+							}
+			return t;
+		}
+
+		template <size_t n>
+		struct network
+		{
+			static constexpr network_table table = make_network(n);
+		};
+
+		template <size_t n>
+		constexpr network_table network<n>::table;
+
+		template <class T, class Compare>
+		void compare_exchange(T& a, T& b, Compare& comp)
+		{
+			bool swap = comp(b, a);
+			T low = swap ? b : a;
+			T high = swap ? a : b;
+			a = low;
+			b = high;
+		}
+
+		// элементы копируются в локальный массив: индексы компараторов известны при компиляции,
+		// и весь массив остается в регистрах
+		template <size_t n, class T, class Compare, size_t... I>
+		void apply_network(T* data, Compare& comp, std::index_sequence<I...>)
+		{
+			T v[n];
+			for (size_t i = 0; i < n; i++)
+				v[i] = data[i];
+			int expand[] = { 0, (compare_exchange(v[network<n>::table.first[I]], v[network<n>::table.second[I]], comp), 0)... };
+			(void)expand;
+			for (size_t i = 0; i < n; i++)
+				data[i] = v[i];
+		}
+
+		template <size_t n, class T, class Compare>
+		void apply_network(T* data, Compare& comp)
+		{
+			apply_network<n>(data, comp, std::make_index_sequence<network<n>::table.count>());
+		}
+
+		template <class T, class Compare>
+		void sort_network(T* data, size_t n, Compare& comp)
+		{
+			static_assert(network_max_size == 16, "sort_network handles sizes up to 16");
+			switch (n)
+			{
+			case 2: return apply_network<2>(data, comp);
+			case 3: return apply_network<3>(data, comp);
+			case 4: return apply_network<4>(data, comp);
+			case 5: return apply_network<5>(data, comp);
+			case 6: return apply_network<6>(data, comp);
+			case 7: return apply_network<7>(data, comp);
+			case 8: return apply_network<8>(data, comp);
+			case 9: return apply_network<9>(data, comp);
+			case 10: return apply_network<10>(data, comp);
+			case 11: return apply_network<11>(data, comp);
+			case 12: return apply_network<12>(data, comp);
+			case 13: return apply_network<13>(data, comp);
+			case 14: return apply_network<14>(data, comp);
+			case 15: return apply_network<15>(data, comp);
+			case 16: return apply_network<16>(data, comp);
+			default: return;
+			}
+		}
+
+		template <class T, class Compare>
+		void insertion_sort(T* first, T* last, Compare& comp)
+		{
+			if (first == last)
+				return;
+			for (T* cur = first + 1; cur != last; ++cur)
+			{
+				if (comp(*cur, *(cur - 1)))
+				{
+					T tmp(std::move(*cur));
+					T* sift = cur;
+					do
+					{
+						*sift = std::move(*(sift - 1));
+						--sift;
+					} while (sift != first && comp(tmp, *(sift - 1)));
+					*sift = std::move(tmp);
+				}
+			}
+		}
+
+		// слева от first лежит элемент не больше любого в диапазоне, поэтому граница не проверяется
+		template <class T, class Compare>
+		void unguarded_insertion_sort(T* first, T* last, Compare& comp)
+		{
+			if (first == last)
+				return;
+			for (T* cur = first + 1; cur != last; ++cur)
+			{
+				if (comp(*cur, *(cur - 1)))
+				{
+					T tmp(std::move(*cur));
+					T* sift = cur;
+					do
+					{
+						*sift = std::move(*(sift - 1));
+						--sift;
+					} while (comp(tmp, *(sift - 1)));
+					*sift = std::move(tmp);
+				}
+			}
+		}
+
+		// сортировка вставками, которая сдается после limit перемещений; true - диапазон отсортирован
+		template <class T, class Compare>
+		bool partial_insertion_sort(T* first, T* last, Compare& comp)
+		{
+			const size_t limit = 8;
+			if (first == last)
+				return true;
+			size_t moves = 0;
+			for (T* cur = first + 1; cur != last; ++cur)
+			{
+				if (comp(*cur, *(cur - 1)))
+				{
+					T tmp(std::move(*cur));
+					T* sift = cur;
+					do
+					{
+						*sift = std::move(*(sift - 1));
+						--sift;
+					} while (sift != first && comp(tmp, *(sift - 1)));
+					*sift = std::move(tmp);
+					moves += cur - sift;
+				}
+				if (moves > limit)
+					return false;
+			}
+			return true;
+		}
+
+		template <class T, class Compare>
+		void sort2(T* a, T* b, Compare& comp)
+		{
+			if (comp(*b, *a))
+				std::iter_swap(a, b);
+		}
+
+		template <class T, class Compare>
+		void sort3(T* a, T* b, T* c, Compare& comp)
+		{
+			sort2(a, b, comp);
+			sort2(b, c, comp);
+			sort2(a, b, comp);
+		}
+
+		// разбиение по опорному *first: слева меньшие, справа не меньшие.
+		// Возвращает позицию опорного и признак того, что перестановок не понадобилось
+		template <class T, class Compare>
+		std::pair<T*, bool> partition_right(T* begin, T* end, Compare& comp)
+		{
+			T pivot(std::move(*begin));
+			T* first = begin;
+			T* last = end;
+
+			while (comp(*++first, pivot));
+			if (first - 1 == begin)
+				while (first < last && !comp(*--last, pivot));
+			else
+				while (!comp(*--last, pivot));
+
+			bool already_partitioned = first >= last;
+			while (first < last)
+			{
+				std::iter_swap(first, last);
+				while (comp(*++first, pivot));
+				while (!comp(*--last, pivot));
+			}
+
+			T* pivot_pos = first - 1;
+			*begin = std::move(*pivot_pos);
+			*pivot_pos = std::move(pivot);
+			return std::make_pair(pivot_pos, already_partitioned);
+		}
+
+		static constexpr size_t block_size = 64;
+
+		template <class T>
+		void swap_offsets(T* first, T* last, const unsigned char* offsets_l, const unsigned char* offsets_r, size_t n, bool use_swaps)
+		{
+			if (use_swaps)
+			{
+				for (size_t i = 0; i < n; i++)
+					std::iter_swap(first + offsets_l[i], last - offsets_r[i]);
+			}
+			else if (n > 0)
+			{
+				// циклическая перестановка: на пару элементов одно перемещение вместо трех
+				T* l = first + offsets_l[0];
+				T* r = last - offsets_r[0];
+				T tmp(std::move(*l));
+				*l = std::move(*r);
+				for (size_t i = 1; i < n; i++)
+				{
+					l = first + offsets_l[i];
+					*r = std::move(*l);
+					r = last - offsets_r[i];
+					*l = std::move(*r);
+				}
+				*r = std::move(tmp);
+			}
+		}
+
+		// блочное разбиение (BlockQuicksort): результаты сравнений блока из block_size элементов
+		// записываются как смещения без переходов, затем неправильно стоящие элементы меняются парами
+		template <class T, class Compare>
+		std::pair<T*, bool> partition_right_branchless(T* begin, T* end, Compare& comp)
+		{
+			T pivot(std::move(*begin));
+			T* first = begin;
+			T* last = end;
+
+			while (comp(*++first, pivot));
+			if (first - 1 == begin)
+				while (first < last && !comp(*--last, pivot));
+			else
+				while (!comp(*--last, pivot));
+
+			bool already_partitioned = first >= last;
+			if (!already_partitioned)
+			{
+				std::iter_swap(first, last);
+				++first;
+
+				alignas(64) unsigned char offsets_l[block_size];
+				alignas(64) unsigned char offsets_r[block_size];
+				T* offsets_l_base = first;
+				T* offsets_r_base = last;
+				size_t num_l = 0, num_r = 0, start_l = 0, start_r = 0;
+
+				while (first < last)
+				{
+					size_t unknown = last - first;
+					size_t left_split = num_l == 0 ? (num_r == 0 ? unknown / 2 : unknown) : 0;
+					size_t right_split = num_r == 0 ? unknown - left_split : 0;
+
+					if (left_split > block_size)
+						left_split = block_size;
+					for (size_t i = 0; i < left_split; i++)
+					{
+						offsets_l[num_l] = static_cast<unsigned char>(i);
+						num_l += !comp(*first, pivot);
+						++first;
+					}
+
+					if (right_split > block_size)
+						right_split = block_size;
+					for (size_t i = 0; i < right_split; i++)
+					{
+						offsets_r[num_r] = static_cast<unsigned char>(i + 1);
+						num_r += comp(*--last, pivot);
+					}
+
+					size_t n = std::min(num_l, num_r);
+					swap_offsets(offsets_l_base, offsets_r_base, offsets_l + start_l, offsets_r + start_r, n, num_l == num_r);
+					num_l -= n;
+					num_r -= n;
+					start_l += n;
+					start_r += n;
+
+					if (num_l == 0)
+					{
+						start_l = 0;
+						offsets_l_base = first;
+					}
+					if (num_r == 0)
+					{
+						start_r = 0;
+						offsets_r_base = last;
+					}
+				}
+
+				// остаток одной из сторон переносится к середине
+				if (num_l)
+				{
+					const unsigned char* offsets = offsets_l + start_l;
+					while (num_l--)
+						std::iter_swap(offsets_l_base + offsets[num_l], --last);
+					first = last;
+				}
+				if (num_r)
+				{
+					const unsigned char* offsets = offsets_r + start_r;
+					while (num_r--)
+					{
+						std::iter_swap(offsets_r_base - offsets[num_r], first);
+						++first;
+					}
+					last = first;
+				}
+			}
+
+			T* pivot_pos = first - 1;
+			*begin = std::move(*pivot_pos);
+			*pivot_pos = std::move(pivot);
+			return std::make_pair(pivot_pos, already_partitioned);
+		}
+
+		// разбиение для случая, когда опорный равен элементу слева от диапазона:
+		// равные опорному уходят влево и дальше не сортируются
+		template <class T, class Compare>
+		T* partition_left(T* begin, T* end, Compare& comp)
+		{
+			T pivot(std::move(*begin));
+			T* first = begin;
+			T* last = end;
+
+			while (comp(pivot, *--last));
+			if (last + 1 == end)
+				while (first < last && !comp(pivot, *++first));
+			else
+				while (!comp(pivot, *++first));
+
+			while (first < last)
+			{
+				std::iter_swap(first, last);
+				while (comp(pivot, *--last));
+				while (!comp(pivot, *++first));
+			}
+
+			T* pivot_pos = last;
+			*begin = std::move(*pivot_pos);
+			*pivot_pos = std::move(pivot);
+			return pivot_pos;
+		}
+
+		static constexpr size_t pdq_insertion_threshold = 24;
+		static constexpr size_t ninther_threshold = 128;
+
+		// перемешивание нескольких элементов после сильно несбалансированного разбиения
+		template <class T>
+		void break_patterns(T* begin, T* end, T* pivot_pos)
+		{
+			size_t l_size = pivot_pos - begin;
+			size_t r_size = end - (pivot_pos + 1);
+			if (l_size >= pdq_insertion_threshold)
+			{
+				std::iter_swap(begin, begin + l_size / 4);
+				std::iter_swap(pivot_pos - 1, pivot_pos - l_size / 4);
+				if (l_size > ninther_threshold)
+				{
+					std::iter_swap(begin + 1, begin + (l_size / 4 + 1));
+					std::iter_swap(begin + 2, begin + (l_size / 4 + 2));
+					std::iter_swap(pivot_pos - 2, pivot_pos - (l_size / 4 + 1));
+					std::iter_swap(pivot_pos - 3, pivot_pos - (l_size / 4 + 2));
+				}
+			}
+			if (r_size >= pdq_insertion_threshold)
+			{
+				std::iter_swap(pivot_pos + 1, pivot_pos + (1 + r_size / 4));
+				std::iter_swap(end - 1, end - r_size / 4);
+				if (r_size > ninther_threshold)
+				{
+					std::iter_swap(pivot_pos + 2, pivot_pos + (2 + r_size / 4));
+					std::iter_swap(pivot_pos + 3, pivot_pos + (3 + r_size / 4));
+					std::iter_swap(end - 2, end - (1 + r_size / 4));
+					std::iter_swap(end - 3, end - (2 + r_size / 4));
+				}
+			}
+		}
+
+		template <bool branchless, class T, class Compare>
+		void pdqsort_loop(T* begin, T* end, Compare& comp, int bad_allowed, bool leftmost)
+		{
+			for (;;)
+			{
+				size_t size = end - begin;
+				if (size < pdq_insertion_threshold)
+				{
+					if (leftmost)
+						insertion_sort(begin, end, comp);
+					else
+						unguarded_insertion_sort(begin, end, comp);
+					return;
+				}
+
+				// опорный - медиана трех или девяти элементов, ставится в begin
+				size_t half = size / 2;
+				if (size > ninther_threshold)
+				{
+					sort3(begin, begin + half, end - 1, comp);
+					sort3(begin + 1, begin + (half - 1), end - 2, comp);
+					sort3(begin + 2, begin + (half + 1), end - 3, comp);
+					sort3(begin + (half - 1), begin + half, begin + (half + 1), comp);
+					std::iter_swap(begin, begin + half);
+				}
+				else
+				{
+					sort3(begin + half, begin, end - 1, comp);
+				}
+
+				// опорный равен элементу слева: все равные ему собираются слева за один проход
+				if (!leftmost && !comp(*(begin - 1), *begin))
+				{
+					begin = partition_left(begin, end, comp) + 1;
+					continue;
+				}
+
+				std::pair<T*, bool> part = branchless ? partition_right_branchless(begin, end, comp) : partition_right(begin, end, comp);
+				T* pivot_pos = part.first;
+				size_t l_size = pivot_pos - begin;
+				size_t r_size = end - (pivot_pos + 1);
+
+				if (l_size < size / 8 || r_size < size / 8)
+				{
+					if (--bad_allowed == 0)
+					{
+						std::make_heap(begin, end, comp);
+						std::sort_heap(begin, end, comp);
+						return;
+					}
+					break_patterns(begin, end, pivot_pos);
+				}
+				else if (part.second && partial_insertion_sort(begin, pivot_pos, comp) && partial_insertion_sort(pivot_pos + 1, end, comp))
+				{
+					return;
+				}
+
+				pdqsort_loop<branchless>(begin, pivot_pos, comp, bad_allowed, leftmost);
+				begin = pivot_pos + 1;
+				leftmost = false;
+			}
+		}
+
+		inline int log2(size_t n) noexcept
+		{
+			int log = 0;
+			while (n >>= 1)
+				log++;
+			return log;
+		}
+	}
+
+	/// pattern-defeating quicksort of [first, last)
+	template <class T, class Compare>
+	void pdqsort(T* first, T* last, Compare comp)
+	{
+		if (last - first < 2)
+			return;
+		detail::pdqsort_loop<std::is_arithmetic<T>::value>(first, last, comp, detail::log2(last - first), true);
+	}
+
+	namespace detail
+	{
+		template <class T, class Compare>
+		void sort(T* first, T* last, Compare& comp, std::integral_constant<bool, true>)
+		{
+			size_t n = last - first;
+			if (n <= network_max_size)
+				sort_network(first, n, comp);
+			else if (n <= insertion_sort_max_size)
+				insertion_sort(first, last, comp);
+			else
+				pdqsort_loop<std::is_arithmetic<T>::value>(first, last, comp, log2(n), true);
+		}
+
+		template <class T, class Compare>
+		void sort(T* first, T* last, Compare& comp, std::integral_constant<bool, false>)
+		{
+			size_t n = last - first;
+			if (n <= insertion_sort_max_size)
+				insertion_sort(first, last, comp);
+			else
+				pdqsort_loop<std::is_arithmetic<T>::value>(first, last, comp, log2(n), true);
+		}
+	}
+
+	/// sorts [first, last), choosing the algorithm by size
+	template <class T, class Compare>
+	void sort(T* first, T* last, Compare comp)
+	{
+		detail::sort(first, last, comp, std::integral_constant<bool, is_network_sortable<T>::value>());
+	}
+}
@@ -0,0 +1,412 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
+
+/// spill telemetry
+/*!
+Opt-in statistics collected by compact_vector when COMPACT_VECTOR_TELEMETRY is defined
+before the first #include "compact_vector.h". Without the macro this header is not included
+and the hooks in compact_vector are empty inline functions.
+
+The macro changes the bodies of compact_vector member functions, so it must be defined the same
+way in every translation unit of a program (best on the compiler command line). Otherwise each
+instantiation shared by two translation units violates the ODR and the linker keeps either copy.
+
+Every compact_vector instantiation gets its own record:
+- spills: grow() calls (and insertions) that move the elements from the inline buffer to the heap;
+- returns: shrink_to_fit() calls that move the elements back to the inline buffer;
+- allocated_bytes / freed_bytes: heap traffic through the allocator;
+- destructions and log2 histograms of size and capacity at destruction, plus an exact
+  histogram of sizes below exact_sizes; the histograms can be sampled with
+  COMPACT_VECTOR_TELEMETRY_SAMPLE=N (every N-th destruction per thread);
+- empty_shells: destructions of vectors left empty by a move and not filled since. With the macro
+  compact_vector keeps a per-object flag for this, so they are kept out of the histograms and do not
+  pull compact_max_size tuning towards smaller inline capacities; vectors that were simply never
+  filled still count as size 0. The flag makes the object larger in telemetry builds, so object_size
+  in profiles is the size without it.
+
+Events are counted in thread_local records without atomics and are added to the
+process-wide totals when the thread exits or when flush() is called. report() flushes
+the calling thread and prints all records; dump_at_exit() registers report(stderr) with std::atexit.
+write_profile() stores the size histograms for the compact_vector_tune tool (see compact_vector_tuning.h);
+defining COMPACT_VECTOR_TELEMETRY_PROFILE="path" writes it automatically at exit.
+*/
+namespace compact_vector_telemetry
+{
+	/// histogram bucket b counts values in [2^(b-1), 2^b), bucket 0 counts zeros
+	static const int histogram_buckets = 65;
+
+	/// sizes below exact_sizes are also counted exactly, for compact_max_size tuning
+	static const int exact_sizes = 256;
+
+#ifndef COMPACT_VECTOR_TELEMETRY_SAMPLE
+	/// only every COMPACT_VECTOR_TELEMETRY_SAMPLE-th destruction of an instantiation in a thread is put into the histograms
+	#define COMPACT_VECTOR_TELEMETRY_SAMPLE 1
+#endif
+
+	inline int bucket(uint64_t value) noexcept
+	{
+		int b = 0;
+		for (; value != 0; value >>= 1)
+			b++;
+		return b;
+	}
+
+	/// counters of one instantiation
+	struct stats
+	{
+		uint64_t spills = 0;
+		uint64_t returns = 0;
+		uint64_t allocated_bytes = 0;
+		uint64_t freed_bytes = 0;
+		uint64_t destructions = 0;
+		uint64_t empty_shells = 0;
+		uint64_t sampled = 0;
+		uint64_t size_histogram[histogram_buckets] = {};
+		uint64_t capacity_histogram[histogram_buckets] = {};
+		uint64_t exact_size_histogram[exact_sizes] = {};
+
+		void add(const stats& x) noexcept
+		{
+			spills += x.spills;
+			returns += x.returns;
+			allocated_bytes += x.allocated_bytes;
+			freed_bytes += x.freed_bytes;
+			destructions += x.destructions;
+			empty_shells += x.empty_shells;
+			sampled += x.sampled;
+			for (int i = 0; i < histogram_buckets; i++)
+			{
+				size_histogram[i] += x.size_histogram[i];
+				capacity_histogram[i] += x.capacity_histogram[i];
+			}
+			for (int i = 0; i < exact_sizes; i++)
+				exact_size_histogram[i] += x.exact_size_histogram[i];
+		}
+	};
+
+	/// process-wide record of one instantiation
+	struct site
+	{
+		std::string name;
+		std::string tag;
+		size_t element_size;
+		size_t element_alignment;
+		size_t size_word;
+		size_t compact_capacity;
+		size_t object_size;
+		stats totals;
+	};
+
+	namespace detail
+	{
+		// записи не удаляются до конца процесса, поэтому достаточно сырых указателей
+		struct registry
+		{
+			std::mutex mutex;
+			std::vector<site*> sites;
+			std::vector<void (*)()> flushers;
+		};
+
+		inline registry& get_registry()
+		{
+			// намеренно не разрушается: потоки могут завершаться после статических деструкторов
+			static registry* r = new registry();
+			return *r;
+		}
+
+		inline std::string demangle(const char* name)
+		{
+#if defined(__GNUG__)
+			int status = 0;
+			char* s = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+			if (status == 0 && s != nullptr)
+			{
+				std::string result(s);
+				std::free(s);
+				return result;
+			}
+#endif
+			return name;
+		}
+
+		// имя тега для векторов с compact_vector_tuning::tagged_growth, иначе пустая строка
+		template <class Vector, class = void>
+		struct tag_of
+		{
+			static std::string name() { return std::string(); }
+		};
+
+		template <class Vector>
+		struct tag_of<Vector, decltype(void(static_cast<typename Vector::growth_policy_type::tag*>(nullptr)))>
+		{
+			// теги обычно только объявлены, поэтому typeid берется от указателя, а '*' отрезается
+			static std::string name()
+			{
+				std::string s = demangle(typeid(typename Vector::growth_policy_type::tag*).name());
+				if (!s.empty() && s.back() == '*')
+					s.pop_back();
+				return s;
+			}
+		};
+
+		inline void register_profile_at_exit();
+
+		// счетчики одного экземпляра шаблона: глобальная запись и локальная для потока
+		template <class Vector>
+		struct instance
+		{
+			static site& global()
+			{
+				static site* s = []
+				{
+					using T = typename Vector::value_type;
+					site* result = new site{ demangle(typeid(Vector).name()), tag_of<Vector>::name(),
+						sizeof(T), alignof(T), sizeof(typename Vector::size_word_type),
+						Vector::compact_capacity, sizeof(typename Vector::storage_type), stats() };
+#ifdef COMPACT_VECTOR_TELEMETRY_PROFILE
+					register_profile_at_exit();
+#endif
+					registry& r = get_registry();
+					std::lock_guard<std::mutex> lock(r.mutex);
+					r.sites.push_back(result);
+					r.flushers.push_back(&flush_current_thread);
+					return result;
+				}();
+				return *s;
+			}
+
+			// счетчики потока тривиально разрушаемы и остаются доступными для flush() из atexit;
+			// guard регистрирует экземпляр и переносит счетчики в общую запись при завершении потока
+			struct guard
+			{
+				guard()
+				{
+					global();
+				}
+
+				~guard()
+				{
+					flush(local());
+				}
+			};
+
+			static stats& local() noexcept
+			{
+				static thread_local stats s;
+				static thread_local guard g;
+				(void)g;
+				return s;
+			}
+
+			static void flush(stats& s)
+			{
+				site& g = global();
+				{
+					std::lock_guard<std::mutex> lock(get_registry().mutex);
+					g.totals.add(s);
+				}
+				s = stats();
+			}
+
+			static void flush_current_thread()
+			{
+				flush(local());
+			}
+		};
+	}
+
+	/// hooks called by compact_vector
+	template <class Vector>
+	void on_spill() noexcept
+	{
+		detail::instance<Vector>::local().spills++;
+	}
+
+	template <class Vector>
+	void on_return() noexcept
+	{
+		detail::instance<Vector>::local().returns++;
+	}
+
+	template <class Vector>
+	void on_allocate(size_t bytes) noexcept
+	{
+		detail::instance<Vector>::local().allocated_bytes += bytes;
+	}
+
+	template <class Vector>
+	void on_deallocate(size_t bytes) noexcept
+	{
+		detail::instance<Vector>::local().freed_bytes += bytes;
+	}
+
+	template <class Vector>
+	void on_destruct(size_t size, size_t capacity, bool moved_from) noexcept
+	{
+		stats& s = detail::instance<Vector>::local();
+		s.destructions++;
+
+		// оболочки после перемещения не отражают итоговые размеры векторов
+		if (moved_from)
+		{
+			s.empty_shells++;
+			return;
+		}
+		if (COMPACT_VECTOR_TELEMETRY_SAMPLE > 1 && s.destructions % COMPACT_VECTOR_TELEMETRY_SAMPLE != 0)
+			return;
+
+		s.sampled++;
+		if (size < static_cast<size_t>(exact_sizes))
+			s.exact_size_histogram[size]++;
+		s.size_histogram[bucket(size)]++;
+		s.capacity_histogram[bucket(capacity)]++;
+	}
+
+	/// adds the calling thread's counters of all instantiations to the totals
+	inline void flush()
+	{
+		detail::registry& r = detail::get_registry();
+		std::vector<void (*)()> flushers;
+		{
+			std::lock_guard<std::mutex> lock(r.mutex);
+			flushers = r.flushers;
+		}
+		for (auto f : flushers)
+			f();
+	}
+
+	/// totals of one instantiation after flushing the calling thread
+	template <class Vector>
+	stats snapshot()
+	{
+		flush();
+		site& s = detail::instance<Vector>::global();
+		std::lock_guard<std::mutex> lock(detail::get_registry().mutex);
+		return s.totals;
+	}
+
+	/// prints all instantiations, one JSON object per line
+	inline void report(FILE* out)
+	{
+		flush();
+
+		detail::registry& r = detail::get_registry();
+		std::lock_guard<std::mutex> lock(r.mutex);
+		for (const site* s : r.sites)
+		{
+			const stats& t = s->totals;
+			std::fprintf(out,
+				"{\"vector\":\"%s\",\"element_size\":%zu,\"compact_capacity\":%zu,"
+				"\"spills\":%llu,\"returns\":%llu,\"allocated_bytes\":%llu,\"freed_bytes\":%llu,\"destructions\":%llu,\"empty_shells\":%llu",
+				s->name.c_str(), s->element_size, s->compact_capacity,
+				(unsigned long long)t.spills, (unsigned long long)t.returns,
+				(unsigned long long)t.allocated_bytes, (unsigned long long)t.freed_bytes,
+				(unsigned long long)t.destructions, (unsigned long long)t.empty_shells);
+
+			const char* names[2] = { "size_histogram", "capacity_histogram" };
+			const uint64_t* histograms[2] = { t.size_histogram, t.capacity_histogram };
+			for (int h = 0; h < 2; h++)
+			{
+				// пары [нижняя граница корзины, число векторов], пустые корзины пропускаются
+				std::fprintf(out, ",\"%s\":[", names[h]);
+				bool first = true;
+				for (int b = 0; b < histogram_buckets; b++)
+				{
+					if (histograms[h][b] == 0)
+						continue;
+					unsigned long long low = b == 0 ? 0 : 1ull << (b - 1);
+					std::fprintf(out, "%s[%llu,%llu]", first ? "" : ",", low, (unsigned long long)histograms[h][b]);
+					first = false;
+				}
+				std::fprintf(out, "]");
+			}
+			std::fprintf(out, "}\n");
+		}
+	}
+
+	/// writes the size profile read by compact_vector_tune
+	/*!
+	Text format, one record per instantiation:
+		site <tag or -> <element_size> <element_alignment> <size_word> <compact_capacity> <sizeof> <sampled> <name>
+		sizes <size>:<count> ...
+	Sizes below exact_sizes are exact; larger ones are written as the upper bound of their log2 bucket.
+	Returns false if the file cannot be opened.
+	*/
+	inline bool write_profile(const char* path)
+	{
+		flush();
+
+		FILE* out = std::fopen(path, "w");
+		if (out == nullptr)
+			return false;
+
+		std::fprintf(out, "# compact_vector profile 1\n");
+		detail::registry& r = detail::get_registry();
+		std::lock_guard<std::mutex> lock(r.mutex);
+		for (const site* s : r.sites)
+		{
+			const stats& t = s->totals;
+			std::fprintf(out, "site\t%s\t%zu\t%zu\t%zu\t%zu\t%zu\t%llu\t%s\nsizes",
+				s->tag.empty() ? "-" : s->tag.c_str(), s->element_size, s->element_alignment, s->size_word,
+				s->compact_capacity, s->object_size, (unsigned long long)t.sampled, s->name.c_str());
+
+			for (int i = 0; i < exact_sizes; i++)
+				if (t.exact_size_histogram[i] != 0)
+					std::fprintf(out, "\t%d:%llu", i, (unsigned long long)t.exact_size_histogram[i]);
+
+			// корзины, которые целиком выше exact_sizes
+			for (int b = bucket(exact_sizes - 1) + 1; b < histogram_buckets; b++)
+				if (t.size_histogram[b] != 0)
+				{
+					unsigned long long high = b == 64 ? ~0ull : (1ull << b) - 1;
+					std::fprintf(out, "\t%llu:%llu", high, (unsigned long long)t.size_histogram[b]);
+				}
+			std::fprintf(out, "\n");
+		}
+		std::fclose(out);
+		return true;
+	}
+
+	/// writes the profile to path when the process exits
+	/*!
+	Called automatically on first use of any instrumented instantiation when
+	COMPACT_VECTOR_TELEMETRY_PROFILE is defined as a path string literal.
+	*/
+	inline void write_profile_at_exit(const char* path)
+	{
+		static const char* profile_path = nullptr;
+		if (profile_path != nullptr)
+			return;
+		profile_path = path;
+		std::atexit([] { write_profile(profile_path); });
+	}
+
+	inline void detail::register_profile_at_exit()
+	{
+#ifdef COMPACT_VECTOR_TELEMETRY_PROFILE
+		write_profile_at_exit(COMPACT_VECTOR_TELEMETRY_PROFILE);
+#endif
+	}
+
+	/// prints report(stderr) when the process exits
+	inline void dump_at_exit()
+	{
+		static bool registered = false;
+		if (registered)
+			return;
+		registered = true;
+		std::atexit([] { report(stderr); });
+	}
+}
@@ -0,0 +1,220 @@
+#pragma once
+
+#include "compact_vector.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// compact_max_size tuning
+/*!
+Registry of tuned capacities and the cost model used by the compact_vector_tune tool.
+
+Workflow:
+1. Declare vectors through tuned_compact_vector<T, Tag>; every Tag is a separate instantiation.
+2. Build with COMPACT_VECTOR_TELEMETRY and COMPACT_VECTOR_TELEMETRY_PROFILE="profile.txt"
+   (optionally COMPACT_VECTOR_TELEMETRY_SAMPLE=N) and run a representative workload.
+3. Run compact_vector_tune profile.txt --header tuned_capacities.h; it recommends a
+   compact_max_size per instantiation and writes capacity<Tag> specializations.
+4. Include the generated header after the tag declarations and rebuild.
+*/
+namespace compact_vector_tuning
+{
+	/// tuned compact_max_size for Tag, -1 (automatic) unless specialized
+	template <class Tag>
+	struct capacity
+	{
+		static constexpr int value = -1;
+	};
+
+	/// growth policy that only carries Tag, so that equal T and N with different tags are different types
+	template <class Tag, class base_policy = compact_vector_growth::doubling>
+	struct tagged_growth : base_policy
+	{
+		using tag = Tag;
+	};
+
+	/// compact_vector whose compact_max_size comes from capacity<Tag>
+	template <class T, class Tag, class allocator_type = std::allocator<T>>
+	using tuned_compact_vector = compact_vector<T, capacity<Tag>::value, allocator_type, tagged_growth<Tag>>;
+
+	/// one instantiation from a profile written by compact_vector_telemetry::write_profile
+	struct profile_site
+	{
+		std::string name;
+		std::string tag;
+		size_t element_size = 0;
+		size_t element_alignment = 0;
+		size_t size_word = 0;
+		size_t compact_capacity = 0;
+		size_t object_size = 0;
+		std::vector<std::pair<size_t, uint64_t>> sizes;
+	};
+
+	/// reads a profile; records with the same name (e.g. from several runs) are merged
+	inline bool read_profile(FILE* in, std::vector<profile_site>& sites)
+	{
+		char line[4096];
+		profile_site* current = nullptr;
+		while (std::fgets(line, sizeof(line), in) != nullptr)
+		{
+			std::string text(line);
+			while (!text.empty() && (text.back() == '\n' || text.back() == '\r'))
+				text.pop_back();
+			if (text.empty() || text[0] == '#')
+				continue;
+
+			std::vector<std::string> fields;
+			size_t start = 0;
+			for (size_t tab; (tab = text.find('\t', start)) != std::string::npos; start = tab + 1)
+				fields.push_back(text.substr(start, tab - start));
+			fields.push_back(text.substr(start));
+
+			if (fields[0] == "site")
+			{
+				if (fields.size() != 9)
+					return false;
+
+				profile_site site;
+				site.tag = fields[1] == "-" ? std::string() : fields[1];
+				site.element_size = std::strtoull(fields[2].c_str(), nullptr, 10);
+				site.element_alignment = std::strtoull(fields[3].c_str(), nullptr, 10);
+				site.size_word = std::strtoull(fields[4].c_str(), nullptr, 10);
+				site.compact_capacity = std::strtoull(fields[5].c_str(), nullptr, 10);
+				site.object_size = std::strtoull(fields[6].c_str(), nullptr, 10);
+				site.name = fields[8];
+
+				current = nullptr;
+				for (auto& s : sites)
+					if (s.name == site.name)
+						current = &s;
+				if (current == nullptr)
+				{
+					sites.push_back(site);
+					current = &sites.back();
+				}
+			}
+			else if (fields[0] == "sizes")
+			{
+				if (current == nullptr)
+					return false;
+
+				for (size_t i = 1; i < fields.size(); i++)
+				{
+					size_t colon = fields[i].find(':');
+					if (colon == std::string::npos)
+						return false;
+					size_t size = std::strtoull(fields[i].c_str(), nullptr, 10);
+					uint64_t count = std::strtoull(fields[i].c_str() + colon + 1, nullptr, 10);
+
+					bool merged = false;
+					for (auto& s : current->sizes)
+						if (s.first == size)
+						{
+							s.second += count;
+							merged = true;
+						}
+					if (!merged)
+						current->sizes.push_back(std::make_pair(size, count));
+				}
+			}
+			else
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/// sizeof(compact_vector) with the standard layout for a given compact capacity
+	inline size_t standard_object_size(const profile_site& site, size_t capacity)
+	{
+		size_t full_size = sizeof(void*) + site.size_word;
+		size_t required = capacity * site.element_size > full_size ? capacity * site.element_size : full_size;
+		size_t region = (required + site.size_word - 1) / site.size_word * site.size_word;
+		size_t alignment = site.element_alignment > alignof(void*) ? site.element_alignment : alignof(void*);
+		return (region + site.size_word + alignment - 1) / alignment * alignment;
+	}
+
+	/// cost of one vector that ends with the given size
+	struct cost
+	{
+		uint64_t bytes = 0;
+		uint64_t allocations = 0;
+	};
+
+	// рост удвоением от емкости встроенного буфера, как compact_vector_growth::doubling
+	inline cost vector_cost(const profile_site& site, size_t capacity, size_t size)
+	{
+		cost c;
+		c.bytes = standard_object_size(site, capacity);
+		if (size <= capacity)
+			return c;
+
+		size_t heap = capacity == 0 ? 1 : capacity;
+		while (heap < size)
+		{
+			heap *= 2;
+			c.allocations++;
+		}
+		c.bytes += heap * site.element_size;
+		return c;
+	}
+
+	enum class objective
+	{
+		bytes,
+		allocations
+	};
+
+	struct recommendation
+	{
+		size_t capacity = 0;
+		size_t object_size = 0;
+		uint64_t bytes = 0;
+		uint64_t allocations = 0;
+	};
+
+	inline recommendation evaluate(const profile_site& site, size_t capacity)
+	{
+		recommendation r;
+		r.capacity = capacity;
+		r.object_size = standard_object_size(site, capacity);
+		for (const auto& s : site.sizes)
+		{
+			cost c = vector_cost(site, capacity, s.first);
+			r.bytes += c.bytes * s.second;
+			r.allocations += c.allocations * s.second;
+		}
+		return r;
+	}
+
+	/// best compact capacity for the profiled sizes
+	/*!
+	objective::bytes minimizes inline waste plus heap bytes, objective::allocations minimizes the
+	number of heap allocations (ties broken by bytes). Candidates are 1..max_capacity whose
+	sizeof(compact_vector) does not exceed sizeof_budget (0 means no budget).
+	The model assumes the standard layout and doubling growth.
+	*/
+	inline recommendation recommend(const profile_site& site, objective goal, size_t sizeof_budget, size_t max_capacity = 255)
+	{
+		recommendation best = evaluate(site, 1);
+		for (size_t capacity = 2; capacity <= max_capacity; capacity++)
+		{
+			recommendation r = evaluate(site, capacity);
+			if (sizeof_budget != 0 && r.object_size > sizeof_budget)
+				break;
+
+			bool better = goal == objective::bytes
+				? r.bytes < best.bytes
+				: r.allocations < best.allocations || (r.allocations == best.allocations && r.bytes < best.bytes);
+			if (better)
+				best = r;
+		}
+		return best;
+	}
+}
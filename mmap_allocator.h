@@ -0,0 +1,578 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define COMPACT_VECTOR_HAS_MMAP 1
+#endif
+
+/// offset_ptr
+/*!
+Self-relative pointer: it stores the distance from its own address to the target, so a structure
+that holds only offset_ptrs keeps its meaning at any address it is mapped to. Copying recomputes
+the distance, therefore an offset_ptr must never be copied bytewise (memcpy, realloc).
+The null pointer is encoded as 1, which is never a valid distance to an object of the same alignment.
+*/
+template <class T>
+class offset_ptr
+{
+public:
+	using element_type = T;
+	using value_type = typename std::remove_cv<T>::type;
+	using difference_type = std::ptrdiff_t;
+	using pointer = T*;
+	using reference = typename std::add_lvalue_reference<T>::type;
+	using iterator_category = std::random_access_iterator_tag;
+
+	template <class U>
+	using rebind = offset_ptr<U>;
+
+	offset_ptr() noexcept
+	{}
+
+	offset_ptr(std::nullptr_t) noexcept
+	{}
+
+	offset_ptr(T* p) noexcept
+	{
+		set(p);
+	}
+
+	offset_ptr(const offset_ptr& x) noexcept
+	{
+		set(x.get());
+	}
+
+	template <class U, class = typename std::enable_if<std::is_convertible<U*, T*>::value>::type>
+	offset_ptr(const offset_ptr<U>& x) noexcept
+	{
+		set(x.get());
+	}
+
+	offset_ptr& operator= (const offset_ptr& x) noexcept
+	{
+		set(x.get());
+		return *this;
+	}
+
+	offset_ptr& operator= (T* p) noexcept
+	{
+		set(p);
+		return *this;
+	}
+
+	template <class U = T>
+	static offset_ptr pointer_to(typename std::add_lvalue_reference<U>::type r) noexcept
+	{
+		return offset_ptr(std::addressof(r));
+	}
+
+	T* get() const noexcept
+	{
+		if (offset == null_offset)
+			return nullptr;
+		return reinterpret_cast<T*>(reinterpret_cast<uintptr_t>(this) + static_cast<uintptr_t>(offset));
+	}
+
+	T* operator-> () const noexcept
+	{
+		return get();
+	}
+
+	reference operator* () const noexcept
+	{
+		return *get();
+	}
+
+	reference operator[] (difference_type i) const noexcept
+	{
+		return get()[i];
+	}
+
+	explicit operator bool() const noexcept
+	{
+		return offset != null_offset;
+	}
+
+	offset_ptr& operator+= (difference_type n) noexcept
+	{
+		set(get() + n);
+		return *this;
+	}
+
+	offset_ptr& operator-= (difference_type n) noexcept
+	{
+		set(get() - n);
+		return *this;
+	}
+
+	offset_ptr& operator++ () noexcept
+	{
+		return *this += 1;
+	}
+
+	offset_ptr& operator-- () noexcept
+	{
+		return *this -= 1;
+	}
+
+	offset_ptr operator++ (int) noexcept
+	{
+		offset_ptr result(*this);
+		++*this;
+		return result;
+	}
+
+	offset_ptr operator-- (int) noexcept
+	{
+		offset_ptr result(*this);
+		--*this;
+		return result;
+	}
+
+	friend offset_ptr operator+ (const offset_ptr& p, difference_type n) noexcept
+	{
+		return offset_ptr(p.get() + n);
+	}
+
+	friend offset_ptr operator- (const offset_ptr& p, difference_type n) noexcept
+	{
+		return offset_ptr(p.get() - n);
+	}
+
+	friend difference_type operator- (const offset_ptr& a, const offset_ptr& b) noexcept
+	{
+		return a.get() - b.get();
+	}
+
+	friend bool operator== (const offset_ptr& a, const offset_ptr& b) noexcept
+	{
+		return a.get() == b.get();
+	}
+
+	friend bool operator!= (const offset_ptr& a, const offset_ptr& b) noexcept
+	{
+		return a.get() != b.get();
+	}
+
+	friend bool operator< (const offset_ptr& a, const offset_ptr& b) noexcept
+	{
+		return a.get() < b.get();
+	}
+
+private:
+	static constexpr std::ptrdiff_t null_offset = 1;
+
+	std::ptrdiff_t offset = null_offset;
+
+	void set(T* p) noexcept
+	{
+		if (p == nullptr)
+			offset = null_offset;
+		else
+			offset = static_cast<std::ptrdiff_t>(reinterpret_cast<uintptr_t>(p) - reinterpret_cast<uintptr_t>(this));
+	}
+};
+
+/// mapped_region
+/*!
+Bump allocator over a contiguous region. It lives at the start of the region itself and
+stores only offsets, so the region may be mapped at a different address every time it is opened.
+The region size is fixed at creation. Only the last block can be extended in place, other
+blocks are never reclaimed. Not thread-safe: a region has a single writer.
+*/
+class mapped_region
+{
+public:
+	static constexpr uint64_t magic_value = 0x31564d4f43564d4dull; // "MMVCOMV1"
+
+	static constexpr uint32_t version_value = 1;
+
+	explicit mapped_region(size_t capacity_bytes) noexcept :
+		magic(magic_value),
+		version(version_value),
+		root_size(0),
+		capacity(capacity_bytes),
+		used(sizeof(mapped_region)),
+		last(0),
+		root(0)
+	{}
+
+	mapped_region(const mapped_region&) = delete;
+	mapped_region& operator= (const mapped_region&) = delete;
+
+	/// true if the region starts with a header of this version and fits into size bytes
+	bool valid(size_t size) const noexcept
+	{
+		return magic == magic_value && version == version_value && capacity == size && used <= capacity;
+	}
+
+	void* allocate(size_t bytes, size_t alignment)
+	{
+		uint64_t offset = (used + alignment - 1) / alignment * alignment;
+		if (offset > capacity || bytes > capacity - offset)
+			throw std::bad_alloc();
+
+		used = offset + bytes;
+		last = offset;
+		return base() + offset;
+	}
+
+	/// extends the last block from old_bytes to new_bytes without moving it, if the region has room
+	bool extend(void* p, size_t old_bytes, size_t new_bytes) noexcept
+	{
+		if (p == nullptr || last == 0 || p != base() + last || new_bytes > capacity - last)
+			return false;
+
+		(void)old_bytes;
+		used = last + new_bytes;
+		return true;
+	}
+
+	/// records the root object; a region has at most one
+	void set_root(const void* p, size_t size) noexcept
+	{
+		root = static_cast<uint64_t>(static_cast<const char*>(p) - base());
+		root_size = static_cast<uint32_t>(size);
+	}
+
+	void* get_root(size_t size) noexcept
+	{
+		return root == 0 || root_size != size ? nullptr : base() + root;
+	}
+
+	const void* get_root(size_t size) const noexcept
+	{
+		return const_cast<mapped_region*>(this)->get_root(size);
+	}
+
+	/// bytes handed out, including the header and alignment padding
+	size_t used_bytes() const noexcept
+	{
+		return static_cast<size_t>(used);
+	}
+
+	size_t capacity_bytes() const noexcept
+	{
+		return static_cast<size_t>(capacity);
+	}
+
+private:
+	uint64_t magic;
+	uint32_t version;
+	uint32_t root_size;
+	uint64_t capacity;
+	uint64_t used;
+	uint64_t last;
+	uint64_t root;
+
+	char* base() noexcept
+	{
+		return reinterpret_cast<char*>(this);
+	}
+
+	const char* base() const noexcept
+	{
+		return reinterpret_cast<const char*>(this);
+	}
+};
+
+/// mmap_allocator
+/*!
+Allocator that takes memory from a mapped_region. Its pointer type is offset_ptr<T>, so
+compact_vector stores the heap pointer self-relatively and a vector constructed inside the region
+(see mapped_file::construct_root) together with its spilled elements can be used again after the file
+is reopened at another address, without deserialization. The allocator itself holds an offset_ptr
+to the region, so it may live inside the region as well.
+
+deallocate() does nothing and is_monotonic is set; reallocate() extends the last block in place.
+The elements must be position-independent too: trivially copyable types or containers that use
+mmap_allocator themselves.
+*/
+template <class T>
+struct mmap_allocator
+{
+	using value_type = T;
+	using pointer = offset_ptr<T>;
+	using const_pointer = offset_ptr<const T>;
+	using void_pointer = offset_ptr<void>;
+	using const_void_pointer = offset_ptr<const void>;
+
+	static constexpr bool is_monotonic = true;
+
+	template <class U>
+	struct rebind
+	{
+		using other = mmap_allocator<U>;
+	};
+
+	explicit mmap_allocator(mapped_region& r) noexcept :
+		source(&r)
+	{}
+
+	template <class U>
+	mmap_allocator(const mmap_allocator<U>& x) noexcept :
+		source(x.source)
+	{}
+
+	pointer allocate(size_t n)
+	{
+		if (n > std::numeric_limits<size_t>::max() / sizeof(T))
+			throw std::bad_alloc();
+
+		return pointer(static_cast<T*>(source->allocate(n * sizeof(T), alignof(T))));
+	}
+
+	void deallocate(pointer, size_t) noexcept
+	{
+	}
+
+	/// reallocate
+	/*!
+	Extends the block in place if it is the last one in the region, otherwise copies it
+	to a new block. The old block is not reclaimed.
+	*/
+	pointer reallocate(pointer p, size_t old_n, size_t new_n)
+	{
+		if (new_n > std::numeric_limits<size_t>::max() / sizeof(T))
+			throw std::bad_alloc();
+
+		if (source->extend(p.get(), old_n * sizeof(T), new_n * sizeof(T)))
+			return p;
+
+		pointer result = allocate(new_n);
+		std::memcpy(static_cast<void*>(result.get()), p.get(), (old_n < new_n ? old_n : new_n) * sizeof(T));
+		return result;
+	}
+
+	offset_ptr<mapped_region> source;
+};
+
+template <class T, class U>
+bool operator== (const mmap_allocator<T>& a, const mmap_allocator<U>& b) noexcept
+{
+	return a.source.get() == b.source.get();
+}
+
+template <class T, class U>
+bool operator!= (const mmap_allocator<T>& a, const mmap_allocator<U>& b) noexcept
+{
+	return a.source.get() != b.source.get();
+}
+
+#ifdef COMPACT_VECTOR_HAS_MMAP
+
+/// mapped_file
+/*!
+A file mapped with MAP_SHARED that holds a mapped_region. create() makes a new file of a fixed
+size (sparse where the file system allows it), open() maps an existing one, in read-only mode
+with PROT_READ so several processes can share it. Changes reach the file on sync() or when the
+mapping is closed.
+
+The root object is constructed once with construct_root() and found again with root() after reopening:
+
+	auto file = mapped_file::create("data.bin", 1 << 20);
+	using vector = compact_vector<int, -1, mmap_allocator<int>>;
+	vector& v = file.construct_root<vector>(file.allocator<int>());
+	...
+	const mapped_file copy = mapped_file::open("data.bin", mapped_file::read_only);
+	const vector* w = copy.root<vector>();
+
+The root type is checked by size only. The file format depends on the platform ABI.
+*/
+class mapped_file
+{
+public:
+	enum access_mode
+	{
+		read_write,
+		read_only
+	};
+
+	static mapped_file create(const char* path, size_t capacity_bytes)
+	{
+		if (capacity_bytes < sizeof(mapped_region))
+			throw std::invalid_argument("mapped_file capacity is smaller than the header");
+
+		mapped_file f;
+		f.fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (f.fd < 0)
+			throw_errno("open");
+		if (::ftruncate(f.fd, static_cast<off_t>(capacity_bytes)) != 0)
+			throw_errno("ftruncate");
+
+		f.map(capacity_bytes, read_write);
+		new (f.address) mapped_region(capacity_bytes);
+		return f;
+	}
+
+	static mapped_file open(const char* path, access_mode mode = read_write)
+	{
+		mapped_file f;
+		f.fd = ::open(path, mode == read_only ? O_RDONLY : O_RDWR);
+		if (f.fd < 0)
+			throw_errno("open");
+
+		struct stat st;
+		if (::fstat(f.fd, &st) != 0)
+			throw_errno("fstat");
+		if (static_cast<size_t>(st.st_size) < sizeof(mapped_region))
+			throw std::runtime_error("mapped_file is too small");
+
+		f.map(static_cast<size_t>(st.st_size), mode);
+		if (!f.region().valid(f.size))
+			throw std::runtime_error("mapped_file has an unknown format");
+		return f;
+	}
+
+	mapped_file(mapped_file&& x) noexcept :
+		fd(x.fd),
+		address(x.address),
+		size(x.size),
+		mode(x.mode)
+	{
+		x.fd = -1;
+		x.address = nullptr;
+	}
+
+	mapped_file& operator= (mapped_file&& x) noexcept
+	{
+		if (this != &x)
+		{
+			close();
+			fd = x.fd;
+			address = x.address;
+			size = x.size;
+			mode = x.mode;
+			x.fd = -1;
+			x.address = nullptr;
+		}
+		return *this;
+	}
+
+	mapped_file(const mapped_file&) = delete;
+	mapped_file& operator= (const mapped_file&) = delete;
+
+	~mapped_file()
+	{
+		close();
+	}
+
+	template <class T>
+	mmap_allocator<T> allocator()
+	{
+		return mmap_allocator<T>(region());
+	}
+
+	/// constructs the root object inside the file; the file must be writable and have no root yet
+	template <class V, class... Args>
+	V& construct_root(Args&&... args)
+	{
+		if (mode == read_only)
+			throw std::logic_error("mapped_file is read-only");
+		if (region().get_root(sizeof(V)) != nullptr)
+			throw std::logic_error("mapped_file already has a root object");
+
+		void* p = region().allocate(sizeof(V), alignof(V));
+		V* root = new (p) V(std::forward<Args>(args)...);
+		region().set_root(root, sizeof(V));
+		return *root;
+	}
+
+	/// the root object or nullptr if there is none or its size does not match V
+	/*!
+	A read-only file gives access to the root through the const overload only.
+	*/
+	template <class V>
+	V* root()
+	{
+		if (mode == read_only)
+			throw std::logic_error("mapped_file is read-only");
+		return static_cast<V*>(region().get_root(sizeof(V)));
+	}
+
+	template <class V>
+	const V* root() const
+	{
+		return static_cast<const V*>(region().get_root(sizeof(V)));
+	}
+
+	/// writes dirty pages to the file
+	void sync()
+	{
+		if (mode == read_write && ::msync(address, size, MS_SYNC) != 0)
+			throw_errno("msync");
+	}
+
+	mapped_region& region() noexcept
+	{
+		return *static_cast<mapped_region*>(address);
+	}
+
+	const mapped_region& region() const noexcept
+	{
+		return *static_cast<const mapped_region*>(address);
+	}
+
+	const void* data() const noexcept
+	{
+		return address;
+	}
+
+	size_t size_bytes() const noexcept
+	{
+		return size;
+	}
+
+private:
+	int fd = -1;
+	void* address = nullptr;
+	size_t size = 0;
+	access_mode mode = read_write;
+
+	mapped_file() = default;
+
+	void map(size_t bytes, access_mode m)
+	{
+		int protection = m == read_only ? PROT_READ : PROT_READ | PROT_WRITE;
+		void* p = ::mmap(nullptr, bytes, protection, MAP_SHARED, fd, 0);
+		if (p == MAP_FAILED)
+			throw_errno("mmap");
+
+		address = p;
+		size = bytes;
+		mode = m;
+	}
+
+	void close() noexcept
+	{
+		if (address != nullptr)
+			::munmap(address, size);
+		if (fd >= 0)
+			::close(fd);
+		address = nullptr;
+		fd = -1;
+	}
+
+	[[noreturn]] static void throw_errno(const char* what)
+	{
+		throw std::system_error(errno, std::generic_category(), what);
+	}
+};
+
+#endif // COMPACT_VECTOR_HAS_MMAP
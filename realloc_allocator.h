@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <limits>
+
+/// realloc_allocator
+/*!
+Allocator on top of malloc/free with an extra reallocate() member.
+compact_vector uses reallocate() to grow or shrink a heap buffer in place when
+compact_vector_traits::is_trivially_relocatable<T> holds, instead of allocate + move + deallocate.
+For large blocks glibc realloc remaps pages with mremap, so no bytes are copied at all.
+*/
+template <class T>
+struct realloc_allocator
+{
+	static_assert(alignof(T) <= alignof(std::max_align_t), "realloc_allocator supports only fundamental alignment");
+
+	using value_type = T;
+
+	template <class U>
+	struct rebind
+	{
+		using other = realloc_allocator<U>;
+	};
+
+	realloc_allocator() noexcept
+	{}
+
+	template <class U>
+	realloc_allocator(const realloc_allocator<U>&) noexcept
+	{}
+
+	T* allocate(size_t n)
+	{
+		if (n > std::numeric_limits<size_t>::max() / sizeof(T))
+			throw std::bad_alloc();
+
+		void* p = std::malloc(n * sizeof(T));
+		if (p == nullptr)
+			throw std::bad_alloc();
+		return static_cast<T*>(p);
+	}
+
+	void deallocate(T* p, size_t) noexcept
+	{
+		std::free(p);
+	}
+
+	/// reallocate
+	/*!
+	Resizes the block to new_n elements, moving its bytes if it cannot be resized in place.
+	On failure throws std::bad_alloc and leaves the original block untouched.
+	*/
+	T* reallocate(T* p, size_t, size_t new_n)
+	{
+		if (new_n > std::numeric_limits<size_t>::max() / sizeof(T))
+			throw std::bad_alloc();
+
+		void* result = std::realloc(static_cast<void*>(p), new_n * sizeof(T));
+		if (result == nullptr)
+			throw std::bad_alloc();
+		return static_cast<T*>(result);
+	}
+};
+
+template <class T, class U>
+bool operator== (const realloc_allocator<T>&, const realloc_allocator<U>&) noexcept
+{
+	return true;
+}
+
+template <class T, class U>
+bool operator!= (const realloc_allocator<T>&, const realloc_allocator<U>&) noexcept
+{
+	return false;
+}
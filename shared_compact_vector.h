@@ -0,0 +1,646 @@
+#pragma once
+
+#include "compact_vector.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+/// shared_compact_vector
+/*!
+Copy-on-write variant of compact_vector for snapshots that are copied often and rarely changed.
+Up to compact_capacity elements are kept inline and copied by value, as in compact_vector.
+A heap buffer is a block with an atomic reference count in front of the elements: copying the vector
+shares the block in O(1), and the first mutable access (non-const data(), begin(), operator[],
+push_back, erase, ...) of a vector whose block is shared copies the elements into a block of its own.
+clear() and destruction of a shared copy only drop a reference.
+
+Copies may be read and changed from different threads; one object must not be changed concurrently,
+as with any container. Read through a const reference (or cbegin(), cdata()) to avoid unsharing.
+A reference or iterator obtained by mutable access must not be kept across a copy of the vector:
+after the copy both vectors share the buffer it points into (the same rule as Qt implicit sharing).
+
+Copies share the allocator together with the buffer, so the allocator is always copied with the vector.
+*/
+template <class T, int compact_max_size = -1, class allocator_type = std::allocator<T>>
+class shared_compact_vector
+{
+	struct header
+	{
+		std::atomic<size_t> refs;
+		size_t capacity;
+	};
+
+	static constexpr size_t word_alignment = alignof(header) > alignof(T) ? alignof(header) : alignof(T);
+
+	// блок кучи выделяется словами, выровненными и для заголовка, и для элементов
+	struct alignas(word_alignment) block_word
+	{
+		unsigned char bytes[word_alignment];
+	};
+
+	static constexpr size_t header_words = (sizeof(header) + sizeof(block_word) - 1) / sizeof(block_word);
+
+	using block_allocator = typename std::allocator_traits<allocator_type>::template rebind_alloc<block_word>;
+	using block_traits = std::allocator_traits<block_allocator>;
+	using size_allocator_pair = typename compact_vector_layout::standard<block_word, 1, block_allocator, size_t>::size_allocator_pair;
+
+	static constexpr size_t full_size = sizeof(header*) + sizeof(size_t);
+
+	static constexpr size_t compact_default_capacity = full_size / sizeof(T) == 0 ? 1 : full_size / sizeof(T);
+
+public:
+	using value_type = T;
+	using size_type = size_t;
+	using difference_type = std::ptrdiff_t;
+	using reference = T&;
+	using const_reference = const T&;
+	using pointer = T*;
+	using const_pointer = const T*;
+	using iterator = T*;
+	using const_iterator = const T*;
+
+	static constexpr size_t compact_capacity = compact_max_size <= 0 ? compact_default_capacity : compact_max_size;
+
+	static constexpr size_t vector_max_size = std::numeric_limits<size_t>::max() >> 1;
+
+	explicit shared_compact_vector(const allocator_type& alloc = allocator_type()) :
+		size_allocator(block_allocator(alloc))
+	{}
+
+	explicit shared_compact_vector(size_t n, const allocator_type& alloc = allocator_type()) :
+		size_allocator(block_allocator(alloc))
+	{
+		resize(n);
+	}
+
+	shared_compact_vector(size_t n, const T& val, const allocator_type& alloc = allocator_type()) :
+		size_allocator(block_allocator(alloc))
+	{
+		resize(n, val);
+	}
+
+	template <class InputIterator, class = typename std::enable_if<!std::is_integral<InputIterator>::value>::type>
+	shared_compact_vector(InputIterator first, InputIterator last, const allocator_type& alloc = allocator_type()) :
+		size_allocator(block_allocator(alloc))
+	{
+		assign(first, last);
+	}
+
+	shared_compact_vector(std::initializer_list<T> il, const allocator_type& alloc = allocator_type()) :
+		size_allocator(block_allocator(alloc))
+	{
+		assign(il.begin(), il.end());
+	}
+
+	/// copy: shares the heap block, copies inline elements
+	shared_compact_vector(const shared_compact_vector& x) :
+		size_allocator(x.get_block_allocator())
+	{
+		if (!x.is_compact())
+		{
+			header* h = x.heap();
+			h->refs.fetch_add(1, std::memory_order_relaxed);
+			set_heap(h, x.size());
+			return;
+		}
+
+		std::uninitialized_copy(x.compact_data(), x.compact_data() + x.size(), compact_data());
+		set_size(x.size());
+	}
+
+	shared_compact_vector(shared_compact_vector&& x) noexcept(std::is_nothrow_move_constructible<T>::value) :
+		size_allocator(x.get_block_allocator())
+	{
+		take(x);
+	}
+
+	~shared_compact_vector()
+	{
+		release();
+	}
+
+	shared_compact_vector& operator= (const shared_compact_vector& x)
+	{
+		if (this != &x)
+		{
+			shared_compact_vector copy(x);
+			*this = std::move(copy);
+		}
+		return *this;
+	}
+
+	shared_compact_vector& operator= (shared_compact_vector&& x) noexcept(std::is_nothrow_move_constructible<T>::value)
+	{
+		if (this != &x)
+		{
+			release();
+			size_allocator.set_size(0, true);
+			get_block_allocator() = std::move(x.get_block_allocator());
+			take(x);
+		}
+		return *this;
+	}
+
+	shared_compact_vector& operator= (std::initializer_list<T> il)
+	{
+		assign(il.begin(), il.end());
+		return *this;
+	}
+
+	template <class InputIterator, class = typename std::enable_if<!std::is_integral<InputIterator>::value>::type>
+	void assign(InputIterator first, InputIterator last)
+	{
+		clear();
+		for (; first != last; ++first)
+			emplace_back(*first);
+	}
+
+	void assign(size_t n, const T& val)
+	{
+		clear();
+		resize(n, val);
+	}
+
+	void assign(std::initializer_list<T> il)
+	{
+		assign(il.begin(), il.end());
+	}
+
+	allocator_type get_allocator() const noexcept
+	{
+		return allocator_type(get_block_allocator());
+	}
+
+	size_t size() const noexcept
+	{
+		return size_allocator.get_size();
+	}
+
+	bool empty() const noexcept
+	{
+		return size() == 0;
+	}
+
+	size_t capacity() const noexcept
+	{
+		return is_compact() ? compact_capacity : heap()->capacity;
+	}
+
+	size_t max_size() const noexcept
+	{
+		return vector_max_size;
+	}
+
+	/// number of vectors sharing the heap block, 0 for inline data
+	size_t use_count() const noexcept
+	{
+		return is_compact() ? 0 : heap()->refs.load(std::memory_order_relaxed);
+	}
+
+	const T* cdata() const noexcept
+	{
+		return is_compact() ? compact_data() : elements(heap());
+	}
+
+	const T* data() const noexcept
+	{
+		return cdata();
+	}
+
+	/// mutable access: a shared heap block is copied first
+	T* data()
+	{
+		return prepare_write(size());
+	}
+
+	const_iterator cbegin() const noexcept
+	{
+		return cdata();
+	}
+
+	const_iterator cend() const noexcept
+	{
+		return cdata() + size();
+	}
+
+	const_iterator begin() const noexcept
+	{
+		return cbegin();
+	}
+
+	const_iterator end() const noexcept
+	{
+		return cend();
+	}
+
+	iterator begin()
+	{
+		return data();
+	}
+
+	iterator end()
+	{
+		T* p = data();
+		return p + size();
+	}
+
+	const T& operator[] (size_t n) const noexcept
+	{
+		return cdata()[n];
+	}
+
+	T& operator[] (size_t n)
+	{
+		return data()[n];
+	}
+
+	const T& at(size_t n) const
+	{
+		if (n >= size())
+			throw std::out_of_range(u8"shared_compact_vector out of range");
+
+		return cdata()[n];
+	}
+
+	T& at(size_t n)
+	{
+		if (n >= size())
+			throw std::out_of_range(u8"shared_compact_vector out of range");
+
+		return data()[n];
+	}
+
+	const T& front() const noexcept
+	{
+		return cdata()[0];
+	}
+
+	T& front()
+	{
+		return data()[0];
+	}
+
+	const T& back() const noexcept
+	{
+		return cdata()[size() - 1];
+	}
+
+	T& back()
+	{
+		T* p = data();
+		return p[size() - 1];
+	}
+
+	void reserve(size_t n)
+	{
+		if (n > capacity())
+			reallocate(checked_capacity(n));
+	}
+
+	void push_back(const T& x)
+	{
+		emplace_back(x);
+	}
+
+	void push_back(T&& x)
+	{
+		emplace_back(std::move(x));
+	}
+
+	template <class... Args>
+	T& emplace_back(Args&&... args)
+	{
+		size_t n = size();
+		T* p;
+		if (writable_capacity() > n)
+			p = ::new (static_cast<void*>(cdata_mutable() + n)) T(std::forward<Args>(args)...);
+		else
+		{
+			// аргументы могут ссылаться на элементы этого вектора, поэтому значение создается до переезда
+			T value(std::forward<Args>(args)...);
+			p = ::new (static_cast<void*>(prepare_write(n + 1) + n)) T(std::move(value));
+		}
+		set_size(n + 1);
+		return *p;
+	}
+
+	void pop_back()
+	{
+		T* p = prepare_write(size());
+		p[size() - 1].~T();
+		set_size(size() - 1);
+	}
+
+	iterator insert(const_iterator position, const T& x)
+	{
+		size_t offset = position - cbegin();
+		emplace_back(x);
+		T* p = cdata_mutable();
+		std::rotate(p + offset, p + size() - 1, p + size());
+		return p + offset;
+	}
+
+	iterator erase(const_iterator position)
+	{
+		return erase(position, position + 1);
+	}
+
+	iterator erase(const_iterator first, const_iterator last)
+	{
+		size_t from = first - cbegin();
+		size_t count = last - first;
+		size_t n = size();
+		T* p = prepare_write(n);
+		std::move(p + from + count, p + n, p + from);
+		destroy(p + n - count, p + n);
+		set_size(n - count);
+		return p + from;
+	}
+
+	void resize(size_t n)
+	{
+		size_t old_size = size();
+		T* p = prepare_write(n > old_size ? n : old_size);
+		if (n < old_size)
+			destroy(p + n, p + old_size);
+		for (size_t i = old_size; i < n; i++)
+		{
+			::new (static_cast<void*>(p + i)) T();
+			set_size(i + 1);
+		}
+		set_size(n);
+	}
+
+	void resize(size_t n, const T& val)
+	{
+		size_t old_size = size();
+		if (n > old_size)
+		{
+			T value(val);
+			T* p = prepare_write(n);
+			for (size_t i = old_size; i < n; i++)
+			{
+				::new (static_cast<void*>(p + i)) T(value);
+				set_size(i + 1);
+			}
+			return;
+		}
+
+		T* p = prepare_write(old_size);
+		destroy(p + n, p + old_size);
+		set_size(n);
+	}
+
+	/// removes all elements; a shared heap block is only released, a block of its own is kept
+	void clear() noexcept
+	{
+		if (!is_compact() && heap()->refs.load(std::memory_order_acquire) != 1)
+		{
+			release();
+			size_allocator.set_size(0, true);
+			return;
+		}
+
+		T* p = cdata_mutable();
+		destroy(p, p + size());
+		set_size(0);
+	}
+
+	void swap(shared_compact_vector& x)
+	{
+		shared_compact_vector tmp(std::move(x));
+		x = std::move(*this);
+		*this = std::move(tmp);
+	}
+
+	friend void swap(shared_compact_vector& a, shared_compact_vector& b)
+	{
+		a.swap(b);
+	}
+
+	friend bool operator== (const shared_compact_vector& a, const shared_compact_vector& b)
+	{
+		if (a.size() != b.size())
+			return false;
+		return a.cdata() == b.cdata() || std::equal(a.cbegin(), a.cend(), b.cbegin());
+	}
+
+	friend bool operator!= (const shared_compact_vector& a, const shared_compact_vector& b)
+	{
+		return !(a == b);
+	}
+
+	friend bool operator< (const shared_compact_vector& a, const shared_compact_vector& b)
+	{
+		return std::lexicographical_compare(a.cbegin(), a.cend(), b.cbegin(), b.cend());
+	}
+
+private:
+	alignas(word_alignment > alignof(header*) ? word_alignment : alignof(header*))
+	unsigned char region[compact_capacity * sizeof(T) > sizeof(header*) ? compact_capacity * sizeof(T) : sizeof(header*)];
+
+	size_allocator_pair size_allocator;
+
+	block_allocator& get_block_allocator() noexcept
+	{
+		return size_allocator;
+	}
+
+	const block_allocator& get_block_allocator() const noexcept
+	{
+		return size_allocator;
+	}
+
+	bool is_compact() const noexcept
+	{
+		return size_allocator.is_compact();
+	}
+
+	void set_size(size_t n) noexcept
+	{
+		size_allocator.set_size(n, is_compact());
+	}
+
+	T* compact_data() noexcept
+	{
+		return reinterpret_cast<T*>(region);
+	}
+
+	const T* compact_data() const noexcept
+	{
+		return reinterpret_cast<const T*>(region);
+	}
+
+	header* heap() const noexcept
+	{
+		header* h;
+		std::memcpy(&h, region, sizeof(header*));
+		return h;
+	}
+
+	void set_heap(header* h, size_t n) noexcept
+	{
+		std::memcpy(region, &h, sizeof(header*));
+		size_allocator.set_size(n, false);
+	}
+
+	static T* elements(header* h) noexcept
+	{
+		return reinterpret_cast<T*>(reinterpret_cast<block_word*>(h) + header_words);
+	}
+
+	// буфер без проверки совместного владения; только там, где он уже собственный
+	T* cdata_mutable() noexcept
+	{
+		return is_compact() ? compact_data() : elements(heap());
+	}
+
+	bool is_unique() const noexcept
+	{
+		return is_compact() || heap()->refs.load(std::memory_order_acquire) == 1;
+	}
+
+	// емкость, доступная для записи без копирования: у общего блока ее нет
+	size_t writable_capacity() const noexcept
+	{
+		return is_unique() ? capacity() : 0;
+	}
+
+	static size_t block_words(size_t capacity) noexcept
+	{
+		return header_words + (capacity * sizeof(T) + sizeof(block_word) - 1) / sizeof(block_word);
+	}
+
+	static void destroy(T* first, T* last) noexcept
+	{
+		for (; first != last; ++first)
+			first->~T();
+	}
+
+	size_t checked_capacity(size_t required) const
+	{
+		if (required > vector_max_size)
+			throw std::length_error(u8"попытка выделить памяти больше чем max_size()");
+		return required;
+	}
+
+	// делает буфер собственным и вмещающим required элементов; общий блок копируется
+	T* prepare_write(size_t required)
+	{
+		if (is_unique())
+		{
+			if (required <= capacity())
+				return cdata_mutable();
+			reallocate(compact_vector_growth::doubling::next_capacity(capacity(), checked_capacity(required), sizeof(T)));
+		}
+		else
+			reallocate(required > size() ? checked_capacity(required) : size());
+		return elements(heap());
+	}
+
+	// элементы переезжают в новый блок: из общего блока копируются, из собственного буфера переносятся
+	void reallocate(size_t new_capacity)
+	{
+		size_t n = size();
+		bool shared = !is_unique();
+
+		block_word* words = compact_vector_traits::to_address(block_traits::allocate(get_block_allocator(), block_words(new_capacity)));
+		header* h = ::new (static_cast<void*>(words)) header;
+		h->refs.store(1, std::memory_order_relaxed);
+		h->capacity = new_capacity;
+
+		T* source = cdata_mutable();
+		try
+		{
+			if (shared)
+				std::uninitialized_copy(source, source + n, elements(h));
+			else
+				relocate(source, source + n, elements(h), typename std::is_trivially_copyable<T>::type());
+		}
+		catch (...)
+		{
+			deallocate_block(h);
+			throw;
+		}
+
+		if (shared)
+			release();
+		else if (!is_compact())
+			deallocate_block(heap());
+
+		set_heap(h, n);
+	}
+
+	static void relocate(T* first, T* last, T* target, std::true_type) noexcept
+	{
+		if (first != last)
+			std::memcpy(static_cast<void*>(target), first, (last - first) * sizeof(T));
+	}
+
+	static void relocate(T* first, T* last, T* target, std::false_type)
+	{
+		T* constructed = target;
+		try
+		{
+			for (T* i = first; i != last; ++i, ++constructed)
+				::new (static_cast<void*>(constructed)) T(std::move(*i));
+		}
+		catch (...)
+		{
+			destroy(target, constructed);
+			throw;
+		}
+		destroy(first, last);
+	}
+
+	void deallocate_block(header* h) noexcept
+	{
+		size_t words = block_words(h->capacity);
+		h->~header();
+		block_traits::deallocate(get_block_allocator(),
+			compact_vector_traits::from_address<typename block_traits::pointer>(reinterpret_cast<block_word*>(h)), words);
+	}
+
+	// отпускает элементы: встроенные разрушаются, у блока кучи последний владелец разрушает элементы и блок
+	void release() noexcept
+	{
+		if (is_compact())
+		{
+			destroy(compact_data(), compact_data() + size());
+			return;
+		}
+
+		header* h = heap();
+		if (h->refs.load(std::memory_order_acquire) == 1 || h->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			destroy(elements(h), elements(h) + size());
+			deallocate_block(h);
+		}
+	}
+
+	// забирает содержимое x; x остается пустым во встроенном буфере
+	void take(shared_compact_vector& x) noexcept(std::is_nothrow_move_constructible<T>::value)
+	{
+		size_t n = x.size();
+		if (!x.is_compact())
+			set_heap(x.heap(), n);
+		else
+		{
+			T* source = x.compact_data();
+			for (size_t i = 0; i < n; i++)
+				::new (static_cast<void*>(compact_data() + i)) T(std::move(source[i]));
+			destroy(source, source + n);
+			size_allocator.set_size(n, true);
+		}
+		x.size_allocator.set_size(0, true);
+	}
+};
@@ -0,0 +1,172 @@
+﻿// Аппаратные счетчики производительности для измерений в TestsRunner.
+// На Linux используется perf_event_open, на остальных платформах (или если
+// ядро/права не позволяют открыть счетчик) счетчик помечается недоступным.
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+struct PerfCounters
+{
+	enum Counter
+	{
+		cycles,
+		instructions,
+		branch_misses,
+		l1d_misses,
+		llc_misses,
+		counter_count
+	};
+
+	static const char* Name(int counter)
+	{
+		static const char* names[counter_count] =
+		{
+			"cycles",
+			"instructions",
+			"branch_misses",
+			"l1d_misses",
+			"llc_misses"
+		};
+		return names[counter];
+	}
+
+	PerfCounters()
+	{
+		for (int i = 0; i < counter_count; i++)
+			fds[i] = Open(i);
+	}
+
+	~PerfCounters()
+	{
+#if defined(__linux__)
+		for (int i = 0; i < counter_count; i++)
+			if (fds[i] >= 0)
+				close(fds[i]);
+#endif
+	}
+
+	PerfCounters(const PerfCounters&) = delete;
+	PerfCounters& operator= (const PerfCounters&) = delete;
+
+	bool Available(int counter) const
+	{
+		return fds[counter] >= 0;
+	}
+
+	bool AnyAvailable() const
+	{
+		for (int i = 0; i < counter_count; i++)
+			if (Available(i))
+				return true;
+		return false;
+	}
+
+	void Start()
+	{
+#if defined(__linux__)
+		for (int i = 0; i < counter_count; i++)
+		{
+			if (fds[i] < 0)
+				continue;
+			ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+			ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+		}
+#endif
+	}
+
+	void Stop()
+	{
+#if defined(__linux__)
+		for (int i = 0; i < counter_count; i++)
+			if (fds[i] >= 0)
+				ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+#endif
+	}
+
+	// значения с поправкой на мультиплексирование; недоступные счетчики равны 0
+	void Read(uint64_t values[counter_count]) const
+	{
+		for (int i = 0; i < counter_count; i++)
+			values[i] = ReadOne(i);
+	}
+
+private:
+	int fds[counter_count];
+
+	static int Open(int counter)
+	{
+#if defined(__linux__)
+		perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		switch (counter)
+		{
+		case cycles:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_CPU_CYCLES;
+			break;
+		case instructions:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+			break;
+		case branch_misses:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+			break;
+		case l1d_misses:
+			attr.type = PERF_TYPE_HW_CACHE;
+			attr.config = PERF_COUNT_HW_CACHE_L1D
+				| (PERF_COUNT_HW_CACHE_OP_READ << 8)
+				| (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+			break;
+		case llc_misses:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_CACHE_MISSES;
+			break;
+		default:
+			return -1;
+		}
+
+		long fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+		return fd < 0 ? -1 : static_cast<int>(fd);
+#else
+		(void)counter;
+		return -1;
+#endif
+	}
+
+	uint64_t ReadOne(int counter) const
+	{
+#if defined(__linux__)
+		if (fds[counter] < 0)
+			return 0;
+
+		// value, time_enabled, time_running
+		uint64_t data[3] = { 0, 0, 0 };
+		if (read(fds[counter], data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)))
+			return 0;
+		if (data[2] == 0)
+			return 0;
+		if (data[2] < data[1])
+			return static_cast<uint64_t>(static_cast<double>(data[0]) * data[1] / data[2]);
+		return data[0];
+#else
+		(void)counter;
+		return 0;
+#endif
+	}
+};
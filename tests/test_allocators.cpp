@@ -0,0 +1,223 @@
+#include "tests_runner.h"
+#include "../compact_vector.h"
+#include "../arena_allocator.h"
+
+#include <string>
+
+#if __cplusplus >= 201703L && __has_include(<memory_resource>)
+#include <memory_resource>
+#define COMPACT_VECTOR_TEST_PMR
+#endif
+
+namespace
+{
+
+// аллокатор с идентификатором и настраиваемым распространением; считает живые блоки по всем экземплярам
+template <class T, bool propagate>
+struct tagged_allocator
+{
+	static int live_blocks;
+
+	using value_type = T;
+	using propagate_on_container_copy_assignment = std::integral_constant<bool, propagate>;
+	using propagate_on_container_move_assignment = std::integral_constant<bool, propagate>;
+	using propagate_on_container_swap = std::integral_constant<bool, propagate>;
+
+	template <class U>
+	struct rebind
+	{
+		using other = tagged_allocator<U, propagate>;
+	};
+
+	explicit tagged_allocator(int id = 0) noexcept :
+		id(id)
+	{}
+
+	template <class U>
+	tagged_allocator(const tagged_allocator<U, propagate>& x) noexcept :
+		id(x.id)
+	{}
+
+	T* allocate(size_t n)
+	{
+		live_blocks++;
+		return std::allocator<T>().allocate(n);
+	}
+
+	void deallocate(T* p, size_t n) noexcept
+	{
+		live_blocks--;
+		std::allocator<T>().deallocate(p, n);
+	}
+
+	int id;
+};
+
+template <class T, bool propagate>
+int tagged_allocator<T, propagate>::live_blocks = 0;
+
+template <class T, bool propagate>
+bool operator== (const tagged_allocator<T, propagate>& a, const tagged_allocator<T, propagate>& b) noexcept
+{
+	return a.id == b.id;
+}
+
+template <class T, bool propagate>
+bool operator!= (const tagged_allocator<T, propagate>& a, const tagged_allocator<T, propagate>& b) noexcept
+{
+	return a.id != b.id;
+}
+
+template <bool propagate>
+using tagged_vector = compact_vector<std::string, 2, tagged_allocator<std::string, propagate>>;
+
+template <bool propagate>
+tagged_vector<propagate> make_tagged(int id, size_t n)
+{
+	tagged_vector<propagate> vector{tagged_allocator<std::string, propagate>(id)};
+	for (size_t i = 0; i < n; i++)
+		vector.push_back(std::to_string(id * 100 + i));
+	return vector;
+}
+
+}
+
+COMPACT_VECTOR_TEST(arena_allocator_vectors)
+{
+	using vector_type = compact_vector<uint32_t, 4, arena_allocator<uint32_t>>;
+	COMPACT_VECTOR_ASSERT(vector_type::monotonic_allocator);
+	COMPACT_VECTOR_ASSERT(vector_type::use_reallocate);
+	COMPACT_VECTOR_ASSERT(!(compact_vector<uint32_t>::monotonic_allocator));
+
+	arena a(256);
+	for (int round = 0; round < 3; round++)
+	{
+		{
+			vector_type first{arena_allocator<uint32_t>(a)};
+			for (uint32_t i = 0; i < 1000; i++)
+				first.push_back(i);
+			COMPACT_VECTOR_ASSERT(first[999] == 999);
+
+			vector_type second(first);
+			COMPACT_VECTOR_ASSERT(second.get_allocator() == first.get_allocator());
+			COMPACT_VECTOR_ASSERT(second.size() == 1000 && second[500] == 500);
+		}
+		COMPACT_VECTOR_ASSERT(a.used_bytes() >= 2000 * sizeof(uint32_t));
+
+		// сброс освобождает память всех векторов разом и оставляет один кусок для следующего раунда
+		a.reset();
+		COMPACT_VECTOR_ASSERT(a.used_bytes() == 0);
+	}
+	COMPACT_VECTOR_ASSERT(a.reserved_bytes() >= 1000 * sizeof(uint32_t));
+
+	a.release();
+	COMPACT_VECTOR_ASSERT(a.reserved_bytes() == 0);
+}
+
+COMPACT_VECTOR_TEST(arena_extend_last_block)
+{
+	arena a(1024);
+	arena_allocator<uint64_t> allocator(a);
+
+	uint64_t* p = allocator.allocate(4);
+	p[3] = 42;
+	COMPACT_VECTOR_ASSERT(allocator.reallocate(p, 4, 16) == p);
+
+	uint64_t* q = allocator.allocate(1);
+	uint64_t* moved = allocator.reallocate(p, 16, 32);
+	COMPACT_VECTOR_ASSERT(moved != p && moved[3] == 42);
+	COMPACT_VECTOR_ASSERT(q != moved);
+}
+
+COMPACT_VECTOR_TEST(allocator_propagation_copy)
+{
+	{
+		tagged_vector<true> x = make_tagged<true>(1, 5);
+		tagged_vector<true> y = make_tagged<true>(2, 5);
+		y = x;
+		COMPACT_VECTOR_ASSERT(y.get_allocator().id == 1);
+		COMPACT_VECTOR_ASSERT(y.size() == 5 && y[4] == "104");
+	}
+	{
+		tagged_vector<false> x = make_tagged<false>(1, 5);
+		tagged_vector<false> y = make_tagged<false>(2, 5);
+		y = x;
+		COMPACT_VECTOR_ASSERT(y.get_allocator().id == 2);
+		COMPACT_VECTOR_ASSERT(y.size() == 5 && y[4] == "104");
+	}
+	COMPACT_VECTOR_ASSERT((tagged_allocator<std::string, true>::live_blocks == 0));
+	COMPACT_VECTOR_ASSERT((tagged_allocator<std::string, false>::live_blocks == 0));
+}
+
+COMPACT_VECTOR_TEST(allocator_propagation_move)
+{
+	{
+		tagged_vector<true> x = make_tagged<true>(1, 5);
+		tagged_vector<true> y = make_tagged<true>(2, 5);
+		const std::string* buffer = x.data();
+		y = std::move(x);
+		COMPACT_VECTOR_ASSERT(y.get_allocator().id == 1);
+		COMPACT_VECTOR_ASSERT(y.data() == buffer);
+	}
+	{
+		// аллокаторы не распространяются и не равны: элементы переносятся в буфер своего аллокатора
+		tagged_vector<false> x = make_tagged<false>(1, 5);
+		tagged_vector<false> y = make_tagged<false>(2, 1);
+		const std::string* buffer = x.data();
+		y = std::move(x);
+		COMPACT_VECTOR_ASSERT(y.get_allocator().id == 2);
+		COMPACT_VECTOR_ASSERT(y.data() != buffer);
+		COMPACT_VECTOR_ASSERT(y.size() == 5 && y[0] == "100" && y[4] == "104");
+		COMPACT_VECTOR_ASSERT(x.empty());
+
+		tagged_vector<false> z(std::move(y), tagged_allocator<std::string, false>(3));
+		COMPACT_VECTOR_ASSERT(z.get_allocator().id == 3);
+		COMPACT_VECTOR_ASSERT(z.size() == 5 && z[4] == "104");
+
+		tagged_vector<false> w(std::move(z), tagged_allocator<std::string, false>(3));
+		COMPACT_VECTOR_ASSERT(w.size() == 5 && z.empty());
+	}
+	COMPACT_VECTOR_ASSERT((tagged_allocator<std::string, true>::live_blocks == 0));
+	COMPACT_VECTOR_ASSERT((tagged_allocator<std::string, false>::live_blocks == 0));
+}
+
+COMPACT_VECTOR_TEST(allocator_propagation_swap)
+{
+	tagged_vector<true> x = make_tagged<true>(1, 5);
+	tagged_vector<true> y = make_tagged<true>(2, 1);
+	x.swap(y);
+	COMPACT_VECTOR_ASSERT(x.get_allocator().id == 2 && x.size() == 1);
+	COMPACT_VECTOR_ASSERT(y.get_allocator().id == 1 && y.size() == 5);
+
+	tagged_vector<false> a = make_tagged<false>(1, 5);
+	tagged_vector<false> b = make_tagged<false>(1, 1);
+	a.swap(b);
+	COMPACT_VECTOR_ASSERT(a.size() == 1 && b.size() == 5 && b[4] == "104");
+}
+
+#ifdef COMPACT_VECTOR_TEST_PMR
+COMPACT_VECTOR_TEST(allocator_pmr)
+{
+	using vector_type = compact_vector<std::string, 2, std::pmr::polymorphic_allocator<std::string>>;
+
+	std::pmr::monotonic_buffer_resource resource;
+	vector_type x{std::pmr::polymorphic_allocator<std::string>(&resource)};
+	for (int i = 0; i < 10; i++)
+		x.push_back(std::to_string(i));
+	COMPACT_VECTOR_ASSERT(x.get_allocator().resource() == &resource);
+
+	// копия получает ресурс по умолчанию, как и у стандартных контейнеров
+	vector_type copy(x);
+	COMPACT_VECTOR_ASSERT(copy.get_allocator().resource() == std::pmr::get_default_resource());
+	COMPACT_VECTOR_ASSERT(copy.size() == 10 && copy[9] == "9");
+
+	copy = std::move(x);
+	COMPACT_VECTOR_ASSERT(copy.get_allocator().resource() == std::pmr::get_default_resource());
+	COMPACT_VECTOR_ASSERT(copy[9] == "9");
+
+	vector_type moved(std::move(copy));
+	COMPACT_VECTOR_ASSERT(moved.size() == 10);
+	moved.swap(copy);
+	COMPACT_VECTOR_ASSERT(copy.size() == 10 && moved.empty());
+}
+#endif
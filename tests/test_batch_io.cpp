@@ -0,0 +1,206 @@
+#include "tests_runner.h"
+#include "../compact_vector_io.h"
+
+#ifdef COMPACT_VECTOR_HAS_IOVEC
+
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+
+using table_row = compact_vector<uint32_t>;
+
+// строки разной длины: пустые, встроенные и в куче
+std::vector<table_row> make_table(size_t rows)
+{
+	std::vector<table_row> table(rows);
+	for (size_t i = 0; i < rows; i++)
+		for (size_t j = 0; j < (i * 7) % 40; j++)
+			table[i].push_back(static_cast<uint32_t>(i * 1000 + j));
+	return table;
+}
+
+bool same_tables(const std::vector<table_row>& a, const std::vector<table_row>& b)
+{
+	if (a.size() != b.size())
+		return false;
+	for (size_t i = 0; i < a.size(); i++)
+	{
+		if (a[i].size() != b[i].size())
+			return false;
+		for (size_t j = 0; j < a[i].size(); j++)
+			if (a[i][j] != b[i][j])
+				return false;
+	}
+	return true;
+}
+
+// временный файл для чтения и записи, удаляется при выходе из теста
+struct temporary_file
+{
+	const char* path;
+	int fd;
+
+	explicit temporary_file(const char* name) :
+		path(name),
+		fd(::open(name, O_RDWR | O_CREAT | O_TRUNC, 0644))
+	{}
+
+	~temporary_file()
+	{
+		::close(fd);
+		std::remove(path);
+	}
+};
+
+}
+
+COMPACT_VECTOR_TEST(batch_io_round_trip)
+{
+	// больше строк, чем IOV_MAX, чтобы пакет шел несколькими вызовами
+	std::vector<table_row> table = make_table(3000);
+	temporary_file file("compact_vector_test_batch_io.bin");
+	COMPACT_VECTOR_ASSERT(file.fd >= 0);
+
+	compact_vector_batch_io io;
+	size_t written = io.write(file.fd, table.begin(), table.end());
+	COMPACT_VECTOR_ASSERT(written == compact_vector_batch_io::batch_bytes(table.begin(), table.end()));
+
+	// второй пакет по смещению сразу за первым, позиция файла не меняется
+	std::vector<table_row> tail = make_table(10);
+	io.pwrite(file.fd, static_cast<off_t>(written), tail.begin(), tail.end());
+	COMPACT_VECTOR_ASSERT(::lseek(file.fd, 0, SEEK_CUR) == static_cast<off_t>(written));
+
+	::lseek(file.fd, 0, SEEK_SET);
+	std::vector<table_row> restored(table.size());
+	// в векторах до чтения лежат другие данные: длинные укорачиваются, короткие растут
+	restored[0].assign(100, 5);
+	restored[1].assign(1, 5);
+	COMPACT_VECTOR_ASSERT(io.read(file.fd, restored.begin(), restored.end()) == written);
+	COMPACT_VECTOR_ASSERT(same_tables(table, restored));
+	COMPACT_VECTOR_ASSERT(restored[0].empty() && restored[1].size() == table[1].size());
+	// короткие строки читаются во встроенный буфер
+	for (size_t i = 1; i < table.size(); i++)
+	{
+		if (table[i].size() <= table_row::compact_capacity)
+		{
+			COMPACT_VECTOR_ASSERT(restored[i].capacity() == table_row::compact_capacity);
+		}
+	}
+
+	std::vector<table_row> tail_restored(tail.size());
+	io.pread(file.fd, static_cast<off_t>(written), tail_restored.begin(), tail_restored.end());
+	COMPACT_VECTOR_ASSERT(same_tables(tail, tail_restored));
+}
+
+COMPACT_VECTOR_TEST(batch_io_partial_transfers)
+{
+	// канал отдает данные порциями не больше своего буфера, поэтому readv и writev передают их частями
+	std::vector<table_row> table = make_table(2000);
+	for (table_row& row : table)
+		row.resize(row.size() + 50, 7);
+
+	int fds[2];
+	COMPACT_VECTOR_ASSERT(::pipe(fds) == 0);
+
+	std::thread writer([&]
+	{
+		compact_vector_batch_io io;
+		io.write(fds[1], table.begin(), table.end());
+		::close(fds[1]);
+	});
+
+	std::vector<table_row> restored(table.size());
+	compact_vector_batch_io io;
+	size_t read = io.read(fds[0], restored.begin(), restored.end());
+	writer.join();
+	::close(fds[0]);
+
+	COMPACT_VECTOR_ASSERT(read > 400 * 1024);
+	COMPACT_VECTOR_ASSERT(same_tables(table, restored));
+}
+
+COMPACT_VECTOR_TEST(batch_io_truncated)
+{
+	std::vector<table_row> table = make_table(20);
+	temporary_file file("compact_vector_test_batch_io_truncated.bin");
+
+	compact_vector_batch_io io;
+	size_t written = io.write(file.fd, table.begin(), table.end());
+	COMPACT_VECTOR_ASSERT(::ftruncate(file.fd, static_cast<off_t>(written - 1)) == 0);
+
+	std::vector<table_row> restored(table.size());
+	bool thrown = false;
+	try
+	{
+		io.pread(file.fd, 0, restored.begin(), restored.end());
+	}
+	catch (const std::out_of_range&)
+	{
+		thrown = true;
+	}
+	COMPACT_VECTOR_ASSERT(thrown);
+	// таблица счетчиков прочитана, поэтому размеры верны и у коротких, и у длинных векторов
+	for (size_t i = 0; i < table.size(); i++)
+		COMPACT_VECTOR_ASSERT(restored[i].size() == table[i].size());
+
+	// файл обрывается внутри таблицы счетчиков: векторы не меняются
+	COMPACT_VECTOR_ASSERT(::ftruncate(file.fd, 8) == 0);
+	std::vector<table_row> untouched(table.size(), table_row(3, 9));
+	thrown = false;
+	try
+	{
+		io.pread(file.fd, 0, untouched.begin(), untouched.end());
+	}
+	catch (const std::out_of_range&)
+	{
+		thrown = true;
+	}
+	COMPACT_VECTOR_ASSERT(thrown);
+	for (const table_row& row : untouched)
+		COMPACT_VECTOR_ASSERT(row.size() == 3 && row[0] == 9);
+
+	thrown = false;
+	try
+	{
+		io.write(-1, table.begin(), table.end());
+	}
+	catch (const std::system_error&)
+	{
+		thrown = true;
+	}
+	COMPACT_VECTOR_ASSERT(thrown);
+}
+
+COMPACT_VECTOR_TEST(batch_io_malformed_counts)
+{
+	// 2^62 + 1 элементов по 4 байта проходят проверку max_size(), но их размер в байтах
+	// переполняется до 4, и в файле как раз хватает байтов для такого короткого вектора
+	const uint64_t counts[] = { 3, (uint64_t(1) << 62) + 1 };
+	const uint32_t elements[] = { 1, 2, 3, 4 };
+	temporary_file file("compact_vector_test_batch_io_malformed.bin");
+	COMPACT_VECTOR_ASSERT(::write(file.fd, counts, sizeof(counts)) == static_cast<ssize_t>(sizeof(counts)));
+	COMPACT_VECTOR_ASSERT(::write(file.fd, elements, sizeof(elements)) == static_cast<ssize_t>(sizeof(elements)));
+
+	std::vector<table_row> restored(2);
+	compact_vector_batch_io io;
+	bool thrown = false;
+	try
+	{
+		io.pread(file.fd, 0, restored.begin(), restored.end());
+	}
+	catch (const std::out_of_range&)
+	{
+		thrown = true;
+	}
+	COMPACT_VECTOR_ASSERT(thrown);
+}
+
+#endif // COMPACT_VECTOR_HAS_IOVEC
@@ -0,0 +1,119 @@
+#include "tests_runner.h"
+#include "../compact_bitvector.h"
+
+#include <random>
+#include <vector>
+
+COMPACT_VECTOR_TEST(bitvector_inline_bits)
+{
+	COMPACT_VECTOR_ASSERT(sizeof(compact_bitvector) == 3 * sizeof(void*));
+	COMPACT_VECTOR_ASSERT(compact_bitvector::compact_capacity >= 128);
+
+	compact_bitvector bits;
+	for (size_t i = 0; i < compact_bitvector::compact_capacity; i++)
+		bits.push_back(i % 3 == 0);
+	COMPACT_VECTOR_ASSERT(bits.capacity() == compact_bitvector::compact_capacity);
+	COMPACT_VECTOR_ASSERT(bits.count() == (compact_bitvector::compact_capacity + 2) / 3);
+	COMPACT_VECTOR_ASSERT(bits[0] && !bits[1] && bits[3]);
+
+	bits.push_back(true);
+	COMPACT_VECTOR_ASSERT(bits.capacity() > compact_bitvector::compact_capacity);
+	COMPACT_VECTOR_ASSERT(bits[compact_bitvector::compact_capacity]);
+
+	bits.resize(10);
+	bits.shrink_to_fit();
+	COMPACT_VECTOR_ASSERT(bits.capacity() == compact_bitvector::compact_capacity);
+	COMPACT_VECTOR_ASSERT(bits.count() == 4);
+	COMPACT_VECTOR_ASSERT(bits.find_first() == 0 && bits.find_first(1) == 3 && bits.find_first(10) == compact_bitvector::npos);
+}
+
+COMPACT_VECTOR_TEST(bitvector_random_against_vector_bool)
+{
+	// операции сверяются с std::vector<bool> на размерах по обе стороны встроенной емкости
+	std::mt19937 random(9);
+	for (size_t n : {0, 1, 63, 64, 65, 127, 128, 129, 500, 1000})
+	{
+		std::vector<bool> ea(n), eb(n + 37);
+		compact_bitvector a(n), b(n + 37);
+		for (size_t i = 0; i < n; i++)
+			if (random() % 4 == 0)
+			{
+				ea[i] = true;
+				a.set(i);
+			}
+		for (size_t i = 0; i < n + 37; i++)
+			if (random() % 2 == 0)
+			{
+				eb[i] = true;
+				b.set(i);
+			}
+
+		size_t expected_count = 0;
+		for (size_t i = 0; i < n; i++)
+			expected_count += ea[i];
+		COMPACT_VECTOR_ASSERT(a.count() == expected_count);
+		COMPACT_VECTOR_ASSERT(a.any() == (expected_count != 0));
+
+		size_t first = 0;
+		while (first < n && !ea[first])
+			first++;
+		COMPACT_VECTOR_ASSERT(a.find_first() == (first == n ? compact_bitvector::npos : first));
+
+		compact_bitvector and_bits = a & b;
+		compact_bitvector or_bits = a | b;
+		compact_bitvector xor_bits = a ^ b;
+		compact_bitvector and_not_bits = a;
+		and_not_bits.and_not(b);
+		bool intersects = false;
+		for (size_t i = 0; i < n; i++)
+		{
+			COMPACT_VECTOR_ASSERT(and_bits[i] == (ea[i] && eb[i]));
+			COMPACT_VECTOR_ASSERT(or_bits[i] == (ea[i] || eb[i]));
+			COMPACT_VECTOR_ASSERT(xor_bits[i] == (ea[i] != eb[i]));
+			COMPACT_VECTOR_ASSERT(and_not_bits[i] == (ea[i] && !eb[i]));
+			intersects = intersects || (ea[i] && eb[i]);
+		}
+		COMPACT_VECTOR_ASSERT(a.intersects(b) == intersects);
+
+		// биты за пределами size() остаются нулевыми и не влияют на count и сравнение
+		COMPACT_VECTOR_ASSERT(or_bits.size() == n);
+		compact_bitvector flipped = or_bits;
+		flipped.flip();
+		COMPACT_VECTOR_ASSERT(flipped.count() + or_bits.count() == n);
+		flipped.flip();
+		COMPACT_VECTOR_ASSERT(flipped == or_bits);
+	}
+}
+
+COMPACT_VECTOR_TEST(bitvector_resize_copy_move)
+{
+	compact_bitvector bits(300, true);
+	COMPACT_VECTOR_ASSERT(bits.all() && bits.count() == 300);
+
+	bits.resize(70);
+	COMPACT_VECTOR_ASSERT(bits.count() == 70);
+	bits.resize(200);
+	COMPACT_VECTOR_ASSERT(bits.count() == 70 && !bits[199]);
+	bits.resize(250, true);
+	COMPACT_VECTOR_ASSERT(bits.count() == 120 && bits[249] && !bits[199]);
+
+	compact_bitvector copy(bits);
+	COMPACT_VECTOR_ASSERT(copy == bits);
+
+	compact_bitvector moved(std::move(copy));
+	COMPACT_VECTOR_ASSERT(moved == bits && copy.empty());
+
+	compact_bitvector small(5, true);
+	small = bits;
+	COMPACT_VECTOR_ASSERT(small == bits);
+	bits = compact_bitvector(3, true);
+	COMPACT_VECTOR_ASSERT(bits.size() == 3 && bits.count() == 3);
+
+	bits.swap(small);
+	COMPACT_VECTOR_ASSERT(bits.size() == 250 && small.size() == 3);
+
+	bits.pop_back();
+	COMPACT_VECTOR_ASSERT(bits.size() == 249 && bits.count() == 119);
+	bits.clear();
+	COMPACT_VECTOR_ASSERT(bits.empty() && bits.none());
+}
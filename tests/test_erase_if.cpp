@@ -0,0 +1,122 @@
+#include "tests_runner.h"
+#include "../compact_vector.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+// сравнение remove_value с erase-remove над std::vector для всех размеров до n,
+// чтобы задеть и векторную часть ядер, и хвост
+template <class T>
+bool remove_value_matches_std(size_t n)
+{
+	std::mt19937 random(7);
+	for (size_t size = 0; size < n; size++)
+	{
+		compact_vector<T, 4> a;
+		std::vector<T> b;
+		for (size_t i = 0; i < size; i++)
+		{
+			T x = static_cast<T>(random() % 3);
+			a.push_back(x);
+			b.push_back(x);
+		}
+
+		size_t removed = remove_value(a, static_cast<T>(1));
+		size_t expected = b.end() - std::remove(b.begin(), b.end(), static_cast<T>(1));
+		b.resize(b.size() - expected);
+
+		if (removed != expected || a.size() != b.size() || !std::equal(b.begin(), b.end(), a.begin()))
+			return false;
+	}
+	return true;
+}
+
+}
+
+COMPACT_VECTOR_TEST(remove_value_integral)
+{
+	COMPACT_VECTOR_ASSERT(remove_value_matches_std<uint32_t>(70));
+	COMPACT_VECTOR_ASSERT(remove_value_matches_std<int32_t>(70));
+	COMPACT_VECTOR_ASSERT(remove_value_matches_std<uint64_t>(70));
+	COMPACT_VECTOR_ASSERT(remove_value_matches_std<int64_t>(70));
+	COMPACT_VECTOR_ASSERT(remove_value_matches_std<uint8_t>(70));
+	COMPACT_VECTOR_ASSERT(remove_value_matches_std<double>(70));
+}
+
+COMPACT_VECTOR_TEST(remove_value_aliased)
+{
+	compact_vector<std::string, 2> vector = { "a", "b", "a", "c", "a" };
+	size_t removed = vector.remove_value(vector[0]);
+
+	COMPACT_VECTOR_ASSERT(removed == 3);
+	COMPACT_VECTOR_ASSERT(vector.size() == 2);
+	COMPACT_VECTOR_ASSERT(vector[0] == "b");
+	COMPACT_VECTOR_ASSERT(vector[1] == "c");
+}
+
+COMPACT_VECTOR_TEST(erase_if_predicate)
+{
+	compact_vector<uint32_t, 4> ids;
+	for (uint32_t i = 0; i < 100; i++)
+		ids.push_back(i);
+
+	size_t removed = erase_if(ids, [](uint32_t x) { return x % 3 != 0; });
+	COMPACT_VECTOR_ASSERT(removed == 66);
+	COMPACT_VECTOR_ASSERT(ids.size() == 34);
+	for (uint32_t i = 0; i < 34; i++)
+		COMPACT_VECTOR_ASSERT(ids[i] == 3 * i);
+
+	compact_vector<std::string, 2> strings = { "keep", "drop", "keep too", "drop" };
+	COMPACT_VECTOR_ASSERT(strings.erase_if([](const std::string& s) { return s == "drop"; }) == 2);
+	COMPACT_VECTOR_ASSERT(strings.size() == 2);
+	COMPACT_VECTOR_ASSERT(strings[1] == "keep too");
+}
+
+COMPACT_VECTOR_TEST(remove_value_kernels)
+{
+	// каждое ядро, которое поддерживает процессор, сверяется со скалярным
+	std::mt19937 random(11);
+	for (size_t n = 0; n < 40; n++)
+	{
+		std::vector<uint32_t> source32(n);
+		std::vector<uint64_t> source64(n);
+		for (size_t i = 0; i < n; i++)
+			source64[i] = source32[i] = random() % 2;
+
+		std::vector<uint32_t> expected32 = source32;
+		std::vector<uint64_t> expected64 = source64;
+		size_t size32 = compact_vector_simd::detail::remove_equal_scalar<uint32_t>(expected32.data(), n, 1);
+		size_t size64 = compact_vector_simd::detail::remove_equal_scalar<uint64_t>(expected64.data(), n, 1);
+
+#if defined(COMPACT_VECTOR_SIMD_X86)
+		compact_vector_simd::isa isa = compact_vector_simd::detected_isa();
+		if (isa == compact_vector_simd::isa::avx2 || isa == compact_vector_simd::isa::sse42)
+		{
+			std::vector<uint32_t> a = source32;
+			std::vector<uint64_t> b = source64;
+			COMPACT_VECTOR_ASSERT(compact_vector_simd::detail::remove_equal_sse42(a.data(), n, uint32_t(1)) == size32);
+			COMPACT_VECTOR_ASSERT(compact_vector_simd::detail::remove_equal_sse42(b.data(), n, uint64_t(1)) == size64);
+			COMPACT_VECTOR_ASSERT(std::equal(a.begin(), a.begin() + size32, expected32.begin()));
+			COMPACT_VECTOR_ASSERT(std::equal(b.begin(), b.begin() + size64, expected64.begin()));
+		}
+		if (isa == compact_vector_simd::isa::avx2)
+		{
+			std::vector<uint32_t> a = source32;
+			std::vector<uint64_t> b = source64;
+			COMPACT_VECTOR_ASSERT(compact_vector_simd::detail::remove_equal_avx2(a.data(), n, uint32_t(1)) == size32);
+			COMPACT_VECTOR_ASSERT(compact_vector_simd::detail::remove_equal_avx2(b.data(), n, uint64_t(1)) == size64);
+			COMPACT_VECTOR_ASSERT(std::equal(a.begin(), a.begin() + size32, expected32.begin()));
+			COMPACT_VECTOR_ASSERT(std::equal(b.begin(), b.begin() + size64, expected64.begin()));
+		}
+#else
+		(void)size32;
+		(void)size64;
+#endif
+	}
+}
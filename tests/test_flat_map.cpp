@@ -0,0 +1,199 @@
+#include "tests_runner.h"
+#include "../compact_flat_map.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <new>
+#include <random>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+COMPACT_VECTOR_TEST(flat_lower_bound)
+{
+	// линейный и двоичный поиск без переходов совпадают с std::lower_bound на всех размерах
+	std::vector<int> keys;
+	for (int n = 0; n < 100; n++)
+	{
+		for (int key = -1; key <= 2 * n + 1; key++)
+		{
+			size_t expected = std::lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+			COMPACT_VECTOR_ASSERT(compact_flat_detail::count_less(keys.data(), keys.size(), key) == expected);
+			COMPACT_VECTOR_ASSERT(compact_flat_detail::branchless_lower_bound(keys.data(), keys.size(), key) == expected);
+		}
+		keys.push_back(2 * n);
+	}
+
+	std::vector<uint32_t> u32 = { 1, 5, 0x7fffffffu, 0x80000000u, 0x80000001u, 0xfffffff0u, 0xfffffffeu, 0xffffffffu, 0xffffffffu };
+	std::vector<uint64_t> u64(u32.begin(), u32.end());
+	u64.push_back(uint64_t(1) << 63);
+	std::sort(u64.begin(), u64.end());
+	for (uint32_t key : u32)
+	{
+		COMPACT_VECTOR_ASSERT(compact_flat_detail::count_less(u32.data(), u32.size(), key) ==
+			size_t(std::lower_bound(u32.begin(), u32.end(), key) - u32.begin()));
+		COMPACT_VECTOR_ASSERT(compact_flat_detail::count_less(u64.data(), u64.size(), uint64_t(key) << 32) ==
+			size_t(std::lower_bound(u64.begin(), u64.end(), uint64_t(key) << 32) - u64.begin()));
+	}
+}
+
+COMPACT_VECTOR_TEST(flat_set_random)
+{
+	compact_flat_set<int, 8> set;
+	std::set<int> expected;
+	std::mt19937 random(5);
+	for (int i = 0; i < 2000; i++)
+	{
+		int key = static_cast<int>(random() % 200);
+		bool erase = random() % 3 == 0;
+		if (erase)
+		{
+			COMPACT_VECTOR_ASSERT(set.erase(key) == expected.erase(key));
+		}
+		else
+		{
+			COMPACT_VECTOR_ASSERT(set.insert(key).second == expected.insert(key).second);
+		}
+		COMPACT_VECTOR_ASSERT(set.contains(key) == (expected.count(key) != 0));
+	}
+	COMPACT_VECTOR_ASSERT(std::equal(set.begin(), set.end(), expected.begin(), expected.end()));
+
+	compact_flat_set<int, 8> small = { 3, 1, 2, 3 };
+	COMPACT_VECTOR_ASSERT(small.size() == 3 && small.data().capacity() == 8);
+	COMPACT_VECTOR_ASSERT(*small.lower_bound(2) == 2 && *small.upper_bound(2) == 3);
+	COMPACT_VECTOR_ASSERT(small.find(4) == small.end());
+}
+
+COMPACT_VECTOR_TEST(flat_set_sorted_range)
+{
+	compact_flat_set<std::string> set = { "b", "d", "f" };
+	std::vector<std::string> range = { "a", "b", "c", "c", "g" };
+	set.insert_sorted_range(range.begin(), range.end());
+	compact_flat_set<std::string> expected = { "a", "b", "c", "d", "f", "g" };
+	COMPACT_VECTOR_ASSERT(set == expected);
+
+	set.insert_sorted_range(range.begin(), range.begin());
+	COMPACT_VECTOR_ASSERT(set == expected);
+}
+
+COMPACT_VECTOR_TEST(flat_map_basic)
+{
+	compact_flat_map<int, std::string, 4> map;
+	map[3] = "three";
+	map[1] = "one";
+	COMPACT_VECTOR_ASSERT(map.insert(2, "two").second);
+	COMPACT_VECTOR_ASSERT(!map.insert(2, "deux").second);
+	COMPACT_VECTOR_ASSERT(!map.insert_or_assign(1, "un").second);
+	COMPACT_VECTOR_ASSERT(map.size() == 3 && map.at(1) == "un" && map.at(2) == "two");
+	COMPACT_VECTOR_ASSERT(map.keys()[0] == 1 && map.keys()[2] == 3 && map.values()[2] == "three");
+
+	bool thrown = false;
+	try
+	{
+		map.at(7);
+	}
+	catch (const std::out_of_range&)
+	{
+		thrown = true;
+	}
+	COMPACT_VECTOR_ASSERT(thrown);
+
+	int sum = 0;
+	for (auto kv : map)
+	{
+		sum += kv.first;
+		kv.second += "!";
+	}
+	COMPACT_VECTOR_ASSERT(sum == 6 && map.at(3) == "three!");
+
+	auto it = map.find(2);
+	COMPACT_VECTOR_ASSERT(it != map.end() && it->second == "two!");
+	it = map.erase(it);
+	COMPACT_VECTOR_ASSERT((*it).first == 3 && map.size() == 2);
+	COMPACT_VECTOR_ASSERT(map.erase(1) == 1 && map.erase(1) == 0);
+	COMPACT_VECTOR_ASSERT(!map.contains(1) && map.find(1) == map.end());
+
+	const auto& view = map;
+	compact_flat_map<int, std::string, 4>::const_iterator first = view.begin();
+	COMPACT_VECTOR_ASSERT(first->first == 3 && view.end() - first == 1);
+}
+
+COMPACT_VECTOR_TEST(flat_map_insert_aliased_value)
+{
+	compact_flat_map<int, std::string, 2> map;
+	map[1] = "a long string that does not fit into sso buffer";
+	map[2] = "two";
+	map.insert_or_assign(3, map.at(1));
+	COMPACT_VECTOR_ASSERT(map.size() == 3 && map.at(3) == map.at(1));
+}
+
+COMPACT_VECTOR_TEST(flat_map_sorted_range)
+{
+	compact_flat_map<int, int> map = { { 2, 20 }, { 4, 40 } };
+	std::vector<std::pair<int, int>> range = { { 1, 10 }, { 2, 99 }, { 3, 30 }, { 3, 31 }, { 5, 50 } };
+	map.insert_sorted_range(range.begin(), range.end());
+
+	std::map<int, int> expected = { { 1, 10 }, { 2, 20 }, { 3, 30 }, { 4, 40 }, { 5, 50 } };
+	COMPACT_VECTOR_ASSERT(map.size() == expected.size());
+	for (const auto& kv : expected)
+		COMPACT_VECTOR_ASSERT(map.at(kv.first) == kv.second);
+}
+
+namespace
+{
+
+// копирование бросает после заданного числа копий
+struct throwing_value
+{
+	static int copies_left;
+
+	std::string text;
+
+	throwing_value(const char* s = "") : text(s) {}
+
+	throwing_value(const throwing_value& x) : text(x.text)
+	{
+		if (copies_left-- == 0)
+			throw std::bad_alloc();
+	}
+
+	throwing_value(throwing_value&&) noexcept = default;
+	throwing_value& operator= (const throwing_value&) = default;
+	throwing_value& operator= (throwing_value&&) noexcept = default;
+};
+
+int throwing_value::copies_left = -1;
+
+}
+
+COMPACT_VECTOR_TEST(flat_map_sorted_range_throw)
+{
+	compact_flat_map<std::string, throwing_value, 2> map;
+	map.try_emplace("b long key that does not fit into sso buffer", "b");
+	map.try_emplace("d long key that does not fit into sso buffer", "d");
+
+	std::vector<std::pair<std::string, throwing_value>> range;
+	range.emplace_back("a", "a");
+	range.emplace_back("c", "c");
+	range.emplace_back("e", "e");
+
+	// третья копия бросает, когда первые ключи карты уже перенесены в результат
+	throwing_value::copies_left = 2;
+	bool thrown = false;
+	try
+	{
+		map.insert_sorted_range(range.begin(), range.end());
+	}
+	catch (const std::bad_alloc&)
+	{
+		thrown = true;
+	}
+	throwing_value::copies_left = -1;
+
+	COMPACT_VECTOR_ASSERT(thrown && map.size() == 2);
+	COMPACT_VECTOR_ASSERT(map.keys()[0] == "b long key that does not fit into sso buffer");
+	COMPACT_VECTOR_ASSERT(map.keys()[1] == "d long key that does not fit into sso buffer");
+	COMPACT_VECTOR_ASSERT(map.values()[0].text == "b" && map.values()[1].text == "d");
+}
@@ -0,0 +1,148 @@
+#include "tests_runner.h"
+#include "../compact_vector.h"
+#include "../realloc_allocator.h"
+
+#include <stdexcept>
+#include <string>
+
+COMPACT_VECTOR_TEST(growth_doubling)
+{
+	compact_vector<uint32_t, 4> vector;
+	for (uint32_t i = 0; i < 5; i++)
+		vector.push_back(i);
+
+	COMPACT_VECTOR_ASSERT(vector.capacity() == 8);
+	for (uint32_t i = 0; i < 5; i++)
+		COMPACT_VECTOR_ASSERT(vector[i] == i);
+}
+
+COMPACT_VECTOR_TEST(growth_one_and_half)
+{
+	compact_vector<uint32_t, 4, std::allocator<uint32_t>, compact_vector_growth::one_and_half> vector;
+	for (uint32_t i = 0; i < 7; i++)
+		vector.push_back(i);
+
+	// 4 -> 6 -> 9
+	COMPACT_VECTOR_ASSERT(vector.capacity() == 9);
+	for (uint32_t i = 0; i < 7; i++)
+		COMPACT_VECTOR_ASSERT(vector[i] == i);
+}
+
+COMPACT_VECTOR_TEST(growth_fixed_step)
+{
+	compact_vector<uint32_t, 4, std::allocator<uint32_t>, compact_vector_growth::fixed_step<3>> vector;
+	vector.resize(12);
+
+	COMPACT_VECTOR_ASSERT(vector.capacity() == 13);
+	COMPACT_VECTOR_ASSERT(vector.size() == 12);
+}
+
+COMPACT_VECTOR_TEST(growth_size_class)
+{
+	compact_vector<uint8_t, 4, std::allocator<uint8_t>, compact_vector_growth::size_class<>> vector;
+	vector.resize(5);
+
+	// doubling gives 8 bytes, malloc class of 8 bytes is 8
+	COMPACT_VECTOR_ASSERT(vector.capacity() == 8);
+
+	vector.resize(33);
+	// doubling gives 64, already a size class
+	COMPACT_VECTOR_ASSERT(vector.capacity() == 64);
+
+	compact_vector<uint8_t, 4, std::allocator<uint8_t>, compact_vector_growth::size_class<compact_vector_growth::one_and_half>> other;
+	other.resize(100);
+	// 1.5x gives 108 bytes, rounded up to the 112 byte class
+	COMPACT_VECTOR_ASSERT(other.capacity() == 112);
+	COMPACT_VECTOR_ASSERT(other.size() == 100);
+}
+
+COMPACT_VECTOR_TEST(growth_reserve_is_exact)
+{
+	compact_vector<uint32_t, 4, std::allocator<uint32_t>, compact_vector_growth::size_class<>> vector;
+	vector.reserve(13);
+
+	COMPACT_VECTOR_ASSERT(vector.capacity() == 13);
+}
+
+namespace
+{
+
+template <class growth_policy>
+bool resize_over_max_size_throws()
+{
+	compact_vector<int, -1, std::allocator<int>, growth_policy> vector;
+	try
+	{
+		vector.resize(vector.max_size() + 1);
+	}
+	catch (const std::length_error&)
+	{
+		return vector.empty();
+	}
+	return false;
+}
+
+}
+
+COMPACT_VECTOR_TEST(growth_over_max_size)
+{
+	COMPACT_VECTOR_ASSERT(resize_over_max_size_throws<compact_vector_growth::doubling>());
+	COMPACT_VECTOR_ASSERT(resize_over_max_size_throws<compact_vector_growth::one_and_half>());
+	COMPACT_VECTOR_ASSERT(resize_over_max_size_throws<compact_vector_growth::fixed_step<3>>());
+	COMPACT_VECTOR_ASSERT(resize_over_max_size_throws<compact_vector_growth::size_class<>>());
+	COMPACT_VECTOR_ASSERT(resize_over_max_size_throws<compact_vector_growth::size_class<compact_vector_growth::one_and_half>>());
+
+	// политики насыщаются вместо переполнения
+	const size_t limit = compact_vector_growth::max_capacity(sizeof(uint64_t));
+	COMPACT_VECTOR_ASSERT(compact_vector_growth::doubling::next_capacity(4, limit - 1, sizeof(uint64_t)) == limit);
+	COMPACT_VECTOR_ASSERT(compact_vector_growth::one_and_half::next_capacity(4, limit - 1, sizeof(uint64_t)) == limit);
+	COMPACT_VECTOR_ASSERT(compact_vector_growth::fixed_step<1000>::next_capacity(4, limit - 1, sizeof(uint64_t)) == limit);
+	COMPACT_VECTOR_ASSERT(compact_vector_growth::size_class<>::next_capacity(4, limit - 1, sizeof(uint64_t)) == limit);
+	COMPACT_VECTOR_ASSERT(compact_vector_growth::malloc_size_class(SIZE_MAX - 1) == SIZE_MAX - 1);
+}
+
+COMPACT_VECTOR_TEST(growth_aliased_argument)
+{
+	const std::string long_string = "a long string that does not fit into sso buffer";
+
+	compact_vector<std::string, 4> strings = { long_string, "b", "c", "d" };
+	strings.push_back(strings[0]);
+	COMPACT_VECTOR_ASSERT(strings.size() == 5);
+	COMPACT_VECTOR_ASSERT(strings[4] == long_string);
+
+	// рост из кучи в кучу
+	strings.push_back("f");
+	strings.push_back("g");
+	strings.push_back("h");
+	strings.emplace_back(strings[0]);
+	COMPACT_VECTOR_ASSERT(strings.size() == 9);
+	COMPACT_VECTOR_ASSERT(strings[8] == long_string);
+
+	compact_vector<std::string, 4> moved = { long_string, "b", "c", "d" };
+	moved.push_back(std::move(moved[0]));
+	COMPACT_VECTOR_ASSERT(moved.size() == 5);
+	COMPACT_VECTOR_ASSERT(moved[4] == long_string);
+
+	compact_vector<uint64_t, 4> numbers = { 1, 2, 3, 4 };
+	numbers.resize(8, numbers[0]);
+	COMPACT_VECTOR_ASSERT(numbers.size() == 8);
+	for (size_t i = 4; i < 8; i++)
+		COMPACT_VECTOR_ASSERT(numbers[i] == 1);
+
+	numbers.resize(20, numbers[7]);
+	COMPACT_VECTOR_ASSERT(numbers.size() == 20);
+	COMPACT_VECTOR_ASSERT(numbers[19] == 1);
+
+	// рост через realloc
+	compact_vector<uint64_t, 2, realloc_allocator<uint64_t>> reallocated = { 5, 6, 7 };
+	for (int i = 0; i < 20; i++)
+		reallocated.push_back(reallocated[0]);
+	COMPACT_VECTOR_ASSERT(reallocated.size() == 23);
+	COMPACT_VECTOR_ASSERT(reallocated[22] == 5);
+
+	compact_vector<std::string, 4> filled = { long_string, "b" };
+	filled.resize(10, filled[0]);
+	COMPACT_VECTOR_ASSERT(filled.size() == 10);
+	for (size_t i = 2; i < 10; i++)
+		COMPACT_VECTOR_ASSERT(filled[i] == long_string);
+}
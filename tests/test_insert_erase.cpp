@@ -0,0 +1,224 @@
+#include "tests_runner.h"
+#include "../compact_vector.h"
+
+#include <cstdint>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+// тип, который считает копирования, но не перемещения
+struct copy_counter
+{
+	static int copies;
+
+	int value = 0;
+
+	copy_counter(int value = 0) :
+		value(value)
+	{}
+
+	copy_counter(const copy_counter& x) :
+		value(x.value)
+	{
+		copies++;
+	}
+
+	copy_counter& operator= (const copy_counter& x)
+	{
+		value = x.value;
+		copies++;
+		return *this;
+	}
+
+	copy_counter(copy_counter&&) = default;
+	copy_counter& operator= (copy_counter&&) = default;
+};
+
+int copy_counter::copies = 0;
+
+// тип, который считает перемещения
+struct move_counter
+{
+	static int moves;
+
+	int value = 0;
+
+	move_counter(int value = 0) :
+		value(value)
+	{}
+
+	move_counter(const move_counter&) = default;
+	move_counter& operator= (const move_counter&) = default;
+
+	move_counter(move_counter&& x) noexcept :
+		value(x.value)
+	{
+		moves++;
+	}
+
+	move_counter& operator= (move_counter&& x) noexcept
+	{
+		value = x.value;
+		moves++;
+		return *this;
+	}
+};
+
+int move_counter::moves = 0;
+
+template <class Vector, class T>
+bool equal(const Vector& a, const std::vector<T>& b)
+{
+	if (a.size() != b.size())
+		return false;
+	for (size_t i = 0; i < b.size(); i++)
+		if (!(a[i] == b[i]))
+			return false;
+	return true;
+}
+
+// сравнение с std::vector для всех позиций вставки и размеров по обе стороны compact_capacity
+template <class T>
+bool insert_erase_matches_std(const T* values, size_t values_count)
+{
+	for (size_t size = 0; size < 8; size++)
+	{
+		for (size_t position = 0; position <= size; position++)
+		{
+			for (size_t n = 0; n <= values_count; n++)
+			{
+				compact_vector<T, 3> a;
+				std::vector<T> b;
+				for (size_t i = 0; i < size; i++)
+				{
+					a.push_back(values[i % values_count]);
+					b.push_back(values[i % values_count]);
+				}
+
+				a.insert(a.begin() + position, values, values + n);
+				b.insert(b.begin() + position, values, values + n);
+				if (!equal(a, b))
+					return false;
+
+				a.insert(a.begin() + position, n, values[0]);
+				b.insert(b.begin() + position, n, values[0]);
+				if (!equal(a, b))
+					return false;
+
+				a.erase(a.begin() + position, a.begin() + position + n);
+				b.erase(b.begin() + position, b.begin() + position + n);
+				if (!equal(a, b))
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+}
+
+COMPACT_VECTOR_TEST(insert_erase_trivial)
+{
+	const int values[] = { 10, 11, 12, 13, 14, 15 };
+	COMPACT_VECTOR_ASSERT(insert_erase_matches_std(values, 6));
+}
+
+COMPACT_VECTOR_TEST(insert_erase_strings)
+{
+	const std::string values[] = { "a", "bb", "a long string that does not fit into sso buffer", "d", "e" };
+	COMPACT_VECTOR_ASSERT(insert_erase_matches_std(values, 5));
+}
+
+COMPACT_VECTOR_TEST(insert_emplace)
+{
+	compact_vector<std::string, 2> vector;
+	vector.emplace(vector.end(), 3, 'c');
+	vector.emplace(vector.begin(), "a");
+	vector.insert(vector.begin() + 1, std::string("b"));
+	vector.emplace(vector.begin() + 1, vector[1]);
+
+	COMPACT_VECTOR_ASSERT(vector.size() == 4);
+	COMPACT_VECTOR_ASSERT(vector[0] == "a");
+	COMPACT_VECTOR_ASSERT(vector[1] == "b");
+	COMPACT_VECTOR_ASSERT(vector[2] == "b");
+	COMPACT_VECTOR_ASSERT(vector[3] == "ccc");
+}
+
+COMPACT_VECTOR_TEST(insert_aliased_value)
+{
+	compact_vector<std::string, 2> vector = { "x", "y", "z" };
+	vector.insert(vector.begin(), 2, vector[2]);
+	vector.insert(vector.begin(), vector.back());
+
+	COMPACT_VECTOR_ASSERT(vector.size() == 6);
+	COMPACT_VECTOR_ASSERT(vector[0] == "z");
+	COMPACT_VECTOR_ASSERT(vector[1] == "z");
+	COMPACT_VECTOR_ASSERT(vector[2] == "z");
+	COMPACT_VECTOR_ASSERT(vector[3] == "x");
+}
+
+COMPACT_VECTOR_TEST(emplace_end_aliased_value)
+{
+	compact_vector<std::string, 2> vector = { "a long string that does not fit into sso buffer", "y" };
+	vector.emplace(vector.end(), vector[0]);
+	COMPACT_VECTOR_ASSERT(vector.size() == 3);
+	COMPACT_VECTOR_ASSERT(vector[2] == vector[0]);
+
+	compact_vector<uint64_t, 2> numbers = { 42, 7 };
+	numbers.emplace(numbers.end(), numbers[0]);
+	numbers.emplace(numbers.end(), numbers[2]);
+	COMPACT_VECTOR_ASSERT(numbers.size() == 4);
+	COMPACT_VECTOR_ASSERT(numbers[2] == 42);
+	COMPACT_VECTOR_ASSERT(numbers[3] == 42);
+}
+
+COMPACT_VECTOR_TEST(emplace_end_in_place)
+{
+	compact_vector<move_counter, 2> vector;
+	move_counter::moves = 0;
+	vector.emplace(vector.end(), 1);
+	vector.emplace(vector.end(), 2);
+	COMPACT_VECTOR_ASSERT(move_counter::moves == 0);
+
+	// при росте переносятся только старые элементы
+	vector.emplace(vector.end(), 3);
+	COMPACT_VECTOR_ASSERT(move_counter::moves == 2);
+	COMPACT_VECTOR_ASSERT(vector.size() == 3 && vector[0].value == 1 && vector[2].value == 3);
+}
+
+COMPACT_VECTOR_TEST(insert_input_iterator)
+{
+	std::istringstream stream("3 4 5");
+	compact_vector<int, 2> vector = { 1, 2, 6 };
+	auto i = vector.insert(vector.begin() + 2, std::istream_iterator<int>(stream), std::istream_iterator<int>());
+
+	COMPACT_VECTOR_ASSERT(i == vector.begin() + 2);
+	COMPACT_VECTOR_ASSERT(vector.size() == 6);
+	for (int k = 0; k < 6; k++)
+		COMPACT_VECTOR_ASSERT(vector[k] == k + 1);
+}
+
+COMPACT_VECTOR_TEST(insert_copies_each_value_once)
+{
+	compact_vector<copy_counter, 4> vector(8);
+	copy_counter values[3] = { 1, 2, 3 };
+
+	copy_counter::copies = 0;
+	vector.insert(vector.begin() + 2, values, values + 3);
+	COMPACT_VECTOR_ASSERT(copy_counter::copies == 3);
+
+	copy_counter::copies = 0;
+	vector.insert(vector.begin() + 1, 2, values[0]);
+	COMPACT_VECTOR_ASSERT(copy_counter::copies == 2);
+
+	copy_counter::copies = 0;
+	vector.erase(vector.begin(), vector.begin() + 2);
+	COMPACT_VECTOR_ASSERT(copy_counter::copies == 0);
+	COMPACT_VECTOR_ASSERT(vector.size() == 11);
+	COMPACT_VECTOR_ASSERT(vector[0].value == 1);
+	COMPACT_VECTOR_ASSERT(vector[3].value == 2);
+}
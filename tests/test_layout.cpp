@@ -0,0 +1,184 @@
+#include "tests_runner.h"
+#include "../compact_vector.h"
+
+#include <string>
+
+template <class T, int compact_max_size = -1>
+using tail_vector = compact_vector<T, compact_max_size, std::allocator<T>, compact_vector_growth::doubling, compact_vector_layout::tail_size>;
+
+COMPACT_VECTOR_TEST(layout_tail_size_capacity)
+{
+	COMPACT_VECTOR_ASSERT(sizeof(tail_vector<uint8_t>) == 3 * sizeof(void*));
+	COMPACT_VECTOR_ASSERT(sizeof(tail_vector<uint32_t>) == 3 * sizeof(void*));
+	COMPACT_VECTOR_ASSERT(tail_vector<uint8_t>::compact_capacity == 3 * sizeof(void*) - 1);
+	COMPACT_VECTOR_ASSERT(tail_vector<uint32_t>::compact_capacity == (3 * sizeof(void*) - 1) / 4);
+	COMPACT_VECTOR_ASSERT(tail_vector<std::string>::compact_capacity == 1);
+	COMPACT_VECTOR_ASSERT((tail_vector<uint8_t, 40>::compact_capacity == 40));
+}
+
+COMPACT_VECTOR_TEST(layout_tail_size_spill)
+{
+	const size_t capacity = tail_vector<uint8_t>::compact_capacity;
+
+	tail_vector<uint8_t> vector;
+	COMPACT_VECTOR_ASSERT(vector.empty());
+
+	for (size_t i = 0; i < capacity; i++)
+		vector.push_back(static_cast<uint8_t>(i));
+	COMPACT_VECTOR_ASSERT(vector.size() == capacity);
+	COMPACT_VECTOR_ASSERT(vector.capacity() == capacity);
+	// последний байт - счетчик свободного места, у заполненного вектора он нулевой
+	COMPACT_VECTOR_ASSERT(reinterpret_cast<const uint8_t*>(&vector)[sizeof(vector) - 1] == 0);
+
+	vector.push_back(200);
+	COMPACT_VECTOR_ASSERT(vector.size() == capacity + 1);
+	COMPACT_VECTOR_ASSERT(vector.capacity() == 2 * capacity);
+	for (size_t i = 0; i < capacity; i++)
+		COMPACT_VECTOR_ASSERT(vector[i] == i);
+	COMPACT_VECTOR_ASSERT(vector.back() == 200);
+
+	vector.resize(3);
+	vector.shrink_to_fit();
+	COMPACT_VECTOR_ASSERT(vector.capacity() == capacity);
+	COMPACT_VECTOR_ASSERT(vector.size() == 3);
+	COMPACT_VECTOR_ASSERT(vector[2] == 2);
+}
+
+COMPACT_VECTOR_TEST(layout_tail_size_strings)
+{
+	tail_vector<std::string, 3> vector;
+	for (int i = 0; i < 10; i++)
+		vector.push_back(std::to_string(i));
+	vector.erase(vector.begin() + 1);
+
+	tail_vector<std::string, 3> other;
+	other.push_back("x");
+
+	vector.swap(other);
+	COMPACT_VECTOR_ASSERT(vector.size() == 1);
+	COMPACT_VECTOR_ASSERT(vector[0] == "x");
+	COMPACT_VECTOR_ASSERT(other.size() == 9);
+	COMPACT_VECTOR_ASSERT(other[0] == "0");
+	COMPACT_VECTOR_ASSERT(other[1] == "2");
+
+	tail_vector<std::string, 3> moved(std::move(other));
+	COMPACT_VECTOR_ASSERT(moved.size() == 9);
+	COMPACT_VECTOR_ASSERT(moved[8] == "9");
+}
+
+template <class T, template <class, int, class, class> class layout = compact_vector_layout::standard>
+using small_vector32 = compact_vector<T, -1, std::allocator<T>, compact_vector_growth::doubling, layout, uint32_t>;
+
+COMPACT_VECTOR_TEST(layout_size_type_32)
+{
+	COMPACT_VECTOR_ASSERT(sizeof(small_vector32<uint8_t>) == sizeof(void*) + 2 * sizeof(uint32_t));
+	COMPACT_VECTOR_ASSERT(small_vector32<uint8_t>::compact_capacity == sizeof(void*) + sizeof(uint32_t));
+	COMPACT_VECTOR_ASSERT(small_vector32<uint32_t>::compact_capacity == (sizeof(void*) + sizeof(uint32_t)) / 4);
+	COMPACT_VECTOR_ASSERT(small_vector32<uint8_t>::vector_max_size == 0x7fffffff);
+
+	COMPACT_VECTOR_ASSERT((sizeof(small_vector32<uint8_t, compact_vector_layout::tail_size>) == sizeof(void*) + 2 * sizeof(uint32_t)));
+	COMPACT_VECTOR_ASSERT((small_vector32<uint8_t, compact_vector_layout::tail_size>::compact_capacity == sizeof(void*) + 2 * sizeof(uint32_t) - 1));
+}
+
+COMPACT_VECTOR_TEST(layout_tail_size_fits)
+{
+	COMPACT_VECTOR_ASSERT((compact_vector_layout::tail_size_fits<uint32_t*, uint32_t>::value));
+	COMPACT_VECTOR_ASSERT((compact_vector_layout::tail_size_fits<uint32_t*, size_t>::value));
+	COMPACT_VECTOR_ASSERT((!compact_vector_layout::tail_size_fits<uint32_t*, uint8_t>::value));
+	COMPACT_VECTOR_ASSERT((compact_vector_layout::tail_size_fits<uint32_t*, uint16_t>::value == (sizeof(void*) <= 4)));
+
+	small_vector32<uint32_t, compact_vector_layout::tail_size> vector;
+	for (uint32_t i = 0; i < 100; i++)
+		vector.push_back(i);
+	COMPACT_VECTOR_ASSERT(vector.size() == 100);
+	for (uint32_t i = 0; i < 100; i++)
+		COMPACT_VECTOR_ASSERT(vector[i] == i);
+}
+
+COMPACT_VECTOR_TEST(layout_size_type_32_spill)
+{
+	small_vector32<uint32_t> vector;
+	for (uint32_t i = 0; i < 1000; i++)
+		vector.push_back(i);
+	COMPACT_VECTOR_ASSERT(vector.size() == 1000);
+	COMPACT_VECTOR_ASSERT(vector.capacity() >= 1000);
+	for (uint32_t i = 0; i < 1000; i++)
+		COMPACT_VECTOR_ASSERT(vector[i] == i);
+
+	small_vector32<std::string, compact_vector_layout::tail_size> strings;
+	for (int i = 0; i < 100; i++)
+		strings.push_back(std::to_string(i));
+	strings.resize(1);
+	strings.shrink_to_fit();
+	COMPACT_VECTOR_ASSERT(strings.size() == 1);
+	COMPACT_VECTOR_ASSERT(strings[0] == "0");
+}
+
+COMPACT_VECTOR_TEST(layout_size_type_32_max_size)
+{
+	small_vector32<uint8_t> vector;
+
+	bool thrown = false;
+	try
+	{
+		vector.reserve(size_t(1) << 31);
+	}
+	catch (std::length_error&)
+	{
+		thrown = true;
+	}
+	COMPACT_VECTOR_ASSERT(thrown);
+}
+
+template <class T, int compact_max_size = -1>
+using pointer_vector = compact_vector<T, compact_max_size, std::allocator<T>, compact_vector_growth::doubling, compact_vector_layout::data_pointer>;
+
+COMPACT_VECTOR_TEST(layout_data_pointer)
+{
+	COMPACT_VECTOR_ASSERT(sizeof(pointer_vector<uint8_t>) == 4 * sizeof(void*));
+	COMPACT_VECTOR_ASSERT(pointer_vector<uint8_t>::compact_capacity == 2 * sizeof(void*));
+
+	pointer_vector<uint32_t, 4> vector;
+	COMPACT_VECTOR_ASSERT(vector.data() == reinterpret_cast<const uint32_t*>(reinterpret_cast<const char*>(&vector) + 2 * sizeof(void*)));
+
+	for (uint32_t i = 0; i < 4; i++)
+		vector.push_back(i);
+	COMPACT_VECTOR_ASSERT(vector.capacity() == 4);
+
+	vector.push_back(4);
+	COMPACT_VECTOR_ASSERT(vector.capacity() == 8);
+	for (uint32_t i = 0; i < 5; i++)
+		COMPACT_VECTOR_ASSERT(vector[i] == i);
+
+	vector.resize(2);
+	vector.shrink_to_fit();
+	COMPACT_VECTOR_ASSERT(vector.capacity() == 4);
+	COMPACT_VECTOR_ASSERT(vector[1] == 1);
+}
+
+COMPACT_VECTOR_TEST(layout_data_pointer_move)
+{
+	pointer_vector<std::string, 2> a;
+	a.push_back("a");
+
+	// после перемещения указатель должен смотреть во встроенный буфер нового объекта
+	pointer_vector<std::string, 2> b(std::move(a));
+	COMPACT_VECTOR_ASSERT(b.size() == 1);
+	COMPACT_VECTOR_ASSERT(b[0] == "a");
+	COMPACT_VECTOR_ASSERT(a.size() == 0);
+
+	b.push_back("b");
+	pointer_vector<std::string, 2> c;
+	for (int i = 0; i < 5; i++)
+		c.push_back(std::to_string(i));
+
+	b.swap(c);
+	COMPACT_VECTOR_ASSERT(b.size() == 5);
+	COMPACT_VECTOR_ASSERT(c.size() == 2);
+	COMPACT_VECTOR_ASSERT(c[1] == "b");
+	COMPACT_VECTOR_ASSERT(b[4] == "4");
+
+	a = std::move(c);
+	COMPACT_VECTOR_ASSERT(a.size() == 2);
+	COMPACT_VECTOR_ASSERT(a[0] == "a");
+}
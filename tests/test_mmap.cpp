@@ -0,0 +1,240 @@
+#include "tests_runner.h"
+#include "../compact_vector.h"
+#include "../mmap_allocator.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+namespace
+{
+
+// std::allocator с указателем offset_ptr: проверяет, что контейнер хранит указатель аллокатора, а не T*
+template <class T>
+struct offset_allocator
+{
+	using value_type = T;
+	using pointer = offset_ptr<T>;
+
+	offset_allocator() noexcept
+	{}
+
+	template <class U>
+	offset_allocator(const offset_allocator<U>&) noexcept
+	{}
+
+	pointer allocate(size_t n)
+	{
+		return pointer(std::allocator<T>().allocate(n));
+	}
+
+	void deallocate(pointer p, size_t n) noexcept
+	{
+		std::allocator<T>().deallocate(p.get(), n);
+	}
+};
+
+template <class T, class U>
+bool operator== (const offset_allocator<T>&, const offset_allocator<U>&) noexcept
+{
+	return true;
+}
+
+template <class T, class U>
+bool operator!= (const offset_allocator<T>&, const offset_allocator<U>&) noexcept
+{
+	return false;
+}
+
+template <class vector_type>
+bool is_sequence(const vector_type& v, size_t n, uint32_t first)
+{
+	if (v.size() != n)
+		return false;
+	for (size_t i = 0; i < n; i++)
+		if (v[i] != first + i)
+			return false;
+	return true;
+}
+
+template <template <class, int, class, class> class layout>
+void check_fancy_pointer_layout()
+{
+	using vector_type = compact_vector<uint32_t, -1, offset_allocator<uint32_t>, compact_vector_growth::doubling, layout>;
+
+	vector_type a;
+	for (uint32_t i = 0; i < 100; i++)
+		a.push_back(i);
+	COMPACT_VECTOR_ASSERT(is_sequence(a, 100, 0));
+
+	vector_type b(a);
+	COMPACT_VECTOR_ASSERT(is_sequence(b, 100, 0) && b.data() != a.data());
+
+	vector_type c(std::move(a));
+	COMPACT_VECTOR_ASSERT(is_sequence(c, 100, 0) && a.empty());
+
+	vector_type small;
+	small.push_back(7);
+	small.swap(c);
+	COMPACT_VECTOR_ASSERT(is_sequence(small, 100, 0) && c.size() == 1 && c[0] == 7);
+
+	small.erase(small.begin(), small.begin() + 98);
+	small.shrink_to_fit();
+	COMPACT_VECTOR_ASSERT(is_sequence(small, 2, 98));
+}
+
+// временный файл в текущем каталоге, удаляется при выходе из теста
+struct temporary_path
+{
+	std::string path;
+
+	explicit temporary_path(const char* name) :
+		path(name)
+	{
+		std::remove(path.c_str());
+	}
+
+	~temporary_path()
+	{
+		std::remove(path.c_str());
+	}
+};
+
+}
+
+COMPACT_VECTOR_TEST(offset_ptr_basics)
+{
+	uint32_t values[4] = {1, 2, 3, 4};
+
+	offset_ptr<uint32_t> p(values);
+	offset_ptr<uint32_t> q(p);
+	COMPACT_VECTOR_ASSERT(p.get() == values && q.get() == values);
+	COMPACT_VECTOR_ASSERT(q[3] == 4 && *(q + 2) == 3 && (q + 3) - p == 3);
+
+	// копия в другом месте памяти хранит другое смещение, но указывает туда же
+	alignas(offset_ptr<uint32_t>) unsigned char buffer[sizeof(offset_ptr<uint32_t>)];
+	offset_ptr<uint32_t>* moved = new (buffer) offset_ptr<uint32_t>(p);
+	COMPACT_VECTOR_ASSERT(moved->get() == values && *moved == p);
+
+	offset_ptr<uint32_t> null;
+	COMPACT_VECTOR_ASSERT(!null && null.get() == nullptr && null == offset_ptr<uint32_t>(nullptr));
+
+	offset_ptr<const uint32_t> c(p);
+	COMPACT_VECTOR_ASSERT(c.get() == values);
+	COMPACT_VECTOR_ASSERT(std::pointer_traits<offset_ptr<uint32_t>>::pointer_to(values[1]).get() == values + 1);
+}
+
+COMPACT_VECTOR_TEST(fancy_pointer_layouts)
+{
+	COMPACT_VECTOR_ASSERT((std::is_same<compact_vector_layout::standard<uint32_t, -1, offset_allocator<uint32_t>, size_t>::pointer, offset_ptr<uint32_t>>::value));
+
+	check_fancy_pointer_layout<compact_vector_layout::standard>();
+	check_fancy_pointer_layout<compact_vector_layout::tail_size>();
+	check_fancy_pointer_layout<compact_vector_layout::data_pointer>();
+}
+
+#ifdef COMPACT_VECTOR_HAS_MMAP
+
+COMPACT_VECTOR_TEST(mmap_root_reopen)
+{
+	using inner_type = compact_vector<uint32_t, -1, mmap_allocator<uint32_t>>;
+	using outer_type = compact_vector<inner_type, 2, mmap_allocator<inner_type>>;
+
+	temporary_path file_path("compact_vector_test_mmap.bin");
+	{
+		mapped_file file = mapped_file::create(file_path.path.c_str(), 1 << 20);
+		outer_type& outer = file.construct_root<outer_type>(file.allocator<inner_type>());
+		for (uint32_t i = 0; i < 10; i++)
+		{
+			outer.emplace_back(file.allocator<uint32_t>());
+			for (uint32_t j = 0; j < i * 100; j++)
+				outer.back().push_back(i * 1000 + j);
+		}
+		COMPACT_VECTOR_ASSERT(file.region().used_bytes() > 45 * 100 * sizeof(uint32_t));
+
+		// второе отображение того же файла лежит по другому адресу и видит те же данные
+		const mapped_file view = mapped_file::open(file_path.path.c_str(), mapped_file::read_only);
+		const outer_type* copy = view.root<outer_type>();
+		COMPACT_VECTOR_ASSERT(copy != nullptr && copy != &outer);
+		COMPACT_VECTOR_ASSERT(copy->size() == 10 && copy->data() != outer.data());
+		for (uint32_t i = 0; i < 10; i++)
+		{
+			COMPACT_VECTOR_ASSERT(is_sequence((*copy)[i], i * 100, i * 1000));
+		}
+
+		COMPACT_VECTOR_ASSERT(view.root<inner_type>() == nullptr);
+		file.sync();
+	}
+
+	{
+		mapped_file file = mapped_file::open(file_path.path.c_str());
+		outer_type* outer = file.root<outer_type>();
+		COMPACT_VECTOR_ASSERT(outer != nullptr && outer->size() == 10);
+		COMPACT_VECTOR_ASSERT(is_sequence((*outer)[9], 900, 9000));
+
+		// после повторного открытия вектор продолжает расти в том же файле
+		for (uint32_t j = 900; j < 5000; j++)
+			(*outer)[9].push_back(9000 + j);
+		outer->emplace_back(size_t(3), 5u, file.allocator<uint32_t>());
+	}
+
+	{
+		const mapped_file file = mapped_file::open(file_path.path.c_str(), mapped_file::read_only);
+		const outer_type* outer = file.root<outer_type>();
+		COMPACT_VECTOR_ASSERT(outer->size() == 11 && (*outer)[10].size() == 3 && (*outer)[10][2] == 5);
+		COMPACT_VECTOR_ASSERT(is_sequence((*outer)[9], 5000, 9000));
+	}
+}
+
+COMPACT_VECTOR_TEST(mmap_errors)
+{
+	temporary_path file_path("compact_vector_test_mmap_errors.bin");
+
+	bool thrown = false;
+	try
+	{
+		mapped_file::open(file_path.path.c_str());
+	}
+	catch (const std::system_error&)
+	{
+		thrown = true;
+	}
+	COMPACT_VECTOR_ASSERT(thrown);
+
+	using vector_type = compact_vector<uint64_t, -1, mmap_allocator<uint64_t>>;
+	{
+		mapped_file file = mapped_file::create(file_path.path.c_str(), 4096);
+		vector_type& v = file.construct_root<vector_type>(file.allocator<uint64_t>());
+
+		// размер файла фиксирован: переполнение области - bad_alloc, вектор остается целым
+		thrown = false;
+		try
+		{
+			for (uint64_t i = 0; i < 10000; i++)
+				v.push_back(i);
+		}
+		catch (const std::bad_alloc&)
+		{
+			thrown = true;
+		}
+		COMPACT_VECTOR_ASSERT(thrown && !v.empty() && v.back() == v.size() - 1);
+	}
+
+	mapped_file view = mapped_file::open(file_path.path.c_str(), mapped_file::read_only);
+	thrown = false;
+	try
+	{
+		view.root<vector_type>();
+	}
+	catch (const std::logic_error&)
+	{
+		thrown = true;
+	}
+	COMPACT_VECTOR_ASSERT(thrown);
+}
+
+#endif // COMPACT_VECTOR_HAS_MMAP
@@ -0,0 +1,98 @@
+#include "tests_runner.h"
+#include "../compact_vector_pool.h"
+
+#include <random>
+#include <vector>
+
+COMPACT_VECTOR_TEST(pool_rows)
+{
+	compact_vector_pool<uint32_t> pool;
+	size_t a = pool.add_row();
+	size_t b = pool.add_row({7, 8, 9});
+	COMPACT_VECTOR_ASSERT(pool.size() == 2);
+	COMPACT_VECTOR_ASSERT(pool[a].empty());
+	COMPACT_VECTOR_ASSERT(pool[b].size() == 3 && pool[b][2] == 9);
+
+	for (uint32_t i = 0; i < 10; i++)
+		pool[a].push_back(i);
+	COMPACT_VECTOR_ASSERT(pool[a].size() == 10 && pool[a].back() == 9);
+	COMPACT_VECTOR_ASSERT(pool[b].size() == 3 && pool[b].front() == 7);
+
+	auto row = pool[a];
+	row.erase(row.begin() + 2, row.begin() + 5);
+	row.erase(row.begin());
+	COMPACT_VECTOR_ASSERT(row.size() == 6 && row[0] == 1 && row[1] == 5);
+	row.pop_back();
+	COMPACT_VECTOR_ASSERT(row.back() == 8);
+
+	const compact_vector_pool<uint32_t>& view = pool;
+	uint32_t sum = 0;
+	for (uint32_t v : view[b])
+		sum += v;
+	COMPACT_VECTOR_ASSERT(sum == 24);
+
+	bool thrown = false;
+	try
+	{
+		view.at(2);
+	}
+	catch (const std::out_of_range&)
+	{
+		thrown = true;
+	}
+	COMPACT_VECTOR_ASSERT(thrown);
+}
+
+COMPACT_VECTOR_TEST(pool_random_against_vectors)
+{
+	// случайные push_back и erase в строки сверяются с std::vector<std::vector>
+	const size_t rows = 200;
+	compact_vector_pool<uint32_t> pool(rows);
+	std::vector<std::vector<uint32_t>> expected(rows);
+	std::mt19937 random(5);
+
+	for (int step = 0; step < 20000; step++)
+	{
+		size_t r = random() % rows;
+		if (random() % 5 == 0 && !expected[r].empty())
+		{
+			size_t position = random() % expected[r].size();
+			expected[r].erase(expected[r].begin() + position);
+			pool[r].erase(pool[r].begin() + position);
+		}
+		else
+		{
+			uint32_t value = random();
+			expected[r].push_back(value);
+			pool[r].push_back(value);
+		}
+	}
+
+	// дыры от переноса строк не превышают половины буфера
+	COMPACT_VECTOR_ASSERT(pool.garbage() * 2 <= pool.buffer_size());
+
+	for (size_t r = 0; r < rows; r++)
+		COMPACT_VECTOR_ASSERT(std::vector<uint32_t>(pool[r].begin(), pool[r].end()) == expected[r]);
+
+	pool.shrink_to_fit();
+	COMPACT_VECTOR_ASSERT(pool.garbage() == 0);
+	COMPACT_VECTOR_ASSERT(pool.buffer_size() == pool.total_size());
+	for (size_t r = 0; r < rows; r++)
+		COMPACT_VECTOR_ASSERT(std::vector<uint32_t>(pool[r].begin(), pool[r].end()) == expected[r]);
+
+	// после уплотнения строки лежат подряд в порядке номеров
+	const compact_vector_pool<uint32_t>& view = pool;
+	for (size_t r = 1; r < rows; r++)
+		COMPACT_VECTOR_ASSERT(view[r].data() == view[r - 1].data() + view[r - 1].size());
+}
+
+COMPACT_VECTOR_TEST(pool_push_back_aliasing)
+{
+	compact_vector_pool<uint64_t> pool;
+	size_t a = pool.add_row({1, 2, 3, 4});
+	size_t b = pool.add_row({5});
+	// строка a не последняя и переедет, а значение берется из нее самой
+	pool[a].push_back(pool[a][0]);
+	COMPACT_VECTOR_ASSERT(pool[a].size() == 5 && pool[a][4] == 1);
+	COMPACT_VECTOR_ASSERT(pool[b][0] == 5);
+}
@@ -0,0 +1,172 @@
+#include "tests_runner.h"
+#include "../compact_vector.h"
+#include "../realloc_allocator.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+namespace
+{
+
+// тип, который считает вызовы перемещающего конструктора
+struct relocatable_counter
+{
+	static int moves;
+
+	int value = 0;
+
+	relocatable_counter(int value = 0) :
+		value(value)
+	{}
+
+	relocatable_counter(relocatable_counter&& x) :
+		value(x.value)
+	{
+		moves++;
+	}
+
+	relocatable_counter& operator= (relocatable_counter&& x)
+	{
+		value = x.value;
+		return *this;
+	}
+
+	~relocatable_counter()
+	{}
+};
+
+int relocatable_counter::moves = 0;
+
+}
+
+namespace compact_vector_traits
+{
+	template <>
+	struct is_trivially_relocatable<relocatable_counter> : std::true_type
+	{};
+}
+
+COMPACT_VECTOR_TEST(relocation_trait_defaults)
+{
+	COMPACT_VECTOR_ASSERT(compact_vector_traits::is_trivially_relocatable<uint32_t>::value);
+	COMPACT_VECTOR_ASSERT(compact_vector_traits::is_trivially_relocatable<std::unique_ptr<int>>::value);
+	COMPACT_VECTOR_ASSERT(!compact_vector_traits::is_trivially_relocatable<std::string>::value);
+	COMPACT_VECTOR_ASSERT(compact_vector_traits::has_reallocate<realloc_allocator<int>>::value);
+	COMPACT_VECTOR_ASSERT(!compact_vector_traits::has_reallocate<std::allocator<int>>::value);
+}
+
+COMPACT_VECTOR_TEST(relocation_without_moves)
+{
+	relocatable_counter::moves = 0;
+
+	compact_vector<relocatable_counter, 2> vector;
+	for (int i = 0; i < 100; i++)
+		vector.emplace_back(i);
+	vector.shrink_to_fit();
+
+	COMPACT_VECTOR_ASSERT(relocatable_counter::moves == 0);
+	for (int i = 0; i < 100; i++)
+		COMPACT_VECTOR_ASSERT(vector[i].value == i);
+}
+
+COMPACT_VECTOR_TEST(relocation_unique_ptr_realloc)
+{
+	compact_vector<std::unique_ptr<int>, 2, realloc_allocator<std::unique_ptr<int>>> vector;
+	for (int i = 0; i < 1000; i++)
+		vector.push_back(std::unique_ptr<int>(new int(i)));
+
+	for (int i = 0; i < 1000; i++)
+		COMPACT_VECTOR_ASSERT(*vector[i] == i);
+
+	vector.resize(10);
+	vector.shrink_to_fit();
+	COMPACT_VECTOR_ASSERT(vector.capacity() == 10);
+	for (int i = 0; i < 10; i++)
+		COMPACT_VECTOR_ASSERT(*vector[i] == i);
+
+	vector.resize(1);
+	vector.shrink_to_fit();
+	COMPACT_VECTOR_ASSERT(vector.capacity() == 2);
+	COMPACT_VECTOR_ASSERT(*vector[0] == 0);
+}
+
+COMPACT_VECTOR_TEST(relocation_string_realloc_fallback)
+{
+	compact_vector<std::string, 2, realloc_allocator<std::string>> vector;
+	for (int i = 0; i < 100; i++)
+		vector.push_back(std::to_string(i));
+
+	for (int i = 0; i < 100; i++)
+		COMPACT_VECTOR_ASSERT(vector[i] == std::to_string(i));
+}
+
+COMPACT_VECTOR_TEST(relocation_move_steals_buffer)
+{
+	// куча: забираются указатель, емкость и размер, x остается пустым во встроенном буфере
+	compact_vector<uint32_t, 4> heap;
+	for (uint32_t i = 0; i < 10; i++)
+		heap.push_back(i);
+	const uint32_t* block = heap.data();
+	size_t capacity = heap.capacity();
+
+	compact_vector<uint32_t, 4> taken(std::move(heap));
+	COMPACT_VECTOR_ASSERT(taken.data() == block && taken.capacity() == capacity && taken.size() == 10);
+	COMPACT_VECTOR_ASSERT(heap.empty() && heap.capacity() == 4);
+
+	// встроенный буфер переносится без вызова перемещающих конструкторов
+	relocatable_counter::moves = 0;
+	compact_vector<relocatable_counter, 4> compact;
+	compact.emplace_back(1);
+	compact.emplace_back(2);
+	compact_vector<relocatable_counter, 4> moved(std::move(compact));
+	COMPACT_VECTOR_ASSERT(relocatable_counter::moves == 0 && compact.empty());
+	COMPACT_VECTOR_ASSERT(moved.size() == 2 && moved[0].value == 1 && moved[1].value == 2);
+
+	compact.emplace_back(3);
+	moved = std::move(compact);
+	COMPACT_VECTOR_ASSERT(relocatable_counter::moves == 0 && moved.size() == 1 && moved[0].value == 3);
+
+	COMPACT_VECTOR_ASSERT((std::is_nothrow_move_constructible<compact_vector<uint32_t>>::value));
+	COMPACT_VECTOR_ASSERT((std::is_nothrow_move_constructible<compact_vector<std::string, 2>>::value));
+}
+
+COMPACT_VECTOR_TEST(relocation_move_and_swap_strings)
+{
+	auto make = [](size_t n, const char* prefix)
+	{
+		compact_vector<std::string, 2> v;
+		for (size_t i = 0; i < n; i++)
+			v.push_back(prefix + std::to_string(i));
+		return v;
+	};
+	auto check = [](const compact_vector<std::string, 2>& v, size_t n, const char* prefix)
+	{
+		if (v.size() != n)
+			return false;
+		for (size_t i = 0; i < n; i++)
+			if (v[i] != prefix + std::to_string(i))
+				return false;
+		return true;
+	};
+
+	// все сочетания встроенного буфера и кучи
+	const size_t sizes[] = { 0, 1, 2, 3, 7 };
+	for (size_t a : sizes)
+	{
+		for (size_t b : sizes)
+		{
+			compact_vector<std::string, 2> x = make(a, "x");
+			compact_vector<std::string, 2> y = make(b, "y");
+			x.swap(y);
+			COMPACT_VECTOR_ASSERT(check(x, b, "y") && check(y, a, "x"));
+
+			y = std::move(x);
+			COMPACT_VECTOR_ASSERT(check(y, b, "y") && x.empty() && x.capacity() == 2);
+
+			compact_vector<std::string, 2> z(std::move(y));
+			COMPACT_VECTOR_ASSERT(check(z, b, "y") && y.empty() && y.capacity() == 2);
+		}
+	}
+}
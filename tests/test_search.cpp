@@ -0,0 +1,127 @@
+#include "tests_runner.h"
+#include "../compact_vector.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+// find/count/min/max сравниваются с алгоритмами std для всех размеров до n:
+// встроенный буфер, векторная часть и хвост ядер
+template <class T, int compact_max_size = 8>
+bool search_matches_std(size_t n)
+{
+	std::mt19937 random(5);
+	for (size_t size = 0; size < n; size++)
+	{
+		compact_vector<T, compact_max_size> a;
+		std::vector<T> b;
+		for (size_t i = 0; i < size; i++)
+		{
+			T x = static_cast<T>(static_cast<int>(random() % 7) - 3);
+			a.push_back(x);
+			b.push_back(x);
+		}
+
+		for (int k = -4; k <= 4; k++)
+		{
+			T value = static_cast<T>(k);
+			if (a.index_of(value) != size_t(std::find(b.begin(), b.end(), value) - b.begin()))
+				return false;
+			if (a.count(value) != size_t(std::count(b.begin(), b.end(), value)))
+				return false;
+			if (a.contains(value) != (std::find(b.begin(), b.end(), value) != b.end()))
+				return false;
+		}
+
+		if (size > 0)
+		{
+			if (&a.min() != &a[std::min_element(b.begin(), b.end()) - b.begin()])
+				return false;
+			if (&a.max() != &a[std::max_element(b.begin(), b.end()) - b.begin()])
+				return false;
+		}
+	}
+	return true;
+}
+
+}
+
+COMPACT_VECTOR_TEST(search_integral)
+{
+	COMPACT_VECTOR_ASSERT(search_matches_std<int8_t>(80));
+	COMPACT_VECTOR_ASSERT(search_matches_std<uint16_t>(80));
+	COMPACT_VECTOR_ASSERT(search_matches_std<int32_t>(80));
+	COMPACT_VECTOR_ASSERT(search_matches_std<uint32_t>(80));
+	COMPACT_VECTOR_ASSERT(search_matches_std<int64_t>(80));
+	COMPACT_VECTOR_ASSERT(search_matches_std<uint64_t>(80));
+
+	// встроенные буферы, которые не кратны ширине регистра
+	COMPACT_VECTOR_ASSERT((search_matches_std<uint32_t, 3>(20)));
+	COMPACT_VECTOR_ASSERT((search_matches_std<uint16_t, 13>(20)));
+	COMPACT_VECTOR_ASSERT((search_matches_std<uint8_t, 50>(60)));
+}
+
+COMPACT_VECTOR_TEST(search_floating_point)
+{
+	COMPACT_VECTOR_ASSERT(search_matches_std<float>(40));
+	COMPACT_VECTOR_ASSERT(search_matches_std<double>(40));
+
+	compact_vector<double, 2> vector = { 1.0, -0.0, 2.0 };
+	COMPACT_VECTOR_ASSERT(vector.index_of(0.0) == 1);
+}
+
+COMPACT_VECTOR_TEST(search_strings)
+{
+	compact_vector<std::string, 2> vector = { "b", "a", "c", "a" };
+	COMPACT_VECTOR_ASSERT(vector.find("a") == vector.begin() + 1);
+	COMPACT_VECTOR_ASSERT(vector.find("d") == vector.end());
+	COMPACT_VECTOR_ASSERT(vector.count("a") == 2);
+	COMPACT_VECTOR_ASSERT(vector.min() == "a");
+	COMPACT_VECTOR_ASSERT(vector.max() == "c");
+}
+
+COMPACT_VECTOR_TEST(search_kernels)
+{
+	// каждое ядро, которое поддерживает процессор, сверяется со скалярным
+#if defined(COMPACT_VECTOR_SIMD_X86)
+	namespace simd = compact_vector_simd;
+	namespace detail = compact_vector_simd::detail;
+
+	std::mt19937 random(13);
+	for (size_t n = 1; n < 70; n++)
+	{
+		std::vector<int64_t> a(n);
+		std::vector<uint32_t> b(n);
+		for (size_t i = 0; i < n; i++)
+		{
+			a[i] = static_cast<int64_t>(random() % 9) - 4;
+			b[i] = random() % 9 + (i % 2 ? 0x80000000u : 0);
+		}
+
+		size_t find_a = detail::find_equal_scalar<int64_t>(a.data(), n, -2);
+		size_t count_b = detail::count_equal_scalar<uint32_t>(b.data(), n, 3);
+		size_t min_a = detail::extremum_scalar(a.data(), n, detail::less_than<int64_t>());
+		size_t max_b = detail::extremum_scalar(b.data(), n, detail::greater_than<uint32_t>());
+
+		if (simd::detected_isa() != simd::isa::scalar)
+		{
+			COMPACT_VECTOR_ASSERT(detail::find_equal_sse42<int64_t>(a.data(), n, -2) == find_a);
+			COMPACT_VECTOR_ASSERT(detail::count_equal_sse42<uint32_t>(b.data(), n, 3) == count_b);
+			COMPACT_VECTOR_ASSERT((detail::extremum_sse42<int64_t, false>(a.data(), n)) == min_a);
+			COMPACT_VECTOR_ASSERT((detail::extremum_sse42<uint32_t, true>(b.data(), n)) == max_b);
+		}
+		if (simd::detected_isa() == simd::isa::avx2)
+		{
+			COMPACT_VECTOR_ASSERT(detail::find_equal_avx2<int64_t>(a.data(), n, -2) == find_a);
+			COMPACT_VECTOR_ASSERT(detail::count_equal_avx2<uint32_t>(b.data(), n, 3) == count_b);
+			COMPACT_VECTOR_ASSERT((detail::extremum_avx2<int64_t, false>(a.data(), n)) == min_a);
+			COMPACT_VECTOR_ASSERT((detail::extremum_avx2<uint32_t, true>(b.data(), n)) == max_b);
+		}
+	}
+#endif
+}
@@ -0,0 +1,247 @@
+#include "tests_runner.h"
+#include "../compact_vector_serialization.h"
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+using record = compact_vector<uint32_t>;
+
+template <class Vector, class Range>
+bool same_values(const Vector& v, const Range& expected)
+{
+	if (v.size() != expected.size())
+		return false;
+	for (size_t i = 0; i < v.size(); i++)
+		if (v[i] != expected[i])
+			return false;
+	return true;
+}
+
+struct alignas(32) wide_element
+{
+	uint32_t values[8];
+};
+
+record make_record(size_t n, uint32_t first)
+{
+	record v;
+	for (size_t i = 0; i < n; i++)
+		v.push_back(first + static_cast<uint32_t>(i) * 3);
+	return v;
+}
+
+}
+
+COMPACT_VECTOR_TEST(serialization_varint)
+{
+	using namespace compact_vector_serialization;
+
+	COMPACT_VECTOR_ASSERT(varint_size(0) == 1 && varint_size(127) == 1 && varint_size(128) == 2);
+	COMPACT_VECTOR_ASSERT(varint_size(UINT64_MAX) == 10);
+
+	const uint64_t values[] = {0, 1, 127, 128, 300, 1ull << 35, UINT64_MAX};
+	for (uint64_t value : values)
+	{
+		COMPACT_VECTOR_ASSERT(unzigzag(zigzag(value)) == value);
+	}
+	COMPACT_VECTOR_ASSERT(zigzag(uint64_t(-1)) == 1 && zigzag(1) == 2);
+
+	// варинт, дополненный байтами продолжения, читается так же, как канонический
+	std::vector<unsigned char> buffer(4 + sizeof(uint32_t));
+	unsigned char* p = put_varint(buffer.data(), 1, 4);
+	COMPACT_VECTOR_ASSERT(buffer[0] == 0x81 && buffer[1] == 0x80 && buffer[3] == 0x00);
+	uint32_t value = 42;
+	std::memcpy(p, &value, sizeof(value));
+
+	compact_vector_reader reader(buffer.data(), buffer.size());
+	record v;
+	reader.read(v);
+	COMPACT_VECTOR_ASSERT(v.size() == 1 && v[0] == 42 && reader.at_end());
+}
+
+COMPACT_VECTOR_TEST(serialization_raw_round_trip)
+{
+	std::vector<unsigned char> buffer;
+	compact_vector_writer<std::vector<unsigned char>> writer(buffer);
+
+	const size_t sizes[] = {0, 1, record::compact_capacity, record::compact_capacity + 1, 1000};
+	for (size_t n : sizes)
+		writer.write(make_record(n, static_cast<uint32_t>(n)));
+
+	compact_vector_reader reader(buffer.data(), buffer.size());
+	for (size_t n : sizes)
+	{
+		record v;
+		reader.read(v);
+		COMPACT_VECTOR_ASSERT(same_values(v, make_record(n, static_cast<uint32_t>(n))));
+		// запись, помещающаяся во встроенный буфер, не выделяет память
+		COMPACT_VECTOR_ASSERT((v.capacity() == record::compact_capacity) == (n <= record::compact_capacity));
+	}
+	COMPACT_VECTOR_ASSERT(reader.at_end() && reader.position() == buffer.size());
+}
+
+COMPACT_VECTOR_TEST(serialization_batch_and_views)
+{
+	std::vector<record> records;
+	for (size_t i = 0; i < 50; i++)
+		records.push_back(make_record(i % 9, static_cast<uint32_t>(i)));
+
+	std::string buffer("x");
+	compact_vector_writer<std::string> writer(buffer);
+	writer.write(records.begin(), records.end());
+
+	std::vector<unsigned char> one_by_one(1, 'x');
+	compact_vector_writer<std::vector<unsigned char>> single(one_by_one);
+	for (const record& r : records)
+		single.write(r);
+	COMPACT_VECTOR_ASSERT(buffer.size() == one_by_one.size());
+	COMPACT_VECTOR_ASSERT(std::memcmp(buffer.data(), one_by_one.data(), buffer.size()) == 0);
+
+	// представления указывают прямо в буфер, данные выровнены по uint32_t
+	compact_vector_reader reader(one_by_one.data() + 1, one_by_one.size() - 1);
+	for (const record& r : records)
+	{
+		compact_vector_view<uint32_t> view = reader.read_view<uint32_t>();
+		COMPACT_VECTOR_ASSERT(same_values(view, r));
+		if (!view.empty())
+		{
+			COMPACT_VECTOR_ASSERT(reinterpret_cast<const unsigned char*>(view.data()) > one_by_one.data());
+			COMPACT_VECTOR_ASSERT(reinterpret_cast<const unsigned char*>(view.end()) <= one_by_one.data() + one_by_one.size());
+		}
+	}
+	COMPACT_VECTOR_ASSERT(reader.at_end());
+
+	compact_vector_view<uint32_t> whole(records[8]);
+	COMPACT_VECTOR_ASSERT(whole.data() == records[8].data() && whole.size() == 8 && whole.back() == 8 + 7 * 3);
+}
+
+COMPACT_VECTOR_TEST(serialization_unaligned_view)
+{
+	std::vector<unsigned char> buffer;
+	compact_vector_writer<std::vector<unsigned char>> writer(buffer);
+	writer.write(make_record(3, 1));
+
+	// тот же поток со сдвигом на байт: представление невозможно, копирование работает
+	std::vector<unsigned char> shifted(buffer.size() + 1);
+	std::memcpy(shifted.data() + 1, buffer.data(), buffer.size());
+	compact_vector_reader reader(shifted.data() + 1, buffer.size());
+
+	bool thrown = false;
+	try
+	{
+		reader.read_view<uint32_t>();
+	}
+	catch (const std::invalid_argument&)
+	{
+		thrown = true;
+	}
+	COMPACT_VECTOR_ASSERT(thrown && reader.position() == 0);
+
+	record v;
+	reader.read(v);
+	COMPACT_VECTOR_ASSERT(same_values(v, make_record(3, 1)) && reader.at_end());
+}
+
+COMPACT_VECTOR_TEST(serialization_over_aligned)
+{
+	compact_vector<wide_element, 2> source;
+	for (uint32_t i = 0; i < 200; i++)
+	{
+		wide_element e = {};
+		e.values[0] = i;
+		e.values[7] = i * 7;
+		source.push_back(e);
+	}
+
+	// смещение 31 и двухбайтовая длина требуют 31 байт выравнивания: заголовок длиной 33 байта
+	std::vector<unsigned char> buffer(31);
+	compact_vector_writer<std::vector<unsigned char>> writer(buffer);
+	writer.write(source);
+	COMPACT_VECTOR_ASSERT(buffer.size() == 31 + 33 + 200 * sizeof(wide_element));
+
+	compact_vector_reader reader(buffer.data() + 31, buffer.size() - 31);
+	compact_vector<wide_element, 2> v;
+	reader.read(v);
+	COMPACT_VECTOR_ASSERT(v.size() == 200 && reader.at_end());
+	for (uint32_t i = 0; i < 200; i++)
+		COMPACT_VECTOR_ASSERT(v[i].values[0] == i && v[i].values[7] == i * 7);
+}
+
+COMPACT_VECTOR_TEST(serialization_delta)
+{
+	std::vector<unsigned char> buffer;
+	compact_vector_writer<std::vector<unsigned char>> writer(buffer);
+
+	record sorted;
+	for (uint32_t i = 0; i < 1000; i++)
+		sorted.push_back(1000000 + i * 5);
+	writer.write_delta(sorted);
+	// первое значение - 3 байта, остальные разности по байту
+	COMPACT_VECTOR_ASSERT(buffer.size() == 2 + 3 + 999);
+
+	compact_vector<int64_t> mixed = {5, -3, INT64_MAX, INT64_MIN, 0, -1};
+	writer.write_delta(mixed);
+
+	compact_vector<uint64_t> wide = {UINT64_MAX, 0, UINT64_MAX};
+	writer.write_delta(wide);
+
+	compact_vector_reader reader(buffer.data(), buffer.size());
+	record sorted_copy;
+	reader.read_delta(sorted_copy);
+	COMPACT_VECTOR_ASSERT(same_values(sorted_copy, sorted));
+
+	compact_vector<int64_t> mixed_copy;
+	reader.read_delta(mixed_copy);
+	COMPACT_VECTOR_ASSERT(same_values(mixed_copy, mixed));
+
+	compact_vector<uint64_t> wide_copy;
+	reader.read_delta(wide_copy);
+	COMPACT_VECTOR_ASSERT(same_values(wide_copy, wide) && reader.at_end());
+}
+
+COMPACT_VECTOR_TEST(serialization_truncated)
+{
+	std::vector<unsigned char> buffer;
+	compact_vector_writer<std::vector<unsigned char>> writer(buffer);
+	writer.write(make_record(10, 0));
+	size_t raw_size = buffer.size();
+	writer.write_delta(make_record(10, 0));
+
+	// любая обрезанная запись отвергается, позиция чтения не меняется
+	for (size_t cut = 0; cut < buffer.size(); cut++)
+	{
+		compact_vector_reader reader(buffer.data(), cut);
+		bool thrown = false;
+		record v;
+		try
+		{
+			reader.read(v);
+			reader.read_delta(v);
+		}
+		catch (const std::out_of_range&)
+		{
+			thrown = true;
+		}
+		COMPACT_VECTOR_ASSERT(thrown && reader.position() == (cut < raw_size ? 0 : raw_size));
+	}
+
+	// длина varint без завершающего байта
+	const unsigned char endless[] = {0xff, 0xff, 0xff};
+	compact_vector_reader reader(endless, sizeof(endless));
+	bool thrown = false;
+	try
+	{
+		record v;
+		reader.read_delta(v);
+	}
+	catch (const std::out_of_range&)
+	{
+		thrown = true;
+	}
+	COMPACT_VECTOR_ASSERT(thrown);
+}
@@ -0,0 +1,153 @@
+#include "tests_runner.h"
+#include "../shared_compact_vector.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+// считает живые объекты, чтобы проверить, что общие блоки разрушаются ровно один раз
+struct counted
+{
+	static std::atomic<int> live;
+
+	int value;
+
+	counted(int v = 0) : value(v) { live++; }
+	counted(const counted& x) : value(x.value) { live++; }
+	~counted() { live--; }
+
+	counted& operator= (const counted&) = default;
+
+	bool operator== (const counted& x) const { return value == x.value; }
+};
+
+std::atomic<int> counted::live{0};
+
+}
+
+COMPACT_VECTOR_TEST(shared_copy_shares_heap)
+{
+	using vector = shared_compact_vector<int>;
+	COMPACT_VECTOR_ASSERT(sizeof(vector) == 24);
+
+	vector a;
+	for (int i = 0; i < 100; i++)
+		a.push_back(i);
+	COMPACT_VECTOR_ASSERT(a.use_count() == 1);
+
+	vector b(a);
+	const vector& ca = a;
+	const vector& cb = b;
+	COMPACT_VECTOR_ASSERT(ca.data() == cb.data());
+	COMPACT_VECTOR_ASSERT(a.use_count() == 2 && b.use_count() == 2);
+	COMPACT_VECTOR_ASSERT(a == b);
+
+	// первая изменяющая операция копирует блок, оригинал не меняется
+	b[5] = -5;
+	COMPACT_VECTOR_ASSERT(ca.data() != cb.data());
+	COMPACT_VECTOR_ASSERT(a.use_count() == 1 && b.use_count() == 1);
+	COMPACT_VECTOR_ASSERT(ca[5] == 5 && cb[5] == -5);
+	COMPACT_VECTOR_ASSERT(a != b);
+
+	vector c;
+	c = a;
+	c.push_back(100);
+	COMPACT_VECTOR_ASSERT(a.size() == 100 && c.size() == 101 && c.back() == 100);
+
+	vector d(a);
+	d.erase(d.begin(), d.begin() + 10);
+	COMPACT_VECTOR_ASSERT(a.size() == 100 && ca[0] == 0 && d.size() == 90 && d[0] == 10);
+
+	// изменение единственного владельца не копирует блок
+	const int* before = ca.data();
+	a[0] = 42;
+	COMPACT_VECTOR_ASSERT(ca.data() == before);
+}
+
+COMPACT_VECTOR_TEST(shared_inline_copied_by_value)
+{
+	using vector = shared_compact_vector<int, 4>;
+
+	vector a{1, 2, 3};
+	COMPACT_VECTOR_ASSERT(a.capacity() == 4 && a.use_count() == 0);
+
+	vector b(a);
+	b[0] = 10;
+	COMPACT_VECTOR_ASSERT(a[0] == 1 && b[0] == 10 && b.use_count() == 0);
+
+	// переход из встроенного буфера в кучу и обратно через clear
+	b.push_back(4);
+	b.push_back(5);
+	COMPACT_VECTOR_ASSERT(b.use_count() == 1 && b.size() == 5 && b[4] == 5);
+
+	vector c(b);
+	c.clear();
+	COMPACT_VECTOR_ASSERT(c.empty() && c.use_count() == 0 && b.use_count() == 1 && b.size() == 5);
+
+	// push_back своего элемента при переезде в новый блок
+	vector d(b);
+	d.push_back(d[0]);
+	COMPACT_VECTOR_ASSERT(d.size() == 6 && d[5] == 10 && b.size() == 5);
+
+	vector e(std::move(d));
+	COMPACT_VECTOR_ASSERT(d.empty() && e.size() == 6);
+	swap(a, e);
+	COMPACT_VECTOR_ASSERT(a.size() == 6 && e.size() == 3 && e[2] == 3);
+}
+
+COMPACT_VECTOR_TEST(shared_strings)
+{
+	shared_compact_vector<std::string> a(20, std::string(40, 'x'));
+	shared_compact_vector<std::string> b(a);
+	b.insert(b.begin() + 1, "y");
+	b.resize(10);
+	b.pop_back();
+	COMPACT_VECTOR_ASSERT(a.size() == 20 && a[1] == std::string(40, 'x'));
+	COMPACT_VECTOR_ASSERT(b.size() == 9 && b[1] == "y" && b[2] == a[2]);
+
+	bool thrown = false;
+	try
+	{
+		b.at(9);
+	}
+	catch (const std::out_of_range&)
+	{
+		thrown = true;
+	}
+	COMPACT_VECTOR_ASSERT(thrown);
+}
+
+COMPACT_VECTOR_TEST(shared_concurrent_copies)
+{
+	{
+		shared_compact_vector<counted> snapshot(1000, counted(7));
+		COMPACT_VECTOR_ASSERT(counted::live == 1000);
+
+		// каждый поток копирует снимок и меняет свои копии; блок снимка остается общим и целым
+		std::vector<std::thread> threads;
+		for (int t = 0; t < 4; t++)
+			threads.emplace_back([&snapshot, t]
+			{
+				for (int i = 0; i < 200; i++)
+				{
+					shared_compact_vector<counted> copy(snapshot);
+					if (i % 10 == 0)
+						copy[0] = counted(t);
+					shared_compact_vector<counted> other;
+					other = copy;
+				}
+			});
+		for (std::thread& thread : threads)
+			thread.join();
+
+		COMPACT_VECTOR_ASSERT(snapshot.use_count() == 1);
+		const shared_compact_vector<counted>& s = snapshot;
+		COMPACT_VECTOR_ASSERT(s[0].value == 7);
+		COMPACT_VECTOR_ASSERT(counted::live == 1000);
+	}
+	COMPACT_VECTOR_ASSERT(counted::live == 0);
+}
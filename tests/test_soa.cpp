@@ -0,0 +1,152 @@
+#include "tests_runner.h"
+#include "../compact_soa_vector.h"
+
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+
+using rows = basic_compact_soa_vector<4, std::allocator<unsigned char>, uint32_t, float, uint8_t>;
+
+bool aligned(const void* p, size_t alignment)
+{
+	return reinterpret_cast<uintptr_t>(p) % alignment == 0;
+}
+
+}
+
+COMPACT_VECTOR_TEST(soa_layout)
+{
+	// 16 байт по умолчанию: две строки uint32_t + uint16_t, одна строка uint64_t + uint8_t
+	COMPACT_VECTOR_ASSERT((compact_soa_vector<uint32_t, uint16_t>::compact_capacity == 2));
+	COMPACT_VECTOR_ASSERT((compact_soa_vector<uint64_t, uint8_t>::compact_capacity == 1));
+	COMPACT_VECTOR_ASSERT((compact_soa_vector<uint8_t>::compact_capacity == 16));
+	COMPACT_VECTOR_ASSERT((sizeof(compact_soa_vector<uint32_t, uint16_t>) == 24));
+
+	rows v;
+	COMPACT_VECTOR_ASSERT(rows::compact_capacity == 4 && v.capacity() == 4);
+	for (uint32_t i = 0; i < 4; i++)
+		v.push_back(i, i * 0.5f, static_cast<uint8_t>(i));
+	COMPACT_VECTOR_ASSERT(v.is_compact());
+	COMPACT_VECTOR_ASSERT(reinterpret_cast<const unsigned char*>(v.column_data<0>()) >= reinterpret_cast<const unsigned char*>(&v));
+	COMPACT_VECTOR_ASSERT(reinterpret_cast<const unsigned char*>(v.column_data<2>() + 4) <= reinterpret_cast<const unsigned char*>(&v) + sizeof(v));
+
+	v.push_back(4, 2.0f, 4);
+	COMPACT_VECTOR_ASSERT(!v.is_compact() && v.capacity() == 8);
+	COMPACT_VECTOR_ASSERT(aligned(v.column_data<0>(), 4) && aligned(v.column_data<1>(), 4));
+	COMPACT_VECTOR_ASSERT(reinterpret_cast<const unsigned char*>(v.column_data<1>()) == reinterpret_cast<const unsigned char*>(v.column_data<0>() + 8));
+	for (uint32_t i = 0; i < 5; i++)
+		COMPACT_VECTOR_ASSERT(v[i] == std::make_tuple(i, i * 0.5f, static_cast<uint8_t>(i)));
+
+	v.pop_back();
+	v.shrink_to_fit();
+	COMPACT_VECTOR_ASSERT(v.is_compact() && v.size() == 4 && std::get<1>(v[3]) == 1.5f);
+}
+
+COMPACT_VECTOR_TEST(soa_columns_in_sync)
+{
+	rows v;
+	std::vector<std::tuple<uint32_t, float, uint8_t>> expected;
+	for (uint32_t i = 0; i < 40; i++)
+	{
+		v.push_back(i, static_cast<float>(i), static_cast<uint8_t>(i % 3));
+		expected.emplace_back(i, static_cast<float>(i), static_cast<uint8_t>(i % 3));
+	}
+
+	v.erase(v.begin() + 5, v.begin() + 15);
+	expected.erase(expected.begin() + 5, expected.begin() + 15);
+	v.erase(v.begin());
+	expected.erase(expected.begin());
+	v.insert(v.begin() + 2, 100, -1.0f, 7);
+	expected.insert(expected.begin() + 2, std::make_tuple(100u, -1.0f, uint8_t(7)));
+	v.push_back(v[0]);
+	expected.push_back(expected[0]);
+
+	COMPACT_VECTOR_ASSERT(v.size() == expected.size());
+	size_t i = 0;
+	for (auto row : v)
+		COMPACT_VECTOR_ASSERT(row == expected[i++]);
+
+	// изменение через строку видно в столбце
+	std::get<1>(v[3]) = 42.0f;
+	COMPACT_VECTOR_ASSERT(v.column<1>()[3] == 42.0f);
+
+	auto ids = v.column<0>();
+	uint64_t sum = std::accumulate(ids.begin(), ids.end(), uint64_t(0));
+	uint64_t expected_sum = 0;
+	for (const auto& row : expected)
+		expected_sum += std::get<0>(row);
+	COMPACT_VECTOR_ASSERT(ids.size() == v.size() && sum == expected_sum);
+
+	v.resize(50);
+	COMPACT_VECTOR_ASSERT(v.size() == 50 && v.column<2>()[49] == 0 && v.column<1>()[49] == 0.0f);
+	v.resize(2);
+	v.shrink_to_fit();
+	COMPACT_VECTOR_ASSERT(v.is_compact() && std::get<0>(v.at(1)) == std::get<0>(expected[1]));
+}
+
+COMPACT_VECTOR_TEST(soa_copy_move_swap)
+{
+	rows small;
+	small.push_back(1, 1.0f, 1);
+	rows large;
+	for (uint32_t i = 0; i < 20; i++)
+		large.push_back(i, 0.0f, 0);
+
+	rows copy(large);
+	COMPACT_VECTOR_ASSERT(copy == large && copy.column_data<0>() != large.column_data<0>());
+
+	const uint32_t* block = large.column_data<0>();
+	rows moved(std::move(large));
+	COMPACT_VECTOR_ASSERT(moved.column_data<0>() == block && large.empty() && large.is_compact());
+
+	small.swap(moved);
+	COMPACT_VECTOR_ASSERT(small.size() == 20 && small.column_data<0>() == block);
+	COMPACT_VECTOR_ASSERT(moved.size() == 1 && moved.is_compact() && std::get<0>(moved[0]) == 1);
+
+	moved = small;
+	COMPACT_VECTOR_ASSERT(moved == small);
+	small = rows();
+	COMPACT_VECTOR_ASSERT(small.empty() && small.is_compact());
+	moved = std::move(copy);
+	COMPACT_VECTOR_ASSERT(moved.size() == 20 && copy.empty());
+}
+
+COMPACT_VECTOR_TEST(soa_max_size)
+{
+	// max_size считается в строках: блок на max_size + 1 строк уже не помещается в size_t / 2 байтов
+	using wide_rows = compact_soa_vector<uint64_t, uint64_t>;
+	COMPACT_VECTOR_ASSERT(wide_rows::max_size == (SIZE_MAX >> 1) / 16);
+
+	const size_t requests[] = { wide_rows::max_size + 1, (SIZE_MAX >> 4) + 2, SIZE_MAX };
+	for (size_t n : requests)
+	{
+		wide_rows vector;
+		bool reserve_thrown = false;
+		try
+		{
+			vector.reserve(n);
+		}
+		catch (const std::length_error&)
+		{
+			reserve_thrown = true;
+		}
+
+		bool resize_thrown = false;
+		try
+		{
+			vector.resize(n);
+		}
+		catch (const std::length_error&)
+		{
+			resize_thrown = true;
+		}
+
+		COMPACT_VECTOR_ASSERT(reserve_thrown && resize_thrown);
+		COMPACT_VECTOR_ASSERT(vector.empty() && vector.is_compact());
+	}
+}
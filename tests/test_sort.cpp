@@ -0,0 +1,102 @@
+#include "tests_runner.h"
+#include "../compact_vector.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+template <class V, class T>
+bool same(const V& v, std::initializer_list<T> il)
+{
+	return v.size() == il.size() && std::equal(v.begin(), v.end(), il.begin());
+}
+
+}
+
+COMPACT_VECTOR_TEST(sort_networks)
+{
+	// принцип нулей и единиц: сеть, сортирующая все последовательности из 0 и 1, сортирует любые
+	for (size_t n = 2; n <= compact_vector_sort::network_max_size; n++)
+	{
+		for (uint32_t bits = 0; bits < (1u << n); bits++)
+		{
+			int v[16];
+			for (size_t i = 0; i < n; i++)
+				v[i] = (bits >> i) & 1;
+			compact_vector_sort::sort(v, v + n, std::less<int>());
+			COMPACT_VECTOR_ASSERT(std::is_sorted(v, v + n));
+		}
+	}
+	COMPACT_VECTOR_ASSERT(compact_vector_sort::detail::network<16>::table.count == 63);
+}
+
+COMPACT_VECTOR_TEST(sort_sizes_and_patterns)
+{
+	std::mt19937 random(13);
+	std::vector<size_t> sizes;
+	for (size_t n = 0; n <= 140; n++)
+		sizes.push_back(n);
+	sizes.push_back(1000);
+	sizes.push_back(100000);
+
+	for (size_t n : sizes)
+	{
+		std::vector<std::vector<uint64_t>> inputs(6);
+		for (size_t i = 0; i < n; i++)
+		{
+			inputs[0].push_back(random());
+			inputs[1].push_back(i);
+			inputs[2].push_back(n - i);
+			inputs[3].push_back(7);
+			inputs[4].push_back(i % 16);
+			inputs[5].push_back(i < n / 2 ? i : n - i);
+		}
+		for (auto& input : inputs)
+		{
+			std::vector<uint64_t> expected = input;
+			std::sort(expected.begin(), expected.end());
+			compact_vector_sort::sort(input.data(), input.data() + n, std::less<uint64_t>());
+			COMPACT_VECTOR_ASSERT(input == expected);
+		}
+
+		std::vector<std::string> strings;
+		for (size_t i = 0; i < n && i < 2000; i++)
+			strings.push_back(std::to_string(random() % 500));
+		std::vector<std::string> expected = strings;
+		std::sort(expected.begin(), expected.end(), std::greater<std::string>());
+		compact_vector_sort::sort(strings.data(), strings.data() + strings.size(), std::greater<std::string>());
+		COMPACT_VECTOR_ASSERT(strings == expected);
+	}
+}
+
+COMPACT_VECTOR_TEST(sort_members)
+{
+	compact_vector<uint32_t> v = { 5, 3, 5, 1, 3 };
+	v.sort();
+	COMPACT_VECTOR_ASSERT(same(v, { 1u, 3u, 3u, 5u, 5u }));
+	COMPACT_VECTOR_ASSERT(v.unique() == 2);
+	COMPACT_VECTOR_ASSERT(same(v, { 1u, 3u, 5u }));
+
+	v.sort(std::greater<uint32_t>());
+	COMPACT_VECTOR_ASSERT(same(v, { 5u, 3u, 1u }));
+
+	compact_vector<double> d;
+	std::mt19937 random(3);
+	for (int i = 0; i < 300; i++)
+		d.push_back(static_cast<double>(random() % 50) - 25.0);
+	size_t removed = d.dedupe();
+	COMPACT_VECTOR_ASSERT(removed == 300 - d.size() && d.size() <= 50);
+	COMPACT_VECTOR_ASSERT(std::adjacent_find(d.begin(), d.end(), std::greater_equal<double>()) == d.end());
+
+	compact_vector<std::string, 4> s = { "b", "a", "b", "c" };
+	COMPACT_VECTOR_ASSERT(s.dedupe() == 1);
+	COMPACT_VECTOR_ASSERT(same(s, { std::string("a"), std::string("b"), std::string("c") }));
+	COMPACT_VECTOR_ASSERT(s.unique([](const std::string& a, const std::string& b) { return a.size() == b.size(); }) == 2);
+	COMPACT_VECTOR_ASSERT(s.size() == 1 && s[0] == "a");
+}
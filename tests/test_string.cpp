@@ -0,0 +1,117 @@
+#include "tests_runner.h"
+#include "../compact_string.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_set>
+
+namespace
+{
+
+// символы лежат внутри самого объекта
+bool is_inline(const compact_string& s)
+{
+	uintptr_t data = reinterpret_cast<uintptr_t>(s.data());
+	uintptr_t object = reinterpret_cast<uintptr_t>(&s);
+	return data >= object && data < object + sizeof(s);
+}
+
+}
+
+COMPACT_VECTOR_TEST(string_inline_capacity)
+{
+	COMPACT_VECTOR_ASSERT(sizeof(compact_string) == 3 * sizeof(void*));
+	COMPACT_VECTOR_ASSERT(compact_string::compact_capacity == 3 * sizeof(void*) - 1);
+
+	compact_string empty;
+	COMPACT_VECTOR_ASSERT(empty.empty() && std::strlen(empty.c_str()) == 0);
+
+	// 23 символа помещаются во встроенный буфер, терминатором служит нулевой счетчик в последнем байте
+	std::string text(compact_string::compact_capacity, 'x');
+	compact_string s(text);
+	COMPACT_VECTOR_ASSERT(s.capacity() == compact_string::compact_capacity);
+	COMPACT_VECTOR_ASSERT(is_inline(s));
+	COMPACT_VECTOR_ASSERT(s.c_str() == text);
+
+	s.push_back('y');
+	COMPACT_VECTOR_ASSERT(!is_inline(s));
+	COMPACT_VECTOR_ASSERT(s.c_str() == text + "y");
+	COMPACT_VECTOR_ASSERT(s.capacity() > s.size());
+
+	s.resize(5);
+	s.shrink_to_fit();
+	COMPACT_VECTOR_ASSERT(is_inline(s));
+	COMPACT_VECTOR_ASSERT(std::strcmp(s.c_str(), "xxxxx") == 0);
+}
+
+COMPACT_VECTOR_TEST(string_terminator)
+{
+	// после каждой операции c_str() совпадает с std::string
+	compact_string s;
+	std::string expected;
+	for (int i = 0; i < 100; i++)
+	{
+		char c = static_cast<char>('a' + i % 26);
+		s.push_back(c);
+		expected.push_back(c);
+		COMPACT_VECTOR_ASSERT(std::strcmp(s.c_str(), expected.c_str()) == 0);
+	}
+
+	s.erase(10, 50);
+	expected.erase(10, 50);
+	COMPACT_VECTOR_ASSERT(std::strcmp(s.c_str(), expected.c_str()) == 0);
+
+	s.shrink_to_fit();
+	COMPACT_VECTOR_ASSERT(s.capacity() == s.size());
+	COMPACT_VECTOR_ASSERT(std::strcmp(s.c_str(), expected.c_str()) == 0);
+
+	compact_string copy(s);
+	COMPACT_VECTOR_ASSERT(std::strcmp(copy.c_str(), expected.c_str()) == 0);
+
+	compact_string moved(std::move(copy));
+	COMPACT_VECTOR_ASSERT(copy.c_str() != nullptr && std::strcmp(moved.c_str(), expected.c_str()) == 0);
+
+	s.append(s.view().substr(0, 5));
+	expected.append(expected.substr(0, 5));
+	COMPACT_VECTOR_ASSERT(s == expected);
+
+	s.pop_back();
+	s.append(3, '!');
+	expected.pop_back();
+	expected.append(3, '!');
+	COMPACT_VECTOR_ASSERT(std::strcmp(s.c_str(), expected.c_str()) == 0);
+
+	s.clear();
+	COMPACT_VECTOR_ASSERT(s.empty() && s.c_str()[0] == '\0');
+}
+
+COMPACT_VECTOR_TEST(string_search_and_compare)
+{
+	compact_string s("key:value:tail");
+	COMPACT_VECTOR_ASSERT(s.find(':') == 3);
+	COMPACT_VECTOR_ASSERT(s.find(':', 4) == 9);
+	COMPACT_VECTOR_ASSERT(s.rfind(':') == 9);
+	COMPACT_VECTOR_ASSERT(s.find("value") == 4);
+	COMPACT_VECTOR_ASSERT(s.find('z') == compact_string::npos);
+	COMPACT_VECTOR_ASSERT(s.starts_with("key") && s.ends_with("tail"));
+	COMPACT_VECTOR_ASSERT(s.substr(4, 5) == "value");
+
+	COMPACT_VECTOR_ASSERT(compact_string("abc") < compact_string("abd"));
+	COMPACT_VECTOR_ASSERT(compact_string("ab") < compact_string("abc"));
+	COMPACT_VECTOR_ASSERT(compact_string("abcdefgh") < compact_string("abcdefgi"));
+	COMPACT_VECTOR_ASSERT(compact_string("b0000000") > compact_string("a9999999"));
+	COMPACT_VECTOR_ASSERT(compact_string("abcdefgh1") < compact_string("abcdefgh2"));
+	COMPACT_VECTOR_ASSERT(compact_string("abcdefgh") <= compact_string("abcdefgh"));
+	COMPACT_VECTOR_ASSERT(compact_string("abc").compare("abc") == 0);
+	COMPACT_VECTOR_ASSERT("abc" == compact_string("abc"));
+	COMPACT_VECTOR_ASSERT(compact_string("abc") != std::string("abd"));
+
+	std::unordered_set<compact_string> keys;
+	keys.insert("alpha");
+	keys.insert(compact_string(40, 'b'));
+	COMPACT_VECTOR_ASSERT(keys.count("alpha") == 1);
+	COMPACT_VECTOR_ASSERT(keys.count(compact_string(40, 'b')) == 1);
+	COMPACT_VECTOR_ASSERT(keys.count("beta") == 0);
+	COMPACT_VECTOR_ASSERT(std::hash<compact_string>()("alpha") == std::hash<std::string_view>()("alpha"));
+}
@@ -0,0 +1,189 @@
+// Телеметрия включается только в этом файле, поэтому тесты используют собственный
+// тип элемента: его экземпляры compact_vector не встречаются в других единицах трансляции.
+#define COMPACT_VECTOR_TELEMETRY
+
+#include "tests_runner.h"
+#include "../compact_vector.h"
+#include "../compact_vector_tuning.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+struct telemetry_value
+{
+	uint32_t value;
+};
+
+using telemetry_vector = compact_vector<telemetry_value, 4>;
+
+struct telemetry_byte
+{
+	uint8_t value;
+};
+
+using telemetry_byte_vector = compact_vector<telemetry_byte, 4>;
+
+struct profile_tag;
+
+}
+
+COMPACT_VECTOR_TEST(telemetry_spills_and_returns)
+{
+	compact_vector_telemetry::stats before = compact_vector_telemetry::snapshot<telemetry_vector>();
+	{
+		telemetry_vector vector;
+		for (uint32_t i = 0; i < 5; i++)
+			vector.push_back({ i });
+		vector.push_back({ 5 });
+
+		vector.resize(2);
+		vector.shrink_to_fit();
+
+		telemetry_vector small;
+		small.push_back({ 0 });
+	}
+	compact_vector_telemetry::stats after = compact_vector_telemetry::snapshot<telemetry_vector>();
+
+	COMPACT_VECTOR_ASSERT(after.spills - before.spills == 1);
+	COMPACT_VECTOR_ASSERT(after.returns - before.returns == 1);
+	COMPACT_VECTOR_ASSERT(after.allocated_bytes - before.allocated_bytes == 8 * sizeof(telemetry_value));
+	COMPACT_VECTOR_ASSERT(after.freed_bytes - before.freed_bytes == 8 * sizeof(telemetry_value));
+	COMPACT_VECTOR_ASSERT(after.destructions - before.destructions == 2);
+
+	// оба вектора разрушены компактными: размер 2 и 1, емкость 4
+	COMPACT_VECTOR_ASSERT(after.size_histogram[compact_vector_telemetry::bucket(1)] - before.size_histogram[compact_vector_telemetry::bucket(1)] == 1);
+	COMPACT_VECTOR_ASSERT(after.size_histogram[compact_vector_telemetry::bucket(2)] - before.size_histogram[compact_vector_telemetry::bucket(2)] == 1);
+	COMPACT_VECTOR_ASSERT(after.capacity_histogram[compact_vector_telemetry::bucket(4)] - before.capacity_histogram[compact_vector_telemetry::bucket(4)] == 2);
+}
+
+COMPACT_VECTOR_TEST(telemetry_threads)
+{
+	compact_vector_telemetry::stats before = compact_vector_telemetry::snapshot<telemetry_vector>();
+
+	// счетчики потока попадают в общую запись при его завершении
+	std::thread thread([]
+	{
+		telemetry_vector vector(100);
+	});
+	thread.join();
+
+	compact_vector_telemetry::stats after = compact_vector_telemetry::snapshot<telemetry_vector>();
+	COMPACT_VECTOR_ASSERT(after.spills - before.spills == 1);
+	COMPACT_VECTOR_ASSERT(after.destructions - before.destructions == 1);
+	COMPACT_VECTOR_ASSERT(after.size_histogram[compact_vector_telemetry::bucket(100)] - before.size_histogram[compact_vector_telemetry::bucket(100)] == 1);
+}
+
+COMPACT_VECTOR_TEST(telemetry_moved_from_shells)
+{
+	compact_vector_telemetry::stats before = compact_vector_telemetry::snapshot<telemetry_vector>();
+	{
+		// рост std::vector перемещает векторы и разрушает оставшиеся пустые оболочки
+		std::vector<telemetry_vector> vectors;
+		for (uint32_t i = 0; i < 16; i++)
+			vectors.push_back(telemetry_vector(i % 2 == 0 ? 3 : 10));
+	}
+	compact_vector_telemetry::stats after = compact_vector_telemetry::snapshot<telemetry_vector>();
+
+	COMPACT_VECTOR_ASSERT(after.empty_shells - before.empty_shells == after.destructions - before.destructions - 16);
+	COMPACT_VECTOR_ASSERT(after.empty_shells - before.empty_shells >= 16);
+	COMPACT_VECTOR_ASSERT(after.size_histogram[0] - before.size_histogram[0] == 0);
+	COMPACT_VECTOR_ASSERT(after.exact_size_histogram[0] - before.exact_size_histogram[0] == 0);
+	COMPACT_VECTOR_ASSERT(after.exact_size_histogram[3] - before.exact_size_histogram[3] == 8);
+	COMPACT_VECTOR_ASSERT(after.exact_size_histogram[10] - before.exact_size_histogram[10] == 8);
+}
+
+COMPACT_VECTOR_TEST(telemetry_empty_vectors)
+{
+	compact_vector_telemetry::stats before = compact_vector_telemetry::snapshot<telemetry_vector>();
+	{
+		// никогда не заполненные векторы - настоящие пустые списки, они остаются в корзине 0
+		std::vector<telemetry_vector> lists(6);
+		lists[0].push_back({ 1 });
+
+		// перемещенный и снова заполненный вектор разрушается со своим размером
+		telemetry_vector reused;
+		reused.push_back({ 2 });
+		telemetry_vector target(std::move(reused));
+		reused.push_back({ 3 });
+
+		// перемещенный и очищенный вектор по-прежнему оболочка
+		telemetry_vector moved;
+		moved.push_back({ 4 });
+		telemetry_vector other(std::move(moved));
+		moved.clear();
+	}
+	compact_vector_telemetry::stats after = compact_vector_telemetry::snapshot<telemetry_vector>();
+
+	COMPACT_VECTOR_ASSERT(after.destructions - before.destructions == 10);
+	COMPACT_VECTOR_ASSERT(after.empty_shells - before.empty_shells == 1);
+	COMPACT_VECTOR_ASSERT(after.exact_size_histogram[0] - before.exact_size_histogram[0] == 5);
+	COMPACT_VECTOR_ASSERT(after.exact_size_histogram[1] - before.exact_size_histogram[1] == 4);
+}
+
+COMPACT_VECTOR_TEST(telemetry_reused_shells)
+{
+	compact_vector_telemetry::stats before = compact_vector_telemetry::snapshot<telemetry_byte_vector>();
+	{
+		// однобайтовый элемент перезаписывает лишь малую часть встроенного буфера, но вектор
+		// после перемещения, записи и очистки уже не оболочка
+		telemetry_byte_vector reused;
+		reused.push_back({ 1 });
+		telemetry_byte_vector target(std::move(reused));
+		reused.push_back({ 2 });
+		reused.clear();
+
+		// при обмене признак оболочки переходит вместе с пустым содержимым
+		telemetry_byte_vector moved;
+		moved.push_back({ 3 });
+		telemetry_byte_vector other(std::move(moved));
+		telemetry_byte_vector filled;
+		filled.push_back({ 4 });
+		filled.push_back({ 5 });
+		moved.swap(filled);
+	}
+	compact_vector_telemetry::stats after = compact_vector_telemetry::snapshot<telemetry_byte_vector>();
+
+	COMPACT_VECTOR_ASSERT(after.destructions - before.destructions == 5);
+	COMPACT_VECTOR_ASSERT(after.empty_shells - before.empty_shells == 1);
+	COMPACT_VECTOR_ASSERT(after.exact_size_histogram[0] - before.exact_size_histogram[0] == 1);
+	COMPACT_VECTOR_ASSERT(after.exact_size_histogram[1] - before.exact_size_histogram[1] == 2);
+	COMPACT_VECTOR_ASSERT(after.exact_size_histogram[2] - before.exact_size_histogram[2] == 1);
+}
+
+COMPACT_VECTOR_TEST(telemetry_profile)
+{
+	using vector_type = compact_vector_tuning::tuned_compact_vector<telemetry_value, profile_tag>;
+	for (size_t i = 0; i < 10; i++)
+	{
+		vector_type vector(i < 8 ? 3 : 300);
+	}
+
+	const char* path = "compact_vector_profile_test.txt";
+	COMPACT_VECTOR_ASSERT(compact_vector_telemetry::write_profile(path));
+
+	std::vector<compact_vector_tuning::profile_site> sites;
+	FILE* in = std::fopen(path, "r");
+	COMPACT_VECTOR_ASSERT(in != nullptr);
+	COMPACT_VECTOR_ASSERT(compact_vector_tuning::read_profile(in, sites));
+	std::fclose(in);
+	std::remove(path);
+
+	const compact_vector_tuning::profile_site* site = nullptr;
+	for (const auto& s : sites)
+		if (s.tag.find("profile_tag") != std::string::npos)
+			site = &s;
+
+	COMPACT_VECTOR_ASSERT(site != nullptr);
+	COMPACT_VECTOR_ASSERT(site->object_size == sizeof(vector_type::storage_type));
+	COMPACT_VECTOR_ASSERT(site->sizes.size() == 2);
+	COMPACT_VECTOR_ASSERT(site->sizes[0].first == 3 && site->sizes[0].second == 8);
+	COMPACT_VECTOR_ASSERT(site->sizes[1].first == 511 && site->sizes[1].second == 2);
+
+	// большие векторы не помещаются ни в какой буфер до 24 байт, поэтому выбирается самый большой из них
+	COMPACT_VECTOR_ASSERT(compact_vector_tuning::recommend(*site, compact_vector_tuning::objective::allocations, 24).capacity == 4);
+}
@@ -0,0 +1,70 @@
+#include "tests_runner.h"
+#include "../compact_vector.h"
+#include "../thread_cache_allocator.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+COMPACT_VECTOR_TEST(thread_cache_size_classes)
+{
+	COMPACT_VECTOR_ASSERT(thread_cache::size_class(1) == 0);
+	COMPACT_VECTOR_ASSERT(thread_cache::size_class(16) == 0);
+	COMPACT_VECTOR_ASSERT(thread_cache::size_class(17) == 1);
+	COMPACT_VECTOR_ASSERT(thread_cache::size_class(4096) == thread_cache::class_count - 1);
+	COMPACT_VECTOR_ASSERT(thread_cache::size_class(4097) == thread_cache::class_count);
+}
+
+COMPACT_VECTOR_TEST(thread_cache_reuse)
+{
+	// освобожденный блок возвращается следующему запросу того же класса
+	thread_cache_allocator<uint32_t> allocator;
+	uint32_t* a = allocator.allocate(5);
+	allocator.deallocate(a, 5);
+	uint32_t* b = allocator.allocate(8);
+	COMPACT_VECTOR_ASSERT(a == b);
+	allocator.deallocate(b, 8);
+
+	uint32_t* large = allocator.allocate(10000);
+	large[9999] = 1;
+	allocator.deallocate(large, 10000);
+}
+
+COMPACT_VECTOR_TEST(thread_cache_vector)
+{
+	compact_vector<std::string, 2, thread_cache_allocator<std::string>> vector;
+	for (int i = 0; i < 100; i++)
+		vector.push_back(std::to_string(i));
+	COMPACT_VECTOR_ASSERT(vector[99] == "99");
+
+	vector.resize(1);
+	vector.shrink_to_fit();
+	COMPACT_VECTOR_ASSERT(vector.capacity() == 2);
+}
+
+COMPACT_VECTOR_TEST(thread_cache_cross_thread)
+{
+	using vector_type = compact_vector<uint32_t, 4, thread_cache_allocator<uint32_t>>;
+
+	// векторы создаются в одном потоке и разрушаются в другом: освобожденные блоки
+	// накапливаются в кэше второго потока и пачками уходят в общий пул
+	std::vector<vector_type> vectors(1000);
+	std::thread producer([&vectors]
+	{
+		for (size_t i = 0; i < vectors.size(); i++)
+			for (uint32_t k = 0; k < 10; k++)
+				vectors[i].push_back(k);
+	});
+	producer.join();
+
+	std::thread consumer([&vectors]
+	{
+		vectors.clear();
+	});
+	consumer.join();
+
+	vector_type vector;
+	for (uint32_t k = 0; k < 10; k++)
+		vector.push_back(k);
+	COMPACT_VECTOR_ASSERT(vector[9] == 9);
+}
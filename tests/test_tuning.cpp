@@ -0,0 +1,67 @@
+#include "tests_runner.h"
+#include "../compact_vector_tuning.h"
+
+#include <cstdint>
+#include <string>
+
+namespace
+{
+
+struct tuned_tag;
+
+template <class Vector>
+compact_vector_tuning::profile_site site_of()
+{
+	using T = typename Vector::value_type;
+	compact_vector_tuning::profile_site site;
+	site.element_size = sizeof(T);
+	site.element_alignment = alignof(T);
+	site.size_word = sizeof(typename Vector::size_word_type);
+	site.compact_capacity = Vector::compact_capacity;
+	site.object_size = sizeof(Vector);
+	return site;
+}
+
+}
+
+namespace compact_vector_tuning
+{
+	template <> struct capacity<tuned_tag> { static constexpr int value = 7; };
+}
+
+COMPACT_VECTOR_TEST(tuning_registry)
+{
+	COMPACT_VECTOR_ASSERT((compact_vector_tuning::tuned_compact_vector<uint32_t, tuned_tag>::compact_capacity == 7));
+	COMPACT_VECTOR_ASSERT((compact_vector_tuning::tuned_compact_vector<uint32_t, struct untuned_tag>::compact_capacity == compact_vector<uint32_t>::compact_capacity));
+}
+
+COMPACT_VECTOR_TEST(tuning_object_size_model)
+{
+	// модель размера объекта должна совпадать с настоящей стандартной раскладкой
+	COMPACT_VECTOR_ASSERT(compact_vector_tuning::standard_object_size(site_of<compact_vector<uint8_t, 3>>(), 3) == sizeof(compact_vector<uint8_t, 3>));
+	COMPACT_VECTOR_ASSERT(compact_vector_tuning::standard_object_size(site_of<compact_vector<uint8_t, 3>>(), 40) == sizeof(compact_vector<uint8_t, 40>));
+	COMPACT_VECTOR_ASSERT(compact_vector_tuning::standard_object_size(site_of<compact_vector<uint32_t, 5>>(), 5) == sizeof(compact_vector<uint32_t, 5>));
+	COMPACT_VECTOR_ASSERT(compact_vector_tuning::standard_object_size(site_of<compact_vector<std::string>>(), 3) == sizeof(compact_vector<std::string, 3>));
+	COMPACT_VECTOR_ASSERT((compact_vector_tuning::standard_object_size(site_of<compact_vector<uint16_t, 9, std::allocator<uint16_t>, compact_vector_growth::doubling, compact_vector_layout::standard, uint32_t>>(), 9)
+		== sizeof(compact_vector<uint16_t, 9, std::allocator<uint16_t>, compact_vector_growth::doubling, compact_vector_layout::standard, uint32_t>)));
+}
+
+COMPACT_VECTOR_TEST(tuning_recommend)
+{
+	compact_vector_tuning::profile_site site = site_of<compact_vector<uint64_t>>();
+	site.sizes = { { 0, 10 }, { 5, 1000 }, { 6, 10 }, { 200, 1 } };
+
+	// почти все векторы из 5 элементов: по байтам выгоднее всего ровно 5,
+	// по аллокациям - буфер на самый большой вектор
+	compact_vector_tuning::recommendation bytes = compact_vector_tuning::recommend(site, compact_vector_tuning::objective::bytes, 0);
+	COMPACT_VECTOR_ASSERT(bytes.capacity == 5);
+
+	compact_vector_tuning::recommendation allocations = compact_vector_tuning::recommend(site, compact_vector_tuning::objective::allocations, 0);
+	COMPACT_VECTOR_ASSERT(allocations.capacity == 200);
+
+	// бюджет sizeof ограничивает кандидатов
+	compact_vector_tuning::recommendation budget = compact_vector_tuning::recommend(site, compact_vector_tuning::objective::allocations, 56);
+	COMPACT_VECTOR_ASSERT(budget.capacity == 6);
+	COMPACT_VECTOR_ASSERT(budget.object_size == 56);
+	COMPACT_VECTOR_ASSERT(budget.allocations == 6);
+}
@@ -2,9 +2,15 @@
 
 #pragma once
 
+#include "perf_counters.h"
+
 #include <vector>
 #include <functional>
 #include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
 
 struct Test
 {
@@ -15,6 +21,33 @@ struct Test
 	Test(const char* name, std::function<void()> test);
 };
 
+struct Benchmark
+{
+	std::string name;
+
+	// тело бенчмарка выполняет iterations повторений измеряемой операции
+	std::function<void(size_t iterations)> body;
+
+	Benchmark(const char* name, std::function<void(size_t)> body);
+};
+
+struct Measurement
+{
+	std::string name;
+
+	// число повторений операции в одном прогоне
+	size_t iterations = 0;
+
+	// время прогона в наносекундах: минимум и медиана по repetitions прогонам
+	double min_ns = 0;
+	double median_ns = 0;
+
+	// суммы по всем прогонам
+	size_t total_iterations = 0;
+	bool counter_available[PerfCounters::counter_count] = {};
+	uint64_t counters[PerfCounters::counter_count] = {};
+};
+
 struct TestsRunner
 {
 	static void AddTest(Test& test)
@@ -55,6 +88,128 @@ struct TestsRunner
 			printf("[FAIL] ");
 		printf("%s\n", name.c_str());
 	}
+
+	// не дает компилятору выбросить вычисление value
+	template <class T>
+	static void DoNotOptimize(const T& value)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "r,m"(value) : "memory");
+#else
+		static volatile const void* sink;
+		sink = &value;
+#endif
+	}
+
+	static void AddBenchmark(Benchmark& benchmark)
+	{
+		GetAllBenchmarks().push_back(benchmark);
+	}
+
+	static std::vector<Benchmark>& GetAllBenchmarks()
+	{
+		static std::vector<Benchmark> benchmarks;
+		return benchmarks;
+	}
+
+	// Запускает зарегистрированные бенчмарки, имя которых содержит filter,
+	// и печатает по одной JSON-строке на бенчмарк.
+	static void RunAllBenchmarks(const char* filter = nullptr)
+	{
+		for (auto& benchmark : GetAllBenchmarks())
+		{
+			if (filter != nullptr && benchmark.name.find(filter) == std::string::npos)
+				continue;
+
+			PrintMeasurement(Measure(benchmark.name, benchmark.body));
+		}
+	}
+
+	// Подбирает число итераций удвоением, пока прогон не займет min_time_ns,
+	// после чего делает repetitions прогонов со счетчиками производительности.
+	static Measurement Measure(
+		const std::string& name,
+		const std::function<void(size_t)>& body,
+		double min_time_ns = 10e6,
+		size_t repetitions = 5)
+	{
+		Measurement m;
+		m.name = name;
+
+		m.iterations = 1;
+		while (TimeRun(body, m.iterations) < min_time_ns && m.iterations < (size_t(1) << 30))
+			m.iterations *= 2;
+
+		PerfCounters perf;
+		for (int i = 0; i < PerfCounters::counter_count; i++)
+			m.counter_available[i] = perf.Available(i);
+
+		std::vector<double> times;
+		for (size_t r = 0; r < repetitions; r++)
+		{
+			uint64_t values[PerfCounters::counter_count];
+			perf.Start();
+			times.push_back(TimeRun(body, m.iterations));
+			perf.Stop();
+			perf.Read(values);
+
+			for (int i = 0; i < PerfCounters::counter_count; i++)
+				m.counters[i] += values[i];
+			m.total_iterations += m.iterations;
+		}
+
+		std::sort(times.begin(), times.end());
+		m.min_ns = times.front();
+		m.median_ns = times[times.size() / 2];
+		return m;
+	}
+
+	// Поля измерения в виде JSON без фигурных скобок, в пересчете на одну операцию.
+	// Недоступные счетчики выводятся как null.
+	static std::string MeasurementFields(const Measurement& m)
+	{
+		char buffer[128];
+		std::string result;
+
+		std::snprintf(buffer, sizeof(buffer), "\"iterations\":%zu,\"ns_per_op\":%.3f,\"min_ns_per_op\":%.3f",
+			m.iterations, m.median_ns / m.iterations, m.min_ns / m.iterations);
+		result += buffer;
+
+		result += ",\"counters\":{";
+		for (int i = 0; i < PerfCounters::counter_count; i++)
+		{
+			if (i > 0)
+				result += ",";
+			result += "\"";
+			result += PerfCounters::Name(i);
+			result += "\":";
+			if (m.counter_available[i] && m.total_iterations > 0)
+			{
+				std::snprintf(buffer, sizeof(buffer), "%.3f", double(m.counters[i]) / m.total_iterations);
+				result += buffer;
+			}
+			else
+			{
+				result += "null";
+			}
+		}
+		result += "}";
+		return result;
+	}
+
+	static void PrintMeasurement(const Measurement& m)
+	{
+		printf("{\"bench\":\"%s\",%s}\n", m.name.c_str(), MeasurementFields(m).c_str());
+	}
+
+private:
+	static double TimeRun(const std::function<void(size_t)>& body, size_t iterations)
+	{
+		auto start = std::chrono::steady_clock::now();
+		body(iterations);
+		auto finish = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::nano>(finish - start).count();
+	}
 };
 
 inline Test::Test(const char* name, std::function<void()> test) :
@@ -64,6 +219,13 @@ inline Test::Test(const char* name, std::function<void()> test) :
 	TestsRunner::AddTest(*this);
 }
 
+inline Benchmark::Benchmark(const char* name, std::function<void(size_t)> body) :
+	name(name),
+	body(body)
+{
+	TestsRunner::AddBenchmark(*this);
+}
+
 #define COMPACT_VECTOR_TEST(name)		\
 void name();							\
 										\
@@ -77,3 +239,14 @@ void name()
 
 #define COMPACT_VECTOR_ASSERT(expr)		\
 if (!(expr)) throw std::exception();
+
+
+#define COMPACT_VECTOR_BENCHMARK(name)				\
+void name(size_t iterations);						\
+													\
+namespace											\
+{													\
+Benchmark benchmark_##name(#name, name);			\
+}													\
+													\
+void name(size_t iterations)
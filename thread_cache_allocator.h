@@ -0,0 +1,250 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <new>
+
+/// thread_cache_allocator
+/*!
+Allocator for the heap buffers of small compact_vector instances.
+
+Requests up to max_class_bytes are rounded up to a power-of-two size class starting at
+min_class_bytes (16 bytes, the spill of a few elements just above compact_capacity).
+Every thread keeps a free list per class, so allocate() and deallocate() normally
+touch neither a lock nor malloc. An empty list is refilled with a batch of blocks from
+a shared pool (or a new chunk from operator new); a list that grows past two batches,
+e.g. because the thread frees blocks allocated by another thread, returns one batch
+to the shared pool. Lists of an exiting thread go back to the pool as well.
+
+Blocks are never returned to the system: the pool keeps its peak size for the lifetime
+of the process. Larger requests go straight to operator new.
+*/
+namespace thread_cache
+{
+	static const size_t min_class_bytes = 16;
+	static const size_t max_class_bytes = 4096;
+	static const int class_count = 9; // 16, 32, ..., 4096
+
+	/// blocks moved between a thread cache and the shared pool at once
+	static const size_t batch_blocks = 32;
+
+	/// size class of a request, or class_count if it is served by operator new
+	inline int size_class(size_t bytes) noexcept
+	{
+		if (bytes > max_class_bytes)
+			return class_count;
+
+		int c = 0;
+		for (size_t s = min_class_bytes; s < bytes; s *= 2)
+			c++;
+		return c;
+	}
+
+	inline size_t class_bytes(int c) noexcept
+	{
+		return min_class_bytes << c;
+	}
+
+	namespace detail
+	{
+		// свободный блок: первое слово - следующий блок в пачке, второе - следующая пачка в общем пуле
+		struct block
+		{
+			block* next;
+			block* next_batch;
+		};
+
+		// общий пул: пачки не больше batch_blocks блоков под мьютексом, по одному списку на класс
+		struct shared_pool
+		{
+			std::mutex mutex;
+			block* batches[class_count] = {};
+
+			block* pop_batch(int c)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				block* b = batches[c];
+				if (b != nullptr)
+					batches[c] = b->next_batch;
+				return b;
+			}
+
+			void push_batch(int c, block* b)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				b->next_batch = batches[c];
+				batches[c] = b;
+			}
+		};
+
+		inline shared_pool& pool()
+		{
+			// намеренно не разрушается: кэши потоков возвращают блоки и после статических деструкторов
+			static shared_pool* p = new shared_pool();
+			return *p;
+		}
+
+		// новая пачка из одного куска памяти
+		inline block* carve_batch(int c)
+		{
+			size_t bytes = class_bytes(c);
+			char* chunk = static_cast<char*>(::operator new(bytes * batch_blocks));
+			block* head = nullptr;
+			for (size_t i = batch_blocks; i > 0; i--)
+			{
+				block* b = reinterpret_cast<block*>(chunk + (i - 1) * bytes);
+				b->next = head;
+				head = b;
+			}
+			return head;
+		}
+
+		// кэш тривиально разрушаем и остается рабочим после завершения потока (например, для
+		// деструкторов статических объектов); блоки в общий пул при выходе потока возвращает guard
+		struct thread_cache
+		{
+			block* heads[class_count];
+			size_t counts[class_count];
+
+			void release_all() noexcept
+			{
+				for (int c = 0; c < class_count; c++)
+					while (counts[c] > 0)
+						return_batch(c);
+			}
+
+			void* allocate(int c)
+			{
+				if (heads[c] == nullptr)
+					refill(c);
+
+				block* b = heads[c];
+				heads[c] = b->next;
+				counts[c]--;
+				return b;
+			}
+
+			void deallocate(void* p, int c) noexcept
+			{
+				block* b = static_cast<block*>(p);
+				b->next = heads[c];
+				heads[c] = b;
+				if (++counts[c] > 2 * batch_blocks)
+					return_batch(c);
+			}
+
+			// пачки в пуле могут быть неполными (остатки кэша завершившегося потока), поэтому длина считается
+			void refill(int c)
+			{
+				block* b = pool().pop_batch(c);
+				if (b == nullptr)
+					b = carve_batch(c);
+
+				size_t n = 0;
+				for (block* i = b; i != nullptr; i = i->next)
+					n++;
+				heads[c] = b;
+				counts[c] = n;
+			}
+
+			// первые batch_blocks блоков списка (или все, если их меньше) уходят в общий пул
+			void return_batch(int c) noexcept
+			{
+				block* first = heads[c];
+				block* last = first;
+				size_t n = 1;
+				for (; n < batch_blocks && last->next != nullptr; n++)
+					last = last->next;
+
+				heads[c] = last->next;
+				counts[c] -= n;
+				last->next = nullptr;
+
+				pool().push_batch(c, first);
+			}
+		};
+
+		inline thread_cache& local_cache()
+		{
+			struct guard
+			{
+				~guard()
+				{
+					local_cache().release_all();
+				}
+			};
+
+			static thread_local thread_cache cache;
+			static thread_local guard g;
+			(void)g;
+			return cache;
+		}
+	}
+
+	/// allocates bytes from the calling thread's cache
+	inline void* allocate(size_t bytes)
+	{
+		int c = size_class(bytes);
+		if (c == class_count)
+			return ::operator new(bytes);
+		return detail::local_cache().allocate(c);
+	}
+
+	/// returns a block to the calling thread's cache; bytes must match the allocate() request
+	inline void deallocate(void* p, size_t bytes) noexcept
+	{
+		int c = size_class(bytes);
+		if (c == class_count)
+			::operator delete(p);
+		else
+			detail::local_cache().deallocate(p, c);
+	}
+}
+
+template <class T>
+struct thread_cache_allocator
+{
+	static_assert(alignof(T) <= alignof(std::max_align_t), "thread_cache_allocator supports only fundamental alignment");
+
+	using value_type = T;
+
+	template <class U>
+	struct rebind
+	{
+		using other = thread_cache_allocator<U>;
+	};
+
+	thread_cache_allocator() noexcept
+	{}
+
+	template <class U>
+	thread_cache_allocator(const thread_cache_allocator<U>&) noexcept
+	{}
+
+	T* allocate(size_t n)
+	{
+		if (n > std::numeric_limits<size_t>::max() / sizeof(T))
+			throw std::bad_alloc();
+
+		return static_cast<T*>(thread_cache::allocate(n * sizeof(T)));
+	}
+
+	void deallocate(T* p, size_t n) noexcept
+	{
+		thread_cache::deallocate(p, n * sizeof(T));
+	}
+};
+
+template <class T, class U>
+bool operator== (const thread_cache_allocator<T>&, const thread_cache_allocator<U>&) noexcept
+{
+	return true;
+}
+
+template <class T, class U>
+bool operator!= (const thread_cache_allocator<T>&, const thread_cache_allocator<U>&) noexcept
+{
+	return false;
+}
@@ -0,0 +1,128 @@
+// Подбор compact_max_size по профилю размеров, записанному compact_vector_telemetry::write_profile.
+//
+// Использование:
+//   compact_vector_tune [--objective bytes|allocations] [--budget sizeof] [--header out.h] [--include file.h]... profile...
+//
+// Для каждого экземпляра печатается JSON-строка с текущей и рекомендованной емкостью и
+// стоимостью обеих по модели из compact_vector_tuning.h. С --header для экземпляров с тегом
+// (tuned_compact_vector) генерируется заголовок со специализациями compact_vector_tuning::capacity.
+
+#include "../compact_vector_tuning.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+int usage()
+{
+	std::fprintf(stderr, "usage: compact_vector_tune [--objective bytes|allocations] [--budget sizeof] [--header out.h] [--include file.h]... profile...\n");
+	return 2;
+}
+
+// теги из анонимных пространств имен и локальных классов нельзя назвать в заголовке
+bool nameable(const std::string& tag)
+{
+	return !tag.empty() && tag.find('(') == std::string::npos && tag.find('{') == std::string::npos;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	compact_vector_tuning::objective goal = compact_vector_tuning::objective::bytes;
+	size_t budget = 0;
+	const char* header = nullptr;
+	std::vector<const char*> includes;
+	std::vector<const char*> profiles;
+
+	for (int i = 1; i < argc; i++)
+	{
+		bool has_value = i + 1 < argc;
+		if (std::strcmp(argv[i], "--objective") == 0 && has_value)
+		{
+			const char* value = argv[++i];
+			if (std::strcmp(value, "bytes") == 0)
+				goal = compact_vector_tuning::objective::bytes;
+			else if (std::strcmp(value, "allocations") == 0)
+				goal = compact_vector_tuning::objective::allocations;
+			else
+				return usage();
+		}
+		else if (std::strcmp(argv[i], "--budget") == 0 && has_value)
+			budget = std::strtoull(argv[++i], nullptr, 10);
+		else if (std::strcmp(argv[i], "--header") == 0 && has_value)
+			header = argv[++i];
+		else if (std::strcmp(argv[i], "--include") == 0 && has_value)
+			includes.push_back(argv[++i]);
+		else if (argv[i][0] == '-')
+			return usage();
+		else
+			profiles.push_back(argv[i]);
+	}
+
+	if (profiles.empty())
+		return usage();
+
+	std::vector<compact_vector_tuning::profile_site> sites;
+	for (const char* path : profiles)
+	{
+		FILE* in = std::fopen(path, "r");
+		if (in == nullptr || !compact_vector_tuning::read_profile(in, sites))
+		{
+			std::fprintf(stderr, "compact_vector_tune: cannot read profile %s\n", path);
+			if (in != nullptr)
+				std::fclose(in);
+			return 1;
+		}
+		std::fclose(in);
+	}
+
+	std::vector<std::pair<std::string, size_t>> tuned;
+	for (const auto& site : sites)
+	{
+		// модель описывает только стандартную раскладку; остальные экземпляры пропускаются
+		if (compact_vector_tuning::standard_object_size(site, site.compact_capacity) != site.object_size)
+		{
+			std::fprintf(stderr, "compact_vector_tune: %s does not use the standard layout, skipped\n", site.name.c_str());
+			continue;
+		}
+
+		compact_vector_tuning::recommendation now = compact_vector_tuning::evaluate(site, site.compact_capacity);
+		compact_vector_tuning::recommendation best = compact_vector_tuning::recommend(site, goal, budget);
+
+		std::printf(
+			"{\"vector\":\"%s\",\"tag\":\"%s\",\"current\":{\"capacity\":%zu,\"sizeof\":%zu,\"bytes\":%llu,\"allocations\":%llu},"
+			"\"recommended\":{\"capacity\":%zu,\"sizeof\":%zu,\"bytes\":%llu,\"allocations\":%llu}}\n",
+			site.name.c_str(), site.tag.c_str(),
+			now.capacity, now.object_size, (unsigned long long)now.bytes, (unsigned long long)now.allocations,
+			best.capacity, best.object_size, (unsigned long long)best.bytes, (unsigned long long)best.allocations);
+
+		if (nameable(site.tag))
+			tuned.push_back(std::make_pair(site.tag, best.capacity));
+	}
+
+	if (header != nullptr)
+	{
+		FILE* out = std::fopen(header, "w");
+		if (out == nullptr)
+		{
+			std::fprintf(stderr, "compact_vector_tune: cannot write %s\n", header);
+			return 1;
+		}
+
+		std::fprintf(out, "// generated by compact_vector_tune, do not edit\n#pragma once\n\n#include \"compact_vector_tuning.h\"\n");
+		for (const char* include : includes)
+			std::fprintf(out, "#include \"%s\"\n", include);
+		std::fprintf(out, "\nnamespace compact_vector_tuning\n{\n");
+		for (const auto& t : tuned)
+			std::fprintf(out, "\ttemplate <> struct capacity<%s> { static constexpr int value = %zu; };\n", t.first.c_str(), t.second);
+		std::fprintf(out, "}\n");
+		std::fclose(out);
+	}
+	return 0;
+}